@@ -57,9 +57,11 @@ class AbsChunker {
          * @brief load the data from the file
          * 
          * @param input_file the input file handler
+         * @param max_read_size the max read size (stop at the next hole)
          * @return uint32_t the read size
          */
-        virtual uint32_t LoadDataFromFile(ifstream& input_file) = 0;
+        virtual uint32_t LoadDataFromFile(ifstream& input_file,
+            uint64_t max_read_size) = 0;
         
         /**
          * @brief generate a chunk
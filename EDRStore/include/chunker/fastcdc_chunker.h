@@ -113,9 +113,10 @@ class FastCDC : public AbsChunker {
          * @brief load the data from the file
          * 
          * @param input_file the input file handler
+         * @param max_read_size the max read size (stop at the next hole)
          * @return uint32_t the read size
          */
-        uint32_t LoadDataFromFile(ifstream& input_file);
+        uint32_t LoadDataFromFile(ifstream& input_file, uint64_t max_read_size);
 
         /**
          * @brief generate a chunk
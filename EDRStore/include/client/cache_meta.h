@@ -15,7 +15,10 @@
 #include "../configure.h"
 #include "../define.h"
 #include "../crypto/crypto_util.h"
-#include "../network/ssl_conn.h"
+#include "../network/abs_transport.h"
+
+#include <sys/mman.h>
+#include <fcntl.h>
 
 using namespace std;
 
@@ -26,35 +29,68 @@ class CacheMeta{
         string my_name_= "CacheMeta";
         string db_name_ = "cache_meta_db";
 
-        uint32_t cur_version_num_ = 0;
-
         uint64_t send_recipe_batch_size_ = 0;
         uint32_t client_id_ = 0;
 
-        // feature --> version
-        unordered_map<uint64_t, uint32_t> feature_2_version_idx_;
-
         uint32_t last_n_para_ = 1;
 
+        // the flat feature --> version table (mapped from db_name_)
+        int db_fd_ = -1;
+        uint8_t* db_buf_ = NULL;
+        size_t db_size_ = 0;
+        CacheMetaHead_t* head_ = NULL;
+        CacheMetaSlot_t* slot_ = NULL;
+        uint64_t slot_mask_ = 0;
+        uint64_t max_item_num_ = 0;
+
+        // the frequency sketch for admission (count-min, in the same file)
+        uint8_t* sketch_ = NULL;
+        uint64_t sketch_mask_ = 0;
+
+        // the expired features waiting for the eviction notice
+        vector<uint64_t> expired_feature_list_;
+        size_t expired_send_pos_ = 0;
+        mutex expired_lck_;
+
         // evict feature buf
         SendMsgBuffer_t evict_feature_buf_;
 
         // for communication
-        SSLConnection* server_channel_;
-        pair<int, SSL*> server_conn_record_;
-        SSL* server_ssl_;
+        AbsTransport* server_channel_;
+        pair<int, Conn_t*> server_conn_record_;
+        Conn_t* server_ssl_;
+
+        /**
+         * @brief map the cache metadata file
+         * 
+         * @param db_name the file name
+         * @param slot_num the slot num of a new file (0: only open an existing
+         * file)
+         * @return true success
+         * @return false the file does not exist or is not a valid table
+         */
+        bool MapCacheMeta(string& db_name, uint64_t slot_num);
+
+        /**
+         * @brief unmap the cache metadata file
+         * 
+         */
+        void UnmapCacheMeta();
 
         /**
-         * @brief load cache metadata
+         * @brief rebuild the table with the configured budget (keep the latest
+         * features, evict the others)
          * 
+         * @param slot_num the new slot num
          */
-        void LoadCacheMeta();
+        void ResizeCacheMeta(uint64_t slot_num);
 
         /**
-         * @brief store cache metadata
+         * @brief get the slot num under the memory budget
          * 
+         * @return uint64_t the slot num
          */
-        void StoreCacheMeta();
+        uint64_t GetBudgetSlotNum();
 
         /**
          * @brief send a batch of features
@@ -62,9 +98,86 @@ class CacheMeta{
          */
         void SendFeatures();
 
+        /**
+         * @brief find the slot of a feature
+         * 
+         * @param feature the feature
+         * @return uint32_t the slot id (UINT32_MAX if not exist)
+         */
+        uint32_t FindSlot(uint64_t feature);
+
+        /**
+         * @brief insert a new feature at the tail of the version list
+         * 
+         * @param feature the feature
+         * @param version the version
+         */
+        void InsertSlot(uint64_t feature, uint32_t version);
+
+        /**
+         * @brief remove a feature (backward shift deletion)
+         * 
+         * @param slot_id the slot id
+         */
+        void RemoveSlot(uint32_t slot_id);
+
+        /**
+         * @brief unlink a slot from the version list
+         * 
+         * @param slot_id the slot id
+         */
+        void UnlinkSlot(uint32_t slot_id);
+
+        /**
+         * @brief append a slot to the tail of the version list
+         * 
+         * @param slot_id the slot id
+         */
+        void AppendSlot(uint32_t slot_id);
+
+        /**
+         * @brief set the version of a feature (move it to the list tail)
+         * 
+         * @param slot_id the slot id
+         */
+        void TouchSlot(uint32_t slot_id);
+
+        /**
+         * @brief evict a feature and record its eviction notice
+         * 
+         * @param slot_id the slot id
+         */
+        void EvictSlot(uint32_t slot_id);
+
+        /**
+         * @brief the home slot of a feature
+         * 
+         * @param feature the feature
+         * @return uint64_t the home slot
+         */
+        uint64_t HashSlot(uint64_t feature) {
+            return (feature * 0x9e3779b97f4a7c15ULL >> 17) & slot_mask_;
+        }
+
+        /**
+         * @brief add a feature to the frequency sketch
+         * 
+         * @param feature the feature
+         */
+        void AddFrequency(uint64_t feature);
+
+        /**
+         * @brief estimate the frequency of a feature
+         * 
+         * @param feature the feature
+         * @return uint8_t the frequency
+         */
+        uint8_t GetFrequency(uint64_t feature);
+
     public:
         // record current cache size
         uint64_t _total_similar_chunk = 0; 
+        uint64_t _total_reject_chunk = 0;
 
         /**
          * @brief Construct a new CacheMeta object
@@ -72,8 +185,8 @@ class CacheMeta{
          * @param server_channel the connection to the storage server
          * @param server_conn_record the storage server connection record
          */
-        CacheMeta(SSLConnection* server_channel,
-            pair<int, SSL*> server_conn_record);
+        CacheMeta(AbsTransport* server_channel,
+            pair<int, Conn_t*> server_conn_record);
 
         /**
          * @brief Destroy the CacheMeta object
@@ -85,8 +198,10 @@ class CacheMeta{
          * @brief insert the features to the cache
          * 
          * @param features input features
+         * @return true the features are admitted
+         * @return false the features are rejected (the table is full)
          */
-        void UpdateCacheMeta(uint64_t* features);
+        bool UpdateCacheMeta(uint64_t* features);
 
         /**
          * @brief query the cache meta to check whether it is similar?
@@ -98,7 +213,22 @@ class CacheMeta{
         bool QueryCacheMeta(uint64_t* features);
 
         /**
-         * @brief evict feature based on last_n_para_
+         * @brief start a new version and collect the expired features based on
+         * last_n_para_ (only visit the oldest features)
+         * 
+         */
+        void CollectExpiredFeature();
+
+        /**
+         * @brief send a batch of the eviction notice
+         * 
+         * @return true still has pending expired features
+         * @return false all expired features are sent
+         */
+        bool EvictFeatureBatch();
+
+        /**
+         * @brief send all pending eviction notices
          * 
          */
         void EvictFeature();
@@ -109,8 +239,8 @@ class CacheMeta{
          * @return size_t the num of feature
          */
         size_t GetFeatureNum() {
-            return feature_2_version_idx_.size();
+            return (head_ == NULL) ? 0 : head_->item_num;
         }
 };
 
-#endif
\ No newline at end of file
+#endif
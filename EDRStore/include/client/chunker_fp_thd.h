@@ -12,6 +12,8 @@
 #ifndef EDRSTORE_CHUNKER_FP_THD_H
 #define EDRSTORE_CHUNKER_FP_THD_H
 
+#include <fcntl.h>
+
 #include "../define.h"
 #include "../configure.h"
 #include "../chunker/chunker_factory.h"
@@ -19,6 +21,7 @@
 #include "../crypto/crypto_util.h"
 #include "../message_queue/mq_factory.h"
 #include "../data_structure.h"
+#include "file_index.h"
 
 using namespace std;
 
@@ -33,9 +36,52 @@ class ChunkerFPThd {
         CryptoUtil* crypto_util_;
         EVP_MD_CTX* md_ctx_;
 
+        // the chunks stored before the interrupted upload is checkpointed
+        uint64_t skip_chunk_num_ = 0;
+
+        /**
+         * @brief chunk a file and send the chunks to the output MQ
+         * 
+         * @param input_file_hdl the input file handler
+         * @param file_path the file path (to find its holes)
+         * @param output_MQ the output MQ
+         */
+        void ChunkFile(ifstream* input_file_hdl, string file_path,
+            AbsMQ<Chunk_t>* output_MQ);
+
+        /**
+         * @brief find the holes of a sparse file
+         * 
+         * @param file_path the file path
+         * @param hole_list the holes [start, end) in the file order <ret>
+         */
+        void FindHoles(string& file_path,
+            vector<pair<uint64_t, uint64_t>>& hole_list);
+
+        /**
+         * @brief send a hole as the all-zero chunks
+         * 
+         * @param hole_size the hole size
+         * @param output_MQ the output MQ
+         */
+        void SendHole(uint64_t hole_size, AbsMQ<Chunk_t>* output_MQ);
+
+        /**
+         * @brief send the end of the session recipe
+         * 
+         * @param output_MQ the output MQ
+         * @param ref_chunk_num the chunks copied from the previous recipe
+         * @param ref_size the size of the copied chunks
+         */
+        void SendEnd(AbsMQ<Chunk_t>* output_MQ, uint64_t ref_chunk_num = 0,
+            uint64_t ref_size = 0);
+
     public:
         uint64_t _total_file_size = 0;
         uint64_t _total_chunk_num = 0;
+        uint64_t _total_zero_chunk_num = 0;
+        uint64_t _total_zero_size = 0;
+        uint64_t _total_hole_size = 0; // never read
 
 #ifdef EDR_BREAKDOWN
         struct timeval _chunking_stime;
@@ -61,13 +107,35 @@ class ChunkerFPThd {
          */
         ~ChunkerFPThd();
 
+        /**
+         * @brief Set the number of leading chunks to skip (resume an
+         * interrupted upload)
+         * 
+         * @param skip_chunk_num the number of chunks
+         */
+        void SetSkipChunkNum(uint64_t skip_chunk_num) {
+            skip_chunk_num_ = skip_chunk_num;
+            return ;
+        }
+
         /**
          * @brief the main thread
          * 
          * @param input_file_hdl the input file handler
+         * @param file_path the input file path
+         * @param output_MQ the output MQ
+         */
+        void Run(ifstream* input_file_hdl, string file_path,
+            AbsMQ<Chunk_t>* output_MQ);
+
+        /**
+         * @brief the main thread of a multi-file session (all files share
+         * one recipe, the file index records the chunks of each file)
+         * 
+         * @param file_index the file index
          * @param output_MQ the output MQ
          */
-        void Run(ifstream* input_file_hdl, AbsMQ<Chunk_t>* output_MQ);
+        void RunFileList(FileIndex* file_index, AbsMQ<Chunk_t>* output_MQ);
 };
 
 #endif
\ No newline at end of file
@@ -14,7 +14,9 @@
 
 #include "two_phase_enc.h"
 #include "comp_pad.h"
-#include "../network/ssl_conn.h"
+#include "version_delta.h"
+#include "../network/abs_transport.h"
+#include "../network/wire_format.h"
 #include "../message_queue/mq_factory.h"
 #include "../configure.h"
 #include "../compression/compress_util.h"
@@ -37,9 +39,15 @@ class DataRetrieverThd {
         SendMsgBuffer_t recv_chunk_buf_;
 
         // for communication
-        SSLConnection* server_channel_;
-        pair<int, SSL*> server_conn_record_;
-        SSL* server_ssl_;
+        AbsTransport* server_channel_;
+        pair<int, Conn_t*> server_conn_record_;
+        Conn_t* server_ssl_;
+        uint32_t wire_ver_ = WIRE_FORMAT_FIXED; // negotiated at login
+        bool auth_only_ = false; // negotiated at login
+        // the connections of this session ([0] is the login one), the batch i
+        // arrives on stripe_conn_list_[i % size]
+        vector<pair<int, Conn_t*>> stripe_conn_list_;
+        uint64_t stripe_seq_ = 0;
 
         // for key recipe
         ifstream key_recipe_hdl_;
@@ -58,6 +66,10 @@ class DataRetrieverThd {
         // for delta compression
         DeltaComp* delta_comp_;
 
+        // verify the chunks restored from the client deltas
+        CryptoUtil* crypto_util_;
+        EVP_MD_CTX* md_ctx_;
+
         /**
          * @brief process a batch of chunks (Full EDR)
          * 
@@ -90,6 +102,14 @@ class DataRetrieverThd {
         void ProcCompChunk(uint8_t* input_chunk, uint32_t size,
             SendChunk_t* output_chunk, KeyRecipe_t* key_recipe);
 
+        /**
+         * @brief proc an all-zero chunk (the writer makes a hole)
+         * 
+         * @param input_chunk input chunk (its size)
+         * @param output_chunk output chunk
+         */
+        void ProcZeroChunk(uint8_t* input_chunk, SendChunk_t* output_chunk);
+
         /**
          * @brief proc an un-comp chunk
          * 
@@ -112,6 +132,20 @@ class DataRetrieverThd {
         void ProcRestoreBaseChunk(uint8_t* input_chunk, uint32_t size,
             SendChunk_t* restore_chunk, KeyRecipe_t* key_recipe);
 
+        /**
+         * @brief process a client delta and its base chunk
+         * 
+         * @param delta_chunk the encrypted delta
+         * @param delta_size the delta size
+         * @param base_chunk the encrypted base chunk
+         * @param base_size the base chunk size
+         * @param output_chunk output chunk
+         * @param key_recipe key recipe (of the delta)
+         */
+        void ProcVersionDeltaChunk(uint8_t* delta_chunk, uint32_t delta_size,
+            uint8_t* base_chunk, uint32_t base_size, SendChunk_t* output_chunk,
+            KeyRecipe_t* key_recipe);
+
         /**
          * @brief fetch key recipe
          * 
@@ -124,6 +158,22 @@ class DataRetrieverThd {
          */
         void ProcessEndFlag();
 
+        /**
+         * @brief open the extra stripe connections of this session
+         * 
+         * @param stripe_num the number of connections
+         * @param stripe_token the session token from the server
+         */
+        void JoinStripes(uint32_t stripe_num, uint64_t stripe_token);
+
+        /**
+         * @brief switch a connection to the authenticated-only data frames
+         * after its login response (if negotiated)
+         * 
+         * @param conn the connection
+         */
+        void EnableAuthOnly(Conn_t* conn);
+
     public:
         uint64_t _total_recv_chunk_num = 0;
         uint64_t _total_recv_data_size = 0;
@@ -136,7 +186,7 @@ class DataRetrieverThd {
          * @param file_name_hash file name hash
          * @param method_type method type
          */
-        DataRetrieverThd(SSLConnection* server_channel, pair<int, SSL*>
+        DataRetrieverThd(AbsTransport* server_channel, pair<int, Conn_t*>
             server_conn_record, uint8_t* file_name_hash,
             uint32_t method_type);
 
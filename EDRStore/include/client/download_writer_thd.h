@@ -15,17 +15,59 @@
 #include "../configure.h"
 #include "../message_queue/mq_factory.h"
 #include "../data_structure.h"
+#include "file_index.h"
 
 class DownloadWriterThd {
     private:
         string my_name_ = "DownloadWriterThd";
 
         // download file
-        FILE* download_file_hdl_;
+        FILE* download_file_hdl_ = NULL;
+        // stdout or a pipe, cannot be synced
+        bool is_stream_ = false;
+        // the current file ends with a hole (set its size at the close)
+        bool is_hole_end_ = false;
+
+        // for a multi-file session (NULL: a single file)
+        FileIndex* file_index_ = NULL;
+        string output_root_;
+        size_t cur_file_idx_ = 0;
+        uint64_t remain_chunk_num_ = 0;
+
+        /**
+         * @brief close the current file and open the next one with chunks
+         * (create the empty files on the way)
+         * 
+         * @return true a file is opened
+         */
+        bool OpenNextFile();
+
+        /**
+         * @brief create a restored file (and its parent directories)
+         * 
+         * @param entry the file entry
+         * @return FILE* the file handler
+         */
+        FILE* CreateFile(FileIndexEntry_t& entry);
+
+        /**
+         * @brief write an all-zero chunk (a hole in a file, zeros in a
+         * stream)
+         * 
+         * @param size the chunk size
+         */
+        void WriteZeroChunk(uint32_t size);
+
+        /**
+         * @brief extend the current file to its end if it ends with a hole
+         * 
+         */
+        void FinishHole();
 
     public:
         uint64_t _total_write_data_size = 0;
         uint64_t _total_write_chunk_num = 0;
+        uint64_t _total_hole_size = 0;
 
         /**
          * @brief Construct a new DownloadWriterThd object
@@ -34,6 +76,24 @@ class DownloadWriterThd {
          */
         DownloadWriterThd(string file_name);
 
+        /**
+         * @brief Construct a new DownloadWriterThd object for a multi-file
+         * session
+         * 
+         * @param file_name the session name (restored to a directory)
+         * @param file_index the file index
+         */
+        DownloadWriterThd(string file_name, FileIndex* file_index);
+
+        /**
+         * @brief Construct a new DownloadWriterThd object for a stream (stdout
+         * or a pipe), the chunks are written in the recipe order as they
+         * arrive
+         * 
+         * @param stream_hdl the stream handler (closed at the end)
+         */
+        DownloadWriterThd(FILE* stream_hdl);
+
         /**
          * @brief Destroy the DownloadWriterThd object
          * 
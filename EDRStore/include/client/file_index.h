@@ -0,0 +1,146 @@
+/**
+ * @file file_index.h
+ * @brief define the interfaces of FileIndex (the per-file recipe index of a
+ * multi-file session)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef EDRSTORE_FILE_INDEX_H
+#define EDRSTORE_FILE_INDEX_H
+
+#include "../define.h"
+#include "../configure.h"
+#include "../data_structure.h"
+
+extern Configure config;
+
+// a file of the session, its chunks are the next chunk_num chunks of the
+// session recipe
+typedef struct {
+    string name; // the relative path (directory) or the given path (list)
+    uint64_t chunk_num;
+    uint64_t size;
+    // the metadata to detect unchanged files
+    uint64_t mtime; // ns
+    uint64_t inode;
+    bool is_ref; // unchanged, its chunks are copied from the previous recipe
+} FileIndexEntry_t;
+
+class FileIndex {
+    private:
+        string my_name_ = "FileIndex";
+
+        // the index file
+        string index_path_;
+
+        // the directory of the relative names (empty for a file list)
+        string root_path_;
+
+        /**
+         * @brief fill the metadata of a file
+         *
+         * @param entry the file entry
+         */
+        void StatFile(FileIndexEntry_t& entry);
+
+    public:
+        vector<FileIndexEntry_t> _entry_list;
+
+        // the ranges of the previous recipe used by the unchanged files
+        vector<RecipeRef_t> _ref_list;
+        uint64_t _ref_file_num = 0;
+        uint64_t _ref_chunk_num = 0;
+        uint64_t _ref_size = 0;
+
+        /**
+         * @brief Construct a new FileIndex object
+         *
+         * @param file_name_hash the session name hash
+         */
+        FileIndex(uint8_t* file_name_hash);
+
+        /**
+         * @brief Destroy the FileIndex object
+         *
+         */
+        ~FileIndex();
+
+        /**
+         * @brief add all regular files under a directory (sorted by path)
+         *
+         * @param dir_path the directory path
+         */
+        void AddDirectory(string dir_path);
+
+        /**
+         * @brief add the files in a file list (one path per line)
+         *
+         * @param list_path the file list path
+         */
+        void AddFileList(string list_path);
+
+        /**
+         * @brief get the source path of a file
+         *
+         * @param entry the file entry
+         * @return string the source path
+         */
+        string GetSourcePath(FileIndexEntry_t& entry);
+
+        /**
+         * @brief get the restore path of a file
+         *
+         * @param entry the file entry
+         * @param output_root the output directory
+         * @return string the restore path
+         */
+        string GetRestorePath(FileIndexEntry_t& entry, string& output_root);
+
+        /**
+         * @brief find the files that are unchanged since the previous version
+         * of this session, and move them to the end of the session (their
+         * chunks are the ranges of the previous recipe)
+         *
+         * @param prev_index the file index of the previous version
+         */
+        void MatchPrevious(FileIndex* prev_index);
+
+        /**
+         * @brief get the metadata of all files in the session order (detect
+         * the changed input of an interrupted upload)
+         *
+         * @return string the metadata
+         */
+        string GetStamp();
+
+        /**
+         * @brief check whether the session has a file index
+         *
+         * @return true a multi-file session
+         */
+        bool Exist();
+
+        /**
+         * @brief store the index after the upload
+         *
+         */
+        void Store();
+
+        /**
+         * @brief load the index before the restore
+         *
+         */
+        void Load();
+
+        /**
+         * @brief remove the index (the session is a single file now)
+         *
+         */
+        void Remove();
+};
+
+#endif
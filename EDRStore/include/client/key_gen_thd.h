@@ -14,7 +14,8 @@
 
 #include "../message_queue/mq_factory.h"
 #include "../data_structure.h"
-#include "../network/ssl_conn.h"
+#include "../network/abs_transport.h"
+#include "../network/batch_tuner.h"
 #include "../configure.h"
 #include "../client/two_phase_enc.h"
 #include "../database/db_factory.h"
@@ -26,7 +27,7 @@ class KeyGenThd {
         string my_name_ = "KeyGenThd";
 
         // config
-        uint64_t send_chunk_batch_size_ = 0;
+        uint64_t max_batch_size_ = 0;
         SendMsgBuffer_t send_buf_;
         SendMsgBuffer_t recv_buf_;
 
@@ -34,9 +35,10 @@ class KeyGenThd {
         vector<EncFeatureChunk_t> chunk_buf_;
 
         // for communication
-        SSLConnection* km_channel_;
-        pair<int, SSL*> km_conn_record_;
-        SSL* km_ssl_;
+        AbsTransport* km_channel_;
+        pair<int, Conn_t*> km_conn_record_;
+        Conn_t* km_ssl_;
+        BatchTuner* batch_tuner_;
 
         // two-phase encryption 
         TwoPhaseEnc* two_phase_enc_;
@@ -78,7 +80,7 @@ class KeyGenThd {
          * @param km_channel the key manager connection channel
          * @param km_conn_record the key manager connection channel
          */
-        KeyGenThd(SSLConnection* km_channel, pair<int, SSL*> km_conn_record);
+        KeyGenThd(AbsTransport* km_channel, pair<int, Conn_t*> km_conn_record);
 
         /**
          * @brief Destroy the KeyGenThd object
@@ -15,6 +15,7 @@
 #include "two_phase_enc.h"
 #include "comp_pad.h"
 #include "cache_meta.h"
+#include "version_delta.h"
 #include "../reduction/similar_policy.h"
 #include "../data_structure.h"
 #include "../message_queue/mq_factory.h"
@@ -39,6 +40,29 @@ class SelectCompThd {
         CryptoUtil* crypto_util_;
         EVP_MD_CTX* md_ctx;
 
+        // the delta against the previous version (NULL: disabled)
+        VersionDelta* version_delta_ = NULL;
+
+        /**
+         * @brief delta-encode a chunk against the previous version
+         * 
+         * @param input_chunk input chunk
+         * @param output_chunk output chunk
+         * @return true the chunk is sent as a delta
+         * @return false the chunk is sent in full
+         */
+        bool VersionDeltaMode(EncFeatureChunk_t* input_chunk,
+            SelectComp2Sender_t* output_chunk);
+
+        /**
+         * @brief an all-zero chunk: only its size is sent
+         * 
+         * @param input_chunk input chunk
+         * @param output_chunk output chunk
+         */
+        void ZeroChunk(EncFeatureChunk_t* input_chunk,
+            SelectComp2Sender_t* output_chunk);
+
         /**
          * @brief only enc mode
          * 
@@ -93,6 +117,13 @@ class SelectCompThd {
          */
         ~SelectCompThd();
 
+        /**
+         * @brief Set the version delta
+         * 
+         * @param version_delta the version delta
+         */
+        void SetVersionDelta(VersionDelta* version_delta);
+
         /**
          * @brief the main thread
          * 
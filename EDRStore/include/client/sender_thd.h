@@ -12,10 +12,16 @@
 #ifndef EDRSTORE_SENDER_THD_H
 #define EDRSTORE_SENDER_THD_H
 
+#include <mutex>
+#include <condition_variable>
+
 #include "../configure.h"
-#include "../network/ssl_conn.h"
+#include "../network/abs_transport.h"
+#include "../network/wire_format.h"
+#include "../network/batch_tuner.h"
 #include "../data_structure.h"
 #include "../message_queue/mq_factory.h"
+#include "../crypto/crypto_util.h"
 #include "two_phase_enc.h"
 #include "cache_meta.h"
 
@@ -27,36 +33,129 @@ class SenderThd {
 
         // config
         uint64_t send_chunk_batch_size_ = 0;
-        uint64_t send_recipe_batch_size_ = 0;
+        uint64_t max_batch_size_ = 0; // the batch buffers are sized by it
         uint32_t client_id_;
 
-        // the send chunk buf
-        SendMsgBuffer_t send_chunk_buf_;
+        // the batch buffers exchanged with the I/O threads (one per stripe),
+        // the batch i goes through the stripe i % stripe_num_
+        vector<SendBatch_t> batch_list_;
+        vector<AbsMQ<SendBatch_t*>*> free_batch_mq_;
+        vector<AbsMQ<SendBatch_t*>*> full_batch_mq_;
+        SendBatch_t* cur_batch_ = NULL;
+        uint64_t batch_seq_ = 0;
 
         // for communication
-        SSLConnection* server_channel_;
-        pair<int, SSL*> server_conn_record_;
-        SSL* server_ssl_;
+        AbsTransport* server_channel_;
+        pair<int, Conn_t*> server_conn_record_;
+        Conn_t* server_ssl_;
+        uint32_t wire_ver_ = WIRE_FORMAT_FIXED; // negotiated at login
+        bool auth_only_ = false; // negotiated at login
+        // the connections of this session ([0] is the login one)
+        vector<pair<int, Conn_t*>> stripe_conn_list_;
+        uint32_t stripe_num_ = 1;
+        // the chunk num of a batch, shared by the stripes
+        BatchTuner* batch_tuner_ = NULL;
+
+        // the key recipes are written in the batch order, an I/O thread
+        // sleeps until its turn
+        uint64_t key_recipe_turn_ = 0;
+        std::mutex key_recipe_mtx_;
+        std::condition_variable key_recipe_cv_;
+        std::mutex stat_lck_;
+        uint32_t io_thd_num_ = 0;
 
         // the master key
         uint8_t master_key_[CHUNK_HASH_SIZE] = {0};
 
-        // for key recipe
+        // for key recipe (written by the I/O thread to a tmp file until the
+        // end)
+        string key_recipe_path_;
         ofstream key_recipe_hdl_;
-        BatchBuf_t key_recipe_buf_;
+
+        // the unchanged files (copy the ranges of the previous recipes)
+        ifstream prev_key_recipe_hdl_;
+        vector<RecipeRef_t>* ref_list_ = NULL;
 
         // for re-encryption
         TwoPhaseEnc* two_phase_enc_;
 
         // cache meta
         CacheMeta* cache_meta_;
-        
+        uint32_t method_type_;
+        bool evict_pending_ = false;
+
+        // for the fingerprint-first upload
+        bool fp_first_ = false; // confirmed by the server at login
+        bool cache_pair_pending_ = false; // the next chunk is a cache pair
+        CryptoUtil* crypto_util_;
+        EVP_MD_CTX* md_ctx_;
+        vector<uint8_t*> bitmap_buf_; // per stripe
+
+        // for the upload checkpoints
+        uint64_t ckpt_size_ = 0; // bytes between two checkpoints (0: none)
+        uint64_t ckpt_pending_size_ = 0;
+        uint64_t resume_chunk_num_ = 0; // asked at login, granted by the server
+        string input_stamp_; // the hash of the input metadata
+
+        // for the credit-based flow control (per stripe, in bytes)
+        uint64_t credit_window_ = 0; // granted at login (0: no flow control)
+        vector<uint64_t> credit_list_;
+        vector<bool> credit_req_list_; // a credit request is pending
+
+        /**
+         * @brief allocate the batch buffers of the negotiated stripes
+         * 
+         */
+        void InitBatches();
+
+        /**
+         * @brief open the extra stripe connections of this session
+         * 
+         * @param stripe_token the session token from the server
+         */
+        void JoinStripes(uint64_t stripe_token);
+
+        /**
+         * @brief switch a connection to the authenticated-only data frames
+         * after its login response (if negotiated)
+         * 
+         * @param conn the connection
+         */
+        void EnableAuthOnly(Conn_t* conn);
+
+        /**
+         * @brief open the tmp key recipe (keep the keys of the resumed chunks)
+         * 
+         */
+        void OpenKeyRecipe();
+
         /**
-         * @brief send a batch of chunk
+         * @brief hand over the current batch to the I/O thread and get a
+         * free one
          * 
          */
         void SendChunks();
 
+        /**
+         * @brief hand over the current batch to the I/O thread (with its
+         * message type set) and get a free one
+         * 
+         */
+        void PushBatch();
+
+        /**
+         * @brief send the ranges of the previous recipe
+         * 
+         */
+        void SendRecipeRef();
+
+        /**
+         * @brief copy the key recipes of the ranges in a batch
+         * 
+         * @param batch the batch
+         */
+        void CopyKeyRecipe(SendBatch_t* batch);
+
         /**
          * @brief store the key recipe
          * 
@@ -70,10 +169,84 @@ class SenderThd {
          * @param key_recipe the ptr to the key recipe
          */
         void StoreKeyRecipe(KeyRecipe_t* key_recipe); 
+
+        /**
+         * @brief copy a chunk to the current batch
+         * 
+         * @param send_chunk the chunk
+         */
+        void AppendChunk(SendChunk_t* send_chunk);
+
+        /**
+         * @brief add the fp query of a chunk to the current batch
+         * 
+         * @param header the chunk header
+         * @param data the chunk payload (ciphertext)
+         */
+        void AddFpQuery(SendChunkHeader_t* header, uint8_t* data);
+
+        /**
+         * @brief send the fp queries of a batch, and drop the payloads that
+         * the server already has
+         * 
+         * @param batch the batch
+         * @param stripe_id the stripe of the batch
+         */
+        void QueryFp(SendBatch_t* batch, uint32_t stripe_id);
+
+        /**
+         * @brief wait for the checkpoint ack, and flush the keys of the
+         * acknowledged chunks
+         * 
+         * @param stripe_id the stripe of the checkpoint
+         */
+        void WaitCheckpoint(uint32_t stripe_id);
+
+        /**
+         * @brief take the credit of a chunk batch, wait for the server to
+         * grant more if it is not enough
+         * 
+         * @param stripe_id the stripe of the batch
+         * @param batch_size the batch size
+         */
+        void AcquireCredit(uint32_t stripe_id, uint32_t batch_size);
+
+        /**
+         * @brief ask the server to top up the credit of a stripe
+         * 
+         * @param stripe_id the stripe id
+         */
+        void RequestCredit(uint32_t stripe_id);
+
+        /**
+         * @brief wait for the credit grant of a stripe
+         * 
+         * @param stripe_id the stripe id
+         */
+        void WaitCredit(uint32_t stripe_id);
+
+        /**
+         * @brief receive a reply of the server, the credit grant ahead of it
+         * is taken on the way
+         * 
+         * @param stripe_id the stripe id
+         * @param buf the reply buffer
+         * @param recv_size the reply size <ret>
+         * @return true success
+         * @return false fail
+         */
+        bool ReceiveReply(uint32_t stripe_id, uint8_t* buf,
+            uint32_t& recv_size);
     
     public:
         uint64_t _total_send_data_size = 0;
         uint64_t _cur_version_idx_size = 0;
+        double _total_io_time = 0;
+        uint64_t _total_skip_chunk_num = 0;
+        uint64_t _total_skip_data_size = 0;
+        uint64_t _total_ckpt_num = 0;
+        uint64_t _acked_chunk_num = 0;
+        uint64_t _total_credit_wait_num = 0; // the batches out of credit
 
         /**
          * @brief Construct a new SenderThd object
@@ -82,9 +255,10 @@ class SenderThd {
          * @param server_conn_record the storage server connection record
          * @param file_name_hash the file name hash
          * @param cache_meta cache meta 
+         * @param method_type method type
          */
-        SenderThd(SSLConnection* server_channel, pair<int, SSL*> server_conn_record,
-            uint8_t* file_name_hash, CacheMeta* cache_meta);
+        SenderThd(AbsTransport* server_channel, pair<int, Conn_t*> server_conn_record,
+            uint8_t* file_name_hash, CacheMeta* cache_meta, uint32_t method_type);
 
         /**
          * @brief Destroy the SenderThd object
@@ -103,12 +277,55 @@ class SenderThd {
         }
 
         /**
-         * @brief the main thread
+         * @brief Set the ranges of the previous recipe used by the unchanged
+         * files
+         * 
+         * @param ref_list the range list
+         */
+        void SetRecipeRef(vector<RecipeRef_t>* ref_list);
+
+        /**
+         * @brief Set the input metadata, an interrupted upload of the same
+         * input is resumed (call it before the login)
+         * 
+         * @param input_stamp the metadata of the input files (empty: never
+         * resumed)
+         */
+        void SetInputStamp(string& input_stamp);
+
+        /**
+         * @brief Get the number of chunks kept from the interrupted upload
+         * 
+         * @return uint64_t the resumed chunk num (valid after login)
+         */
+        uint64_t GetResumeChunkNum() {
+            return resume_chunk_num_;
+        }
+
+        /**
+         * @brief the main thread (assemble the batches)
          * 
          * @param the input MQ
          */
         void Run(AbsMQ<SelectComp2Sender_t>* input_MQ);
 
+        /**
+         * @brief the I/O thread of a stripe (send the batches and write the
+         * key recipe)
+         * 
+         * @param stripe_id the stripe id
+         */
+        void RunIO(uint32_t stripe_id);
+
+        /**
+         * @brief Get the number of stripes (I/O threads)
+         * 
+         * @return uint32_t the stripe num (valid after login)
+         */
+        uint32_t GetStripeNum() {
+            return stripe_num_;
+        }
+
         /**
          * @brief upload login with the file name hash
          * 
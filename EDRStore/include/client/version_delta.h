@@ -0,0 +1,151 @@
+/**
+ * @file version_delta.h
+ * @brief define the interfaces of VersionDelta (delta-encode a chunk against
+ * the previous version of the session before encryption)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef EDRSTORE_VERSION_DELTA_H
+#define EDRSTORE_VERSION_DELTA_H
+
+#include "../define.h"
+#include "../configure.h"
+#include "../data_structure.h"
+#include "../crypto/crypto_util.h"
+#include "../chunker/xxhash64.h"
+
+extern Configure config;
+
+// the delta ops after the delta head
+enum VERSION_DELTA_OP_SET {VERSION_DELTA_COPY = 0, VERSION_DELTA_LITERAL};
+
+class VersionDelta {
+    private:
+        string my_name_ = "VersionDelta";
+
+        // the signature file of this session
+        string sig_path_;
+
+        // the signature of the previous version, read on demand
+        ifstream prev_sig_hdl_;
+        uint64_t prev_chunk_num_ = 0;
+
+        // super-feature -> the chunk of the previous version (sorted)
+        vector<pair<uint64_t, uint64_t>> feature_idx_;
+
+        // the signature of this version
+        ofstream sig_hdl_;
+        uint64_t chunk_num_ = 0;
+
+        // for the ciphertext fp
+        CryptoUtil* crypto_util_;
+        EVP_MD_CTX* md_ctx_;
+
+        /**
+         * @brief compute the rolling checksum of a block
+         *
+         * @param data the block
+         * @param a the sum of the bytes <ret>
+         * @param b the weighted sum of the bytes <ret>
+         */
+        void WeakSum(uint8_t* data, uint32_t& a, uint32_t& b);
+
+        /**
+         * @brief read a signature of the previous version
+         *
+         * @param idx the chunk index in the previous version
+         * @param sig the signature <ret>
+         * @return true success
+         */
+        bool ReadSig(uint64_t idx, VersionSig_t* sig);
+
+        /**
+         * @brief find a chunk of the previous version sharing a super-feature
+         *
+         * @param features the plaintext super-features
+         * @param base_sig the signature of the base chunk <ret>
+         * @return true found
+         */
+        bool FindBase(uint64_t* features, VersionSig_t* base_sig);
+
+    public:
+        uint64_t _total_delta_chunk_num = 0;
+        uint64_t _total_delta_src_size = 0; // the chunk size before the delta
+        uint64_t _total_delta_size = 0;
+
+        /**
+         * @brief Construct a new VersionDelta object
+         *
+         * @param file_name_hash the session name hash
+         */
+        VersionDelta(uint8_t* file_name_hash);
+
+        /**
+         * @brief Destroy the VersionDelta object
+         *
+         */
+        ~VersionDelta();
+
+        /**
+         * @brief delta-encode a chunk against the previous version
+         *
+         * @param input_chunk the chunk
+         * @param delta the delta (plaintext) <ret>
+         * @param delta_size the delta size <ret>
+         * @param base_sig the signature of the base chunk <ret>
+         * @return true the delta is small enough to send
+         */
+        bool EncodeChunk(EncFeatureChunk_t* input_chunk, uint8_t* delta,
+            uint32_t& delta_size, VersionSig_t* base_sig);
+
+        /**
+         * @brief add the signature of a chunk of this version (in the recipe
+         * order)
+         *
+         * @param input_chunk the chunk
+         * @param base_sig the signature of its base if it is sent as a delta
+         * (NULL: sent in full)
+         */
+        void AddChunk(EncFeatureChunk_t* input_chunk, VersionSig_t* base_sig);
+
+        /**
+         * @brief add the signature of an all-zero chunk of this version (never
+         * a base)
+         *
+         */
+        void AddZeroChunk();
+
+        /**
+         * @brief copy the signatures of the unchanged files, and replace the
+         * previous signature
+         *
+         * @param ref_list the ranges of the previous recipe
+         */
+        void Commit(vector<RecipeRef_t>* ref_list);
+
+        /**
+         * @brief drop the signature of this version (it misses the chunks
+         * before the resumed point), keep the previous one
+         *
+         */
+        void Discard();
+
+        /**
+         * @brief decode a delta with its base chunk
+         *
+         * @param base the base chunk (plaintext)
+         * @param base_size the base chunk size
+         * @param delta the delta ops (after the delta head)
+         * @param delta_size the size of the delta ops
+         * @param output the restored chunk <ret>
+         * @return uint32_t the restored chunk size (0: malformed delta)
+         */
+        static uint32_t DecodeDelta(uint8_t* base, uint32_t base_size,
+            uint8_t* delta, uint32_t delta_size, uint8_t* output);
+};
+
+#endif
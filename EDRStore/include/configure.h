@@ -33,20 +33,31 @@ class Configure {
 
         // similar config 
         uint64_t similar_sliding_win_size_;
+        uint64_t max_delta_depth_;
+        bool prefer_local_base_;
+        uint64_t candidate_num_;
+        uint64_t min_predicted_gain_;
 
         // storage server settings
         string storage_server_ip_;
         int storage_server_port_;
+        int storage_server_transport_;
+        string storage_server_unix_path_;
         string recipe_root_path_;
         string container_root_path_;
         string cache_root_path_;
         string fp_2_chunk_db_;
         string feature_2_fp_db_;
         uint64_t container_cache_size_;
+        uint64_t delta_worker_num_;
+        uint64_t session_worker_num_;
+        uint64_t session_mem_budget_;
 
         // key manager settings
         string km_ip_;
         int km_port_;
+        int km_transport_;
+        string km_unix_path_;
         string feature_2_key_db_;
 
         // client settings
@@ -54,11 +65,33 @@ class Configure {
         uint64_t send_chunk_batch_size_;
         uint64_t send_recipe_batch_size_;
         string user_key_;
+        uint64_t cache_meta_budget_;
+        bool fp_first_upload_;
+        uint32_t stripe_num_;
+        bool skip_unchanged_file_;
+        uint64_t checkpoint_size_; // MiB, 0: no checkpoint
+        uint64_t restore_window_; // MiB
+        bool version_delta_;
+        bool adaptive_batch_;
+        uint64_t min_batch_size_;
+        uint64_t max_batch_size_; // the peer buffers are sized by it
+
+        // network settings
+        bool enable_ktls_;
+        bool session_resumption_;
+        uint64_t session_lifetime_;
+        bool auth_only_data_;
 
         // const 
         string recipe_suffix_ = "-recipe";
         string container_suffix_ = "-container";
         string key_recipe_suffix_ = "-key";
+        string file_index_suffix_ = "-index";
+        string tmp_suffix_ = "-tmp";
+        string ckpt_suffix_ = "-ckpt";
+        string journal_suffix_ = "-journal";
+        string version_sig_suffix_ = "-sig";
+        string sketch_suffix_ = "-sketch";
 
         /**
          * @brief parse the json file
@@ -106,6 +139,18 @@ class Configure {
         uint64_t GetSimilarSlidingWinSize() {
             return similar_sliding_win_size_;
         }
+        uint64_t GetMaxDeltaDepth() {
+            return max_delta_depth_;
+        }
+        bool GetPreferLocalBase() {
+            return prefer_local_base_;
+        }
+        uint64_t GetCandidateNum() {
+            return candidate_num_;
+        }
+        uint64_t GetMinPredictedGain() {
+            return min_predicted_gain_;
+        }
 
         // storage management settings
         string GetStorageServerIP() {
@@ -114,6 +159,12 @@ class Configure {
         int GetStorageServerPort() {
             return storage_server_port_;
         }
+        int GetStorageServerTransport() {
+            return storage_server_transport_;
+        }
+        string GetStorageServerUnixPath() {
+            return storage_server_unix_path_;
+        }
         string GetRecipeRootPath() {
             return recipe_root_path_;
         }
@@ -132,6 +183,15 @@ class Configure {
         uint64_t GetContainerCacheSize() {
             return container_cache_size_;
         }
+        uint64_t GetDeltaWorkerNum() {
+            return delta_worker_num_;
+        }
+        uint64_t GetSessionWorkerNum() {
+            return session_worker_num_;
+        }
+        uint64_t GetSessionMemBudget() {
+            return session_mem_budget_;
+        }
 
         // key management settings
         string GetKeyServerIP() {
@@ -140,6 +200,12 @@ class Configure {
         int GetKeyServerPort() {
             return km_port_;
         }
+        int GetKeyServerTransport() {
+            return km_transport_;
+        }
+        string GetKeyServerUnixPath() {
+            return km_unix_path_;
+        }
         string GetFeature2KeyDBName() {
             return feature_2_key_db_;
         }
@@ -157,6 +223,50 @@ class Configure {
         string GetUserKey() {
             return user_key_;
         }
+        uint64_t GetCacheMetaBudget() {
+            return cache_meta_budget_;
+        }
+        bool GetFpFirstUpload() {
+            return fp_first_upload_;
+        }
+        uint32_t GetStripeNum() {
+            return stripe_num_;
+        }
+        bool GetSkipUnchangedFile() {
+            return skip_unchanged_file_;
+        }
+        uint64_t GetCheckpointSize() {
+            return checkpoint_size_;
+        }
+        uint64_t GetRestoreWindow() {
+            return restore_window_;
+        }
+        bool GetVersionDelta() {
+            return version_delta_;
+        }
+        bool GetAdaptiveBatch() {
+            return adaptive_batch_;
+        }
+        uint64_t GetMinBatchSize() {
+            return min_batch_size_;
+        }
+        uint64_t GetMaxBatchSize() {
+            return max_batch_size_;
+        }
+
+        // network settings
+        bool GetEnableKTLS() {
+            return enable_ktls_;
+        }
+        bool GetSessionResumption() {
+            return session_resumption_;
+        }
+        uint64_t GetSessionLifetime() {
+            return session_lifetime_;
+        }
+        bool GetAuthOnlyData() {
+            return auth_only_data_;
+        }
 
         // global
         string GetRecipeSuffix() {
@@ -168,6 +278,24 @@ class Configure {
         string GetKeyRecipeSuffix() {
             return key_recipe_suffix_;
         }
+        string GetFileIndexSuffix() {
+            return file_index_suffix_;
+        }
+        string GetTmpSuffix() {
+            return tmp_suffix_;
+        }
+        string GetCkptSuffix() {
+            return ckpt_suffix_;
+        }
+        string GetJournalSuffix() {
+            return journal_suffix_;
+        }
+        string GetVersionSigSuffix() {
+            return version_sig_suffix_;
+        }
+        string GetSketchSuffix() {
+            return sketch_suffix_;
+        }
 };
 
 #endif
\ No newline at end of file
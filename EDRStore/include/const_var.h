@@ -21,6 +21,7 @@ static const size_t MAX_CHUNK_SIZE = (1 << 14);
 
 static const uint32_t CHUNK_QUEUE_SIZE = (1024 * 4);
 static const size_t THREAD_STACK_SIZE = (8*1024*1024);
+static const uint32_t SEND_BATCH_BUF_NUM = 3; // the batch buffers in the sender
 
 // sketch & super-feature & feature settings
 static const uint32_t SUPER_FEATURE_PER_CHUNK = 3; // 3 super-feature per chunk 
@@ -28,13 +29,28 @@ static const uint32_t FEATURE_PER_SUPER_FEATURE = 4; // 4 features per super-fea
 static const uint32_t FEATURE_PER_CHUNK = SUPER_FEATURE_PER_CHUNK * 
     FEATURE_PER_SUPER_FEATURE; // 12 total features per chunk
 
+// the max delta chain depth the restore path can decode
+// (cache delta chunk -> delta base chunk -> base chunk)
+static const uint32_t MAX_DELTA_DEPTH = 2;
+
+// the sampled fingerprint sketch to predict the delta size
+static const uint32_t SKETCH_SAMPLE_NUM = 16;
+static const uint32_t SKETCH_SAMPLE_MASK = 0x1f; // sample 1/32 shingles
+
+// the flat client cache metadata table
+static const uint64_t CACHE_META_MAGIC = 0x454452434d455441ULL;
+static const uint32_t CACHE_META_NIL = UINT32_MAX;
+static const uint32_t CACHE_META_SKETCH_ROW = 4;
+static const uint8_t CACHE_META_SKETCH_MAX = 15;
+
 // for rabin fingerprint
 static const uint64_t FINGERPRINT_PT = 0xbfe6b8a5bf378d83LL;
 
 // data type enum
 enum DATA_TYPE_SET {NORMAL_CHUNK = 0, COMPRESSED_NORMAL_CHUNK, RECIPE_CHUNK,
     FULL_EDR_CACHE_CHUNK, FULL_EDR_UNCOMPRESS_CHUNK, CACHE_RESTORE_DELTA,
-    CACHE_RESTORE_BASE, COMP_NORMAL_CHUNK, UNCOMP_NORMAL_CHUNK};
+    CACHE_RESTORE_BASE, COMP_NORMAL_CHUNK, UNCOMP_NORMAL_CHUNK, FP_REF_CHUNK,
+    CLIENT_DELTA_CHUNK, CLIENT_RESTORE_DELTA, ZERO_CHUNK};
 
 // for crypto info 
 enum ENCRYPT_SET {AES_256_GCM = 0, AES_128_GCM, AES_256_CFB, AES_128_CFB,
@@ -67,12 +83,29 @@ enum NETWORK_PROTOCOL_SET {CLIENT_LOGIN_UPLOAD = 0, CLIENT_LOGIN_DOWNLOAD,
     CLIENT_UPLOAD_RECIPE_END, SERVER_FILE_NON_EXIST, SERVER_RESTORE_RECIPE,
     CLIENT_RESTORE_READY, CLIENT_KEY_GEN, KEY_MANAGER_KEY_GEN_REPLY,
     CLIENT_RESTORE_RECIPE_REPLY, SERVER_RESTORE_CHUNK, SERVER_RESTORE_FINAL,
-    CLIENT_UPLOAD_FEATURE};
+    CLIENT_UPLOAD_FEATURE, CLIENT_UPLOAD_FP, SERVER_FP_BITMAP,
+    CLIENT_LOGIN_STRIPE, CLIENT_UPLOAD_RECIPE_REF, CLIENT_UPLOAD_CHECKPOINT,
+    SERVER_CHECKPOINT_ACK, CLIENT_CREDIT_REQUEST, SERVER_CREDIT_GRANT};
+
+// the chunk batch wire format (negotiated at login, the lower one wins)
+enum WIRE_FORMAT_SET {WIRE_FORMAT_FIXED = 0, WIRE_FORMAT_COMPACT};
+static const uint32_t WIRE_FORMAT_VERSION = WIRE_FORMAT_COMPACT; // the newest one
+static const uint32_t MAX_VARINT32_SIZE = 5;
+
+// connection striping of a session
+static const uint32_t MAX_STRIPE_NUM = 16;
+static const uint32_t STRIPE_JOIN_TIMEOUT = 30; // sec
+
+// the connection reactor of the storage server: the max time from the accept
+// to the login message, and the max events per wait
+static const uint32_t CONN_LOGIN_TIMEOUT = 30; // sec
+static const uint32_t REACTOR_EVENT_NUM = 256;
 
 enum CHUNK_STATUS_SET {UNIQUE_CHUNK = 0, UNIQUE_CHUNK_AFTER_CACHE, DUPLICATE_CHUNK, SIMILAR_CHUNK,
     NON_SIMILAR_CHUNK, COMP_DELTA_CHUNK, UNCOMP_DELTA_CHUNK, COMP_BASE_CHUNK,
     UNCOMP_BASE_CHUNK, CACHE_INSERT_CHUNK, CACHE_DELTA_CHUNK, CACHE_EVICT_CHUNK,
-    MULTI_LEVEL_DELTA_CHUNK, CHUNK_PAIR, SINGLE_CHUNK};
+    MULTI_LEVEL_DELTA_CHUNK, CHUNK_PAIR, SINGLE_CHUNK, CHECKPOINT_MARK,
+    VERSION_DELTA_CHUNK, ZERO_RECIPE_CHUNK};
 
 // for SSL connection 
 static const char SERVER_CERT[] = "../key/server/server.crt";
@@ -81,6 +114,18 @@ static const char CLIENT_CERT[] = "../key/client/client.crt";
 static const char CLIENT_KEY[] = "../key/client/client.key";
 static const char CA_CERT[] = "../key/ca/ca.crt";
 
+// the session tickets: the context of the servers, and the ticket file of the
+// client (+ <ip>-<port>)
+static const char SSL_SESSION_ID_CTX[] = "EDRStore";
+static const char SESSION_FILE_PREFIX[] = "tls-session-";
+
+// the authenticated-only data frames: the exporter label of their keys, and
+// the AES-256-GCM key, nonce and tag sizes
+static const char AUTH_ONLY_LABEL[] = "EXPORTER-EDRStore-auth-only";
+static const uint32_t AUTH_ONLY_KEY_SIZE = 32;
+static const uint32_t AUTH_ONLY_IV_SIZE = 12;
+static const uint32_t AUTH_ONLY_TAG_SIZE = 16;
+
 // max client
 static const int MAX_CLIENT_NUM = 10;
 
@@ -91,4 +136,30 @@ enum EDR_DESIGN_SET {ONLY_SIMILAR_ENC = 0, SIMILAR_ENC_COMP, FULL_EDR};
 static const size_t ENC_MAX_CHUNK_SIZE = MAX_CHUNK_SIZE + CRYPTO_BLOCK_SIZE +
     sizeof(uint32_t);
 
+// the client-side delta against the previous version: the block signature of
+// a base chunk, the delta head is [base key][plaintext fp]
+static const uint32_t VERSION_DELTA_BLOCK_SIZE = 1024;
+static const uint32_t VERSION_DELTA_BLOCK_NUM = MAX_CHUNK_SIZE /
+    VERSION_DELTA_BLOCK_SIZE;
+static const uint32_t VERSION_DELTA_HEAD_SIZE = 2 * CHUNK_HASH_SIZE;
+
+// an all-zero chunk (or a hole) is a recipe entry only: [magic][size] + zeros
+// in place of the fp, its payload on the wire is the size
+static const uint64_t ZERO_CHUNK_FP_MAGIC = 0x45445230434e4b5aULL;
+
+// the adaptive batch size: the max share of the round trip in a
+// request-response batch, the batches between two adjustments, and the weight
+// of a new sample
+static const double BATCH_TUNE_RTT_RATIO = 0.1;
+static const uint32_t BATCH_TUNE_INTERVAL = 4;
+static const double BATCH_TUNE_ALPHA = 0.25;
+
+// the credit-based flow control of an upload: the MQs of the server pipeline
+// (recv->dual, dual->comp, comp->writer, writer->delta, delta->append) share
+// the session memory budget, the server grants more credit only if they are
+// at most half full
+static const uint32_t UPLOAD_MQ_NUM = 5;
+static const double CREDIT_GRANT_OCCUPANCY = 0.5;
+static const uint32_t CREDIT_WAIT_INTERVAL = 1; // ms, recheck the MQs
+
 #endif
\ No newline at end of file
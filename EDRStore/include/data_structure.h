@@ -47,6 +47,9 @@ typedef struct {
     uint32_t enc_size;
     uint8_t key[CHUNK_HASH_SIZE];
     uint64_t seed;
+    // the features of the plaintext (feature_chunk.features are replaced
+    // by the cipher features)
+    uint64_t plain_features[SUPER_FEATURE_PER_CHUNK];
 } EncFeatureChunk_t;
 
 typedef EncFeatureChunk_t KeyGen2SelectComp_t;
@@ -56,6 +59,7 @@ typedef struct {
     uint8_t type;
     uint64_t cipher_features[SUPER_FEATURE_PER_CHUNK];
     uint8_t compressed_fp[CHUNK_HASH_SIZE];
+    uint8_t base_fp[CHUNK_HASH_SIZE]; // the base of a client delta chunk
 } SendChunkHeader_t;
 
 typedef struct {
@@ -67,11 +71,37 @@ typedef struct {
     uint8_t key[CHUNK_HASH_SIZE];
 } KeyRecipe_t;
 
+typedef struct {
+    uint8_t fp[CHUNK_HASH_SIZE];
+    uint32_t size;
+} FpQuery_t;
+
+// a range of the previous recipe of the same session
+typedef struct {
+    uint64_t offset; // the first chunk
+    uint64_t chunk_num;
+} RecipeRef_t;
+
 typedef struct {
     SendChunk_t send_chunk; 
     KeyRecipe_t key_recipe;
 } SelectComp2Sender_t;
 
+typedef struct {
+    uint64_t chunk_num;
+} VersionSigHead_t;
+
+// the signature of a chunk of the previous version (in the recipe order), it
+// refers to the base chunk stored in full
+typedef struct {
+    uint32_t size; // the plaintext size of the base chunk
+    uint8_t fp[CHUNK_HASH_SIZE]; // the ciphertext fp (the fp in the server)
+    uint8_t key[CHUNK_HASH_SIZE];
+    uint64_t features[SUPER_FEATURE_PER_CHUNK]; // the plaintext features
+    uint32_t weak[VERSION_DELTA_BLOCK_NUM]; // the rolling checksum of a block
+    uint64_t strong[VERSION_DELTA_BLOCK_NUM];
+} VersionSig_t;
+
 typedef struct {
     uint8_t key_seed[CHUNK_HASH_SIZE];
     // uint64_t seed;
@@ -89,6 +119,7 @@ typedef struct {
 
 typedef struct {
     uint8_t stat;
+    uint8_t depth; // the delta chain depth (0 for the base chunk)
     uint8_t container_id[CONTAINER_ID_LENGTH];
     uint32_t offset;
     uint32_t len;
@@ -96,6 +127,31 @@ typedef struct {
     uint8_t compressed_fp[CHUNK_HASH_SIZE];
 } KeyForChunkHashDB_t;
 
+typedef struct {
+    uint32_t cnt; // the number of features referring to the cached base chunk
+    uint32_t size;
+    KeyForChunkHashDB_t addr; // the container address of the cached base chunk
+} CacheEntry_t;
+
+typedef struct {
+    uint64_t magic;
+    uint64_t slot_num; // power of two
+    uint64_t item_num;
+    uint64_t total_similar_chunk;
+    uint64_t sketch_add_cnt; // for the frequency sketch aging
+    uint32_t cur_version_num;
+    uint32_t head; // the oldest feature
+    uint32_t tail; // the latest feature
+} CacheMetaHead_t;
+
+typedef struct {
+    uint64_t feature;
+    uint32_t version;
+    uint32_t prev; // the version list (the oldest first)
+    uint32_t next;
+    uint32_t is_used;
+} CacheMetaSlot_t;
+
 typedef struct {
     char id[CONTAINER_ID_LENGTH];
     uint8_t body[MAX_CONTAINER_SIZE];
@@ -134,6 +190,12 @@ typedef struct {
     uint32_t cnt;
 } BatchBuf_t;
 
+typedef struct {
+    SendMsgBuffer_t chunk_buf;
+    BatchBuf_t key_recipe_buf; // the key recipes of the chunks in this batch
+    SendMsgBuffer_t fp_buf; // the fp queries of this batch (fp-first upload)
+} SendBatch_t;
+
 typedef struct {
     SendChunk_t input_chunk;
     SendChunk_t base_chunk;
@@ -111,6 +111,12 @@ class AbsDatabase {
          * @param key key str
          */
         virtual void Delete(const string& key) = 0;
+
+        /**
+         * @brief make the previous updates durable
+         * 
+         */
+        virtual void Sync() = 0;
 };
 
 #endif
\ No newline at end of file
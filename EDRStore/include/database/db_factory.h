@@ -16,6 +16,7 @@
 #include "in_mem_db.h"
 #include "leveldb_db.h"
 #include "rocksdb_db.h"
+#include "rocksdb_cf_store.h"
 
 enum DB_TYPE_SET {IN_MEMORY_DB = 0, LEVELDB_DB, ROCKSDB_DB};
 
@@ -24,6 +24,39 @@ class InMemoryDatabase : public AbsDatabase {
         // for lock
         pthread_rwlock_t rwlock_;
 
+        // the updates since the last file rewrite are appended to a log
+        // (replayed after the db file), the file is rewritten once the log
+        // outgrows it
+        string log_name_;
+        ofstream log_hdl_;
+        uint64_t log_size_ = 0;
+        uint64_t file_size_ = 0;
+        uint64_t min_compact_size_ = 64 * 1024 * 1024;
+        unordered_set<string> dirty_key_set_; // updated since the last Sync
+
+        /**
+         * @brief load the (key, value) pairs of a file, an item with the
+         * max value size deletes the key
+         * 
+         * @param file_name the file name
+         * @return uint64_t the file size
+         */
+        uint64_t LoadFile(string file_name);
+
+        /**
+         * @brief append the updated (key, value) pairs to the log (hold the
+         * write lock)
+         * 
+         */
+        void WriteLog();
+
+        /**
+         * @brief rewrite the whole db file and clear the log (hold the write
+         * lock)
+         * 
+         */
+        void Compact();
+
     public:
         /**
          * @brief Construct a new In Memory Database object
@@ -116,6 +149,12 @@ class InMemoryDatabase : public AbsDatabase {
          * @param key key str
          */
         void Delete(const string& key);
+
+        /**
+         * @brief make the previous updates durable (append them to the log)
+         * 
+         */
+        void Sync();
 };
 
 #endif
\ No newline at end of file
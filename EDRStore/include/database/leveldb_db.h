@@ -15,6 +15,7 @@
 
 #include <leveldb/db.h>
 #include <leveldb/cache.h>
+#include <leveldb/write_batch.h>
 #include <bits/stdc++.h>
 
 class LeveldbDatabase : public AbsDatabase {
@@ -116,6 +117,12 @@ class LeveldbDatabase : public AbsDatabase {
          * @param key key str
          */
         void Delete(const string& key);
+
+        /**
+         * @brief make the previous updates durable
+         * 
+         */
+        void Sync();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,131 @@
+/**
+ * @file rocksdb_cf_db.h
+ * @brief define the interface of using a column family of a shared RocksDB
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#ifndef MY_CODEBASE_ROCKSDB_CF_DB_H
+#define MY_CODEBASE_ROCKSDB_CF_DB_H
+
+#include "abs_db.h"
+
+#include <rocksdb/db.h>
+#include <bits/stdc++.h>
+
+class RocksdbCFDatabase : public AbsDatabase {
+    private:
+        string my_name_ = "RocksdbCFDatabase";
+        /* data */
+        rocksdb::DB* rocks_db_obj_ = NULL;
+        rocksdb::ColumnFamilyHandle* cf_handle_ = NULL;
+
+        // global setting
+        rocksdb::WriteOptions write_options_;
+        rocksdb::ReadOptions read_options_;
+    public:
+        /**
+         * @brief Construct a new RocksdbCFDatabase object
+         * 
+         * @param rocks_db_obj the shared db (owned by the RocksdbCFStore)
+         * @param cf_handle the column family handle
+         */
+        RocksdbCFDatabase(rocksdb::DB* rocks_db_obj,
+            rocksdb::ColumnFamilyHandle* cf_handle);
+
+        /**
+         * @brief Destroy the RocksdbCFDatabase object
+         * 
+         */
+        ~RocksdbCFDatabase();
+
+        /**
+         * @brief open a database (the shared db is opened by the store)
+         * 
+         * @param db_name the db path
+         * @return true success
+         * @return false fail
+         */
+        bool OpenDB(string db_name);
+
+        /**
+         * @brief query the database
+         * 
+         * @param key key
+         * @param value value
+         * @return true exist
+         * @return false not exist
+         */
+        bool Query(const string& key, string& value);
+
+        /**
+         * @brief insert the key, value pair
+         * 
+         * @param key key
+         * @param value value
+         * @return true success
+         * @return false fail
+         */
+        bool Insert(const string& key, const string& value);
+
+        /**
+         * @brief insert the (key, value) pair
+         * 
+         * @param key the key 
+         * @param buf the value buffer
+         * @param buf_size the buffer size
+         * @return true success
+         * @return false fail
+         */
+        bool InsertBuffer(const string& key, const char* buf, size_t buf_size);
+
+        /**
+         * @brief insert the (key, value) pair
+         * 
+         * @param key the key
+         * @param key_size the key size
+         * @param buf the value buffer
+         * @param buf_size the buffer size
+         * @return true success
+         * @return false fail
+         */
+        bool InsertBothBuffer(const char* key, size_t key_size, const char* buf,
+            size_t buf_size);
+
+        /**
+         * @brief query the (key, value) pair
+         * 
+         * @param key the key
+         * @param key_size the key size
+         * @param value the value
+         * @return true exist
+         * @return false not exist
+         */
+        bool QueryBuffer(const char* key, size_t key_size, string& value);
+
+        /**
+         * @brief delete a given key
+         * 
+         * @param key key ptr
+         * @param key_size key size
+         */
+        void DeleteBuffer(const char* key, size_t key_size);
+
+        /**
+         * @brief delete a given key
+         * 
+         * @param key key str
+         */
+        void Delete(const string& key);
+
+        /**
+         * @brief make the previous updates durable
+         * 
+         */
+        void Sync();
+};
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @file rocksdb_cf_store.h
+ * @brief define the interface of a shared RocksDB with column families
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#ifndef MY_CODEBASE_ROCKSDB_CF_STORE_H
+#define MY_CODEBASE_ROCKSDB_CF_STORE_H
+
+#include "rocksdb_cf_db.h"
+
+#include <rocksdb/db.h>
+#include <bits/stdc++.h>
+
+class RocksdbCFStore {
+    private:
+        string my_name_ = "RocksdbCFStore";
+        string db_name_;
+        rocksdb::DB* rocks_db_obj_ = NULL;
+
+        // global setting
+        rocksdb::Options options_;
+
+        // opened column families
+        unordered_map<string, rocksdb::ColumnFamilyHandle*> cf_handle_idx_;
+        mutex cf_handle_lck_;
+
+    public:
+        /**
+         * @brief Construct a new RocksdbCFStore object
+         * 
+         * @param db_name the path of the db file
+         */
+        RocksdbCFStore(string db_name);
+
+        /**
+         * @brief Destroy the RocksdbCFStore object
+         * 
+         */
+        ~RocksdbCFStore();
+
+        /**
+         * @brief get a view of a column family (create it if not exist)
+         * 
+         * @param cf_name the column family name
+         * @return AbsDatabase* the column family view (owned by the caller)
+         */
+        AbsDatabase* GetColumnFamily(string cf_name);
+};
+
+#endif
@@ -122,6 +122,12 @@ class RocksdbDatabase : public AbsDatabase {
          * @param key key str
          */
         void Delete(const string& key);
+
+        /**
+         * @brief make the previous updates durable
+         * 
+         */
+        void Sync();
 };
 
 #endif
\ No newline at end of file
@@ -166,6 +166,26 @@ namespace tool {
         return ;
     }
 
+    inline bool IsAllZero(const uint8_t* data, size_t size) {
+        // OR 64 bytes at a time (vectorized by the compiler), stop at the
+        // first non-zero block
+        size_t i = 0;
+        uint64_t word[8];
+        for (; i + sizeof(word) <= size; i += sizeof(word)) {
+            memcpy(word, data + i, sizeof(word));
+            if ((word[0] | word[1] | word[2] | word[3] | word[4] | word[5] |
+                word[6] | word[7]) != 0) {
+                return false;
+            }
+        }
+        for (; i < size; i++) {
+            if (data[i] != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     inline bool FileExist(std::string filePath) {
         return std::filesystem::is_regular_file(filePath);
     }
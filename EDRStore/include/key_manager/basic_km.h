@@ -15,7 +15,7 @@
 #include "define.h"
 #include "configure.h"
 #include "../data_structure.h"
-#include "../network/ssl_conn.h"
+#include "../network/abs_transport.h"
 #include "../crypto/crypto_util.h"
 #include "../database/db_factory.h"
 #include "../reduction/similar_policy.h"
@@ -26,10 +26,10 @@ class BasicKM {
     private:
         string my_name_ = "BasicKM";
 
-        SSLConnection* km_channel_;
+        AbsTransport* km_channel_;
 
         // config
-        uint64_t send_chunk_batch_size_ = 0;
+        uint64_t max_batch_size_ = 0;
 
         // for crypto
         CryptoUtil* crypto_util_;
@@ -60,7 +60,7 @@ class BasicKM {
          * @param km_channel the key generation channel
          * @param feature_2_key_index the feature index
          */
-        BasicKM(SSLConnection* km_channel, AbsDatabase* feature_2_key_index);
+        BasicKM(AbsTransport* km_channel, AbsDatabase* feature_2_key_index);
 
         /**
          * @brief Destroy the Basic KM object
@@ -73,7 +73,7 @@ class BasicKM {
          * 
          * @param key_client_ssl the client ssl
          */
-        void Run(SSL* key_client_ssl);
+        void Run(Conn_t* key_client_ssl);
 };
 
 #endif
\ No newline at end of file
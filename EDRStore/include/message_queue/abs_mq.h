@@ -63,6 +63,13 @@ class AbsMQ {
          * @return false not empty
          */
         virtual bool IsEmpty() = 0;
+
+        /**
+         * @brief get the number of data items in the queue (approximate)
+         * 
+         * @return size_t the item num
+         */
+        virtual size_t GetSize() = 0;
 };
 
 #endif
\ No newline at end of file
@@ -104,6 +104,16 @@ class BlockedMQ : public AbsMQ<T> {
             unique_lock<mutex> lck(mq_mtx_);
             return blocked_mq_.empty();
         }
+
+        /**
+         * @brief get the number of data items in the queue
+         * 
+         * @return size_t the item num
+         */
+        size_t GetSize() {
+            unique_lock<mutex> lck(mq_mtx_);
+            return blocked_mq_.size();
+        }
 };
 
 #endif
\ No newline at end of file
@@ -92,6 +92,15 @@ class LckFreeMQ : public AbsMQ<T> {
                 return false;
             }
         }
+
+        /**
+         * @brief get the number of data items in the queue (approximate)
+         * 
+         * @return size_t the item num
+         */
+        size_t GetSize() {
+            return lockFreeQueue_->size_approx();
+        }
 };
 
 #endif // BASICDEDUP_MESSAGEQUEUE_h
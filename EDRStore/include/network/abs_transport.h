@@ -0,0 +1,243 @@
+/**
+ * @file abs_transport.h
+ * @brief define the interfaces of a transport (the connections between the
+ * client and the servers)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MY_CODEBASE_ABS_TRANSPORT_H
+#define MY_CODEBASE_ABS_TRANSPORT_H
+
+#include "../configure.h"
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h> // for writev
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <openssl/ssl.h>
+#include <openssl/evp.h>
+
+using namespace std;
+
+// the progress of a non-blocking connection
+enum CONN_STATE_SET {CONN_DONE = 0, CONN_WANT_READ, CONN_WANT_WRITE,
+    CONN_FAIL};
+
+// the state of the authenticated-only data frames of a connection, the keys
+// are exported from its TLS session
+typedef struct {
+    EVP_CIPHER_CTX* send_ctx;
+    EVP_CIPHER_CTX* recv_ctx;
+    uint8_t send_iv[AUTH_ONLY_IV_SIZE];
+    uint8_t recv_iv[AUTH_ONLY_IV_SIZE];
+    uint64_t send_seq;
+    uint64_t recv_seq;
+    uint8_t* enc_buf; // the encrypted head of an outgoing frame
+    uint32_t enc_buf_size;
+    bool close_sent;
+    bool close_recv;
+} AuthOnly_t;
+
+// an established connection
+typedef struct {
+    int fd;
+    SSL* ssl; // NULL: no TLS on this transport
+    AuthOnly_t* auth_only; // NULL: all messages go through the TLS records
+} Conn_t;
+
+class AbsTransport {
+    protected:
+        // the listen file descriptor
+        int listen_fd_ = -1;
+
+        /**
+         * @brief write the length and the data to a socket in one writev
+         *
+         * @param fd the socket fd
+         * @param data the pointer to the data buffer
+         * @param size the size of the input data
+         * @return true success
+         * @return false fail (errno is set)
+         */
+        bool WriteMsg(int fd, uint8_t* data, uint32_t size);
+
+        /**
+         * @brief write all the buffers to a socket
+         *
+         * @param fd the socket fd
+         * @param iov the buffers (modified)
+         * @param iov_num the buffer num
+         * @return true success
+         * @return false fail (errno is set)
+         */
+        bool WriteVec(int fd, struct iovec* iov, int iov_num);
+
+        /**
+         * @brief read the given size from a socket
+         *
+         * @param fd the socket fd
+         * @param buf the buffer
+         * @param size the size to read
+         * @return true success
+         * @return false fail (errno is set, 0: the peer closed the
+         * connection)
+         */
+        bool ReadFull(int fd, uint8_t* buf, uint32_t size);
+
+    public:
+        /**
+         * @brief Destroy the AbsTransport object
+         *
+         */
+        virtual ~AbsTransport() {};
+
+        /**
+         * @brief finalize the connection (wait for the peer to close)
+         *
+         * @param conn_pair the pair of the socket and the connection
+         */
+        virtual void Finish(pair<int, Conn_t*> conn_pair) = 0;
+
+        /**
+         * @brief clear the corresponding accepted client connection
+         *
+         * @param conn the accepted client connection
+         */
+        virtual void ClearAcceptedClientSd(Conn_t* conn) = 0;
+
+        /**
+         * @brief connect to the server
+         *
+         * @return pair<int, Conn_t*>
+         */
+        virtual pair<int, Conn_t*> Connect() = 0;
+
+        /**
+         * @brief accept a connection (blocking)
+         *
+         * @return pair<int, Conn_t*>
+         */
+        virtual pair<int, Conn_t*> Listen() = 0;
+
+        /**
+         * @brief accept a pending connection without blocking (the handshake
+         * is driven by HandshakeNonBlock)
+         *
+         * @return pair<int, Conn_t*> (-1, NULL) if no connection is pending
+         */
+        virtual pair<int, Conn_t*> AcceptNonBlock() = 0;
+
+        /**
+         * @brief continue the handshake of a non-blocking connection
+         *
+         * @param conn the connection
+         * @return int the CONN_STATE_SET
+         */
+        virtual int HandshakeNonBlock(Conn_t* conn) = 0;
+
+        /**
+         * @brief continue to receive a message of a non-blocking connection
+         *
+         * @param conn the connection
+         * @param buf the buffer of [length][data]
+         * @param buf_size the buffer size
+         * @param cur_size the received size in the buffer <ret>
+         * @return int the CONN_STATE_SET
+         */
+        virtual int ReceiveDataNonBlock(Conn_t* conn, uint8_t* buf,
+            uint32_t buf_size, uint32_t& cur_size) = 0;
+
+        /**
+         * @brief send the data to the given connection
+         *
+         * @param conn the connection
+         * @param data the pointer to the data buffer
+         * @param size the size of the input data
+         * @return true success
+         * @return false fail
+         */
+        virtual bool SendData(Conn_t* conn, uint8_t* data, uint32_t size) = 0;
+
+        /**
+         * @brief send a message of a head and an already-encrypted payload,
+         * the payload is authenticated but not encrypted again if the
+         * connection has enabled the authenticated-only data frames
+         *
+         * @param conn the connection
+         * @param data the pointer to the data buffer
+         * @param size the size of the input data
+         * @param head_size the size of the head (encrypted)
+         * @return true success
+         * @return false fail
+         */
+        virtual bool SendPayload(Conn_t* conn, uint8_t* data, uint32_t size,
+            uint32_t head_size) = 0;
+
+        /**
+         * @brief switch a connection to the authenticated-only data frames
+         * (both peers switch after the same message)
+         *
+         * @param conn the connection
+         * @return true success
+         * @return false fail
+         */
+        virtual bool EnableAuthOnly(Conn_t* conn) = 0;
+
+        /**
+         * @brief receive the data from the given connection
+         *
+         * @param conn the connection
+         * @param data the pointer to the data buffer
+         * @param recv_size the size of received data <ret>
+         * @return true success
+         * @return false fail
+         */
+        virtual bool ReceiveData(Conn_t* conn, uint8_t* data,
+            uint32_t& recv_size) = 0;
+
+        /**
+         * @brief Get the smoothed round-trip time of the given connection
+         *
+         * @param conn the connection
+         * @param rtt the round-trip time (second) <ret>
+         * @return true success
+         * @return false fail (not measured by this transport)
+         */
+        virtual bool GetRTT(Conn_t* conn, double& rtt) = 0;
+
+        /**
+         * @brief Get the Client Ip object
+         *
+         * @param ip the ip of the client
+         * @param conn the connection of the client
+         */
+        virtual void GetClientIp(string& ip, Conn_t* conn) = 0;
+
+        /**
+         * @brief switch a connection back to the blocking mode
+         *
+         * @param conn the connection
+         */
+        void SetBlocking(Conn_t* conn) {
+            int flags = fcntl(conn->fd, F_GETFL, 0);
+            fcntl(conn->fd, F_SETFL, flags & ~O_NONBLOCK);
+            return ;
+        }
+
+        /**
+         * @brief Get the Listen Fd object
+         *
+         * @return int the listenFd
+         */
+        int GetListenFd() {
+            return this->listen_fd_;
+        }
+};
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file batch_tuner.h
+ * @brief define the interfaces of BatchTuner (adapt the batch size of a
+ * connection to its round-trip time and throughput)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MY_CODEBASE_BATCH_TUNER_H
+#define MY_CODEBASE_BATCH_TUNER_H
+
+#include <atomic>
+#include <mutex>
+
+#include "../configure.h"
+#include "abs_transport.h"
+
+extern Configure config;
+
+class BatchTuner {
+    private:
+        string my_name_ = "BatchTuner";
+        // the traffic of this tuner (for the log)
+        string traffic_name_;
+
+        // the batch waits for the response of the peer
+        bool is_round_trip_;
+
+        // config
+        bool adaptive_;
+        uint64_t min_size_;
+        uint64_t max_size_;
+
+        // read by the batch assembler, set by the sender
+        std::atomic<uint64_t> cur_size_;
+
+        // the smoothed samples
+        std::mutex tune_lck_;
+        double rtt_ = 0; // second
+        double item_time_ = 0; // second per item
+        uint32_t sample_num_ = 0;
+        uint64_t logged_size_;
+
+    public:
+        uint64_t _tuned_batch_num = 0;
+        uint64_t _min_used_size;
+        uint64_t _max_used_size;
+
+        /**
+         * @brief Construct a new BatchTuner object
+         *
+         * @param traffic_name the traffic of this tuner
+         * @param is_round_trip whether the batch waits for the response
+         */
+        BatchTuner(string traffic_name, bool is_round_trip);
+
+        /**
+         * @brief Destroy the BatchTuner object
+         *
+         */
+        ~BatchTuner();
+
+        /**
+         * @brief Get the current batch size
+         *
+         * @return uint64_t the batch size (item num)
+         */
+        uint64_t GetBatchSize() {
+            return cur_size_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief add the sample of a sent batch, and adjust the batch size
+         *
+         * @param channel the connection channel
+         * @param conn the connection of the batch
+         * @param item_num the item num of the batch
+         * @param elapsed the time to send (and get the response of) the batch
+         */
+        void OnBatch(AbsTransport* channel, Conn_t* conn, uint64_t item_num,
+            double elapsed);
+
+        /**
+         * @brief print the used batch sizes
+         *
+         */
+        void PrintStat();
+};
+
+#endif
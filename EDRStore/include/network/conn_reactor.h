@@ -0,0 +1,115 @@
+/**
+ * @file conn_reactor.h
+ * @brief define the interfaces of ConnReactor (accept the connections, drive
+ * their handshakes and read their login messages without blocking)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MY_CODEBASE_CONN_REACTOR_H
+#define MY_CODEBASE_CONN_REACTOR_H
+
+#include <sys/epoll.h>
+#include <functional>
+
+#include "../configure.h"
+#include "abs_transport.h"
+
+// a connection before its login message is received
+typedef struct {
+    Conn_t* conn;
+    bool is_handshake_done;
+    uint8_t* login_buf; // [length][login]
+    uint32_t recv_size;
+    uint32_t events;
+    struct timeval accept_time;
+} PendingConn_t;
+
+// handle an established connection and its login message
+typedef std::function<void(Conn_t*, uint8_t*, uint32_t)> LoginHandler;
+
+class ConnReactor {
+    private:
+        string my_name_ = "ConnReactor";
+
+        // the server channel
+        AbsTransport* server_channel_;
+
+        // the max login size
+        uint32_t max_login_size_;
+
+        // called in the reactor thread for each login
+        LoginHandler login_hdl_;
+
+        int epoll_fd_;
+
+        // fd -> the pending connection
+        unordered_map<int, PendingConn_t*> pending_idx_;
+
+        /**
+         * @brief accept all pending connections
+         * 
+         */
+        void AcceptAll();
+
+        /**
+         * @brief continue the handshake and the login of a connection
+         * 
+         * @param fd the socket fd
+         */
+        void Progress(int fd);
+
+        /**
+         * @brief set the events to wait for of a pending connection
+         * 
+         * @param fd the socket fd
+         * @param events the epoll events
+         */
+        void WaitFor(int fd, uint32_t events);
+
+        /**
+         * @brief remove a pending connection from the reactor
+         * 
+         * @param fd the socket fd
+         * @param is_close whether to close the connection
+         */
+        void Remove(int fd, bool is_close);
+
+        /**
+         * @brief close the connections that do not login in time
+         * 
+         */
+        void CloseExpired();
+
+    public:
+        uint64_t _total_accept_num = 0;
+        uint64_t _total_login_num = 0;
+        uint64_t _total_fail_num = 0;
+
+        /**
+         * @brief Construct a new ConnReactor object
+         * 
+         * @param server_channel the server channel
+         * @param max_login_size the max login size
+         * @param login_hdl the handler of the established connections
+         */
+        ConnReactor(AbsTransport* server_channel, uint32_t max_login_size,
+            LoginHandler login_hdl);
+
+        /**
+         * @brief Destroy the ConnReactor object
+         * 
+         */
+        ~ConnReactor();
+
+        /**
+         * @brief the main loop
+         * 
+         */
+        void Run();
+};
+
+#endif
@@ -12,18 +12,17 @@
 #ifndef MY_CODEBASE_SSL_CONNECTION_H
 #define MY_CODEBASE_SSL_CONNECTION_H
 
-#include "../configure.h"
+#include "abs_transport.h"
 
 #include <netinet/in.h> // for sockaddr_in 
-#include <sys/socket.h>
-#include <sys/types.h>
+#include <netinet/tcp.h> // for tcp_info
 #include <arpa/inet.h>
-#include <unistd.h>
 
-#include <openssl/ssl.h>
 #include <openssl/err.h>
 
-class SSLConnection {
+extern Configure config;
+
+class SSLConnection : public AbsTransport {
     private:
         string my_name_ = "SSLConnection";
         // the socket address
@@ -38,10 +37,118 @@ class SSLConnection {
         // ssl context pointer
         SSL_CTX* ssl_ctx_ = NULL;
 
-        // the listen file descriptor
-        int listen_fd_;
+        // whether the kTLS state is logged (only for the first connection)
+        atomic<bool> is_ktls_logged_;
+
+        // the connection type (client/server)
+        int type_;
+
+        // the newest session ticket from the server (client side), kept in
+        // the session file across the runs
+        SSL_SESSION* session_ = NULL;
+        string session_path_;
+        std::mutex session_lck_;
+
+        /**
+         * @brief load the saved session ticket of this server
+         * 
+         */
+        void LoadSession();
+
+        /**
+         * @brief keep a new session ticket, and save it to the session file
+         * 
+         * @param session the session ticket
+         */
+        void SaveSession(SSL_SESSION* session);
+
+        /**
+         * @brief the callback of a new session ticket (client side)
+         * 
+         * @param ssl_conn the pointer to the connection
+         * @param session the session ticket
+         * @return int 1: the session is kept
+         */
+        static int NewSessionCallback(SSL* ssl_conn, SSL_SESSION* session);
+
+        /**
+         * @brief log whether kTLS is active on a connection after the
+         * handshake
+         * 
+         * @param ssl_conn the pointer to the connection
+         */
+        void LogKTLS(SSL* ssl_conn);
+
+        /**
+         * @brief convert the result of a non-blocking SSL call to the
+         * CONN_STATE_SET
+         * 
+         * @param ssl_conn the pointer to the connection
+         * @param ret the return value of the SSL call
+         * @return int the CONN_STATE_SET
+         */
+        int GetConnState(SSL* ssl_conn, int ret);
+
+        /**
+         * @brief send the length and the data via the kernel (kTLS send is
+         * active) in one writev
+         * 
+         * @param ssl_conn the pointer to the connection
+         * @param data the pointer to the data buffer
+         * @param size the size of the input data
+         * @return true success
+         * @return false fail
+         */
+        bool SendDataKTLS(SSL* ssl_conn, uint8_t* data, uint32_t size);
+
+        /**
+         * @brief send an authenticated-only data frame: [size][head size]
+         * [encrypted head][tag][payload], the sizes and the payload are the
+         * AAD of AES-GCM
+         * 
+         * @param conn the connection
+         * @param data the pointer to the data buffer
+         * @param size the size of the input data (0: close the connection)
+         * @param head_size the size of the head (encrypted)
+         * @return true success
+         * @return false fail
+         */
+        bool SendFrame(Conn_t* conn, uint8_t* data, uint32_t size,
+            uint32_t head_size);
+
+        /**
+         * @brief receive and verify an authenticated-only data frame
+         * 
+         * @param conn the connection
+         * @param data the pointer to the data buffer
+         * @param max_size the max size of the data
+         * @param recv_size the size of received data <ret>
+         * @return true success
+         * @return false fail (or the peer closed the connection)
+         */
+        bool ReceiveFrame(Conn_t* conn, uint8_t* data, uint32_t max_size,
+            uint32_t& recv_size);
+
+        /**
+         * @brief the nonce of a frame: the iv XOR the frame sequence number
+         * 
+         * @param iv the iv of the direction
+         * @param seq the frame sequence number
+         * @param nonce the nonce <ret>
+         */
+        static void GetNonce(uint8_t* iv, uint64_t seq, uint8_t* nonce);
+
+        /**
+         * @brief free the state of the authenticated-only data frames
+         * 
+         * @param conn the connection
+         */
+        void FreeAuthOnly(Conn_t* conn);
 
     public:
+        atomic<uint64_t> _total_conn_num;
+        atomic<uint64_t> _total_resumed_num;
+
         /**
          * @brief Construct a new SSLConnection object
          * 
@@ -60,77 +167,132 @@ class SSLConnection {
         /**
          * @brief finalize the connection
          * 
-         * @param ssl_pair the pair of the server socket and ssl context
+         * @param conn_pair the pair of the server socket and the connection
          */
-        void Finish(pair<int, SSL*> ssl_pair);
+        void Finish(pair<int, Conn_t*> conn_pair);
 
         /**
          * @brief clear the corresponding accepted client socket and context
          * 
-         * @param ssl_ptr the pointer to the SSL* of accepted client
+         * @param conn the accepted client connection
          */
-        void ClearAcceptedClientSd(SSL* ssl_ptr);
+        void ClearAcceptedClientSd(Conn_t* conn);
 
         /**
          * @brief connect to ssl
          * 
-         * @return pair<int, SSL*> 
+         * @return pair<int, Conn_t*> 
          */
-        pair<int, SSL*> ConnectSSL();
+        pair<int, Conn_t*> Connect();
 
         /**
          * @brief listen to a port 
          * 
-         * @return pair<int, SSL*> 
+         * @return pair<int, Conn_t*> 
+         */
+        pair<int, Conn_t*> Listen();
+
+        /**
+         * @brief accept a pending connection without blocking (the handshake
+         * is driven by HandshakeNonBlock)
+         * 
+         * @return pair<int, Conn_t*> (-1, NULL) if no connection is pending
          */
-        pair<int, SSL*> ListenSSL();
+        pair<int, Conn_t*> AcceptNonBlock();
+
+        /**
+         * @brief continue the handshake of a non-blocking connection
+         * 
+         * @param conn the connection
+         * @return int the CONN_STATE_SET
+         */
+        int HandshakeNonBlock(Conn_t* conn);
+
+        /**
+         * @brief continue to receive a message of a non-blocking connection
+         * 
+         * @param conn the connection
+         * @param buf the buffer of [length][data]
+         * @param buf_size the buffer size
+         * @param cur_size the received size in the buffer <ret>
+         * @return int the CONN_STATE_SET
+         */
+        int ReceiveDataNonBlock(Conn_t* conn, uint8_t* buf, uint32_t buf_size,
+            uint32_t& cur_size);
 
         /**
          * @brief send the data to the given connection
          * 
-         * @param ssl_conn the pointer to the connection
+         * @param conn the connection
          * @param data the pointer to the data buffer
          * @param size the size of the input data
          * @return true success
          * @return false fail
          */
-        bool SendData(SSL* ssl_conn, uint8_t* data, uint32_t size);
+        bool SendData(Conn_t* conn, uint8_t* data, uint32_t size);
+
+        /**
+         * @brief send a message of a head and an already-encrypted payload,
+         * the payload is authenticated but not encrypted again if the
+         * connection has enabled the authenticated-only data frames
+         * 
+         * @param conn the connection
+         * @param data the pointer to the data buffer
+         * @param size the size of the input data
+         * @param head_size the size of the head (encrypted)
+         * @return true success
+         * @return false fail
+         */
+        bool SendPayload(Conn_t* conn, uint8_t* data, uint32_t size,
+            uint32_t head_size);
+
+        /**
+         * @brief switch a connection to the authenticated-only data frames
+         * (both peers switch after the same message), the frames bypass the
+         * TLS records with the keys exported from the TLS session
+         * 
+         * @param conn the connection
+         * @return true success
+         * @return false fail
+         */
+        bool EnableAuthOnly(Conn_t* conn);
 
         /**
          * @brief receive the data from the given connection
          * 
-         * @param connection the pointer to the connection
+         * @param conn the connection
          * @param data the pointer to the data buffer
-         * @param receiveDataSize the size of received data 
+         * @param recv_size the size of received data <ret>
          * @return true success
          * @return false fail
          */
-        bool ReceiveData(SSL* ssl_conn, uint8_t* data, uint32_t& recv_size);
+        bool ReceiveData(Conn_t* conn, uint8_t* data, uint32_t& recv_size);
 
         /**
-         * @brief Get the Listen Fd object
+         * @brief Get the smoothed round-trip time of the given connection
+         * (measured by the TCP stack)
          * 
-         * @return int the listenFd
+         * @param conn the connection
+         * @param rtt the round-trip time (second) <ret>
+         * @return true success
+         * @return false fail
          */
-        int GetListenFd() {
-            return this->listen_fd_;
-        }
+        bool GetRTT(Conn_t* conn, double& rtt);
 
         /**
          * @brief Get the Client Ip object
          * 
          * @param ip the ip of the client 
-         * @param client_ssl the SSL connection of the client
+         * @param conn the connection of the client
          */
-        void GetClientIp(string& ip, SSL* client_ssl) {
-            int client_fd = SSL_get_fd(client_ssl);
+        void GetClientIp(string& ip, Conn_t* conn) {
             struct sockaddr_in client_addr;
             socklen_t client_addr_len = sizeof(client_addr);
-            getpeername(client_fd, (struct sockaddr*)&client_addr, &client_addr_len);
+            getpeername(conn->fd, (struct sockaddr*)&client_addr, &client_addr_len);
             ip.resize(INET_ADDRSTRLEN, 0);
             inet_ntop(AF_INET, &(client_addr.sin_addr), &ip[0], INET_ADDRSTRLEN);
             return ;
         }
 };
 
-#endif
+#endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+/**
+ * @file transport_factory.h
+ * @brief the factory of transport
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MY_CODEBASE_TRANSPORT_FACTORY_H
+#define MY_CODEBASE_TRANSPORT_FACTORY_H
+
+#include "abs_transport.h"
+#include "ssl_conn.h"
+#include "unix_conn.h"
+
+enum TRANSPORT_TYPE_SET {TLS_TRANSPORT = 0, UNIX_TRANSPORT};
+
+class TransportFactory {
+    private:
+        string my_name_ = "TransportFactory";
+    public:
+        AbsTransport* CreateTransport(int transport_type, string ip, int port,
+            string unix_path, int type);
+};
+
+#endif
@@ -0,0 +1,175 @@
+/**
+ * @file unix_conn.h
+ * @brief define the interface of unix-domain connection (plain, for the
+ * client and the servers on the same host)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MY_CODEBASE_UNIX_CONNECTION_H
+#define MY_CODEBASE_UNIX_CONNECTION_H
+
+#include "abs_transport.h"
+
+#include <sys/un.h> // for sockaddr_un
+#include <sys/stat.h>
+
+class UnixConnection : public AbsTransport {
+    private:
+        string my_name_ = "UnixConnection";
+        // the socket address
+        struct sockaddr_un socket_addr_;
+
+        // the socket path
+        string socket_path_;
+
+        // the connection type (client/server)
+        int type_;
+
+    public:
+        /**
+         * @brief Construct a new UnixConnection object
+         *
+         * @param path the socket path
+         * @param type the type (client/server)
+         */
+        UnixConnection(string path, int type);
+
+        /**
+         * @brief Destroy the UnixConnection object
+         *
+         */
+        ~UnixConnection();
+
+        /**
+         * @brief finalize the connection
+         *
+         * @param conn_pair the pair of the server socket and the connection
+         */
+        void Finish(pair<int, Conn_t*> conn_pair);
+
+        /**
+         * @brief clear the corresponding accepted client socket
+         *
+         * @param conn the accepted client connection
+         */
+        void ClearAcceptedClientSd(Conn_t* conn);
+
+        /**
+         * @brief connect to the socket path
+         *
+         * @return pair<int, Conn_t*>
+         */
+        pair<int, Conn_t*> Connect();
+
+        /**
+         * @brief listen to the socket path
+         *
+         * @return pair<int, Conn_t*>
+         */
+        pair<int, Conn_t*> Listen();
+
+        /**
+         * @brief accept a pending connection without blocking
+         *
+         * @return pair<int, Conn_t*> (-1, NULL) if no connection is pending
+         */
+        pair<int, Conn_t*> AcceptNonBlock();
+
+        /**
+         * @brief no handshake on this transport
+         *
+         * @param conn the connection
+         * @return int CONN_DONE
+         */
+        int HandshakeNonBlock(Conn_t* conn) {
+            return CONN_DONE;
+        }
+
+        /**
+         * @brief continue to receive a message of a non-blocking connection
+         *
+         * @param conn the connection
+         * @param buf the buffer of [length][data]
+         * @param buf_size the buffer size
+         * @param cur_size the received size in the buffer <ret>
+         * @return int the CONN_STATE_SET
+         */
+        int ReceiveDataNonBlock(Conn_t* conn, uint8_t* buf, uint32_t buf_size,
+            uint32_t& cur_size);
+
+        /**
+         * @brief send the data to the given connection
+         *
+         * @param conn the connection
+         * @param data the pointer to the data buffer
+         * @param size the size of the input data
+         * @return true success
+         * @return false fail
+         */
+        bool SendData(Conn_t* conn, uint8_t* data, uint32_t size);
+
+        /**
+         * @brief send a message of a head and an already-encrypted payload
+         * (nothing is encrypted on the same host)
+         *
+         * @param conn the connection
+         * @param data the pointer to the data buffer
+         * @param size the size of the input data
+         * @param head_size the size of the head
+         * @return true success
+         * @return false fail
+         */
+        bool SendPayload(Conn_t* conn, uint8_t* data, uint32_t size,
+            uint32_t head_size) {
+            return this->SendData(conn, data, size);
+        }
+
+        /**
+         * @brief no encryption to skip on the same host
+         *
+         * @param conn the connection
+         * @return true always
+         */
+        bool EnableAuthOnly(Conn_t* conn) {
+            return true;
+        }
+
+        /**
+         * @brief receive the data from the given connection
+         *
+         * @param conn the connection
+         * @param data the pointer to the data buffer
+         * @param recv_size the size of received data <ret>
+         * @return true success
+         * @return false fail
+         */
+        bool ReceiveData(Conn_t* conn, uint8_t* data, uint32_t& recv_size);
+
+        /**
+         * @brief no round trip to measure on the same host
+         *
+         * @param conn the connection
+         * @param rtt the round-trip time (second) <ret>
+         * @return false always
+         */
+        bool GetRTT(Conn_t* conn, double& rtt) {
+            return false;
+        }
+
+        /**
+         * @brief Get the Client Ip object
+         *
+         * @param ip the ip of the client (the local host)
+         * @param conn the connection of the client
+         */
+        void GetClientIp(string& ip, Conn_t* conn) {
+            ip.assign("localhost");
+            return ;
+        }
+};
+
+#endif
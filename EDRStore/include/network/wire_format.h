@@ -0,0 +1,246 @@
+/**
+ * @file wire_format.h
+ * @brief encode/decode the per-chunk header inside a chunk batch
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MY_CODEBASE_WIRE_FORMAT_H
+#define MY_CODEBASE_WIRE_FORMAT_H
+
+#include "../define.h"
+#include "../data_structure.h"
+
+/**
+ * WIRE_FORMAT_FIXED: the raw SendChunkHeader_t before each payload.
+ * WIRE_FORMAT_COMPACT: [type (1 byte)][size (varint)][fields of this type]
+ *  - cipher features (raw): FULL_EDR_CACHE_CHUNK, FULL_EDR_UNCOMPRESS_CHUNK
+ *  - compressed fp (raw): FULL_EDR_UNCOMPRESS_CHUNK
+ *  - base fp (raw): CLIENT_DELTA_CHUNK
+ * The payload of a ZERO_CHUNK (ZERO_RECIPE_CHUNK in the restore batches) is
+ * its size (uint32_t).
+ * The payload always follows the header in place.
+ */
+namespace wire {
+    /**
+     * @brief check whether the chunk type carries the cipher features
+     *
+     * @param type the chunk type
+     * @return true carry the cipher features
+     */
+    inline bool HasFeature(uint8_t type) {
+        return type == FULL_EDR_CACHE_CHUNK ||
+            type == FULL_EDR_UNCOMPRESS_CHUNK;
+    }
+
+    /**
+     * @brief check whether the chunk type carries the compressed fp
+     *
+     * @param type the chunk type
+     * @return true carry the compressed fp
+     */
+    inline bool HasCompressedFp(uint8_t type) {
+        return type == FULL_EDR_UNCOMPRESS_CHUNK;
+    }
+
+    /**
+     * @brief check whether the chunk type carries the base fp
+     *
+     * @param type the chunk type
+     * @return true carry the base fp
+     */
+    inline bool HasBaseFp(uint8_t type) {
+        return type == CLIENT_DELTA_CHUNK;
+    }
+
+    /**
+     * @brief make the recipe entry of an all-zero chunk
+     *
+     * @param size the chunk size
+     * @param fp the recipe entry <ret>
+     */
+    inline void MakeZeroFp(uint32_t size, uint8_t* fp) {
+        memset(fp, 0, CHUNK_HASH_SIZE);
+        memcpy(fp, &ZERO_CHUNK_FP_MAGIC, sizeof(uint64_t));
+        memcpy(fp + sizeof(uint64_t), &size, sizeof(uint32_t));
+        return ;
+    }
+
+    /**
+     * @brief check whether a recipe entry is an all-zero chunk
+     *
+     * @param fp the recipe entry
+     * @param size the chunk size <ret>
+     * @return true an all-zero chunk
+     */
+    inline bool IsZeroFp(const uint8_t* fp, uint32_t& size) {
+        uint64_t magic;
+        memcpy(&magic, fp, sizeof(uint64_t));
+        if (magic != ZERO_CHUNK_FP_MAGIC || !tool::IsAllZero(fp +
+            sizeof(uint64_t) + sizeof(uint32_t), CHUNK_HASH_SIZE -
+            sizeof(uint64_t) - sizeof(uint32_t))) {
+            return false;
+        }
+        memcpy(&size, fp + sizeof(uint64_t), sizeof(uint32_t));
+        return true;
+    }
+
+    /**
+     * @brief get the varint length of a value
+     *
+     * @param value the value
+     * @return uint32_t the encoded length
+     */
+    inline uint32_t VarintLen(uint32_t value) {
+        uint32_t len = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            len++;
+        }
+        return len;
+    }
+
+    /**
+     * @brief encode a varint with a given width (pad with continuation bytes)
+     *
+     * @param value the value
+     * @param width the output width (>= VarintLen(value))
+     * @param out the output buffer
+     * @return uint32_t the encoded length
+     */
+    inline uint32_t EncodeVarint(uint32_t value, uint32_t width, uint8_t* out) {
+        for (uint32_t i = 0; i < width - 1; i++) {
+            out[i] = (uint8_t)(value & 0x7f) | 0x80;
+            value >>= 7;
+        }
+        out[width - 1] = (uint8_t)(value & 0x7f);
+        return width;
+    }
+
+    /**
+     * @brief decode a varint
+     *
+     * @param in the input buffer
+     * @param value the decoded value
+     * @return uint32_t the consumed length
+     */
+    inline uint32_t DecodeVarint(const uint8_t* in, uint32_t& value) {
+        uint32_t len = 0;
+        uint32_t shift = 0;
+        value = 0;
+        while (len < MAX_VARINT32_SIZE) {
+            value |= (uint32_t)(in[len] & 0x7f) << shift;
+            if ((in[len++] & 0x80) == 0) {
+                break;
+            }
+            shift += 7;
+        }
+        return len;
+    }
+
+    /**
+     * @brief get the encoded header length
+     *
+     * @param type the chunk type
+     * @param size the payload size (or its upper bound)
+     * @param wire_ver the wire format
+     * @return uint32_t the header length
+     */
+    inline uint32_t ChunkHeaderLen(uint8_t type, uint32_t size,
+        uint32_t wire_ver) {
+        if (wire_ver == WIRE_FORMAT_FIXED) {
+            return sizeof(SendChunkHeader_t);
+        }
+        uint32_t len = sizeof(uint8_t) + VarintLen(size);
+        if (HasFeature(type)) {
+            len += sizeof(uint64_t) * SUPER_FEATURE_PER_CHUNK;
+        }
+        if (HasCompressedFp(type)) {
+            len += CHUNK_HASH_SIZE;
+        }
+        if (HasBaseFp(type)) {
+            len += CHUNK_HASH_SIZE;
+        }
+        return len;
+    }
+
+    /**
+     * @brief encode a chunk header
+     *
+     * @param header the chunk header
+     * @param out the output buffer
+     * @param wire_ver the wire format
+     * @param reserved_len the reserved header length (0: the shortest one),
+     * used when the header is written after its payload
+     * @return uint32_t the header length
+     */
+    inline uint32_t EncodeChunkHeader(const SendChunkHeader_t* header,
+        uint8_t* out, uint32_t wire_ver, uint32_t reserved_len = 0) {
+        if (wire_ver == WIRE_FORMAT_FIXED) {
+            memcpy(out, header, sizeof(SendChunkHeader_t));
+            return sizeof(SendChunkHeader_t);
+        }
+
+        uint32_t size_width = VarintLen(header->size);
+        if (reserved_len != 0) {
+            size_width += reserved_len - ChunkHeaderLen(header->type,
+                header->size, wire_ver);
+        }
+        uint32_t offset = 0;
+        out[offset++] = header->type;
+        offset += EncodeVarint(header->size, size_width, out + offset);
+        if (HasFeature(header->type)) {
+            memcpy(out + offset, header->cipher_features,
+                sizeof(uint64_t) * SUPER_FEATURE_PER_CHUNK);
+            offset += sizeof(uint64_t) * SUPER_FEATURE_PER_CHUNK;
+        }
+        if (HasCompressedFp(header->type)) {
+            memcpy(out + offset, header->compressed_fp, CHUNK_HASH_SIZE);
+            offset += CHUNK_HASH_SIZE;
+        }
+        if (HasBaseFp(header->type)) {
+            memcpy(out + offset, header->base_fp, CHUNK_HASH_SIZE);
+            offset += CHUNK_HASH_SIZE;
+        }
+        return offset;
+    }
+
+    /**
+     * @brief decode a chunk header (the payload starts right after it)
+     *
+     * @param in the input buffer
+     * @param header the decoded header
+     * @param wire_ver the wire format
+     * @return uint32_t the header length
+     */
+    inline uint32_t DecodeChunkHeader(const uint8_t* in,
+        SendChunkHeader_t* header, uint32_t wire_ver) {
+        if (wire_ver == WIRE_FORMAT_FIXED) {
+            memcpy(header, in, sizeof(SendChunkHeader_t));
+            return sizeof(SendChunkHeader_t);
+        }
+
+        uint32_t offset = 0;
+        header->type = in[offset++];
+        offset += DecodeVarint(in + offset, header->size);
+        if (HasFeature(header->type)) {
+            memcpy(header->cipher_features, in + offset,
+                sizeof(uint64_t) * SUPER_FEATURE_PER_CHUNK);
+            offset += sizeof(uint64_t) * SUPER_FEATURE_PER_CHUNK;
+        }
+        if (HasCompressedFp(header->type)) {
+            memcpy(header->compressed_fp, in + offset, CHUNK_HASH_SIZE);
+            offset += CHUNK_HASH_SIZE;
+        }
+        if (HasBaseFp(header->type)) {
+            memcpy(header->base_fp, in + offset, CHUNK_HASH_SIZE);
+            offset += CHUNK_HASH_SIZE;
+        }
+        return offset;
+    }
+}
+
+#endif
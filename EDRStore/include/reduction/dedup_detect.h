@@ -40,9 +40,11 @@ class DedupDetect {
         /**
          * @brief detect deduplicate chunks
          * 
-         * @param info the stat
+         * @param info the stat (the stored address of a duplicate chunk)
+         * @param journal_hdl record the new fp before updating the index
+         * (NULL: no journal)
          */
-        void DetectDuplicate(ChunkInfo_t* info);
+        void DetectDuplicate(ChunkInfo_t* info, ofstream* journal_hdl = NULL);
 };
 
 #endif
\ No newline at end of file
@@ -14,11 +14,43 @@
 
 #include "../database/db_factory.h"
 #include "../data_structure.h"
+#include "../configure.h"
+#include "../readCache.h"
+
+extern Configure config;
+
+typedef struct {
+    string base_fp;
+    uint32_t freq; // the number of matched super-features
+    uint32_t order; // the first matched position in the feature index
+    bool is_local;
+    uint8_t depth;
+} BaseCandidate_t;
 
 class SimilarPolicy {
     private:
         string my_name_ = "SimilarPolicy";
 
+        // for restore-aware base selection
+        uint32_t max_delta_depth_;
+        bool prefer_local_base_;
+
+        // the number of base candidates per super-feature
+        uint32_t candidate_num_;
+
+        /**
+         * @brief check whether the base chunk is co-located with the input
+         * chunk (i.e., in the current container or the container cache)
+         * 
+         * @param base_addr base chunk address
+         * @param cur_container_id current container id
+         * @param container_cache container cache
+         * @return true co-located
+         * @return false not co-located
+         */
+        bool IsLocalBase(KeyForChunkHashDB_t* base_addr, char* cur_container_id,
+            ReadCache* container_cache);
+
     public:
         /**
          * @brief Construct a new SimilarPolicy object
@@ -50,6 +82,38 @@ class SimilarPolicy {
         void FindBaseChunk(unordered_map<uint64_t, string>& feature_2_fp_db,
             ChunkInfo_t* info);
 
+        /**
+         * @brief find the base chunk with the restore cost (bound the delta
+         * chain depth and prefer the co-located base chunk)
+         * 
+         * @param feature_2_fp_db feature to base fp candidates index
+         * @param fp_2_addr_db fp to chunk addr index
+         * @param pending_feature_idx feature to base fp candidates of the
+         * session (not appended yet)
+         * @param pending_addr_idx fp to chunk addr of the session (not
+         * appended yet)
+         * @param info chunk info
+         * @param cur_container_id current container id
+         * @param container_cache container cache
+         * @param candidates the ranked base candidates <ret>
+         */
+        void FindBaseChunk(AbsDatabase* feature_2_fp_db,
+            AbsDatabase* fp_2_addr_db,
+            unordered_map<uint64_t, string>& pending_feature_idx,
+            unordered_map<string, KeyForChunkHashDB_t>& pending_addr_idx,
+            ChunkInfo_t* info, char* cur_container_id,
+            ReadCache* container_cache, vector<BaseCandidate_t>& candidates);
+
+        /**
+         * @brief check whether the delta chain depth of a base chunk allows
+         * one more level of delta
+         * 
+         * @param base_addr base chunk address
+         * @return true can be used as the base
+         * @return false exceeds the max delta depth
+         */
+        bool IsValidBaseDepth(KeyForChunkHashDB_t* base_addr);
+
         /**
          * @brief update the feature index 
          * 
@@ -69,6 +133,67 @@ class SimilarPolicy {
          */
         void UpdateFeatureIndex(unordered_map<uint64_t, string>& feature_2_fp_db,
             uint64_t* features, string& base_fp);
+
+        /**
+         * @brief update the feature index with multiple candidates per
+         * super-feature (the latest base chunk first)
+         * 
+         * @param feature_2_fp_db feature to base fp candidates index
+         * @param features chunk feature
+         * @param base_fp base chunk fp
+         */
+        void UpdateFeatureCandidates(AbsDatabase* feature_2_fp_db,
+            uint64_t* features, uint8_t* base_fp);
+
+        /**
+         * @brief update the feature index with multiple candidates per
+         * super-feature (the latest base chunk first)
+         * 
+         * @param feature_2_fp_db feature to base fp candidates index
+         * @param features chunk feature
+         * @param base_fp base chunk fp
+         */
+        void UpdateFeatureCandidates(
+            unordered_map<uint64_t, string>& feature_2_fp_db,
+            uint64_t* features, uint8_t* base_fp);
+
+        /**
+         * @brief remove a base chunk from the candidates of its features
+         * 
+         * @param feature_2_fp_db feature to base fp candidates index
+         * @param features chunk feature
+         * @param base_fp base chunk fp
+         */
+        void RemoveFeatureCandidate(
+            unordered_map<uint64_t, string>& feature_2_fp_db,
+            uint64_t* features, uint8_t* base_fp);
+
+        /**
+         * @brief compute the sampled fingerprint sketch of a chunk
+         * 
+         * @param data chunk data
+         * @param size chunk size
+         * @param sketch the sorted sampled fingerprints <ret>
+         */
+        void ComputeSketch(uint8_t* data, uint32_t size, uint32_t* sketch);
+
+        /**
+         * @brief estimate the content overlap of two chunks from their sketches
+         * 
+         * @param sketch_a the sketch of chunk a
+         * @param sketch_b the sketch of chunk b
+         * @return double the estimated resemblance in [0, 1]
+         */
+        double EstimateOverlap(uint32_t* sketch_a, uint32_t* sketch_b);
+
+        /**
+         * @brief Get the number of base candidates per super-feature
+         * 
+         * @return uint32_t the candidate number
+         */
+        uint32_t GetCandidateNum() {
+            return candidate_num_;
+        }
 };
 
 #endif
\ No newline at end of file
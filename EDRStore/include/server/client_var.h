@@ -12,27 +12,45 @@
 #ifndef EDRSTORE_CLIENT_VAR_H
 #define EDRSTORE_CLIENT_VAR_H
 
+#include <condition_variable>
+
 #include "inform_cache.h"
 #include "../configure.h"
 #include "../message_queue/mq_factory.h"
-#include "../network/ssl_conn.h"
+#include "../network/abs_transport.h"
 #include "../crypto/crypto_util.h"
 #include "../readCache.h"
 #include "../chunker/rabin_poly.h"
 
 extern Configure config;
 
+class StorageCore;
+
 class ClientVar {
     private:
         string my_name_ = "ClientVar";
         int opt_type_; // the operation type (upload / download)
         uint64_t send_chunk_batch_size_;
+        uint64_t max_batch_size_; // the upload batches of the client
         uint64_t send_recipe_batch_size_;
         string recipe_path_;
 
+        // for the upload checkpoints
+        string ckpt_path_; // the checkpointed chunk num of the partial recipe
+        string journal_path_; // the new fps since the last checkpoint
+        uint64_t resume_chunk_num_;
+        mutex ckpt_mtx_;
+        condition_variable ckpt_cv_;
+        bool ckpt_sealed_;
+
+        // wake up the held credit grant when the writer stages pop
+        mutex mq_pop_mtx_;
+        condition_variable mq_pop_cv_;
+
         RabinFPUtil* rabin_util_;
 
         uint32_t MQ_TYPE_ = LCK_FREE_MQ;
+        uint64_t upload_mq_cap_; // the item num of all upload MQs
         MQFactory<WrappedChunk_t> wrapped_chunk_mq_factory_;
         MQFactory<Reader2Decoder_t> reader_2_decoder_mq_factory_;
 
@@ -67,12 +85,29 @@ class ClientVar {
         EVP_CIPHER_CTX* _cipher_ctx;
 
         // for handling file recipe
-        ofstream _recipe_write_hdl;
+        ofstream _recipe_write_hdl; // written to a tmp file until the end
         ifstream _recipe_read_hdl;
+        ifstream _prev_recipe_hdl; // the previous version (may not exist)
+        uint64_t _recipe_chunk_num; // the fps in the recipe so far
+        bool _recipe_done; // the recipe is committed
+        bool _resumable; // false after the ranges of the previous recipe
+
+        // the new fps in the index whose containers may not be saved yet
+        ofstream _journal_hdl;
+        // the duplicate chunks (recipe idx, fp) whose containers may not be
+        // saved yet, e.g., in the open container of another session
+        vector<pair<uint64_t, string>> _unsaved_ref_list;
+        unordered_set<string> _saved_container_set;
+        uint64_t _ckpt_chunk_num; // the chunk num of the last checkpoint
 
         // common container cache
         ReadCache* _container_cache;
-        InformCache* _inform_cache;
+        InformCache* _inform_cache; // NULL except for FULL_EDR upload
+
+        // for the fingerprint-first upload
+        AbsDatabase* _owner_db; // NULL except for fp-first upload
+        vector<FpQuery_t> _known_fp_list; // known chunks of the last query
+        uint32_t _known_fp_idx;
 
         // upload var
         Container_t _cur_container;
@@ -85,12 +120,42 @@ class ClientVar {
         AbsMQ<WrappedChunk_t>* _dual_2_comp_mq;
         AbsMQ<WrappedChunk_t>* _comp_2_writer_mq;
 
+        // for the parallel delta workers in the writer
+        vector<AbsMQ<WrappedChunk_t>*> _writer_2_delta_mq;
+        vector<AbsMQ<WrappedChunk_t>*> _delta_2_append_mq;
+
+        // the credit-based flow control: the bytes of chunk batches each
+        // stripe may still send, topped up to the window (the recv buffer
+        // size) on request
+        uint64_t _credit_window; // 0: no flow control
+        vector<uint64_t> _stripe_credit;
+        mutex _storage_mtx; // the current container & container cache
+        mutex _pending_base_mtx;
+        unordered_map<string, string> _pending_base_idx; // not appended base chunks
+        // the chunks dispatched but not appended are only visible to this
+        // session, the appender moves them to the shared indexes
+        unordered_map<string, KeyForChunkHashDB_t> _pending_addr_idx;
+        unordered_map<uint64_t, string> _pending_feature_idx;
+        unordered_map<string, string> _pending_sketch_idx;
+
+        // the stat of the writer dispatcher in this session
+        uint64_t _bounded_chunk_num; // cache delta chunks stored as base
+        uint64_t _switched_base_num; // switched to a better base candidate
+
         // download var
         SendMsgBuffer_t _send_chunk_buf;
         uint8_t* _read_recipe_buf;
         AbsMQ<Reader2Decoder_t>*_reader_2_decoder_mq;
 
-        SSL* _client_ssl; // SSL connection
+        Conn_t* _client_ssl; // SSL connection
+        uint32_t _wire_ver; // the chunk batch wire format
+        bool _auth_only; // the authenticated-only data frames after the login
+
+        // the connections of this session ([0] is _client_ssl), the batch i
+        // goes through _stripe_ssl[i % size]
+        vector<Conn_t*> _stripe_ssl;
+        uint32_t _stripe_joined;
+        uint64_t _stripe_seq;
 
         uint64_t* _total_cache_size;
 
@@ -101,15 +166,81 @@ class ClientVar {
          * @param client_ssl the client SSL
          * @param opt_type the operation type (upload / download)
          * @param recipe_path the file recipe path
+         * @param resume_chunk_num the checkpointed chunks to keep in the
+         * partial recipe (upload only, 0: a new upload)
          */
-        ClientVar(uint32_t client_id, SSL* client_ssl,
-            int opt_type, string& recipe_path);
+        ClientVar(uint32_t client_id, Conn_t* client_ssl,
+            int opt_type, string& recipe_path, uint64_t resume_chunk_num = 0);
 
         /**
          * @brief Destroy the Client Var object
          * 
          */
         ~ClientVar();
+
+        /**
+         * @brief replace the previous recipe with the uploaded one
+         * 
+         */
+        void CommitRecipe();
+
+        /**
+         * @brief wait for the appender to seal the container at the checkpoint
+         * 
+         */
+        void WaitSealed();
+
+        /**
+         * @brief get the occupancy of the upload MQs
+         * 
+         * @return double the ratio of the queued items to the capacity
+         */
+        double GetUploadMQOccupancy();
+
+        /**
+         * @brief wait until the upload MQs are at most the occupancy
+         * 
+         * @param occupancy the ratio of the queued items to the capacity
+         */
+        void WaitUploadMQ(double occupancy);
+
+        /**
+         * @brief notify that a writer stage has popped from the upload MQs
+         * 
+         */
+        void NotifyUploadMQPop();
+
+        /**
+         * @brief notify that the container is sealed at the checkpoint
+         * 
+         */
+        void NotifySealed();
+
+        /**
+         * @brief check whether a container is saved
+         * 
+         * @param container_id the container id
+         * @param storage_core the storage core
+         * @return true the container is saved
+         */
+        bool IsContainerSaved(const uint8_t* container_id,
+            StorageCore* storage_core);
+
+        /**
+         * @brief persist the partial recipe, the checkpoint stops before the
+         * first chunk whose container is not saved
+         * 
+         * @param fp_2_addr_db the fp to address index
+         * @param storage_core the storage core
+         */
+        void SaveCheckpoint(AbsDatabase* fp_2_addr_db,
+            StorageCore* storage_core);
+
+        /**
+         * @brief remove the checkpoint after the upload ends
+         * 
+         */
+        void ClearCheckpoint();
 };
 
 #endif
\ No newline at end of file
@@ -15,7 +15,8 @@
 #include "client_var.h"
 #include "../reduction/delta_comp.h"
 #include "../compression/compress_util.h"
-#include "../network/ssl_conn.h"
+#include "../network/abs_transport.h"
+#include "../network/wire_format.h"
 #include "../configure.h"
 
 class DataDecoderThd {
@@ -32,16 +33,28 @@ class DataDecoderThd {
         // for delta compression
         DeltaComp* delta_comp_;
 
-        // SSL connection
-        SSLConnection* server_channel_;
+        // the connection channel
+        AbsTransport* server_channel_;
 
         /**
          * @brief decode a chunk
          * 
          * @param raw_chunk raw chunk
          * @param cur_client current client
+         * @return true a chunk of the recipe is complete
+         * @return false its base follows (a client delta)
          */
-        void DecodeChunk(Reader2Decoder_t* raw_chunk, ClientVar* cur_client);
+        bool DecodeChunk(Reader2Decoder_t* raw_chunk, ClientVar* cur_client);
+
+        /**
+         * @brief append a chunk to the send buffer in the client wire format
+         * 
+         * @param header the chunk header
+         * @param data the chunk data
+         * @param cur_client current client
+         */
+        void AppendChunk(SendChunkHeader_t* header, uint8_t* data,
+            ClientVar* cur_client);
 
         /**
          * @brief send a batch of chunk
@@ -64,7 +77,7 @@ class DataDecoderThd {
          * 
          * @param server_channel server channel
          */
-        DataDecoderThd(SSLConnection* server_channel);
+        DataDecoderThd(AbsTransport* server_channel);
 
         /**
          * @brief Destroy the DataDecodeThd object
@@ -16,6 +16,7 @@
 #include "storage_core.h"
 #include "../database/db_factory.h"
 #include "../configure.h"
+#include "../network/wire_format.h"
 #include "../reduction/delta_comp.h"
 
 extern Configure config;
@@ -44,6 +45,14 @@ class DataReaderThd {
          */
         void FetchChunk(uint8_t* fp, ClientVar* cur_client);
 
+        /**
+         * @brief push an all-zero chunk (only its size)
+         * 
+         * @param size chunk size
+         * @param cur_client current client
+         */
+        void PushZeroChunk(uint32_t size, ClientVar* cur_client);
+
         /**
          * @brief process normal delta chunk
          * 
@@ -14,10 +14,12 @@
 
 #include "../configure.h"
 #include "../database/db_factory.h"
-#include "../network/ssl_conn.h"
+#include "../network/abs_transport.h"
+#include "../network/wire_format.h"
 #include "../reduction/dedup_detect.h"
 #include "../chunker/finesse_util.h"
 #include "client_var.h"
+#include "storage_core.h"
 
 extern Configure config;
 
@@ -31,11 +33,12 @@ class DataRecvThd{
         uint64_t feature_batch_size_ = MAX_CHUNK_SIZE / sizeof(uint64_t);
 
         // for storage server connection
-        SSLConnection* server_channel_;
+        AbsTransport* server_channel_;
 
         // for deduplication
         AbsDatabase* fp_2_addr_db_;
         DedupDetect* dedup_util_;
+        StorageCore* storage_core_;
 
         // for feature computation
         FinesseUtil* finesse_util_;
@@ -65,6 +68,13 @@ class DataRecvThd{
          */
         void ProcessRecipe(ClientVar* cur_client, uint8_t* fp);
 
+        /**
+         * @brief copy the ranges of the previous recipe (unchanged files)
+         * 
+         * @param cur_client current client
+         */
+        void ProcessRecipeRef(ClientVar* cur_client);
+
         /**
          * @brief process evict features
          * 
@@ -72,6 +82,59 @@ class DataRecvThd{
          */
         void ProcessEvictFeature(ClientVar* cur_client);
 
+        /**
+         * @brief answer the fp queries with a bitmap of the chunks to send
+         * 
+         * @param cur_client current client
+         * @param client_ssl the connection of the query
+         */
+        void ProcessFpQuery(ClientVar* cur_client, Conn_t* client_ssl);
+
+        /**
+         * @brief seal the stored chunks, persist the partial recipe and
+         * acknowledge the checkpointed chunk num
+         * 
+         * @param cur_client current client
+         * @param client_ssl the connection of the checkpoint
+         */
+        void ProcessCheckpoint(ClientVar* cur_client, Conn_t* client_ssl);
+
+        /**
+         * @brief take the credit of a chunk batch
+         * 
+         * @param cur_client current client
+         * @param stripe_id the stripe of the batch
+         * @param batch_size the batch size
+         */
+        void TakeCredit(ClientVar* cur_client, uint32_t stripe_id,
+            uint32_t batch_size);
+
+        /**
+         * @brief top up the credit of a stripe to the window once the upload
+         * MQs have room
+         * 
+         * @param cur_client current client
+         * @param stripe_id the stripe of the request
+         */
+        void ProcessCreditRequest(ClientVar* cur_client, uint32_t stripe_id);
+
+        /**
+         * @brief record that the client has uploaded a chunk
+         * 
+         * @param cur_client current client
+         * @param fp chunk fp
+         */
+        void RecordOwner(ClientVar* cur_client, uint8_t* fp);
+
+        /**
+         * @brief record a duplicate chunk whose container may not be saved,
+         * it is checked again at the checkpoint
+         * 
+         * @param cur_client current client
+         * @param info the duplicate chunk
+         */
+        void RecordRef(ClientVar* cur_client, ChunkInfo_t* info);
+
     public:
         uint64_t _chunk_batch_num = 0;
         uint64_t _total_recv_chunk_num = 0;
@@ -82,6 +145,25 @@ class DataRecvThd{
         uint64_t _total_logical_chunk_num = 0;
         uint64_t _total_unique_data_size = 0;
         uint64_t _total_unique_chunk_num = 0;
+
+        // for the fingerprint-first upload
+        uint64_t _total_skip_chunk_num = 0;
+        uint64_t _total_skip_data_size = 0;
+        uint64_t _total_ref_chunk_num = 0; // copied from the previous recipes
+
+        // for the upload checkpoints
+        uint64_t _total_ckpt_num = 0;
+
+        // for the credit-based flow control
+        uint64_t _total_credit_grant_num = 0;
+        uint64_t _total_credit_stall_num = 0; // the grants held by full MQs
+
+        // the client deltas against the previous version
+        uint64_t _total_version_delta_num = 0;
+
+        // the all-zero chunks (recipe entries only)
+        uint64_t _total_zero_chunk_num = 0;
+        uint64_t _total_zero_data_size = 0;
     
 #ifdef EDR_BREAKDOWN
         struct timeval _cipher_fp_stime;
@@ -109,8 +191,10 @@ class DataRecvThd{
          * 
          * @param server_channel the storage server channel
          * @param fp_2_addr_db fp to chunk addr index
+         * @param storage_core the storage core
          */
-        DataRecvThd(SSLConnection* server_channel, AbsDatabase* fp_2_addr_db);
+        DataRecvThd(AbsTransport* server_channel, AbsDatabase* fp_2_addr_db,
+            StorageCore* storage_core);
 
         /**
          * @brief Destroy the DataRecvThd object
@@ -37,6 +37,16 @@ class DataWriterThd {
         AbsDatabase* fp_2_addr_db_;
         AbsDatabase* feature_2_fp_db_;
 
+        // the sketches of the base chunks (NULL: a single base candidate),
+        // a hint for the base selection, only saved at the exit
+        AbsDatabase* fp_2_sketch_db_ = NULL;
+
+        // for top-k base candidates
+        uint64_t min_predicted_gain_;
+
+        // protect the stat updated by the delta workers
+        mutex stat_mtx_;
+
         /**
          * @brief process a similar chunk
          * 
@@ -46,20 +56,47 @@ class DataWriterThd {
         void ProcSimilarChunk(WrappedChunk_t* input_chunk, ClientVar* cur_client);
 
         /**
-         * @brief process a non-similar chunk 
+         * @brief process a cache delta chunk (decide how to store it)
          * 
          * @param input_chunk input chunk
          * @param cur_client current client
          */
-        void ProcNonSimilarChunk(WrappedChunk_t* input_chunk, ClientVar* cur_client);
+        void ProcCacheDeltaChunk(WrappedChunk_t* input_chunk,
+            ClientVar* cur_client);
 
         /**
-         * @brief process a cache delta chunk
+         * @brief query the address of a chunk (the chunks not appended yet
+         * are only known to this session)
+         * 
+         * @param fp the chunk fp
+         * @param addr the chunk address <ret>
+         * @param cur_client current client
+         * @return true found
+         * @return false not found
+         */
+        bool QueryChunkAddr(uint8_t* fp, KeyForChunkHashDB_t* addr,
+            ClientVar* cur_client);
+
+        /**
+         * @brief restore the uncompressed chunk from a cache delta chunk
          * 
          * @param input_chunk input chunk
          * @param cur_client current client
          */
-        void ProcCacheDeltaChunk(WrappedChunk_t* input_chunk, ClientVar* cur_client);
+        void RestoreCacheDeltaChunk(WrappedChunk_t* input_chunk,
+            ClientVar* cur_client);
+
+        /**
+         * @brief select the base candidate with the smallest predicted delta size
+         * 
+         * @param input_chunk input chunk
+         * @param candidates the ranked base candidates
+         * @param input_sketch the sketch of the input chunk
+         * @param cur_client current client
+         */
+        void SelectBaseCandidate(WrappedChunk_t* input_chunk,
+            vector<BaseCandidate_t>& candidates, uint32_t* input_sketch,
+            ClientVar* cur_client);
 
         /**
          * @brief fetch the base chunk
@@ -72,6 +109,14 @@ class DataWriterThd {
         uint32_t FetchBaseChunk(uint8_t* base_fp, uint8_t* base_data,
             ClientVar* cur_client);
 
+        /**
+         * @brief save the current container and make the index updates
+         * durable (at a checkpoint)
+         * 
+         * @param cur_client current client
+         */
+        void SealContainer(ClientVar* cur_client);
+
     public:
         // for delta compression
         uint64_t _total_similar_chunk_num = 0;
@@ -79,8 +124,6 @@ class DataWriterThd {
         uint64_t _total_delta_size = 0;
 
 #ifdef EDR_BREAKDOWN
-        struct timeval _comp_delta_stime;
-        struct timeval _comp_delta_etime;
         double _total_comp_delta_time = 0;
         uint64_t _total_comp_delta_data_size = 0;
 #endif
@@ -102,11 +145,26 @@ class DataWriterThd {
         ~DataWriterThd();
 
         /**
-         * @brief the main process
+         * @brief the main process (dispatch the chunks to the delta workers in order)
          * 
          * @param cur_client current client var
          */
         void Run(ClientVar* cur_client);
+
+        /**
+         * @brief the delta worker (fetch the base chunk and perform delta encoding)
+         * 
+         * @param cur_client current client var
+         * @param worker_id the worker id
+         */
+        void RunDeltaWorker(ClientVar* cur_client, uint32_t worker_id);
+
+        /**
+         * @brief the container appender (write the chunks to containers in order)
+         * 
+         * @param cur_client current client var
+         */
+        void RunAppender(ClientVar* cur_client);
 };
 
 #endif
\ No newline at end of file
@@ -21,18 +21,39 @@
 
 extern Configure config;
 
+class ClientVar;
+class StorageCore;
+
 class InformCache {
     private:
         string my_name_ = "InformCache";
         uint32_t client_id_;
         string cache_root_path_;
 
-        // feature to base fp
-        AbsDatabase* base_2_data_db_; // LevelDB
+        // per-client column families in the shared cache store
+        AbsDatabase* base_2_entry_db_; // base fp -> <cnt, chunk size, addr>
+        AbsDatabase* feature_2_fp_db_; // feature -> base fp
+
+        // the cached base chunks are stored in the cache containers of this
+        // client (apart from the chunk containers), a cache container is
+        // deleted once none of its base chunks is cached
+        StorageCore* storage_core_;
+        ClientVar* cur_client_;
+        Container_t* cache_container_; // the unsealed one
+        mutex cache_container_mtx_;
+
+        // container id -> the num of its cached base chunks (loaded on
+        // demand, stored under the prefixed key in the entry cf)
+        string container_key_prefix_ = "container_";
+        unordered_map<string, uint64_t> container_live_map_;
+
+        // persisted counters (stored under a reserved key in the entry cf)
+        string cache_stat_key_ = "cache_stat";
+        uint64_t feature_num_ = 0;
+        uint64_t cache_data_size_ = 0;
 
-        // record the reference count <cnt, chunk size>
-        unordered_map<string, pair<uint32_t,uint32_t>> base_2_cnt_idx_;
-        unordered_map<uint64_t, string> local_feature_2_fp_db_;
+        // base chunks whose count drops to zero in this session
+        unordered_set<string> zero_cnt_base_set_;
 
         // for feature computation
         FinesseUtil* finesse_util_;
@@ -46,27 +67,54 @@ class InformCache {
 
         // for delta compression
         DeltaComp* delta_comp_;
-        string cache_base_chunk_str_;
+        uint8_t cache_base_chunk_[ENC_MAX_CHUNK_SIZE];
+
+        /**
+         * @brief read a cached base chunk (hot buffer first, then container)
+         * 
+         * @param base_entry the cache entry of the base chunk
+         * @param base_fp base chunk fp
+         * @param output_base output base chunk <ret>
+         */
+        void ReadBaseChunk(CacheEntry_t* base_entry, uint8_t* base_fp,
+            uint8_t* output_base);
+
+        /**
+         * @brief append a base chunk to the cache container
+         * 
+         * @param data the base chunk
+         * @param size the base chunk size
+         * @param addr the base chunk address <ret>
+         */
+        void AppendBaseChunk(uint8_t* data, uint32_t size,
+            KeyForChunkHashDB_t* addr);
 
         /**
-         * @brief load cnt index
+         * @brief get the num of the cached base chunks in a cache container
          * 
+         * @param container_id the container id
+         * @return uint64_t* the num (NULL: not a cache container)
          */
-        void LoadCntIdx();
+        uint64_t* GetLiveNum(const string& container_id);
 
         /**
-         * @brief store cnt index
+         * @brief store the nums of the cached base chunks, and delete the
+         * cache containers without any cached base chunk
          * 
          */
-        void StoreCntIdx();
+        void FlushLiveNum();
 
     public:
         /**
          * @brief Construct a new InformCache object
          * 
          * @param client_id client id
+         * @param cache_store the shared cache store
+         * @param storage_core the storage core
+         * @param cur_client the current client
          */
-        InformCache(uint32_t client_id);
+        InformCache(uint32_t client_id, RocksdbCFStore* cache_store,
+            StorageCore* storage_core, ClientVar* cur_client);
 
         /**
          * @brief Destroy the InformCache object
@@ -13,6 +13,8 @@
 #define EDRSTORE_SERVER_OPT_THD_H
 
 #include <boost/thread/thread.hpp>
+#include <condition_variable>
+#include <openssl/rand.h>
 
 // for upload
 #include "../server/data_recv_thd.h"
@@ -28,7 +30,7 @@
 #include "../database/db_factory.h"
 #include "../server/client_var.h"
 #include "../server/storage_core.h" 
-#include "../network/ssl_conn.h"
+#include "../network/abs_transport.h"
 #include "../configure.h"
 #include "../reduction/dedup_detect.h"
 #include "../reduction/delta_comp.h"
@@ -44,7 +46,7 @@ class ServerOptThd {
         string persist_stat_name_ = "persist-stat";
 
         // for storage server connection channel
-        SSLConnection* server_channel_;
+        AbsTransport* server_channel_;
 
         // for storage operation
         StorageCore* storage_core_;
@@ -63,10 +65,37 @@ class ServerOptThd {
         AbsDatabase* fp_2_addr_db_;
         AbsDatabase* feature_2_fp_db_;
 
+        // shared inform cache store (opened on the first FULL_EDR upload)
+        RocksdbCFStore* inform_cache_store_ = NULL;
+        std::mutex inform_cache_store_lck_;
+
+        // chunk owner store (opened on the first fingerprint-first upload)
+        RocksdbCFStore* owner_store_ = NULL;
+        std::mutex owner_store_lck_;
+
+        // sessions waiting for their stripe connections (by session token)
+        unordered_map<uint64_t, ClientVar*> stripe_session_idx_;
+        std::mutex stripe_session_lck_;
+        std::condition_variable stripe_session_cv_;
+
         // locks for multiple clients
         unordered_map<int, boost::mutex*> client_lck_idx_;
         std::mutex client_idx_lck_;
 
+        // the session worker pool: the established sessions wait in the
+        // queue with their login messages
+        vector<boost::thread*> worker_list_;
+        deque<pair<Conn_t*, uint8_t*>> session_queue_;
+        std::mutex session_queue_lck_;
+        std::condition_variable session_queue_cv_;
+        bool is_stop_ = false;
+
+        /**
+         * @brief the session worker (run the queued sessions one by one)
+         * 
+         */
+        void RunWorker();
+
         /**
          * @brief lock the mutex of a given client id
          * 
@@ -91,6 +120,89 @@ class ServerOptThd {
          */
         bool CheckFileStat(string& recipe_path, int opt_type);
 
+        /**
+         * @brief get the shared inform cache store (open it lazily)
+         * 
+         * @return RocksdbCFStore* the inform cache store
+         */
+        RocksdbCFStore* GetInformCacheStore();
+
+        /**
+         * @brief get the shared chunk owner store (open it lazily)
+         * 
+         * @return RocksdbCFStore* the chunk owner store
+         */
+        RocksdbCFStore* GetOwnerStore();
+
+        /**
+         * @brief register a session that waits for its stripe connections
+         * 
+         * @param cur_client the current client
+         * @param stripe_num the number of connections
+         * @param stripe_token the session token
+         */
+        void OpenStripes(ClientVar* cur_client, uint32_t stripe_num,
+            uint64_t stripe_token);
+
+        /**
+         * @brief wait until all stripe connections of a session join
+         * 
+         * @param cur_client the current client
+         * @param stripe_token the session token
+         * @return true all stripes join in time
+         */
+        bool WaitStripes(ClientVar* cur_client, uint64_t stripe_token);
+
+        /**
+         * @brief close the connections of a session that fails before its
+         * threads start, the other sessions keep running
+         * 
+         * @param cur_client the current client (deleted)
+         * @param stripe_token the session token
+         */
+        void AbandonSession(ClientVar* cur_client, uint64_t stripe_token);
+
+        /**
+         * @brief attach a stripe connection to its session
+         * 
+         * @param client_ssl the stripe connection
+         * @param recv_buf the stripe login
+         */
+        void JoinStripe(Conn_t* client_ssl, SendMsgBuffer_t* recv_buf);
+
+        /**
+         * @brief switch a connection of the session to the authenticated-only
+         * data frames after its login response (if negotiated)
+         * 
+         * @param cur_client the current client
+         * @param client_ssl the connection
+         */
+        void EnableAuthOnly(ClientVar* cur_client, Conn_t* client_ssl);
+
+        /**
+         * @brief remove the index entries of an interrupted upload whose
+         * containers were never saved, and remove its journal
+         * 
+         * @param recipe_path the full recipe path
+         */
+        void RollbackIndex(string& recipe_path);
+
+        /**
+         * @brief load the checkpointed chunk num of an interrupted upload
+         * 
+         * @param recipe_path the full recipe path
+         * @return uint64_t the checkpointed chunk num (0: no checkpoint)
+         */
+        uint64_t LoadCheckpoint(string& recipe_path);
+
+        /**
+         * @brief make the index updates durable after the upload, and keep a
+         * checkpoint if it is interrupted
+         * 
+         * @param cur_client the current client
+         */
+        void CloseCheckpoint(ClientVar* cur_client);
+
         /**
          * @brief load previous stat 
          * 
@@ -121,7 +233,7 @@ class ServerOptThd {
          * @param fp_2_addr_db the fp to address index
          * @param feature_2_fp_db the feature to base hash index
          */
-        ServerOptThd(SSLConnection* server_channel, AbsDatabase* fp_2_addr_db, 
+        ServerOptThd(AbsTransport* server_channel, AbsDatabase* fp_2_addr_db, 
             AbsDatabase* feature_2_fp_db);
 
         /**
@@ -130,12 +242,33 @@ class ServerOptThd {
          */
         ~ServerOptThd();
 
+        // the max size of a login message
+        static const uint32_t LOGIN_SIZE = sizeof(NetworkHead_t) +
+            CHUNK_HASH_SIZE + sizeof(uint32_t) * 6 + sizeof(uint64_t);
+
+        /**
+         * @brief roll back the journals of the uploads interrupted by a
+         * crash, before any connection is accepted
+         * 
+         */
+        void RollbackJournals();
+
+        /**
+         * @brief dispatch an established connection (called by the reactor)
+         * 
+         * @param client_ssl the connection
+         * @param login the login message
+         * @param login_size the login size
+         */
+        void Dispatch(Conn_t* client_ssl, uint8_t* login, uint32_t login_size);
+
         /**
-         * @brief the main thread
+         * @brief the main thread of a session
          * 
-         * @param client_ssl 
+         * @param client_ssl the connection
+         * @param login_buf the login message (freed by the session)
          */
-        void Run(SSL* client_ssl);
+        void Run(Conn_t* client_ssl, uint8_t* login_buf);
 };
 
 #endif
\ No newline at end of file
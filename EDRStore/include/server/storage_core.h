@@ -73,6 +73,21 @@ class StorageCore {
          * @param new_container new container
          */
         void SaveContainer(Container_t* new_container);
+
+        /**
+         * @brief check whether a container is saved
+         * 
+         * @param container_id the container id
+         * @return true the container file exists
+         */
+        bool ContainerExist(const uint8_t* container_id);
+
+        /**
+         * @brief delete a saved container (no chunk refers to it)
+         * 
+         * @param container_id the container id
+         */
+        void DeleteContainer(const uint8_t* container_id);
 };
 
 #endif
\ No newline at end of file
@@ -23,6 +23,12 @@
 #include "../../include/client/download_writer_thd.h"
 #include "../../include/client/data_retriever_thd.h"
 
+// for multi-file session
+#include "../../include/client/file_index.h"
+#include "../../include/client/version_delta.h"
+
+#include "../../include/network/transport_factory.h"
+
 #include <boost/thread/thread.hpp>
 
 using namespace std;
@@ -41,12 +47,15 @@ string client_stat_file_name = "client-stat";
 Configure config("config.json");
 string my_name = "ClientMain";
 string log_file_name = "client-log";
+// the input path of a stream (stdin)
+string stdin_path = "-";
 ofstream log_file;
 MQFactory<Chunk_t> chunk_mq_factory;
 MQFactory<FeatureChunk_t> feature_chunk_mq_factory;
 MQFactory<EncFeatureChunk_t> enc_feature_chunk_mq_factory;
 MQFactory<SelectComp2Sender_t> select_comp_2_sender_mq_factory;
 MQFactory<Retriever2Writer_t> retriever_2_writer_mq_factory;
+TransportFactory transport_factory;
 
 uint32_t MQ_TYPE = LCK_FREE_MQ;
 
@@ -57,10 +66,15 @@ string breakdown_stat_file_name = "breakdown-stat";
 #endif
 
 void Usage() {
-    fprintf(stderr, "%s -t [u/d] -i [input file path] -m .\n"
+    fprintf(stderr, "%s -t [u/d] -i [input file/directory path] -m .\n"
         "-t: operation ([u/d]):\n"
         "\tu: upload\n"
         "\td: download\n"
+        "-i: a file, or a directory (all files in one session), or a pipe "
+        "(a FIFO, or '-' for stdin/stdout)\n"
+        "-l: a file list (one path per line, all files in one session), "
+        "instead of -i\n"
+        "-n: the session name (default: the input path), required for stdin\n"
         "-m: method type:\n"
         "\t0: similar-aware encryption\n"
         "\t1: similar-aware encryption + local compression\n"
@@ -114,10 +128,11 @@ int main(int argc, char* argv[]) {
     // printf("%d", ee.tv_usec);
     //cout<<ss.tv_sec<<" "<<ss.tv_usec<<endl;
 
-    const char opt_str[] = "t:i:m:";
+    const char opt_str[] = "t:i:l:m:n:";
     int option;
 
-    if (argc < (int)sizeof(opt_str)) {
+    // -t, -i (or -l), -m
+    if (argc < 7) {
         tool::Logging(my_name.c_str(), "wrong argc: %d\n", argc);
         Usage();
         exit(EXIT_FAILURE);
@@ -125,6 +140,8 @@ int main(int argc, char* argv[]) {
 
     uint32_t opt_type;
     string input_file_path;
+    string session_name;
+    bool is_file_list = false;
     uint32_t method_type;
     while ((option = getopt(argc, argv, opt_str)) != -1) {
         switch (option) {
@@ -144,6 +161,15 @@ int main(int argc, char* argv[]) {
                 input_file_path.assign(optarg);
                 break;
             }
+            case 'l': {
+                input_file_path.assign(optarg);
+                is_file_list = true;
+                break;
+            }
+            case 'n': {
+                session_name.assign(optarg);
+                break;
+            }
             case 'm': {
                 switch (atoi(optarg)) {
                     case ONLY_SIMILAR_ENC: {
@@ -175,6 +201,15 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (session_name.empty()) {
+        if (input_file_path == stdin_path) {
+            tool::Logging(my_name.c_str(), "stdin needs a session name (-n).\n");
+            Usage();
+            exit(EXIT_FAILURE);
+        }
+        session_name = input_file_path;
+    }
+
     vector<boost::thread*> thd_list;
     boost::thread* tmp_thd;
     boost::thread::attributes thd_attrs;
@@ -187,24 +222,30 @@ int main(int argc, char* argv[]) {
     SelectCompThd* select_comp_thd = nullptr;
     SenderThd* sender_thd = nullptr;
     CacheMeta* cache_meta = nullptr;
+    VersionDelta* version_delta = nullptr;
+
+    // for a multi-file session (a directory or a file list)
+    FileIndex* file_index = nullptr;
 
     // for download operation
     DownloadWriterThd* download_writer_thd = nullptr;
     DataRetrieverThd* data_retriever_thd = nullptr;
 
     // for connection 
-    SSLConnection* server_channel;
-    pair<int, SSL*> server_conn_record;
-    SSLConnection* km_channel = nullptr;
-    pair<int, SSL*> km_conn_record;
+    AbsTransport* server_channel;
+    pair<int, Conn_t*> server_conn_record;
+    AbsTransport* km_channel = nullptr;
+    pair<int, Conn_t*> km_conn_record;
 
-    server_channel = new SSLConnection(config.GetStorageServerIP(),
-        config.GetStorageServerPort(), IN_CLIENT_SIDE);
-    server_conn_record = server_channel->ConnectSSL();
+    server_channel = transport_factory.CreateTransport(
+        config.GetStorageServerTransport(), config.GetStorageServerIP(),
+        config.GetStorageServerPort(), config.GetStorageServerUnixPath(),
+        IN_CLIENT_SIDE);
+    server_conn_record = server_channel->Connect();
 
     // compute the file name hash
     uint32_t client_id = config.GetClientID();
-    string full_name = input_file_path + to_string(client_id);
+    string full_name = session_name + to_string(client_id);
     uint8_t file_name_hash[CHUNK_HASH_SIZE] = {0};
     CryptoUtil* crypto_util = new CryptoUtil(CIPHER_TYPE, HASH_TYPE);
     EVP_MD_CTX* md_ctx = EVP_MD_CTX_new();
@@ -212,30 +253,65 @@ int main(int argc, char* argv[]) {
         file_name_hash);
     delete crypto_util;
     EVP_MD_CTX_free(md_ctx);
+    file_index = new FileIndex(file_name_hash);
 
     switch (opt_type) {
         case UPLOAD_OPT: {
             ifstream input_file_hdl;
             tool::Logging(my_name.c_str(), "upload input file name: %s\n",
                 input_file_path.c_str());
-            input_file_hdl.open(input_file_path, ios_base::in | ios_base::binary);
-            if (!input_file_hdl.is_open()) {
-                tool::Logging(my_name.c_str(), "cannot open the input file: %s\n",
-                    input_file_path.c_str());
-                exit(EXIT_FAILURE);
+            bool is_file_set = is_file_list ||
+                filesystem::is_directory(input_file_path);
+            if (is_file_list) {
+                file_index->AddFileList(input_file_path);
+            } else if (is_file_set) {
+                file_index->AddDirectory(input_file_path);
+            }
+            if (is_file_set && config.GetSkipUnchangedFile()) {
+                // the unchanged files refer to the previous version
+                FileIndex prev_file_index(file_name_hash);
+                if (prev_file_index.Exist()) {
+                    prev_file_index.Load();
+                    file_index->MatchPrevious(&prev_file_index);
+                }
+            }
+            string input_open_path = input_file_path == stdin_path ?
+                "/dev/stdin" : input_file_path;
+            if (!is_file_set) {
+                // a pipe is chunked as it arrives, its size is unknown
+                input_file_hdl.open(input_open_path, ios_base::in |
+                    ios_base::binary);
+                if (!input_file_hdl.is_open()) {
+                    tool::Logging(my_name.c_str(), "cannot open the input file: %s\n",
+                        input_file_path.c_str());
+                    exit(EXIT_FAILURE);
+                }
             }
 
             chunk_fp_thd = new ChunkerFPThd();
             plain_similar_thd = new PlainSimilarThd();
-            km_channel = new SSLConnection(config.GetKeyServerIP(),
-                config.GetKeyServerPort(), IN_CLIENT_SIDE);
-            km_conn_record = km_channel->ConnectSSL();
+            km_channel = transport_factory.CreateTransport(
+                config.GetKeyServerTransport(), config.GetKeyServerIP(),
+                config.GetKeyServerPort(), config.GetKeyServerUnixPath(),
+                IN_CLIENT_SIDE);
+            km_conn_record = km_channel->Connect();
             key_gen_thd = new KeyGenThd(km_channel, km_conn_record);
             cipher_similar_thd = new CipherSimilarThd();
             cache_meta = new CacheMeta(server_channel, server_conn_record);
             select_comp_thd = new SelectCompThd(cache_meta, method_type);
             sender_thd = new SenderThd(server_channel, server_conn_record,
-                file_name_hash, cache_meta);
+                file_name_hash, cache_meta, method_type);
+            sender_thd->SetRecipeRef(&file_index->_ref_list);
+            if (config.GetVersionDelta()) {
+                // the base is referred to by the fp of its ciphertext
+                if (method_type == ONLY_SIMILAR_ENC) {
+                    version_delta = new VersionDelta(file_name_hash);
+                    select_comp_thd->SetVersionDelta(version_delta);
+                } else {
+                    tool::Logging(my_name.c_str(), "the version delta only "
+                        "works with method 0, it is disabled.\n");
+                }
+            }
 
 #ifdef EDR_BREAKDOWN
             // restore the breakdown status
@@ -296,11 +372,36 @@ int main(int argc, char* argv[]) {
             AbsMQ<SelectComp2Sender_t>* select_comp_mq =
                 select_comp_2_sender_mq_factory.CreateMQ(MQ_TYPE, CHUNK_QUEUE_SIZE);
 
+            // an interrupted upload of the same input is resumed
+            string input_stamp;
+            if (is_file_set) {
+                input_stamp = file_index->GetStamp();
+            } else {
+                // a pipe cannot be replayed, it is never resumed
+                struct stat input_stat;
+                if (stat(input_file_path.c_str(), &input_stat) == 0 &&
+                    S_ISREG(input_stat.st_mode)) {
+                    input_stamp = input_file_path + ":" +
+                        to_string(input_stat.st_size) + ":" +
+                        to_string(input_stat.st_mtim.tv_sec) + "." +
+                        to_string(input_stat.st_mtim.tv_nsec) + ":" +
+                        to_string(input_stat.st_ino);
+                }
+            }
+            sender_thd->SetInputStamp(input_stamp);
+
             // send the upload login to notify the server
             sender_thd->UploadLogin(file_name_hash);
-
-            tmp_thd = new boost::thread(thd_attrs, boost::bind(&ChunkerFPThd::Run,
-                chunk_fp_thd, &input_file_hdl, chunker_mq));
+            chunk_fp_thd->SetSkipChunkNum(sender_thd->GetResumeChunkNum());
+
+            if (is_file_set) {
+                tmp_thd = new boost::thread(thd_attrs, boost::bind(
+                    &ChunkerFPThd::RunFileList, chunk_fp_thd, file_index,
+                    chunker_mq));
+            } else {
+                tmp_thd = new boost::thread(thd_attrs, boost::bind(&ChunkerFPThd::Run,
+                    chunk_fp_thd, &input_file_hdl, input_open_path, chunker_mq));
+            }
             thd_list.push_back(tmp_thd);
             tmp_thd = new boost::thread(thd_attrs, boost::bind(&PlainSimilarThd::Run,
                 plain_similar_thd, chunker_mq, plain_similar_mq));
@@ -317,6 +418,11 @@ int main(int argc, char* argv[]) {
             tmp_thd = new boost::thread(thd_attrs, boost::bind(&SenderThd::Run,
                 sender_thd, select_comp_mq));
             thd_list.push_back(tmp_thd);
+            for (uint32_t i = 0; i < sender_thd->GetStripeNum(); i++) {
+                tmp_thd = new boost::thread(thd_attrs, boost::bind(&SenderThd::RunIO,
+                    sender_thd, i));
+                thd_list.push_back(tmp_thd);
+            }
 
       
       	    gettimeofday(&stime, NULL);
@@ -409,7 +515,25 @@ int main(int argc, char* argv[]) {
             out_breakdown_stat_hdl.close();
 #endif
 
-            input_file_hdl.close();
+            // the per-file recipe index of this session
+            if (is_file_set) {
+                file_index->Store();
+            } else {
+                input_file_hdl.close();
+                if (file_index->Exist()) {
+                    file_index->Remove();
+                }
+            }
+            if (version_delta != nullptr) {
+                // the signature of a resumed upload misses the chunks before
+                // the checkpoint
+                if (sender_thd->GetResumeChunkNum() != 0) {
+                    version_delta->Discard();
+                } else {
+                    version_delta->Commit(&file_index->_ref_list);
+                }
+                delete version_delta;
+            }
             delete chunk_fp_thd;
             delete plain_similar_thd;
             delete key_gen_thd;
@@ -440,10 +564,43 @@ int main(int argc, char* argv[]) {
             
             data_retriever_thd = new DataRetrieverThd(server_channel,
                 server_conn_record, file_name_hash, method_type);
-            download_writer_thd = new DownloadWriterThd(input_file_path);
+            // restore to stdout, or into an existing FIFO
+            struct stat output_stat;
+            bool is_stream = input_file_path == stdin_path ||
+                (stat(input_file_path.c_str(), &output_stat) == 0 &&
+                S_ISFIFO(output_stat.st_mode));
+            if (is_stream && file_index->Exist()) {
+                tool::Logging(my_name.c_str(), "a multi-file session cannot be "
+                    "restored to a stream.\n");
+                exit(EXIT_FAILURE);
+            }
+            if (is_stream) {
+                FILE* stream_hdl = stdout;
+                if (input_file_path != stdin_path) {
+                    stream_hdl = fopen(input_file_path.c_str(), "wb");
+                    if (stream_hdl == NULL) {
+                        tool::Logging(my_name.c_str(), "cannot open the "
+                            "output pipe: %s\n", input_file_path.c_str());
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                download_writer_thd = new DownloadWriterThd(stream_hdl);
+            } else if (file_index->Exist()) {
+                // restore all files of the session to a directory
+                file_index->Load();
+                download_writer_thd = new DownloadWriterThd(input_file_path,
+                    file_index);
+            } else {
+                download_writer_thd = new DownloadWriterThd(input_file_path);
+            }
 
+            // the restored chunks in flight, bounded by the restore window
+            uint32_t restore_window_chunk_num = max((uint64_t)1,
+                config.GetRestoreWindow() * 1024 * 1024 /
+                sizeof(Retriever2Writer_t));
             AbsMQ<Retriever2Writer_t>* retriever_mq =
-                retriever_2_writer_mq_factory.CreateMQ(MQ_TYPE, CHUNK_HASH_SIZE);
+                retriever_2_writer_mq_factory.CreateMQ(MQ_TYPE,
+                restore_window_chunk_num);
 
             data_retriever_thd->DownloadLogin(file_name_hash);
 
@@ -486,6 +643,7 @@ int main(int argc, char* argv[]) {
 
     // clear the connection
     delete server_channel;
+    delete file_index;
 
 #ifdef EDR_BREAKDOWN
     breakdown_client_file_hdl.close();
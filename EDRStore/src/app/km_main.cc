@@ -11,6 +11,7 @@
 
 #include "../../include/key_manager/basic_km.h"
 #include "../../include/database/db_factory.h"
+#include "../../include/network/transport_factory.h"
 
 // to receive the interrupt
 #include <signal.h>
@@ -20,7 +21,8 @@ using namespace std;
 
 Configure config("config.json");
 
-SSLConnection* km_channel;
+TransportFactory transport_factory;
+AbsTransport* km_channel;
 vector<boost::thread*> th_list;
 
 // the key manager main thread
@@ -76,8 +78,9 @@ int main(int argc, char* argv[]) {
 
     // init
     feature_2_key_index = db_factory.CreateDatabase(IN_MEMORY_DB, config.GetFeature2KeyDBName());
-    km_channel = new SSLConnection(config.GetKeyServerIP(), config.GetKeyServerPort(),
-        IN_SERVER_SIDE);
+    km_channel = transport_factory.CreateTransport(config.GetKeyServerTransport(),
+        config.GetKeyServerIP(), config.GetKeyServerPort(),
+        config.GetKeyServerUnixPath(), IN_SERVER_SIDE);
     km_ = new BasicKM(km_channel, feature_2_key_index);
 
     /**
@@ -88,7 +91,7 @@ int main(int argc, char* argv[]) {
 
     while (true) {
         tool::Logging(my_name.c_str(), "waiting the request from the client.\n");
-        SSL* client_ssl = km_channel->ListenSSL().second;
+        Conn_t* client_ssl = km_channel->Listen().second;
         tmp_th = new boost::thread(attrs, boost::bind(&BasicKM::Run,
             km_, client_ssl));
         th_list.push_back(tmp_th);
@@ -10,7 +10,8 @@
  */
 
 #include "../../include/configure.h"
-#include "../../include/network/ssl_conn.h"
+#include "../../include/network/transport_factory.h"
+#include "../../include/network/conn_reactor.h"
 #include "../../include/database/db_factory.h"
 #include "../../include/server/server_opt_thd.h"
 
@@ -22,15 +23,18 @@ using namespace std;
 
 Configure config("config.json");
 
-SSLConnection* server_channel;
+TransportFactory transport_factory;
+AbsTransport* server_channel;
 DatabaseFactory db_factory;
 AbsDatabase* fp_2_addr_db;
 AbsDatabase* feature_2_fp_db;
-vector<boost::thread*> thd_list;
 
 // the server main thread
 ServerOptThd* server_opt_thd;
 
+// accept the connections
+ConnReactor* conn_reactor;
+
 string my_name = "EDRServer";
 
 void Usage() {
@@ -43,13 +47,8 @@ void CTRLC(int s) {
     tool::Logging(my_name.c_str(), "terminated with ctrl+c interrupt.\n");
 
     // -------- clean up --------
-    for (auto it : thd_list) {
-        it->join();
-    }
-    
-    for (auto it : thd_list) {
-        delete it;
-    }
+    delete conn_reactor;
+    // wait for the running sessions
     delete server_opt_thd;
     tool::Logging(my_name.c_str(), "clear all server threads.\n");
 
@@ -76,21 +75,23 @@ int main(int argc, char* argv[]) {
 
     srand(tool::GetStrongSeed());
 
-    boost::thread* tmp_thd;
-    boost::thread_attributes attrs;
-    attrs.set_stack_size(THREAD_STACK_SIZE);
-
     fp_2_addr_db = db_factory.CreateDatabase(IN_MEMORY_DB,
         config.GetFp2ChunkDBName());
     feature_2_fp_db = db_factory.CreateDatabase(IN_MEMORY_DB,
         config.GetFeature2FpDBName());
 
-    server_channel = new SSLConnection(config.GetStorageServerIP(),
-        config.GetStorageServerPort(), IN_SERVER_SIDE);
+    server_channel = transport_factory.CreateTransport(
+        config.GetStorageServerTransport(), config.GetStorageServerIP(),
+        config.GetStorageServerPort(), config.GetStorageServerUnixPath(),
+        IN_SERVER_SIDE);
 
     // init
     server_opt_thd = new ServerOptThd(server_channel, fp_2_addr_db,
         feature_2_fp_db);
+    // the interrupted uploads may resume on any connection
+    server_opt_thd->RollbackJournals();
+    conn_reactor = new ConnReactor(server_channel, ServerOptThd::LOGIN_SIZE,
+        boost::bind(&ServerOptThd::Dispatch, server_opt_thd, _1, _2, _3));
 
     /**
      * |---------------------------------------|
@@ -98,13 +99,7 @@ int main(int argc, char* argv[]) {
      * |---------------------------------------|
      */
 
-    while (true) {
-        tool::Logging(my_name.c_str(), "waiting the req from the client.\n");
-        SSL* client_ssl = server_channel->ListenSSL().second;
-        tmp_thd = new boost::thread(attrs, boost::bind(&ServerOptThd::Run,
-            server_opt_thd, client_ssl));
-        thd_list.push_back(tmp_thd);
-    } 
+    conn_reactor->Run();
 
     return 0;
 }
\ No newline at end of file
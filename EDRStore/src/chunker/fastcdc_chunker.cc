@@ -35,10 +35,11 @@ FastCDC::~FastCDC() {
  * @brief load the data from the file
  * 
  * @param input_file the input file handler
+ * @param max_read_size the max read size (stop at the next hole)
  * @return uint32_t the read size
  */
-uint32_t FastCDC::LoadDataFromFile(ifstream& input_file) {
-    input_file.read((char*)read_data_buf_, read_size_);
+uint32_t FastCDC::LoadDataFromFile(ifstream& input_file, uint64_t max_read_size) {
+    input_file.read((char*)read_data_buf_, min(read_size_, max_read_size));
     pending_chunking_size_ = input_file.gcount();
 
     // reset the offset
@@ -17,13 +17,16 @@
  * @param server_channel the connection to the storage server
  * @param server_conn_record the storage server connection record
  */
-CacheMeta::CacheMeta(SSLConnection* server_channel,
-    pair<int, SSL*> server_conn_record) {
-    this->LoadCacheMeta();
-    cur_version_num_++;
+CacheMeta::CacheMeta(AbsTransport* server_channel,
+    pair<int, Conn_t*> server_conn_record) {
     send_recipe_batch_size_ = config.GetSendRecipeBatchSize();
     client_id_ = config.GetClientID();
 
+    // only map the table here, it is updated by the FULL_EDR upload
+    if (this->MapCacheMeta(db_name_, 0)) {
+        _total_similar_chunk = head_->total_similar_chunk;
+    }
+
     // init the evict feature send buf
     evict_feature_buf_.send_buf = (uint8_t*) malloc(send_recipe_batch_size_ * 
         sizeof(uint64_t) + sizeof(NetworkHead_t));
@@ -44,97 +47,418 @@ CacheMeta::CacheMeta(SSLConnection* server_channel,
  * 
  */
 CacheMeta::~CacheMeta(){
-    this->StoreCacheMeta();
+    if (head_ != NULL) {
+        tool::Logging(my_name_.c_str(), "cached feature num: %lu, rejected "
+            "cache chunk num: %lu\n", head_->item_num, _total_reject_chunk);
+        head_->total_similar_chunk = _total_similar_chunk;
+        this->UnmapCacheMeta();
+    }
     free(evict_feature_buf_.send_buf);
 }
 
 /**
- * @brief load cache metadata
+ * @brief map the cache metadata file
  * 
+ * @param db_name the file name
+ * @param slot_num the slot num of a new file (0: only open an existing
+ * file)
+ * @return true success
+ * @return false the file does not exist or is not a valid table
  */
-void CacheMeta::LoadCacheMeta() {
-    // check cache meta data exist
-    ifstream cache_meta_hdl;
-    if (tool::FileExist(db_name_)) {
-        // check the file size
-        cache_meta_hdl.open(db_name_, ios_base::in | ios_base::binary);
-        if (!cache_meta_hdl.is_open()) {
+bool CacheMeta::MapCacheMeta(string& db_name, uint64_t slot_num) {
+    CacheMetaHead_t tmp_head;
+    if (slot_num == 0) {
+        // open an existing table
+        if (!tool::FileExist(db_name)) {
+            return false;
+        }
+        db_fd_ = open(db_name.c_str(), O_RDWR);
+        if (db_fd_ < 0) {
             tool::Logging(my_name_.c_str(), "cannot open the cache meta.\n");
             exit(EXIT_FAILURE);
         }
+        if (pread(db_fd_, &tmp_head, sizeof(CacheMetaHead_t), 0) !=
+            sizeof(CacheMetaHead_t) || tmp_head.magic != CACHE_META_MAGIC) {
+            // the previous whole-file format, rebuilt by the FULL_EDR upload
+            close(db_fd_);
+            db_fd_ = -1;
+            return false;
+        }
+        slot_num = tmp_head.slot_num;
+    } else {
+        db_fd_ = open(db_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (db_fd_ < 0) {
+            tool::Logging(my_name_.c_str(), "cannot init the cache meta.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
 
-        size_t start_size = cache_meta_hdl.tellg();
-        cache_meta_hdl.seekg(0, ios_base::end);
-        size_t file_size = cache_meta_hdl.tellg();
-        file_size = file_size - start_size;
-
-        if (file_size == 0) {
-            return ;
+    db_size_ = sizeof(CacheMetaHead_t) + slot_num * sizeof(CacheMetaSlot_t) +
+        slot_num * CACHE_META_SKETCH_ROW;
+    struct stat db_stat;
+    fstat(db_fd_, &db_stat);
+    if (static_cast<size_t>(db_stat.st_size) != db_size_) {
+        if (ftruncate(db_fd_, db_size_) != 0) {
+            tool::Logging(my_name_.c_str(), "cannot resize the cache meta.\n");
+            exit(EXIT_FAILURE);
         }
-        cache_meta_hdl.seekg(0, ios_base::beg);
+    }
+
+    db_buf_ = (uint8_t*) mmap(NULL, db_size_, PROT_READ | PROT_WRITE,
+        MAP_SHARED, db_fd_, 0);
+    if (db_buf_ == MAP_FAILED) {
+        tool::Logging(my_name_.c_str(), "cannot map the cache meta.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    head_ = (CacheMetaHead_t*) db_buf_;
+    slot_ = (CacheMetaSlot_t*) (db_buf_ + sizeof(CacheMetaHead_t));
+    sketch_ = db_buf_ + sizeof(CacheMetaHead_t) +
+        slot_num * sizeof(CacheMetaSlot_t);
+    if (head_->magic != CACHE_META_MAGIC) {
+        // a new table (the file is zero-filled)
+        head_->magic = CACHE_META_MAGIC;
+        head_->slot_num = slot_num;
+        head_->item_num = 0;
+        head_->total_similar_chunk = 0;
+        head_->sketch_add_cnt = 0;
+        head_->cur_version_num = 0;
+        head_->head = CACHE_META_NIL;
+        head_->tail = CACHE_META_NIL;
+    }
+    slot_mask_ = slot_num - 1;
+    sketch_mask_ = slot_num - 1;
+    max_item_num_ = slot_num / 4 * 3;
 
-        cache_meta_hdl.read((char*)&_total_similar_chunk, sizeof(uint64_t));
-        cache_meta_hdl.read((char*)&cur_version_num_, sizeof(uint32_t));
+    return true;
+}
+
+/**
+ * @brief unmap the cache metadata file
+ * 
+ */
+void CacheMeta::UnmapCacheMeta() {
+    msync(db_buf_, db_size_, MS_ASYNC);
+    munmap(db_buf_, db_size_);
+    close(db_fd_);
+    db_fd_ = -1;
+    db_buf_ = NULL;
+    head_ = NULL;
+    slot_ = NULL;
+    sketch_ = NULL;
+    return ;
+}
+
+/**
+ * @brief get the slot num under the memory budget
+ * 
+ * @return uint64_t the slot num
+ */
+uint64_t CacheMeta::GetBudgetSlotNum() {
+    uint64_t budget = config.GetCacheMetaBudget() << 20;
+    uint64_t max_slot_num = (budget - sizeof(CacheMetaHead_t)) /
+        (sizeof(CacheMetaSlot_t) + CACHE_META_SKETCH_ROW);
+    uint64_t slot_num = 1024;
+    while (slot_num * 2 <= max_slot_num && slot_num * 2 <= (1ULL << 31)) {
+        slot_num *= 2;
+    }
+    return slot_num;
+}
 
-        // it exists in the client, read it
+/**
+ * @brief rebuild the table with the configured budget (keep the latest
+ * features, evict the others)
+ * 
+ * @param slot_num the new slot num
+ */
+void CacheMeta::ResizeCacheMeta(uint64_t slot_num) {
+    // <feature, version> from the oldest one
+    vector<pair<uint64_t, uint32_t>> item_list;
+    uint32_t cur_version_num = 0;
+    uint64_t total_similar_chunk = 0;
+    if (head_ != NULL) {
+        for (uint32_t id = head_->head; id != CACHE_META_NIL;
+            id = slot_[id].next) {
+            item_list.push_back({slot_[id].feature, slot_[id].version});
+        }
+        cur_version_num = head_->cur_version_num;
+        total_similar_chunk = _total_similar_chunk;
+        this->UnmapCacheMeta();
+    } else if (tool::FileExist(db_name_)) {
+        // the previous whole-file format
+        ifstream cache_meta_hdl;
+        cache_meta_hdl.open(db_name_, ios_base::in | ios_base::binary);
+        if (!cache_meta_hdl.is_open()) {
+            tool::Logging(my_name_.c_str(), "cannot open the cache meta.\n");
+            exit(EXIT_FAILURE);
+        }
         size_t idx_item_num = 0;
+        cache_meta_hdl.read((char*)&total_similar_chunk, sizeof(uint64_t));
+        cache_meta_hdl.read((char*)&cur_version_num, sizeof(uint32_t));
         cache_meta_hdl.read((char*)&idx_item_num, sizeof(size_t));
-        if (idx_item_num == 0) {
-            return ;
-        }
-
         uint64_t feature;
         uint32_t version_num;
-        for (size_t i = 0; i < idx_item_num; i++) {
+        for (size_t i = 0; i < idx_item_num && cache_meta_hdl.good(); i++) {
             cache_meta_hdl.read((char*)&feature, sizeof(uint64_t));
             cache_meta_hdl.read((char*)&version_num, sizeof(uint32_t));
-            feature_2_version_idx_[feature] = version_num;
+            item_list.push_back({feature, version_num});
         }
-
         cache_meta_hdl.close();
+        sort(item_list.begin(), item_list.end(),
+            [](const pair<uint64_t, uint32_t>& a,
+            const pair<uint64_t, uint32_t>& b) {
+            return a.second < b.second;
+        });
+    }
+
+    this->MapCacheMeta(db_name_, slot_num);
+    head_->cur_version_num = cur_version_num;
+    _total_similar_chunk = total_similar_chunk;
+    for (auto& it : item_list) {
+        if (head_->item_num >= max_item_num_) {
+            this->EvictSlot(head_->head);
+        }
+        this->InsertSlot(it.first, it.second);
     }
 
+    tool::Logging(my_name_.c_str(), "rebuild the cache meta with %lu slots, "
+        "keep %lu features.\n", slot_num, head_->item_num);
     return ;
 }
 
 /**
- * @brief store cache metadata
+ * @brief find the slot of a feature
  * 
+ * @param feature the feature
+ * @return uint32_t the slot id (UINT32_MAX if not exist)
  */
-void CacheMeta::StoreCacheMeta() {
-    ofstream cache_meta_hdl;
-    cache_meta_hdl.open(db_name_, ios_base::trunc | ios_base::binary);
-    if (!cache_meta_hdl.is_open()) {
-        tool::Logging(my_name_.c_str(), "cannot init the cache meta.\n");
-        exit(EXIT_FAILURE);
+uint32_t CacheMeta::FindSlot(uint64_t feature) {
+    uint64_t id = this->HashSlot(feature);
+    while (slot_[id].is_used) {
+        if (slot_[id].feature == feature) {
+            return id;
+        }
+        id = (id + 1) & slot_mask_;
+    }
+    return CACHE_META_NIL;
+}
+
+/**
+ * @brief insert a new feature at the tail of the version list
+ * 
+ * @param feature the feature
+ * @param version the version
+ */
+void CacheMeta::InsertSlot(uint64_t feature, uint32_t version) {
+    uint64_t id = this->HashSlot(feature);
+    while (slot_[id].is_used) {
+        id = (id + 1) & slot_mask_;
+    }
+    slot_[id].feature = feature;
+    slot_[id].version = version;
+    slot_[id].is_used = 1;
+    head_->item_num++;
+    this->AppendSlot(id);
+    return ;
+}
+
+/**
+ * @brief remove a feature (backward shift deletion)
+ * 
+ * @param slot_id the slot id
+ */
+void CacheMeta::RemoveSlot(uint32_t slot_id) {
+    this->UnlinkSlot(slot_id);
+    slot_[slot_id].is_used = 0;
+    head_->item_num--;
+
+    // shift the following features of the probe sequence
+    uint64_t hole = slot_id;
+    uint64_t id = slot_id;
+    while (true) {
+        id = (id + 1) & slot_mask_;
+        if (!slot_[id].is_used) {
+            break;
+        }
+        uint64_t home = this->HashSlot(slot_[id].feature);
+        bool is_movable = (hole <= id) ? (home <= hole || home > id) :
+            (home <= hole && home > id);
+        if (is_movable) {
+            slot_[hole] = slot_[id];
+            slot_[id].is_used = 0;
+            // fix the version list
+            if (slot_[hole].prev != CACHE_META_NIL) {
+                slot_[slot_[hole].prev].next = hole;
+            } else {
+                head_->head = hole;
+            }
+            if (slot_[hole].next != CACHE_META_NIL) {
+                slot_[slot_[hole].next].prev = hole;
+            } else {
+                head_->tail = hole;
+            }
+            hole = id;
+        }
+    }
+    return ;
+}
+
+/**
+ * @brief unlink a slot from the version list
+ * 
+ * @param slot_id the slot id
+ */
+void CacheMeta::UnlinkSlot(uint32_t slot_id) {
+    CacheMetaSlot_t* cur_slot = &slot_[slot_id];
+    if (cur_slot->prev != CACHE_META_NIL) {
+        slot_[cur_slot->prev].next = cur_slot->next;
+    } else {
+        head_->head = cur_slot->next;
+    }
+    if (cur_slot->next != CACHE_META_NIL) {
+        slot_[cur_slot->next].prev = cur_slot->prev;
+    } else {
+        head_->tail = cur_slot->prev;
+    }
+    cur_slot->prev = CACHE_META_NIL;
+    cur_slot->next = CACHE_META_NIL;
+    return ;
+}
+
+/**
+ * @brief append a slot to the tail of the version list
+ * 
+ * @param slot_id the slot id
+ */
+void CacheMeta::AppendSlot(uint32_t slot_id) {
+    slot_[slot_id].prev = head_->tail;
+    slot_[slot_id].next = CACHE_META_NIL;
+    if (head_->tail != CACHE_META_NIL) {
+        slot_[head_->tail].next = slot_id;
+    } else {
+        head_->head = slot_id;
     }
+    head_->tail = slot_id;
+    return ;
+}
+
+/**
+ * @brief set the version of a feature (move it to the list tail)
+ * 
+ * @param slot_id the slot id
+ */
+void CacheMeta::TouchSlot(uint32_t slot_id) {
+    if (slot_[slot_id].version == head_->cur_version_num) {
+        return ;
+    }
+    slot_[slot_id].version = head_->cur_version_num;
+    this->UnlinkSlot(slot_id);
+    this->AppendSlot(slot_id);
+    return ;
+}
 
-    cache_meta_hdl.write((char*)&_total_similar_chunk, sizeof(uint64_t));
-    cache_meta_hdl.write((char*)&cur_version_num_, sizeof(uint32_t));
-    
-    size_t idx_item_num = feature_2_version_idx_.size();
-    cache_meta_hdl.write((char*)&idx_item_num, sizeof(size_t));
+/**
+ * @brief evict a feature and record its eviction notice
+ * 
+ * @param slot_id the slot id
+ */
+void CacheMeta::EvictSlot(uint32_t slot_id) {
+    {
+        lock_guard<mutex> lck(expired_lck_);
+        expired_feature_list_.push_back(slot_[slot_id].feature);
+    }
+    this->RemoveSlot(slot_id);
+    return ;
+}
 
-    // cache meta index mapping: feature -> current version
-    for (auto it : feature_2_version_idx_) {
-        cache_meta_hdl.write((char*)&it.first, sizeof(uint64_t));
-        cache_meta_hdl.write((char*)&it.second, sizeof(uint32_t));
+/**
+ * @brief add a feature to the frequency sketch
+ * 
+ * @param feature the feature
+ */
+void CacheMeta::AddFrequency(uint64_t feature) {
+    uint64_t width = sketch_mask_ + 1;
+    for (uint32_t i = 0; i < CACHE_META_SKETCH_ROW; i++) {
+        uint64_t id = ((feature + i) * 0xc6a4a7935bd1e995ULL >> 23) &
+            sketch_mask_;
+        uint8_t* counter = &sketch_[i * width + id];
+        if (*counter < CACHE_META_SKETCH_MAX) {
+            (*counter)++;
+        }
     }
-    cache_meta_hdl.close();
 
+    // aging: halve all counters periodically
+    head_->sketch_add_cnt++;
+    if (head_->sketch_add_cnt >= max_item_num_ * 10) {
+        for (uint64_t i = 0; i < width * CACHE_META_SKETCH_ROW; i++) {
+            sketch_[i] >>= 1;
+        }
+        head_->sketch_add_cnt = 0;
+    }
     return ;
 }
 
+/**
+ * @brief estimate the frequency of a feature
+ * 
+ * @param feature the feature
+ * @return uint8_t the frequency
+ */
+uint8_t CacheMeta::GetFrequency(uint64_t feature) {
+    uint64_t width = sketch_mask_ + 1;
+    uint8_t freq = CACHE_META_SKETCH_MAX;
+    for (uint32_t i = 0; i < CACHE_META_SKETCH_ROW; i++) {
+        uint64_t id = ((feature + i) * 0xc6a4a7935bd1e995ULL >> 23) &
+            sketch_mask_;
+        freq = min(freq, sketch_[i * width + id]);
+    }
+    return freq;
+}
+
 /**
  * @brief insert the features to the cache
  * 
  * @param features input features
+ * @return true the features are admitted
+ * @return false the features are rejected (the table is full)
  */
-void CacheMeta::UpdateCacheMeta(uint64_t* features) {
+bool CacheMeta::UpdateCacheMeta(uint64_t* features) {
+    uint64_t new_feature_num = 0;
+    uint8_t cand_freq = CACHE_META_SKETCH_MAX;
     for (size_t i = 0; i < SUPER_FEATURE_PER_CHUNK; i++) {
-        feature_2_version_idx_[features[i]] = cur_version_num_;
+        if (this->FindSlot(features[i]) == CACHE_META_NIL) {
+            new_feature_num++;
+        }
+        cand_freq = min(cand_freq, this->GetFrequency(features[i]));
     }
-    return ;
+
+    // admission: only replace the older and less frequent features
+    if (head_->item_num + new_feature_num > max_item_num_) {
+        uint64_t victim_num = head_->item_num + new_feature_num - max_item_num_;
+        uint32_t id = head_->head;
+        for (uint64_t i = 0; i < victim_num; i++) {
+            if (id == CACHE_META_NIL ||
+                slot_[id].version == head_->cur_version_num ||
+                this->GetFrequency(slot_[id].feature) >= cand_freq) {
+                _total_reject_chunk++;
+                return false;
+            }
+            id = slot_[id].next;
+        }
+        for (uint64_t i = 0; i < victim_num; i++) {
+            this->EvictSlot(head_->head);
+        }
+    }
+
+    for (size_t i = 0; i < SUPER_FEATURE_PER_CHUNK; i++) {
+        uint32_t id = this->FindSlot(features[i]);
+        if (id == CACHE_META_NIL) {
+            this->InsertSlot(features[i], head_->cur_version_num);
+        } else {
+            this->TouchSlot(id);
+        }
+    }
+    return true;
 }
 
 /**
@@ -147,10 +471,11 @@ void CacheMeta::UpdateCacheMeta(uint64_t* features) {
 bool CacheMeta::QueryCacheMeta(uint64_t* features) {
     bool is_similar = false;
     for (size_t i = 0; i < SUPER_FEATURE_PER_CHUNK; i++) {
-        if (feature_2_version_idx_.find(features[i]) !=
-            feature_2_version_idx_.end()) {
+        this->AddFrequency(features[i]);
+        uint32_t id = this->FindSlot(features[i]);
+        if (id != CACHE_META_NIL) {
             // it exist in the index, update the version
-            feature_2_version_idx_[features[i]] = cur_version_num_;
+            this->TouchSlot(id);
             is_similar = true;
         }
     }
@@ -162,38 +487,73 @@ bool CacheMeta::QueryCacheMeta(uint64_t* features) {
 }
 
 /**
- * @brief evict feature based on last_n_para_
+ * @brief start a new version and collect the expired features based on
+ * last_n_para_ (only visit the oldest features)
  * 
  */
-void CacheMeta::EvictFeature() {
-    auto it = feature_2_version_idx_.begin();
-
-    while (it != feature_2_version_idx_.end()) {
-        if (cur_version_num_ - it->second >= last_n_para_) {
-            memcpy(
-                evict_feature_buf_.data_buf + evict_feature_buf_.header->size, 
-                &it->first, sizeof(uint64_t));
-            evict_feature_buf_.header->size += sizeof(uint64_t);
-            evict_feature_buf_.header->cur_item_num++;
-
-            // check whether to send evict feature buffer
-            if (evict_feature_buf_.header->cur_item_num %
-                send_recipe_batch_size_ == 0) {
-                this->SendFeatures();
-            }
+void CacheMeta::CollectExpiredFeature() {
+    uint64_t slot_num = this->GetBudgetSlotNum();
+    if (head_ == NULL || head_->slot_num != slot_num) {
+        // the first run, the previous format or the budget is changed
+        this->ResizeCacheMeta(slot_num);
+    }
+    head_->cur_version_num++;
 
-            // erasure the feature    
-            it = feature_2_version_idx_.erase(it);
-        } else {
-            it++;
+    // the features not used in the last n versions before this one, the
+    // same set as evicting at the end of the previous version
+    while (head_->head != CACHE_META_NIL &&
+        slot_[head_->head].version + last_n_para_ < head_->cur_version_num) {
+        this->EvictSlot(head_->head);
+    }
+
+    return ;
+}
+
+/**
+ * @brief send a batch of the eviction notice
+ * 
+ * @return true still has pending expired features
+ * @return false all expired features are sent
+ */
+bool CacheMeta::EvictFeatureBatch() {
+    lock_guard<mutex> lck(expired_lck_);
+    while (expired_send_pos_ < expired_feature_list_.size()) {
+        memcpy(evict_feature_buf_.data_buf + evict_feature_buf_.header->size, 
+            &expired_feature_list_[expired_send_pos_], sizeof(uint64_t));
+        evict_feature_buf_.header->size += sizeof(uint64_t);
+        evict_feature_buf_.header->cur_item_num++;
+        expired_send_pos_++;
+
+        // check whether to send evict feature buffer
+        if (evict_feature_buf_.header->cur_item_num %
+            send_recipe_batch_size_ == 0) {
+            this->SendFeatures();
+            break;
         }
     }
-    
-    // Process the tail
+
+    if (expired_send_pos_ < expired_feature_list_.size()) {
+        return true;
+    }
+
+    // process the tail
     if (evict_feature_buf_.header->cur_item_num != 0) {
         this->SendFeatures();
     }
+    expired_feature_list_.clear();
+    expired_send_pos_ = 0;
+
+    return false;
+}
 
+/**
+ * @brief send all pending eviction notices
+ * 
+ */
+void CacheMeta::EvictFeature() {
+    while (this->EvictFeatureBatch()) {
+        ;
+    }
     return ;
 }
 
@@ -215,4 +575,4 @@ void CacheMeta::SendFeatures() {
     evict_feature_buf_.header->size = 0;
 
     return ;
-}
\ No newline at end of file
+}
@@ -32,20 +32,100 @@ ChunkerFPThd::~ChunkerFPThd() {
  * @brief the main thread
  * 
  * @param input_file_hdl the input file handler
+ * @param file_path the input file path
  * @param output_MQ the output MQ
  */
-void ChunkerFPThd::Run(ifstream* input_file_hdl,
+void ChunkerFPThd::Run(ifstream* input_file_hdl, string file_path,
     AbsMQ<Chunk_t>* output_MQ) {
     tool::Logging(my_name_.c_str(), "the main thread is running.\n");
-    bool is_end = false;
+
+    this->ChunkFile(input_file_hdl, file_path, output_MQ);
+    this->SendEnd(output_MQ);
+    return ;
+}
+
+/**
+ * @brief the main thread of a multi-file session (all files share one
+ * recipe, the file index records the chunks of each file)
+ * 
+ * @param file_index the file index
+ * @param output_MQ the output MQ
+ */
+void ChunkerFPThd::RunFileList(FileIndex* file_index,
+    AbsMQ<Chunk_t>* output_MQ) {
+    tool::Logging(my_name_.c_str(), "the main thread is running.\n");
+
+    ifstream input_file_hdl;
+    uint64_t last_chunk_num = 0;
+    uint64_t last_file_size = 0;
+    for (auto& it : file_index->_entry_list) {
+        if (it.is_ref) {
+            // unchanged, the server copies its chunks from the previous recipe
+            continue;
+        }
+        input_file_hdl.open(file_index->GetSourcePath(it),
+            ios_base::in | ios_base::binary);
+        if (!input_file_hdl.is_open()) {
+            tool::Logging(my_name_.c_str(), "cannot open the input file: %s\n",
+                it.name.c_str());
+            exit(EXIT_FAILURE);
+        }
+
+        // the chunker never cuts a chunk across two files
+        this->ChunkFile(&input_file_hdl, file_index->GetSourcePath(it),
+            output_MQ);
+        input_file_hdl.close();
+        input_file_hdl.clear();
+
+        it.chunk_num = chunker_obj_->_total_chunk_num - last_chunk_num;
+        it.size = chunker_obj_->_total_file_size - last_file_size;
+        last_chunk_num = chunker_obj_->_total_chunk_num;
+        last_file_size = chunker_obj_->_total_file_size;
+    }
+
+    this->SendEnd(output_MQ, file_index->_ref_chunk_num, file_index->_ref_size);
+    return ;
+}
+
+/**
+ * @brief chunk a file and send the chunks to the output MQ
+ * 
+ * @param input_file_hdl the input file handler
+ * @param file_path the file path (to find its holes)
+ * @param output_MQ the output MQ
+ */
+void ChunkerFPThd::ChunkFile(ifstream* input_file_hdl, string file_path,
+    AbsMQ<Chunk_t>* output_MQ) {
+    vector<pair<uint64_t, uint64_t>> hole_list;
+    this->FindHoles(file_path, hole_list);
+    size_t hole_idx = 0;
+    uint64_t file_offset = 0;
 
     Chunk_t tmp_data;
-    while (!is_end) {
+    while (true) {
+        if (hole_idx < hole_list.size() &&
+            hole_list[hole_idx].first == file_offset) {
+            // skip the hole without reading it
+            this->SendHole(hole_list[hole_idx].second - file_offset,
+                output_MQ);
+            file_offset = hole_list[hole_idx].second;
+            input_file_hdl->seekg(file_offset, ios_base::beg);
+            hole_idx++;
+            continue;
+        }
+
+        // a read buffer never crosses a hole
+        uint64_t max_read_size = UINT64_MAX;
+        if (hole_idx < hole_list.size()) {
+            max_read_size = hole_list[hole_idx].first - file_offset;
+        }
         uint64_t pending_size = 0;
-        pending_size = chunker_obj_->LoadDataFromFile(*input_file_hdl);
+        pending_size = chunker_obj_->LoadDataFromFile(*input_file_hdl,
+            max_read_size);
         if (pending_size == 0) {
             break;
         }
+        file_offset += pending_size;
 
         while (true) {
 
@@ -65,6 +145,20 @@ void ChunkerFPThd::Run(ifstream* input_file_hdl,
             if (tmp_data.raw_chunk.size == 0) {
                 break;
             }
+            if (chunker_obj_->_total_chunk_num <= skip_chunk_num_) {
+                // already stored, only the chunk boundary is needed
+                continue;
+            }
+
+            if (tool::IsAllZero(tmp_data.raw_chunk.data,
+                tmp_data.raw_chunk.size)) {
+                // a recipe entry only, never hashed, keyed or stored
+                tmp_data.type = ZERO_CHUNK;
+                output_MQ->Push(tmp_data);
+                _total_zero_chunk_num++;
+                _total_zero_size += tmp_data.raw_chunk.size;
+                continue;
+            }
 
 #ifdef EDR_BREAKDOWN
             gettimeofday(&_fp_stime, NULL);
@@ -83,10 +177,22 @@ void ChunkerFPThd::Run(ifstream* input_file_hdl,
             output_MQ->Push(tmp_data);
         }
     }
+    return ;
+}
 
+/**
+ * @brief send the end of the session recipe
+ * 
+ * @param output_MQ the output MQ
+ * @param ref_chunk_num the chunks copied from the previous recipe
+ * @param ref_size the size of the copied chunks
+ */
+void ChunkerFPThd::SendEnd(AbsMQ<Chunk_t>* output_MQ, uint64_t ref_chunk_num,
+    uint64_t ref_size) {
+    Chunk_t tmp_data;
     tmp_data.type = RECIPE_CHUNK;
-    tmp_data.head.chunk_num = chunker_obj_->_total_chunk_num;
-    tmp_data.head.size = chunker_obj_->_total_file_size;
+    tmp_data.head.chunk_num = chunker_obj_->_total_chunk_num + ref_chunk_num;
+    tmp_data.head.size = chunker_obj_->_total_file_size + ref_size;
     output_MQ->Push(tmp_data);
     output_MQ->_done = true;
 
@@ -95,9 +201,86 @@ void ChunkerFPThd::Run(ifstream* input_file_hdl,
 
     tool::Logging(my_name_.c_str(), "total file size (B): %lu\n", chunker_obj_->_total_file_size); 
     tool::Logging(my_name_.c_str(), "total chunk num: %lu\n", chunker_obj_->_total_chunk_num); 
+    if (_total_zero_chunk_num != 0) {
+        tool::Logging(my_name_.c_str(), "zero chunk num: %lu, zero data size: "
+            "%lu, hole size: %lu\n", _total_zero_chunk_num, _total_zero_size,
+            _total_hole_size);
+    }
 #if (CHUNKING_BREAKDOWN == 1)
     tool::Logging(my_name_.c_str(), "total chunking time: %lf\n", total_chunking_time_); 
     tool::Logging(my_name_.c_str(), "total fp time: %lf\n", total_fp_time_); 
 #endif
     return ;
-}
\ No newline at end of file
+}
+
+
+/**
+ * @brief find the holes of a sparse file
+ * 
+ * @param file_path the file path
+ * @param hole_list the holes [start, end) in the file order <ret>
+ */
+void ChunkerFPThd::FindHoles(string& file_path,
+    vector<pair<uint64_t, uint64_t>>& hole_list) {
+    // a pipe is never sparse (and opening a FIFO twice blocks)
+    struct stat file_stat;
+    if (stat(file_path.c_str(), &file_stat) != 0 ||
+        !S_ISREG(file_stat.st_mode)) {
+        return ;
+    }
+    int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return ;
+    }
+
+    // a hole shorter than a chunk is read (and caught by the zero check)
+    uint64_t min_hole_size = config.GetMaxChunkSize();
+    uint64_t file_size = file_stat.st_size;
+    uint64_t offset = 0;
+    while (offset < file_size) {
+        off_t data_start = lseek(fd, offset, SEEK_DATA);
+        if (data_start < 0) {
+            // ENXIO: a hole till the end, otherwise not supported
+            if (errno == ENXIO && file_size - offset >= min_hole_size) {
+                hole_list.push_back(make_pair(offset, file_size));
+            }
+            break;
+        }
+        if ((uint64_t)data_start - offset >= min_hole_size) {
+            hole_list.push_back(make_pair(offset, (uint64_t)data_start));
+        }
+        off_t data_end = lseek(fd, data_start, SEEK_HOLE);
+        if (data_end <= data_start) {
+            break;
+        }
+        offset = data_end;
+    }
+    close(fd);
+    return ;
+}
+
+/**
+ * @brief send a hole as the all-zero chunks
+ * 
+ * @param hole_size the hole size
+ * @param output_MQ the output MQ
+ */
+void ChunkerFPThd::SendHole(uint64_t hole_size, AbsMQ<Chunk_t>* output_MQ) {
+    Chunk_t tmp_data;
+    tmp_data.type = ZERO_CHUNK;
+    uint64_t max_chunk_size = config.GetMaxChunkSize();
+    while (hole_size != 0) {
+        tmp_data.raw_chunk.size = min(hole_size, max_chunk_size);
+        hole_size -= tmp_data.raw_chunk.size;
+        chunker_obj_->_total_chunk_num++;
+        chunker_obj_->_total_file_size += tmp_data.raw_chunk.size;
+        _total_hole_size += tmp_data.raw_chunk.size;
+        if (chunker_obj_->_total_chunk_num <= skip_chunk_num_) {
+            continue;
+        }
+        output_MQ->Push(tmp_data);
+        _total_zero_chunk_num++;
+        _total_zero_size += tmp_data.raw_chunk.size;
+    }
+    return ;
+}
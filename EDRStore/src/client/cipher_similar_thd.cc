@@ -63,11 +63,16 @@ void CipherSimilarThd::Run(AbsMQ<EncFeatureChunk_t>* input_MQ,
 
             switch (tmp_data.feature_chunk.chunk.type) {
                 case NORMAL_CHUNK: {
+                    // keep the plaintext features for the version delta
+                    memcpy(tmp_data.plain_features,
+                        tmp_data.feature_chunk.features,
+                        sizeof(uint64_t) * SUPER_FEATURE_PER_CHUNK);
                     // re-use the plaintext feature buffer to store features of ciphertext chunk
                     finesse_util_->ExtractFeature(rabin_ctx_, tmp_data.enc_data,
                         tmp_data.enc_size, tmp_data.feature_chunk.features);
                     break;    
                 }
+                case ZERO_CHUNK:
                 case RECIPE_CHUNK: {
                     // do not need to compute the feature
                     break;
@@ -82,7 +87,7 @@ void CipherSimilarThd::Run(AbsMQ<EncFeatureChunk_t>* input_MQ,
             gettimeofday(&_cipher_feature_etime, NULL);
             _total_cipher_feature_time += tool::GetTimeDiff(
                 _cipher_feature_stime, _cipher_feature_etime);
-            if (tmp_data.feature_chunk.chunk.type != RECIPE_CHUNK) {
+            if (tmp_data.feature_chunk.chunk.type == NORMAL_CHUNK) {
                 _total_cipher_feature_size += tmp_data.enc_size;
             }
 #endif
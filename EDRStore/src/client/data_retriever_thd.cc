@@ -19,8 +19,8 @@
  * @param file_name_hash file name hash
  * @param method_type method type
  */
-DataRetrieverThd::DataRetrieverThd(SSLConnection* server_channel,
-    pair<int, SSL*> server_conn_record, uint8_t* file_name_hash,
+DataRetrieverThd::DataRetrieverThd(AbsTransport* server_channel,
+    pair<int, Conn_t*> server_conn_record, uint8_t* file_name_hash,
     uint32_t method_type) {
     // for config
     send_chunk_batch_size_ = config.GetSendChunkBatchSize();
@@ -31,9 +31,10 @@ DataRetrieverThd::DataRetrieverThd(SSLConnection* server_channel,
     server_channel_ = server_channel;
     server_conn_record_ = server_conn_record;
     server_ssl_ = server_conn_record.second;
+    stripe_conn_list_.push_back(server_conn_record);
 
-    // recv chunk buffer
-    recv_chunk_buf_.send_buf = (uint8_t*) malloc(send_chunk_batch_size_ *
+    // recv chunk buffer (a chunk of the recipe can come with its base)
+    recv_chunk_buf_.send_buf = (uint8_t*) malloc(2 * send_chunk_batch_size_ *
         sizeof(SendChunk_t) + sizeof(NetworkHead_t));
     recv_chunk_buf_.header = (NetworkHead_t*) recv_chunk_buf_.send_buf;
     recv_chunk_buf_.header->client_id = client_id_;
@@ -69,6 +70,9 @@ DataRetrieverThd::DataRetrieverThd(SSLConnection* server_channel,
 
     // for delta compression
     delta_comp_ = new DeltaComp();
+
+    crypto_util_ = new CryptoUtil(CIPHER_TYPE, HASH_TYPE);
+    md_ctx_ = EVP_MD_CTX_new();
 }
 
 /**
@@ -82,6 +86,8 @@ DataRetrieverThd::~DataRetrieverThd() {
     delete two_phase_enc_;
     delete comp_pad_;
     delete delta_comp_;
+    delete crypto_util_;
+    EVP_MD_CTX_free(md_ctx_);
 }
 
 /**
@@ -105,9 +111,12 @@ void DataRetrieverThd::Run(AbsMQ<Retriever2Writer_t>* output_MQ) {
 
     uint32_t recv_size = 0; 
     bool job_done_flag = false;
+    uint32_t stripe_num = stripe_conn_list_.size();
+    Conn_t* cur_ssl;
     while (true) {
-        // wait the data from the storage server
-        if (!server_channel_->ReceiveData(server_ssl_,
+        // wait the data from the storage server (in round-robin order)
+        cur_ssl = stripe_conn_list_[stripe_seq_ % stripe_num].second;
+        if (!server_channel_->ReceiveData(cur_ssl,
             recv_chunk_buf_.send_buf, recv_size)) {
             tool::Logging(my_name_.c_str(), "recv data from storage server error.\n");
             exit(EXIT_FAILURE);
@@ -133,6 +142,7 @@ void DataRetrieverThd::Run(AbsMQ<Retriever2Writer_t>* output_MQ) {
                             exit(EXIT_FAILURE);
                         }
                     }
+                    stripe_seq_++;
                     break;
                 }
                 case SERVER_RESTORE_RECIPE: {
@@ -140,7 +150,12 @@ void DataRetrieverThd::Run(AbsMQ<Retriever2Writer_t>* output_MQ) {
                     exit(EXIT_FAILURE);
                 }
                 case SERVER_RESTORE_FINAL: {
-                    server_channel_->Finish(server_conn_record_);
+                    // close the stripes in order, the server waits for them
+                    // in the same order
+                    for (uint32_t i = 0; i < stripe_num; i++) {
+                        server_channel_->Finish(stripe_conn_list_[
+                            (stripe_seq_ + i) % stripe_num]);
+                    }
                     output_MQ->_done = true;
                     job_done_flag = true;
                     break;    
@@ -184,7 +199,7 @@ void DataRetrieverThd::Run(AbsMQ<Retriever2Writer_t>* output_MQ) {
 void DataRetrieverThd::DownloadLogin(uint8_t* file_name_hash) {
     SendMsgBuffer_t login_buf;
     login_buf.send_buf = (uint8_t*) malloc(sizeof(NetworkHead_t) + 
-        CHUNK_HASH_SIZE);
+        CHUNK_HASH_SIZE + sizeof(uint32_t) * 3);
     login_buf.header = (NetworkHead_t*) login_buf.send_buf;
     login_buf.header->client_id = client_id_;
     login_buf.header->size = 0;
@@ -194,6 +209,20 @@ void DataRetrieverThd::DownloadLogin(uint8_t* file_name_hash) {
     memcpy(login_buf.data_buf + login_buf.header->size, file_name_hash,
         CHUNK_HASH_SIZE);
     login_buf.header->size += CHUNK_HASH_SIZE;
+    // the newest wire format of this client
+    memcpy(login_buf.data_buf + login_buf.header->size, &WIRE_FORMAT_VERSION,
+        sizeof(uint32_t));
+    login_buf.header->size += sizeof(uint32_t);
+    // ask for the stripe connections
+    uint32_t stripe_num = config.GetStripeNum();
+    memcpy(login_buf.data_buf + login_buf.header->size, &stripe_num,
+        sizeof(uint32_t));
+    login_buf.header->size += sizeof(uint32_t);
+    // ask for the authenticated-only data frames
+    uint32_t auth_only = config.GetAuthOnlyData();
+    memcpy(login_buf.data_buf + login_buf.header->size, &auth_only,
+        sizeof(uint32_t));
+    login_buf.header->size += sizeof(uint32_t);
 
     // send the download login request
     if (!server_channel_->SendData(server_ssl_, login_buf.send_buf,
@@ -228,6 +257,32 @@ void DataRetrieverThd::DownloadLogin(uint8_t* file_name_hash) {
     }
 
     memcpy(&recipe_head_, login_buf.data_buf, sizeof(FileRecipeHead_t));
+    // the server replies the accepted wire format after the recipe header
+    if (login_buf.header->size >= sizeof(FileRecipeHead_t) + sizeof(uint32_t)) {
+        memcpy(&wire_ver_, login_buf.data_buf + sizeof(FileRecipeHead_t),
+            sizeof(uint32_t));
+    }
+    // and the granted stripe connections
+    uint32_t offset = sizeof(FileRecipeHead_t) + sizeof(uint32_t);
+    stripe_num = 1;
+    uint64_t stripe_token = 0;
+    if (login_buf.header->size >= offset + sizeof(uint32_t) +
+        sizeof(uint64_t)) {
+        memcpy(&stripe_num, login_buf.data_buf + offset, sizeof(uint32_t));
+        memcpy(&stripe_token, login_buf.data_buf + offset + sizeof(uint32_t),
+            sizeof(uint64_t));
+    }
+    // and whether the connections switch to the authenticated-only data
+    // frames (after the login response)
+    offset += sizeof(uint32_t) + sizeof(uint64_t);
+    if (login_buf.header->size >= offset + sizeof(uint32_t)) {
+        memcpy(&auth_only, login_buf.data_buf + offset, sizeof(uint32_t));
+        auth_only_ = (auth_only != 0) && config.GetAuthOnlyData();
+    }
+    this->EnableAuthOnly(server_ssl_);
+    this->JoinStripes(stripe_num, stripe_token);
+    tool::Logging(my_name_.c_str(), "wire format: %u, stripe num: %u, "
+        "auth-only data: %d\n", wire_ver_, stripe_num, auth_only_);
     tool::Logging(my_name_.c_str(), "total check num: %lu\n",
         recipe_head_.chunk_num);
     tool::Logging(my_name_.c_str(), "file size: %lu\n",
@@ -237,6 +292,64 @@ void DataRetrieverThd::DownloadLogin(uint8_t* file_name_hash) {
     return ;
 }
 
+/**
+ * @brief open the extra stripe connections of this session
+ * 
+ * @param stripe_num the number of connections
+ * @param stripe_token the session token from the server
+ */
+void DataRetrieverThd::JoinStripes(uint32_t stripe_num, uint64_t stripe_token) {
+    SendMsgBuffer_t login_buf;
+    login_buf.send_buf = (uint8_t*) malloc(sizeof(NetworkHead_t) +
+        sizeof(uint64_t) + sizeof(uint32_t));
+    login_buf.header = (NetworkHead_t*) login_buf.send_buf;
+    login_buf.data_buf = login_buf.send_buf + sizeof(NetworkHead_t);
+
+    uint32_t recv_size = 0;
+    for (uint32_t i = 1; i < stripe_num; i++) {
+        pair<int, Conn_t*> conn_record = server_channel_->Connect();
+        login_buf.header->client_id = client_id_;
+        login_buf.header->msg_type = CLIENT_LOGIN_STRIPE;
+        memcpy(login_buf.data_buf, &stripe_token, sizeof(uint64_t));
+        memcpy(login_buf.data_buf + sizeof(uint64_t), &i, sizeof(uint32_t));
+        login_buf.header->size = sizeof(uint64_t) + sizeof(uint32_t);
+        if (!server_channel_->SendData(conn_record.second, login_buf.send_buf,
+            sizeof(NetworkHead_t) + login_buf.header->size)) {
+            tool::Logging(my_name_.c_str(), "send stripe login error.\n");
+            exit(EXIT_FAILURE);
+        }
+        if (!server_channel_->ReceiveData(conn_record.second,
+            login_buf.send_buf, recv_size) ||
+            login_buf.header->msg_type != SERVER_LOGIN_RESPONSE) {
+            tool::Logging(my_name_.c_str(), "stripe %u is rejected.\n", i);
+            exit(EXIT_FAILURE);
+        }
+        this->EnableAuthOnly(conn_record.second);
+        stripe_conn_list_.push_back(conn_record);
+    }
+
+    free(login_buf.send_buf);
+    return ;
+}
+
+/**
+ * @brief switch a connection to the authenticated-only data frames after its
+ * login response (if negotiated)
+ * 
+ * @param conn the connection
+ */
+void DataRetrieverThd::EnableAuthOnly(Conn_t* conn) {
+    if (!auth_only_) {
+        return ;
+    }
+    if (!server_channel_->EnableAuthOnly(conn)) {
+        tool::Logging(my_name_.c_str(), "enable the authenticated-only data "
+            "frames error.\n");
+        exit(EXIT_FAILURE);
+    }
+    return ;
+}
+
 /**
  * @brief fetch key recipe
  * 
@@ -256,7 +369,7 @@ void DataRetrieverThd::FetchKeyRecipe() {
  */
 void DataRetrieverThd::FullEDR(AbsMQ<Retriever2Writer_t>* output_MQ) {
     uint32_t cur_chunk_num = recv_chunk_buf_.header->cur_item_num;
-    SendChunkHeader_t* cur_header;
+    SendChunkHeader_t cur_header;
     uint8_t* cur_data;
 
     SendChunk_t tmp_restore_chunk;
@@ -266,8 +379,8 @@ void DataRetrieverThd::FullEDR(AbsMQ<Retriever2Writer_t>* output_MQ) {
     size_t offset = 0;
     
     for (size_t i = 0; i < cur_chunk_num; i++) {
-        cur_header = (SendChunkHeader_t*)(recv_chunk_buf_.data_buf + offset);
-        offset += sizeof(SendChunkHeader_t);
+        offset += wire::DecodeChunkHeader(recv_chunk_buf_.data_buf + offset,
+            &cur_header, wire_ver_);
         cur_data = recv_chunk_buf_.data_buf + offset;
 
         if (remain_recipe_num_ == 0) {
@@ -277,30 +390,34 @@ void DataRetrieverThd::FullEDR(AbsMQ<Retriever2Writer_t>* output_MQ) {
 
         KeyRecipe_t* tmp_key_recipe = (KeyRecipe_t*)(key_recipe_buf_.buf +
             key_recipe_buf_.cnt * sizeof(KeyRecipe_t));
-        switch (cur_header->type) {
+        tmp_restore_chunk.header.type = NORMAL_CHUNK;
+        switch (cur_header.type) {
+            case ZERO_RECIPE_CHUNK: {
+                this->ProcZeroChunk(cur_data, &tmp_restore_chunk);
+                break;
+            }
             case COMP_NORMAL_CHUNK: {
-                this->ProcCompChunk(cur_data, cur_header->size,
+                this->ProcCompChunk(cur_data, cur_header.size,
                     &tmp_restore_chunk, tmp_key_recipe);
                 break;
             }
             case UNCOMP_NORMAL_CHUNK: {
-                this->ProcUncompChunk(cur_data, cur_header->size,
+                this->ProcUncompChunk(cur_data, cur_header.size,
                     &tmp_restore_chunk, tmp_key_recipe);
                 break;
             }
             case CACHE_RESTORE_DELTA: {
                 // store the delta chunk in the tmp_input_chunk
-                memcpy(tmp_input_chunk.data, cur_data, cur_header->size);
-                tmp_input_chunk.header.size = cur_header->size;
+                memcpy(tmp_input_chunk.data, cur_data, cur_header.size);
+                tmp_input_chunk.header.size = cur_header.size;
 
                 // -------- read the compressed base chunk --------
-                offset += cur_header->size;
+                offset += cur_header.size;
 
-                cur_header =
-                    (SendChunkHeader_t*)(recv_chunk_buf_.data_buf + offset);
-                offset += sizeof(SendChunkHeader_t);
+                offset += wire::DecodeChunkHeader(
+                    recv_chunk_buf_.data_buf + offset, &cur_header, wire_ver_);
                 cur_data = recv_chunk_buf_.data_buf + offset;
-                this->ProcRestoreBaseChunk(cur_data, cur_header->size,
+                this->ProcRestoreBaseChunk(cur_data, cur_header.size,
                     &tmp_base_chunk, tmp_key_recipe);
 
                 tmp_enc_restore_chunk.header.size = delta_comp_->DeltaDecode(
@@ -318,8 +435,8 @@ void DataRetrieverThd::FullEDR(AbsMQ<Retriever2Writer_t>* output_MQ) {
             }
             case MULTI_LEVEL_DELTA_CHUNK: {
                 // TODO: directly ignore multi-level delta
-                memcpy(tmp_restore_chunk.data, cur_data, cur_header->size);
-                tmp_restore_chunk.header.size = cur_header->size;
+                memcpy(tmp_restore_chunk.data, cur_data, cur_header.size);
+                tmp_restore_chunk.header.size = cur_header.size;
                 break;
             }
 
@@ -330,7 +447,7 @@ void DataRetrieverThd::FullEDR(AbsMQ<Retriever2Writer_t>* output_MQ) {
         }
         
         output_MQ->Push(tmp_restore_chunk);
-        offset += cur_header->size;
+        offset += cur_header.size;
 
         key_recipe_buf_.cnt++;
         remain_recipe_num_--;
@@ -349,15 +466,15 @@ void DataRetrieverThd::FullEDR(AbsMQ<Retriever2Writer_t>* output_MQ) {
  */
 void DataRetrieverThd::OnlyEncMode(AbsMQ<Retriever2Writer_t>* output_MQ) {
     uint32_t cur_chunk_num = recv_chunk_buf_.header->cur_item_num;
-    SendChunkHeader_t* cur_header;
+    SendChunkHeader_t cur_header;
     uint8_t* cur_data;
 
     SendChunk_t tmp_restore_chunk;
     size_t offset = 0;
     
     for (size_t i = 0; i < cur_chunk_num; i++) {
-        cur_header = (SendChunkHeader_t*)(recv_chunk_buf_.data_buf + offset);
-        offset += sizeof(SendChunkHeader_t);
+        offset += wire::DecodeChunkHeader(recv_chunk_buf_.data_buf + offset,
+            &cur_header, wire_ver_);
         cur_data = recv_chunk_buf_.data_buf + offset;
 
         if (remain_recipe_num_ == 0) {
@@ -367,11 +484,27 @@ void DataRetrieverThd::OnlyEncMode(AbsMQ<Retriever2Writer_t>* output_MQ) {
 
         KeyRecipe_t* tmp_key_recipe = (KeyRecipe_t*)(key_recipe_buf_.buf +
             key_recipe_buf_.cnt * sizeof(KeyRecipe_t));
-        this->ProcUncompChunk(cur_data, cur_header->size,
-            &tmp_restore_chunk, tmp_key_recipe);
+        tmp_restore_chunk.header.type = NORMAL_CHUNK;
+        if (cur_header.type == ZERO_RECIPE_CHUNK) {
+            this->ProcZeroChunk(cur_data, &tmp_restore_chunk);
+        } else if (cur_header.type == CLIENT_RESTORE_DELTA) {
+            // -------- read its base chunk --------
+            uint8_t* delta_data = cur_data;
+            uint32_t delta_size = cur_header.size;
+            offset += cur_header.size;
+
+            offset += wire::DecodeChunkHeader(
+                recv_chunk_buf_.data_buf + offset, &cur_header, wire_ver_);
+            cur_data = recv_chunk_buf_.data_buf + offset;
+            this->ProcVersionDeltaChunk(delta_data, delta_size, cur_data,
+                cur_header.size, &tmp_restore_chunk, tmp_key_recipe);
+        } else {
+            this->ProcUncompChunk(cur_data, cur_header.size,
+                &tmp_restore_chunk, tmp_key_recipe);
+        }
         
         output_MQ->Push(tmp_restore_chunk);
-        offset += cur_header->size;
+        offset += cur_header.size;
 
         key_recipe_buf_.cnt++;
         remain_recipe_num_--;
@@ -390,15 +523,15 @@ void DataRetrieverThd::OnlyEncMode(AbsMQ<Retriever2Writer_t>* output_MQ) {
  */
 void DataRetrieverThd::EncCompMode(AbsMQ<Retriever2Writer_t>* output_MQ) {
     uint32_t cur_chunk_num = recv_chunk_buf_.header->cur_item_num;
-    SendChunkHeader_t* cur_header;
+    SendChunkHeader_t cur_header;
     uint8_t* cur_data;
 
     SendChunk_t tmp_restore_chunk;
     size_t offset = 0;
     
     for (size_t i = 0; i < cur_chunk_num; i++) {
-        cur_header = (SendChunkHeader_t*)(recv_chunk_buf_.data_buf + offset);
-        offset += sizeof(SendChunkHeader_t);
+        offset += wire::DecodeChunkHeader(recv_chunk_buf_.data_buf + offset,
+            &cur_header, wire_ver_);
         cur_data = recv_chunk_buf_.data_buf + offset;
 
         if (remain_recipe_num_ == 0) {
@@ -408,11 +541,16 @@ void DataRetrieverThd::EncCompMode(AbsMQ<Retriever2Writer_t>* output_MQ) {
 
         KeyRecipe_t* tmp_key_recipe = (KeyRecipe_t*)(key_recipe_buf_.buf +
             key_recipe_buf_.cnt * sizeof(KeyRecipe_t));
-        this->ProcCompChunk(cur_data, cur_header->size,
-            &tmp_restore_chunk, tmp_key_recipe);
+        tmp_restore_chunk.header.type = NORMAL_CHUNK;
+        if (cur_header.type == ZERO_RECIPE_CHUNK) {
+            this->ProcZeroChunk(cur_data, &tmp_restore_chunk);
+        } else {
+            this->ProcCompChunk(cur_data, cur_header.size,
+                &tmp_restore_chunk, tmp_key_recipe);
+        }
         
         output_MQ->Push(tmp_restore_chunk);
-        offset += cur_header->size;
+        offset += cur_header.size;
 
         key_recipe_buf_.cnt++;
         remain_recipe_num_--;
@@ -448,6 +586,19 @@ void DataRetrieverThd::ProcCompChunk(uint8_t* input_chunk, uint32_t size,
     return ;
 }
 
+/**
+ * @brief proc an all-zero chunk (the writer makes a hole)
+ * 
+ * @param input_chunk input chunk (its size)
+ * @param output_chunk output chunk
+ */
+void DataRetrieverThd::ProcZeroChunk(uint8_t* input_chunk,
+    SendChunk_t* output_chunk) {
+    output_chunk->header.type = ZERO_CHUNK;
+    memcpy(&output_chunk->header.size, input_chunk, sizeof(uint32_t));
+    return ;
+}
+
 /**
  * @brief proc an un-comp chunk
  * 
@@ -465,6 +616,47 @@ void DataRetrieverThd::ProcUncompChunk(uint8_t* input_chunk, uint32_t size,
     return ;
 }
 
+/**
+ * @brief process a client delta and its base chunk
+ * 
+ * @param delta_chunk the encrypted delta
+ * @param delta_size the delta size
+ * @param base_chunk the encrypted base chunk
+ * @param base_size the base chunk size
+ * @param output_chunk output chunk
+ * @param key_recipe key recipe (of the delta)
+ */
+void DataRetrieverThd::ProcVersionDeltaChunk(uint8_t* delta_chunk,
+    uint32_t delta_size, uint8_t* base_chunk, uint32_t base_size,
+    SendChunk_t* output_chunk, KeyRecipe_t* key_recipe) {
+    uint8_t delta_buf[ENC_MAX_CHUNK_SIZE];
+    uint8_t base_buf[ENC_MAX_CHUNK_SIZE];
+    uint8_t restore_fp[CHUNK_HASH_SIZE];
+
+    // the delta carries the key of its base
+    uint32_t dec_delta_size = two_phase_enc_->TwoPhaseDecChunk(delta_chunk,
+        delta_size, key_recipe->key, delta_buf);
+    if (dec_delta_size < VERSION_DELTA_HEAD_SIZE) {
+        tool::Logging(my_name_.c_str(), "the client delta is broken.\n");
+        exit(EXIT_FAILURE);
+    }
+    uint32_t dec_base_size = two_phase_enc_->TwoPhaseDecChunk(base_chunk,
+        base_size, delta_buf, base_buf);
+
+    output_chunk->header.size = VersionDelta::DecodeDelta(base_buf,
+        dec_base_size, delta_buf + VERSION_DELTA_HEAD_SIZE,
+        dec_delta_size - VERSION_DELTA_HEAD_SIZE, output_chunk->data);
+    crypto_util_->GenerateHash(md_ctx_, output_chunk->data,
+        output_chunk->header.size, restore_fp);
+    if (output_chunk->header.size == 0 || memcmp(restore_fp,
+        delta_buf + CHUNK_HASH_SIZE, CHUNK_HASH_SIZE) != 0) {
+        tool::Logging(my_name_.c_str(), "the chunk restored from the client "
+            "delta mismatches.\n");
+        exit(EXIT_FAILURE);
+    }
+    return ;
+}
+
 /**
  * @brief process restore base chunk
  * 
@@ -21,10 +21,33 @@ DownloadWriterThd::DownloadWriterThd(string file_name) {
     download_file_hdl_ = fopen(real_file_name.c_str(), "wb");
 }
 
+/**
+ * @brief Construct a new DownloadWriterThd object for a multi-file session
+ * 
+ * @param file_name the session name (restored to a directory)
+ * @param file_index the file index
+ */
+DownloadWriterThd::DownloadWriterThd(string file_name, FileIndex* file_index) {
+    output_root_ = file_name + "-d";
+    file_index_ = file_index;
+}
+
+/**
+ * @brief Construct a new DownloadWriterThd object for a stream (stdout or a
+ * pipe), the chunks are written in the recipe order as they arrive
+ * 
+ * @param stream_hdl the stream handler (closed at the end)
+ */
+DownloadWriterThd::DownloadWriterThd(FILE* stream_hdl) {
+    download_file_hdl_ = stream_hdl;
+    is_stream_ = true;
+}
+
 DownloadWriterThd::~DownloadWriterThd() {
     fprintf(stderr, "========DownloadWriterThd Info========\n");
     fprintf(stderr, "write chunk num: %lu\n", _total_write_chunk_num);
     fprintf(stderr, "write data size: %lu\n", _total_write_data_size);
+    fprintf(stderr, "hole size: %lu\n", _total_hole_size);
     fprintf(stderr, "======================================\n");
 }
 
@@ -52,17 +75,53 @@ void DownloadWriterThd::Run(AbsMQ<SendChunk_t>* input_MQ) {
         }
 
         if (input_MQ->Pop(tmp_data)) {
-            // write the data to the file
-            fwrite((char*)tmp_data.data, tmp_data.header.size, 1,
-                download_file_hdl_);
+            // switch to the file of this chunk
+            if (file_index_ != NULL) {
+                if (remain_chunk_num_ == 0 && !this->OpenNextFile()) {
+                    tool::Logging(my_name_.c_str(), "more chunks than the "
+                        "file index.\n");
+                    exit(EXIT_FAILURE);
+                }
+                remain_chunk_num_--;
+            }
+
+            // write the data to the file (a slow pipe reader blocks here, and
+            // the full MQ stops the retriever in turn)
+            if (tmp_data.header.type == ZERO_CHUNK) {
+                this->WriteZeroChunk(tmp_data.header.size);
+            } else if (tmp_data.header.size != 0 && fwrite((char*)tmp_data.data,
+                tmp_data.header.size, 1, download_file_hdl_) != 1) {
+                tool::Logging(my_name_.c_str(), "write the restored data "
+                    "error: %s\n", strerror(errno));
+                exit(EXIT_FAILURE);
+            } else {
+                is_hole_end_ = false;
+            }
             _total_write_chunk_num++;
             _total_write_data_size += tmp_data.header.size; 
         }
     }
 
-    // ensure all data is written to the disk
-    fsync(fileno(download_file_hdl_));
-    fclose(download_file_hdl_);
+    if (file_index_ != NULL) {
+        // the trailing empty files
+        while (this->OpenNextFile()) {
+            ;
+        }
+        // ensure all files are written to the disk (once for the session)
+        sync();
+    } else if (is_stream_) {
+        // the reader sees the end of the stream
+        if (fclose(download_file_hdl_) != 0) {
+            tool::Logging(my_name_.c_str(), "close the stream error: %s\n",
+                strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        // ensure all data is written to the disk
+        this->FinishHole();
+        fsync(fileno(download_file_hdl_));
+        fclose(download_file_hdl_);
+    }
 
     gettimeofday(&etime, NULL);
     total_running_time += tool::GetTimeDiff(stime, etime);
@@ -71,4 +130,101 @@ void DownloadWriterThd::Run(AbsMQ<SendChunk_t>* input_MQ) {
         total_running_time);
 
     return ;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief close the current file and open the next one with chunks (create
+ * the empty files on the way)
+ * 
+ * @return true a file is opened
+ */
+bool DownloadWriterThd::OpenNextFile() {
+    if (download_file_hdl_ != NULL) {
+        // one fsync per file costs more than a small file itself, sync
+        // once at the end
+        this->FinishHole();
+        fclose(download_file_hdl_);
+        download_file_hdl_ = NULL;
+    }
+
+    vector<FileIndexEntry_t>& entry_list = file_index_->_entry_list;
+    while (cur_file_idx_ < entry_list.size()) {
+        FileIndexEntry_t& entry = entry_list[cur_file_idx_];
+        cur_file_idx_++;
+        FILE* file_hdl = this->CreateFile(entry);
+        if (entry.chunk_num == 0) {
+            fclose(file_hdl);
+            continue;
+        }
+        download_file_hdl_ = file_hdl;
+        remain_chunk_num_ = entry.chunk_num;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief create a restored file (and its parent directories)
+ * 
+ * @param entry the file entry
+ * @return FILE* the file handler
+ */
+FILE* DownloadWriterThd::CreateFile(FileIndexEntry_t& entry) {
+    filesystem::path file_path = file_index_->GetRestorePath(entry,
+        output_root_);
+    filesystem::create_directories(file_path.parent_path());
+    FILE* file_hdl = fopen(file_path.c_str(), "wb");
+    if (file_hdl == NULL) {
+        tool::Logging(my_name_.c_str(), "cannot create the file: %s\n",
+            file_path.c_str());
+        exit(EXIT_FAILURE);
+    }
+    return file_hdl;
+}
+
+
+/**
+ * @brief write an all-zero chunk (a hole in a file, zeros in a stream)
+ * 
+ * @param size the chunk size
+ */
+void DownloadWriterThd::WriteZeroChunk(uint32_t size) {
+    if (is_stream_) {
+        static const uint8_t zero_buf[MAX_CHUNK_SIZE] = {0};
+        if (size != 0 && fwrite((char*)zero_buf, size, 1,
+            download_file_hdl_) != 1) {
+            tool::Logging(my_name_.c_str(), "write the restored data "
+                "error: %s\n", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        return ;
+    }
+
+    // skip the range, the file system leaves it unallocated
+    if (fseeko(download_file_hdl_, size, SEEK_CUR) != 0) {
+        tool::Logging(my_name_.c_str(), "seek over the hole error: %s\n",
+            strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    is_hole_end_ = true;
+    _total_hole_size += size;
+    return ;
+}
+
+/**
+ * @brief extend the current file to its end if it ends with a hole
+ * 
+ */
+void DownloadWriterThd::FinishHole() {
+    if (!is_hole_end_) {
+        return ;
+    }
+    fflush(download_file_hdl_);
+    if (ftruncate(fileno(download_file_hdl_), ftello(download_file_hdl_)) != 0) {
+        tool::Logging(my_name_.c_str(), "extend the file over the hole "
+            "error: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    is_hole_end_ = false;
+    return ;
+}
@@ -0,0 +1,316 @@
+/**
+ * @file file_index.cc
+ * @brief implement the interfaces of FileIndex
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "../../include/client/file_index.h"
+
+/**
+ * @brief Construct a new FileIndex object
+ *
+ * @param file_name_hash the session name hash
+ */
+FileIndex::FileIndex(uint8_t* file_name_hash) {
+    char file_name_hash_buf[CHUNK_HASH_SIZE * 2 + 1];
+    for (size_t i = 0; i < CHUNK_HASH_SIZE; i++) {
+        sprintf(file_name_hash_buf + i * 2, "%02x", file_name_hash[i]);
+    }
+    string file_name_str;
+    file_name_str.assign(file_name_hash_buf, CHUNK_HASH_SIZE * 2);
+    index_path_ = config.GetRecipeRootPath() + file_name_str +
+        config.GetFileIndexSuffix();
+}
+
+/**
+ * @brief Destroy the FileIndex object
+ *
+ */
+FileIndex::~FileIndex() {
+    ;
+}
+
+/**
+ * @brief add all regular files under a directory (sorted by path)
+ *
+ * @param dir_path the directory path
+ */
+void FileIndex::AddDirectory(string dir_path) {
+    root_path_ = dir_path;
+    FileIndexEntry_t tmp_entry;
+    tmp_entry.chunk_num = 0;
+    tmp_entry.size = 0;
+    tmp_entry.is_ref = false;
+    for (auto& it : filesystem::recursive_directory_iterator(dir_path)) {
+        if (!it.is_regular_file() || it.is_symlink()) {
+            continue;
+        }
+        tmp_entry.name = filesystem::relative(it.path(), dir_path).string();
+        _entry_list.push_back(tmp_entry);
+    }
+
+    // a fixed order keeps the chunk stream similar across versions
+    sort(_entry_list.begin(), _entry_list.end(),
+        [](const FileIndexEntry_t& a, const FileIndexEntry_t& b) {
+            return a.name < b.name;
+        });
+    for (auto& it : _entry_list) {
+        this->StatFile(it);
+    }
+    tool::Logging(my_name_.c_str(), "file num in %s: %lu\n", dir_path.c_str(),
+        _entry_list.size());
+    return ;
+}
+
+/**
+ * @brief add the files in a file list (one path per line)
+ *
+ * @param list_path the file list path
+ */
+void FileIndex::AddFileList(string list_path) {
+    ifstream list_hdl;
+    list_hdl.open(list_path, ios_base::in);
+    if (!list_hdl.is_open()) {
+        tool::Logging(my_name_.c_str(), "cannot open the file list: %s\n",
+            list_path.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    root_path_.clear();
+    FileIndexEntry_t tmp_entry;
+    tmp_entry.chunk_num = 0;
+    tmp_entry.size = 0;
+    tmp_entry.is_ref = false;
+    while (getline(list_hdl, tmp_entry.name)) {
+        if (tmp_entry.name.empty()) {
+            continue;
+        }
+        this->StatFile(tmp_entry);
+        _entry_list.push_back(tmp_entry);
+    }
+    list_hdl.close();
+
+    tool::Logging(my_name_.c_str(), "file num in %s: %lu\n", list_path.c_str(),
+        _entry_list.size());
+    return ;
+}
+
+/**
+ * @brief get the source path of a file
+ *
+ * @param entry the file entry
+ * @return string the source path
+ */
+string FileIndex::GetSourcePath(FileIndexEntry_t& entry) {
+    if (root_path_.empty()) {
+        return entry.name;
+    }
+    return (filesystem::path(root_path_) / entry.name).string();
+}
+
+/**
+ * @brief get the restore path of a file
+ *
+ * @param entry the file entry
+ * @param output_root the output directory
+ * @return string the restore path
+ */
+string FileIndex::GetRestorePath(FileIndexEntry_t& entry, string& output_root) {
+    // an absolute path in the file list is restored under the output directory
+    return (filesystem::path(output_root) /
+        filesystem::path(entry.name).relative_path()).string();
+}
+
+/**
+ * @brief find the files that are unchanged since the previous version of this
+ * session, and move them to the end of the session (their chunks are the
+ * ranges of the previous recipe)
+ *
+ * @param prev_index the file index of the previous version
+ */
+void FileIndex::MatchPrevious(FileIndex* prev_index) {
+    // name -> the file and its first chunk in the previous recipe
+    unordered_map<string, pair<FileIndexEntry_t*, uint64_t>> prev_file_idx;
+    uint64_t offset = 0;
+    for (auto& it : prev_index->_entry_list) {
+        prev_file_idx[it.name] = make_pair(&it, offset);
+        offset += it.chunk_num;
+    }
+
+    vector<FileIndexEntry_t> changed_list;
+    vector<pair<uint64_t, FileIndexEntry_t>> ref_list;
+    for (auto& it : _entry_list) {
+        auto find_res = prev_file_idx.find(it.name);
+        if (find_res != prev_file_idx.end()) {
+            FileIndexEntry_t* prev_entry = find_res->second.first;
+            if (prev_entry->size == it.size && prev_entry->mtime == it.mtime &&
+                prev_entry->inode == it.inode && it.mtime != 0) {
+                it.chunk_num = prev_entry->chunk_num;
+                it.is_ref = true;
+                ref_list.push_back(make_pair(find_res->second.second, it));
+                continue;
+            }
+        }
+        changed_list.push_back(it);
+    }
+
+    // keep the previous order of the unchanged files, so that their ranges
+    // are merged
+    sort(ref_list.begin(), ref_list.end(),
+        [](const pair<uint64_t, FileIndexEntry_t>& a,
+        const pair<uint64_t, FileIndexEntry_t>& b) {
+            return a.first < b.first;
+        });
+    _entry_list.swap(changed_list);
+    _ref_list.clear();
+    RecipeRef_t tmp_ref;
+    for (auto& it : ref_list) {
+        _entry_list.push_back(it.second);
+        _ref_file_num++;
+        _ref_chunk_num += it.second.chunk_num;
+        _ref_size += it.second.size;
+        if (it.second.chunk_num == 0) {
+            continue;
+        }
+        if (!_ref_list.empty() && _ref_list.back().offset +
+            _ref_list.back().chunk_num == it.first) {
+            _ref_list.back().chunk_num += it.second.chunk_num;
+        } else {
+            tmp_ref.offset = it.first;
+            tmp_ref.chunk_num = it.second.chunk_num;
+            _ref_list.push_back(tmp_ref);
+        }
+    }
+
+    tool::Logging(my_name_.c_str(), "unchanged file num: %lu, chunk num: %lu, "
+        "size: %lu, recipe ranges: %lu\n", _ref_file_num, _ref_chunk_num,
+        _ref_size, _ref_list.size());
+    return ;
+}
+
+/**
+ * @brief get the metadata of all files in the session order (detect the
+ * changed input of an interrupted upload)
+ *
+ * @return string the metadata
+ */
+string FileIndex::GetStamp() {
+    string stamp;
+    for (auto& it : _entry_list) {
+        stamp.append(it.name);
+        stamp.push_back('\0');
+        stamp.append((char*)&it.size, sizeof(uint64_t));
+        stamp.append((char*)&it.mtime, sizeof(uint64_t));
+        stamp.append((char*)&it.inode, sizeof(uint64_t));
+        stamp.push_back(it.is_ref ? 1 : 0);
+    }
+    return stamp;
+}
+
+/**
+ * @brief fill the metadata of a file
+ *
+ * @param entry the file entry
+ */
+void FileIndex::StatFile(FileIndexEntry_t& entry) {
+    struct stat file_stat;
+    if (stat(this->GetSourcePath(entry).c_str(), &file_stat) != 0) {
+        // never matched, the chunker reports the error
+        entry.mtime = 0;
+        entry.inode = 0;
+        return ;
+    }
+    entry.size = file_stat.st_size;
+    entry.mtime = file_stat.st_mtim.tv_sec * 1000000000ULL +
+        file_stat.st_mtim.tv_nsec;
+    entry.inode = file_stat.st_ino;
+    return ;
+}
+
+/**
+ * @brief check whether the session has a file index
+ *
+ * @return true a multi-file session
+ */
+bool FileIndex::Exist() {
+    return tool::FileExist(index_path_);
+}
+
+/**
+ * @brief store the index after the upload
+ *
+ */
+void FileIndex::Store() {
+    ofstream index_hdl;
+    index_hdl.open(index_path_, ios_base::trunc | ios_base::binary);
+    if (!index_hdl.is_open()) {
+        tool::Logging(my_name_.c_str(), "cannot init the file index: %s\n",
+            index_path_.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    // [file num] + [name len][name][chunk num][size][mtime][inode] per file
+    uint64_t file_num = _entry_list.size();
+    index_hdl.write((char*)&file_num, sizeof(uint64_t));
+    uint32_t name_len = 0;
+    for (auto& it : _entry_list) {
+        name_len = it.name.size();
+        index_hdl.write((char*)&name_len, sizeof(uint32_t));
+        index_hdl.write(it.name.data(), name_len);
+        index_hdl.write((char*)&it.chunk_num, sizeof(uint64_t));
+        index_hdl.write((char*)&it.size, sizeof(uint64_t));
+        index_hdl.write((char*)&it.mtime, sizeof(uint64_t));
+        index_hdl.write((char*)&it.inode, sizeof(uint64_t));
+    }
+    index_hdl.close();
+    return ;
+}
+
+/**
+ * @brief load the index before the restore
+ *
+ */
+void FileIndex::Load() {
+    ifstream index_hdl;
+    index_hdl.open(index_path_, ios_base::in | ios_base::binary);
+    if (!index_hdl.is_open()) {
+        tool::Logging(my_name_.c_str(), "cannot open the file index: %s\n",
+            index_path_.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t file_num = 0;
+    index_hdl.read((char*)&file_num, sizeof(uint64_t));
+    _entry_list.resize(file_num);
+    uint32_t name_len = 0;
+    for (auto& it : _entry_list) {
+        index_hdl.read((char*)&name_len, sizeof(uint32_t));
+        it.name.resize(name_len);
+        index_hdl.read(&it.name[0], name_len);
+        index_hdl.read((char*)&it.chunk_num, sizeof(uint64_t));
+        index_hdl.read((char*)&it.size, sizeof(uint64_t));
+        index_hdl.read((char*)&it.mtime, sizeof(uint64_t));
+        index_hdl.read((char*)&it.inode, sizeof(uint64_t));
+        it.is_ref = false;
+    }
+    if (!index_hdl) {
+        tool::Logging(my_name_.c_str(), "the file index is broken: %s\n",
+            index_path_.c_str());
+        exit(EXIT_FAILURE);
+    }
+    index_hdl.close();
+    return ;
+}
+
+/**
+ * @brief remove the index (the session is a single file now)
+ *
+ */
+void FileIndex::Remove() {
+    filesystem::remove(index_path_);
+    return ;
+}
@@ -17,12 +17,12 @@
  * @param km_channel the key manager connection channel
  * @param km_conn_record the key manager connection channel
  */
-KeyGenThd::KeyGenThd(SSLConnection* km_channel,
-    pair<int, SSL*> km_conn_record) {
-    send_chunk_batch_size_ = config.GetSendChunkBatchSize();
+KeyGenThd::KeyGenThd(AbsTransport* km_channel,
+    pair<int, Conn_t*> km_conn_record) {
+    max_batch_size_ = config.GetMaxBatchSize();
 
     // send buffer
-    send_buf_.send_buf = (uint8_t*) malloc(send_chunk_batch_size_ * 
+    send_buf_.send_buf = (uint8_t*) malloc(max_batch_size_ * 
         sizeof(KeyGenReq_t) + sizeof(NetworkHead_t));
     send_buf_.header = (NetworkHead_t*) send_buf_.send_buf;
     send_buf_.header->client_id = config.GetClientID();
@@ -31,19 +31,20 @@ KeyGenThd::KeyGenThd(SSLConnection* km_channel,
     send_buf_.data_buf = send_buf_.send_buf + sizeof(NetworkHead_t);
 
     // recv buffer
-    recv_buf_.send_buf = (uint8_t*) malloc(send_chunk_batch_size_ * 
+    recv_buf_.send_buf = (uint8_t*) malloc(max_batch_size_ * 
         sizeof(KeyGenRet_t) + sizeof(NetworkHead_t));
     recv_buf_.header = (NetworkHead_t*) recv_buf_.send_buf;
     recv_buf_.data_buf = recv_buf_.send_buf + sizeof(NetworkHead_t);
 
     // the chunk buffer
-    chunk_buf_.reserve(send_chunk_batch_size_);
+    chunk_buf_.reserve(max_batch_size_);
 
     two_phase_enc_ = new TwoPhaseEnc();
 
     km_channel_ = km_channel;
     km_conn_record_ = km_conn_record;
     km_ssl_ = km_conn_record.second;
+    batch_tuner_ = new BatchTuner("key generation", true);
 
     crypto_util_ = new CryptoUtil(CIPHER_TYPE, HASH_TYPE);
     md_ctx = EVP_MD_CTX_new();
@@ -57,6 +58,7 @@ KeyGenThd::~KeyGenThd() {
     delete crypto_util_;
     EVP_MD_CTX_free(md_ctx);
     delete two_phase_enc_;
+    delete batch_tuner_;
     free(send_buf_.send_buf);
     free(recv_buf_.send_buf);
 }
@@ -92,6 +94,18 @@ void KeyGenThd::Run(AbsMQ<FeatureChunk_t>* input_MQ,
                     this->AddChunkToBuf(tmp_data, output_MQ);
                     break;
                 }
+                case ZERO_CHUNK: {
+                    // no key, keep its order among the pending chunks
+                    if (chunk_buf_.empty()) {
+                        output_MQ->Push(tmp_data);
+                        break;
+                    }
+                    chunk_buf_.push_back(tmp_data);
+                    if (chunk_buf_.size() >= max_batch_size_) {
+                        this->ProcessBatch(output_MQ);
+                    }
+                    break;
+                }
                 case RECIPE_CHUNK: {
                     // process the tail batch first
                     this->ProcessBatch(output_MQ);
@@ -113,6 +127,7 @@ void KeyGenThd::Run(AbsMQ<FeatureChunk_t>* input_MQ,
     gettimeofday(&etime, NULL);
     total_running_time += tool::GetTimeDiff(stime, etime);
 
+    batch_tuner_->PrintStat();
     tool::Logging(my_name_.c_str(), "thread exits, total running time: %lf\n",
         total_running_time);
 
@@ -151,8 +166,10 @@ void KeyGenThd::AddChunkToBuf(EncFeatureChunk_t& input_chunk,
     memcpy(cur_key_req->features, input_chunk.feature_chunk.features,
         sizeof(uint64_t) * SUPER_FEATURE_PER_CHUNK);
     send_buf_.header->size += sizeof(KeyGenReq_t);
+    send_buf_.header->cur_item_num++;
 
-    if (chunk_buf_.size() % send_chunk_batch_size_ == 0) {
+    if (send_buf_.header->cur_item_num >= batch_tuner_->GetBatchSize() ||
+        chunk_buf_.size() >= max_batch_size_) {
         this->ProcessBatch(output_MQ);
     }
 
@@ -167,6 +184,10 @@ void KeyGenThd::AddChunkToBuf(EncFeatureChunk_t& input_chunk,
 void KeyGenThd::ProcessBatch(AbsMQ<EncFeatureChunk_t>* output_MQ) {
     uint32_t recv_size = 0;
     uint32_t cur_batch_size = chunk_buf_.size();
+    // the zero chunks in the batch have no key request
+    uint32_t req_num = send_buf_.header->cur_item_num;
+    struct timeval rtt_stime;
+    struct timeval rtt_etime;
     // EVP_MD_CTX* md_ctx = EVP_MD_CTX_new();
 
     if (cur_batch_size == 0) {
@@ -174,7 +195,6 @@ void KeyGenThd::ProcessBatch(AbsMQ<EncFeatureChunk_t>* output_MQ) {
     }
 
     // send the request to the key mananger
-    send_buf_.header->cur_item_num = cur_batch_size;
     send_buf_.header->client_id = config.GetClientID();
     send_buf_.header->msg_type = CLIENT_KEY_GEN;
 
@@ -182,6 +202,7 @@ void KeyGenThd::ProcessBatch(AbsMQ<EncFeatureChunk_t>* output_MQ) {
     gettimeofday(&_key_gen_stime, NULL);
 #endif
 
+    gettimeofday(&rtt_stime, NULL);
     if (!km_channel_->SendData(km_ssl_, send_buf_.send_buf,
         send_buf_.header->size + sizeof(NetworkHead_t))) {
         tool::Logging(my_name_.c_str(), "send the key gen batch error.\n");
@@ -193,6 +214,9 @@ void KeyGenThd::ProcessBatch(AbsMQ<EncFeatureChunk_t>* output_MQ) {
         tool::Logging(my_name_.c_str(), "recv the key gen batch error.\n");
         exit(EXIT_FAILURE);
     }
+    gettimeofday(&rtt_etime, NULL);
+    batch_tuner_->OnBatch(km_channel_, km_ssl_, req_num,
+        tool::GetTimeDiff(rtt_stime, rtt_etime));
 
 #ifdef EDR_BREAKDOWN
     gettimeofday(&_key_gen_etime, NULL);
@@ -202,6 +226,11 @@ void KeyGenThd::ProcessBatch(AbsMQ<EncFeatureChunk_t>* output_MQ) {
 
     KeyGenRet_t* cur_key_ret = (KeyGenRet_t*) recv_buf_.data_buf;
     for (size_t i = 0; i < cur_batch_size; i++) {
+        if (chunk_buf_[i].feature_chunk.chunk.type == ZERO_CHUNK) {
+            output_MQ->Push(chunk_buf_[i]);
+            continue;
+        }
+
         // // copy the key seed
         // memcpy(chunk_buf_[i].key, cur_key_ret->key_seed, CHUNK_HASH_SIZE);
         // // chunk_buf_[i].seed = cur_key_ret->seed;
@@ -68,6 +68,7 @@ void PlainSimilarThd::Run(AbsMQ<Chunk_t>* input_MQ,
                         tmp_data.chunk.raw_chunk.size, tmp_data.features);
                     break;
                 }
+                case ZERO_CHUNK:
                 case RECIPE_CHUNK: {
                     break;
                 }
@@ -81,7 +82,7 @@ void PlainSimilarThd::Run(AbsMQ<Chunk_t>* input_MQ,
             gettimeofday(&_plain_feature_etime, NULL);
             _total_plain_feature_time += tool::GetTimeDiff(
                 _plain_feature_stime, _plain_feature_etime);
-            if (tmp_data.chunk.type != RECIPE_CHUNK) {
+            if (tmp_data.chunk.type == NORMAL_CHUNK) {
                 _total_plain_feature_size += tmp_data.chunk.raw_chunk.size;
             }
 #endif
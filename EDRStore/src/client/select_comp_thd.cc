@@ -69,6 +69,18 @@ void SelectCompThd::Run(AbsMQ<EncFeatureChunk_t>* input_MQ,
 
         if(input_MQ->Pop(tmp_data)){
             // extract a chunk from the MQ
+            if (tmp_data.feature_chunk.chunk.type == ZERO_CHUNK) {
+                this->ZeroChunk(&tmp_data, &tmp_send_chunk);
+                output_MQ->Push(tmp_send_chunk);
+                continue;
+            }
+            if (version_delta_ != NULL &&
+                tmp_data.feature_chunk.chunk.type == NORMAL_CHUNK &&
+                this->VersionDeltaMode(&tmp_data, &tmp_send_chunk)) {
+                output_MQ->Push(tmp_send_chunk);
+                continue;
+            }
+
             switch (method_type_) {
                 case ONLY_SIMILAR_ENC: {
                     this->OnlyEncMode(&tmp_data, &tmp_send_chunk);
@@ -108,6 +120,67 @@ void SelectCompThd::Run(AbsMQ<EncFeatureChunk_t>* input_MQ,
     return ;
 }
 
+/**
+ * @brief Set the version delta
+ * 
+ * @param version_delta the version delta
+ */
+void SelectCompThd::SetVersionDelta(VersionDelta* version_delta) {
+    version_delta_ = version_delta;
+    return ;
+}
+
+/**
+ * @brief delta-encode a chunk against the previous version
+ * 
+ * @param input_chunk input chunk
+ * @param output_chunk output chunk
+ * @return true the chunk is sent as a delta
+ * @return false the chunk is sent in full
+ */
+bool SelectCompThd::VersionDeltaMode(EncFeatureChunk_t* input_chunk,
+    SelectComp2Sender_t* output_chunk) {
+    uint8_t delta_buf[ENC_MAX_CHUNK_SIZE];
+    uint32_t delta_size = 0;
+    VersionSig_t base_sig;
+    if (!version_delta_->EncodeChunk(input_chunk, delta_buf, delta_size,
+        &base_sig)) {
+        version_delta_->AddChunk(input_chunk, NULL);
+        return false;
+    }
+    version_delta_->AddChunk(input_chunk, &base_sig);
+
+    // encrypt the delta with the chunk key, the key recipe is unchanged
+    output_chunk->send_chunk.header.type = CLIENT_DELTA_CHUNK;
+    output_chunk->send_chunk.header.size = two_phase_enc_->TwoPhaseEncChunk(
+        delta_buf, delta_size, input_chunk->key, output_chunk->send_chunk.data);
+    memcpy(output_chunk->send_chunk.header.base_fp, base_sig.fp,
+        CHUNK_HASH_SIZE);
+    memcpy(output_chunk->key_recipe.key, input_chunk->key, CHUNK_HASH_SIZE);
+    return true;
+}
+
+/**
+ * @brief an all-zero chunk: only its size is sent
+ * 
+ * @param input_chunk input chunk
+ * @param output_chunk output chunk
+ */
+void SelectCompThd::ZeroChunk(EncFeatureChunk_t* input_chunk,
+    SelectComp2Sender_t* output_chunk) {
+    output_chunk->send_chunk.header.type = ZERO_CHUNK;
+    output_chunk->send_chunk.header.size = sizeof(uint32_t);
+    memcpy(output_chunk->send_chunk.data,
+        &input_chunk->feature_chunk.chunk.raw_chunk.size, sizeof(uint32_t));
+
+    // keep the key recipe aligned with the recipe
+    memset(output_chunk->key_recipe.key, 0, CHUNK_HASH_SIZE);
+    if (version_delta_ != NULL) {
+        version_delta_->AddZeroChunk();
+    }
+    return ;
+}
+
 /**
  * @brief only enc mode
  * 
@@ -286,15 +359,15 @@ bool SelectCompThd::FullEDR(EncFeatureChunk_t* input_chunk,
                 gettimeofday(&_cache_manage_stime, NULL);
 #endif
 
-                cache_meta_->UpdateCacheMeta(input_chunk->feature_chunk.features);
+                // only send the cached chunk if it is admitted
+                ret = cache_meta_->UpdateCacheMeta(
+                    input_chunk->feature_chunk.features);
 
 #ifdef EDR_BREAKDOWN
                 gettimeofday(&_cache_manage_etime, NULL);
                 _total_cache_manage_time += tool::GetTimeDiff(_cache_manage_stime,
                     _cache_manage_etime);
 #endif
-
-                ret = true;
             }
             break;
         }
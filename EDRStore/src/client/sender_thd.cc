@@ -18,32 +18,20 @@
  * @param server_conn_record the storage server connection record
  * @param file_name_hash the file name hash
  * @param cache_meta cache meta 
+ * @param method_type method type
  */
-SenderThd::SenderThd(SSLConnection* server_channel, pair<int, SSL*> server_conn_record,
-    uint8_t* file_name_hash, CacheMeta* cache_meta) {
+SenderThd::SenderThd(AbsTransport* server_channel, pair<int, Conn_t*> server_conn_record,
+    uint8_t* file_name_hash, CacheMeta* cache_meta, uint32_t method_type) {
     // for config
     send_chunk_batch_size_ = config.GetSendChunkBatchSize();
-    send_recipe_batch_size_ = config.GetSendRecipeBatchSize();
+    max_batch_size_ = config.GetMaxBatchSize();
     client_id_ = config.GetClientID();
 
-    // send chunk buffer
-    send_chunk_buf_.send_buf = (uint8_t*) malloc(2 * send_chunk_batch_size_ *
-        sizeof(SendChunk_t) + sizeof(NetworkHead_t));
-    send_chunk_buf_.header = (NetworkHead_t*) send_chunk_buf_.send_buf;
-    send_chunk_buf_.header->client_id = client_id_;
-    send_chunk_buf_.header->size = 0;
-    send_chunk_buf_.header->cur_item_num = 0;
-    send_chunk_buf_.data_buf = send_chunk_buf_.send_buf + sizeof(NetworkHead_t); 
-
     // for storage server connection
     server_channel_ = server_channel;
     server_conn_record_ = server_conn_record;
     server_ssl_ = server_conn_record.second;
-
-    // for key recipe
-    key_recipe_buf_.buf = (uint8_t*) malloc(send_recipe_batch_size_ *
-        sizeof(KeyRecipe_t));
-    key_recipe_buf_.cnt = 0;
+    stripe_conn_list_.push_back(server_conn_record);
 
     char file_name_hash_buf[CHUNK_HASH_SIZE * 2 + 1];
     for (size_t i = 0; i < CHUNK_HASH_SIZE; i++) {
@@ -51,20 +39,33 @@ SenderThd::SenderThd(SSLConnection* server_channel, pair<int, SSL*> server_conn_
     }
     string file_name_str;
     file_name_str.assign(file_name_hash_buf, CHUNK_HASH_SIZE * 2);
-    string key_recipe_path = config.GetRecipeRootPath() + file_name_str +
+    key_recipe_path_ = config.GetRecipeRootPath() + file_name_str +
         config.GetKeyRecipeSuffix();
-    key_recipe_hdl_.open(key_recipe_path, ios_base::trunc | ios_base::binary);
-    if (!key_recipe_hdl_.is_open()) {
-        tool::Logging(my_name_.c_str(), "cannot init key recipe file: %s\n",
-            key_recipe_path.c_str());
-        exit(EXIT_FAILURE);
+    if (tool::FileExist(key_recipe_path_)) {
+        prev_key_recipe_hdl_.open(key_recipe_path_, ios_base::in | ios_base::binary);
     }
 
     // for re-encryption
     two_phase_enc_ = new TwoPhaseEnc();
 
+    // for the fingerprint-first upload
+    crypto_util_ = new CryptoUtil(CIPHER_TYPE, HASH_TYPE);
+    md_ctx_ = EVP_MD_CTX_new();
+
     // for cache meta
     cache_meta_ = cache_meta;
+    method_type_ = method_type;
+
+    // the inform cache state of FULL_EDR is not checkpointed
+    if (method_type_ != FULL_EDR) {
+        ckpt_size_ = config.GetCheckpointSize() * 1024 * 1024;
+    }
+    if (method_type_ == FULL_EDR) {
+        // detach the expired features before the pipeline starts, stream
+        // their eviction notices ahead of the first chunk batch
+        cache_meta_->CollectExpiredFeature();
+        evict_pending_ = true;
+    }
 }
 
 /**
@@ -72,10 +73,91 @@ SenderThd::SenderThd(SSLConnection* server_channel, pair<int, SSL*> server_conn_
  * 
  */
 SenderThd::~SenderThd() {
-    key_recipe_hdl_.close();
-    free(send_chunk_buf_.send_buf);
-    free(key_recipe_buf_.buf);
+    if (key_recipe_hdl_.is_open()) {
+        key_recipe_hdl_.close();
+    }
+    if (prev_key_recipe_hdl_.is_open()) {
+        prev_key_recipe_hdl_.close();
+    }
+    SendBatch_t* tmp_batch;
+    for (uint32_t i = 0; i < free_batch_mq_.size(); i++) {
+        while (free_batch_mq_[i]->Pop(tmp_batch)) {
+            ;
+        }
+        delete free_batch_mq_[i];
+        delete full_batch_mq_[i];
+        free(bitmap_buf_[i]);
+    }
+    for (size_t i = 0; i < batch_list_.size(); i++) {
+        free(batch_list_[i].chunk_buf.send_buf);
+        free(batch_list_[i].key_recipe_buf.buf);
+        free(batch_list_[i].fp_buf.send_buf);
+    }
     delete two_phase_enc_;
+    delete crypto_util_;
+    delete batch_tuner_;
+    EVP_MD_CTX_free(md_ctx_);
+}
+
+/**
+ * @brief allocate the batch buffers of the negotiated stripes
+ * 
+ */
+void SenderThd::InitBatches() {
+    // keep at least two batches in flight per stripe
+    uint32_t stripe_batch_num = max(tool::DivCeil(SEND_BATCH_BUF_NUM,
+        stripe_num_), (uint32_t)2);
+    batch_list_.resize(stripe_batch_num * stripe_num_);
+
+    MQFactory<SendBatch_t*> batch_mq_factory;
+    for (uint32_t i = 0; i < stripe_num_; i++) {
+        free_batch_mq_.push_back(batch_mq_factory.CreateMQ(LCK_FREE_MQ,
+            stripe_batch_num));
+        full_batch_mq_.push_back(batch_mq_factory.CreateMQ(LCK_FREE_MQ,
+            stripe_batch_num));
+        bitmap_buf_.push_back(NULL);
+        if (fp_first_) {
+            bitmap_buf_[i] = (uint8_t*) malloc(sizeof(NetworkHead_t) +
+                tool::DivCeil(max_batch_size_, 8));
+        }
+    }
+
+    for (size_t i = 0; i < batch_list_.size(); i++) {
+        SendMsgBuffer_t* chunk_buf = &batch_list_[i].chunk_buf;
+        chunk_buf->send_buf = (uint8_t*) malloc(2 * max_batch_size_ *
+            sizeof(SendChunk_t) + sizeof(NetworkHead_t));
+        chunk_buf->header = (NetworkHead_t*) chunk_buf->send_buf;
+        chunk_buf->header->client_id = client_id_;
+        chunk_buf->header->size = 0;
+        chunk_buf->header->cur_item_num = 0;
+        chunk_buf->data_buf = chunk_buf->send_buf + sizeof(NetworkHead_t);
+
+        batch_list_[i].key_recipe_buf.buf = (uint8_t*) malloc(
+            max_batch_size_ * sizeof(KeyRecipe_t));
+        batch_list_[i].key_recipe_buf.cnt = 0;
+
+        // the fp queries are only sent in the fingerprint-first upload
+        SendMsgBuffer_t* fp_buf = &batch_list_[i].fp_buf;
+        fp_buf->send_buf = NULL;
+        if (fp_first_) {
+            fp_buf->send_buf = (uint8_t*) malloc(max_batch_size_ *
+                sizeof(FpQuery_t) + sizeof(NetworkHead_t));
+            fp_buf->header = (NetworkHead_t*) fp_buf->send_buf;
+            fp_buf->header->client_id = client_id_;
+            fp_buf->header->msg_type = CLIENT_UPLOAD_FP;
+            fp_buf->header->size = 0;
+            fp_buf->header->cur_item_num = 0;
+            fp_buf->data_buf = fp_buf->send_buf + sizeof(NetworkHead_t);
+        }
+
+        SendBatch_t* tmp_batch = &batch_list_[i];
+        free_batch_mq_[i % stripe_num_]->Push(tmp_batch);
+    }
+    io_thd_num_ = stripe_num_;
+
+    // the fp queries of a batch wait for the bitmap
+    batch_tuner_ = new BatchTuner("chunk upload", fp_first_);
+    return ;
 }
 
 /**
@@ -94,7 +176,10 @@ void SenderThd::Run(AbsMQ<SelectComp2Sender_t>* input_MQ) {
     // -------- main process --------
 
     SelectComp2Sender_t tmp_data;
-    uint8_t tmp_enc_buf[ENC_MAX_CHUNK_SIZE];
+    while (!free_batch_mq_[0]->Pop(cur_batch_)) {
+        ;
+    }
+    SendMsgBuffer_t* chunk_buf;
     while (true) {
         // extract a chunk from the MQ
         if (input_MQ->_done && input_MQ->IsEmpty()) {
@@ -103,120 +188,84 @@ void SenderThd::Run(AbsMQ<SelectComp2Sender_t>* input_MQ) {
         }
 
         if (input_MQ->Pop(tmp_data)) {
+            chunk_buf = &cur_batch_->chunk_buf;
             switch (tmp_data.send_chunk.header.type) {
                 case COMPRESSED_NORMAL_CHUNK: {
                     // this a compressed normal chunk (compressed chunk -> new base chunk)
-                    // perform re-encryption
+                    // perform re-encryption directly into the batch
+                    // the cipher size is unknown yet, reserve the header
+                    // for its upper bound
+                    uint8_t* header_pos = chunk_buf->data_buf +
+                        chunk_buf->header->size;
+                    uint32_t header_len = wire::ChunkHeaderLen(NORMAL_CHUNK,
+                        tmp_data.send_chunk.header.size + CRYPTO_BLOCK_SIZE,
+                        wire_ver_);
+                    chunk_buf->header->size += header_len;
+                    uint8_t* payload_pos = chunk_buf->data_buf +
+                        chunk_buf->header->size;
                     tmp_data.send_chunk.header.size = two_phase_enc_->TwoPhaseEncChunk(
                         tmp_data.send_chunk.data,
                         tmp_data.send_chunk.header.size,
                         tmp_data.key_recipe.key,
-                        tmp_enc_buf);
+                        payload_pos);
                     tmp_data.send_chunk.header.type = NORMAL_CHUNK;
-                    
-                    memcpy(send_chunk_buf_.data_buf + send_chunk_buf_.header->size,
-                        &tmp_data.send_chunk.header, sizeof(SendChunkHeader_t));
-                    send_chunk_buf_.header->size += sizeof(SendChunkHeader_t);
-                    memcpy(send_chunk_buf_.data_buf + send_chunk_buf_.header->size,
-                        tmp_enc_buf, tmp_data.send_chunk.header.size);
-                    send_chunk_buf_.header->size += tmp_data.send_chunk.header.size;
-
-                    send_chunk_buf_.header->cur_item_num++;
-                    
-                    if(send_chunk_buf_.header->cur_item_num %
-                        send_chunk_batch_size_ == 0){
-                        this->SendChunks();
+                    wire::EncodeChunkHeader(&tmp_data.send_chunk.header,
+                        header_pos, wire_ver_, header_len);
+                    if (fp_first_) {
+                        this->AddFpQuery(&tmp_data.send_chunk.header, payload_pos);
                     }
+                    chunk_buf->header->size += tmp_data.send_chunk.header.size;
 
                     // update the send size
                     _total_send_data_size += tmp_data.send_chunk.header.size;
 
                     // store the key recipe
                     this->StoreKeyRecipe(&tmp_data.key_recipe);
-                    break;
-                } 
-                case NORMAL_CHUNK: {
-                    // this is a normal chunk (uncompressed chunk):
-                    memcpy(send_chunk_buf_.data_buf + send_chunk_buf_.header->size,
-                        &tmp_data.send_chunk.header, sizeof(SendChunkHeader_t));
-                    send_chunk_buf_.header->size += sizeof(SendChunkHeader_t);
-                    memcpy(send_chunk_buf_.data_buf + send_chunk_buf_.header->size,
-                        tmp_data.send_chunk.data, tmp_data.send_chunk.header.size);
-                    send_chunk_buf_.header->size += tmp_data.send_chunk.header.size;
-
-                    send_chunk_buf_.header->cur_item_num++;
-                    
-                    if(send_chunk_buf_.header->cur_item_num %
-                        send_chunk_batch_size_ == 0){
+
+                    chunk_buf->header->cur_item_num++;
+                    if (chunk_buf->header->cur_item_num >=
+                        batch_tuner_->GetBatchSize()) {
                         this->SendChunks();
                     }
-
-                    // update the send size
-                    _total_send_data_size += tmp_data.send_chunk.header.size;
+                    break;
+                } 
+                case NORMAL_CHUNK:
+                case CLIENT_DELTA_CHUNK:
+                case ZERO_CHUNK:
+                case FULL_EDR_UNCOMPRESS_CHUNK: {
+                    // this is a normal chunk (uncompressed chunk / delta
+                    // against the previous version / all-zero chunk /
+                    // uncompressed chunk -> similar chunk)
+                    this->AppendChunk(&tmp_data.send_chunk);
 
                     // store the key recipe
                     this->StoreKeyRecipe(&tmp_data.key_recipe);
+
+                    chunk_buf->header->cur_item_num++;
+                    if (chunk_buf->header->cur_item_num >=
+                        batch_tuner_->GetBatchSize()) {
+                        this->SendChunks();
+                    }
                     break;
                 }
                 case FULL_EDR_CACHE_CHUNK: {
                     // this is a cached chunk (uncompressed chunk -> non-similar chunk):
-                    // cached chunk
-                    memcpy(send_chunk_buf_.data_buf + send_chunk_buf_.header->size,
-                        &tmp_data.send_chunk.header, sizeof(SendChunkHeader_t));
-                    send_chunk_buf_.header->size += sizeof(SendChunkHeader_t);
-                    memcpy(send_chunk_buf_.data_buf + send_chunk_buf_.header->size,
-                        tmp_data.send_chunk.data, tmp_data.send_chunk.header.size);
-                    send_chunk_buf_.header->size += tmp_data.send_chunk.header.size;
-
-                    // update the send size
-                    _total_send_data_size += tmp_data.send_chunk.header.size;
-
-                    // do not need to update key recipe
-                    break;
-                }
-                case FULL_EDR_UNCOMPRESS_CHUNK: {
-                    // this is a normal chunk (uncompressed chunk -> similar chunk):
-                    memcpy(send_chunk_buf_.data_buf + send_chunk_buf_.header->size,
-                        &tmp_data.send_chunk.header, sizeof(SendChunkHeader_t));
-                    send_chunk_buf_.header->size += sizeof(SendChunkHeader_t);
-                    memcpy(send_chunk_buf_.data_buf + send_chunk_buf_.header->size,
-                        tmp_data.send_chunk.data, tmp_data.send_chunk.header.size);
-                    send_chunk_buf_.header->size += tmp_data.send_chunk.header.size;
-
-                    send_chunk_buf_.header->cur_item_num++;
-                    
-                    if(send_chunk_buf_.header->cur_item_num %
-                        send_chunk_batch_size_ == 0){
-                        this->SendChunks();
-                    }
-
-                    // update the send size
-                    _total_send_data_size += tmp_data.send_chunk.header.size;
-
-                    // store the key recipe
-                    this->StoreKeyRecipe(&tmp_data.key_recipe);
+                    // cached chunk, do not need to update key recipe
+                    this->AppendChunk(&tmp_data.send_chunk);
                     break;
                 }
                 case RECIPE_CHUNK: {
                     // this is the end recipe chunk
-                    if (send_chunk_buf_.header->cur_item_num != 0) {
+                    if (chunk_buf->header->cur_item_num != 0) {
                         this->SendChunks();
                     }
-                    if (key_recipe_buf_.cnt != 0) {
-                        key_recipe_hdl_.write((char*)key_recipe_buf_.buf,
-                            key_recipe_buf_.cnt * sizeof(KeyRecipe_t));
-                        key_recipe_buf_.cnt = 0;
+                    if (ref_list_ != NULL && !ref_list_->empty()) {
+                        this->SendRecipeRef();
                     }
                     this->ProcessRecipeEnd(&tmp_data.send_chunk);
 
-                    // evict the feature here
-                    cache_meta_->EvictFeature();
-
                     _cur_version_idx_size = cache_meta_->GetFeatureNum() * (sizeof(uint64_t) +
                         sizeof(uint32_t));
-
-                    // close the connection 
-                    server_channel_->Finish(server_conn_record_);
                     break;
                 }
                 default: {
@@ -227,6 +276,11 @@ void SenderThd::Run(AbsMQ<SelectComp2Sender_t>* input_MQ) {
         }
     }
 
+    // the I/O threads close the connections after the last batch
+    for (uint32_t i = 0; i < stripe_num_; i++) {
+        full_batch_mq_[i]->_done = true;
+    }
+
     gettimeofday(&etime, NULL);
     total_running_time += tool::GetTimeDiff(stime, etime);
 
@@ -237,43 +291,573 @@ void SenderThd::Run(AbsMQ<SelectComp2Sender_t>* input_MQ) {
 }
 
 /**
- * @brief send a batch of chunks
+ * @brief the I/O thread of a stripe (send the batches and write the key
+ * recipe)
+ * 
+ * @param stripe_id the stripe id
+ */
+void SenderThd::RunIO(uint32_t stripe_id) {
+    tool::Logging(my_name_.c_str(), "the I/O thread of stripe %u is running.\n",
+        stripe_id);
+
+    struct timeval stime;
+    struct timeval etime;
+    double total_io_time = 0;
+
+    AbsMQ<SendBatch_t*>* full_batch_mq = full_batch_mq_[stripe_id];
+    Conn_t* stripe_ssl = stripe_conn_list_[stripe_id].second;
+    uint64_t batch_seq = stripe_id;
+    SendBatch_t* tmp_batch;
+    SendMsgBuffer_t* chunk_buf;
+    uint64_t batch_item_num = 0;
+    struct timeval batch_stime;
+    struct timeval batch_etime;
+    while (true) {
+        if (full_batch_mq->_done && full_batch_mq->IsEmpty()) {
+            break;
+        }
+
+        if (full_batch_mq->Pop(tmp_batch)) {
+            gettimeofday(&stime, NULL);
+            // the eviction notice must arrive before the chunks (it goes
+            // through the login connection, the server reads it first; a
+            // FULL_EDR upload has no other stripe)
+            if (stripe_id == 0 && method_type_ == FULL_EDR) {
+                cache_meta_->EvictFeature();
+                evict_pending_ = false;
+            }
+
+            chunk_buf = &tmp_batch->chunk_buf;
+            batch_item_num = chunk_buf->header->cur_item_num;
+            gettimeofday(&batch_stime, NULL);
+
+            // only send the payloads that the server asks for
+            if (fp_first_ && tmp_batch->fp_buf.header->cur_item_num != 0) {
+                this->QueryFp(tmp_batch, stripe_id);
+            }
+
+            // the chunks are encrypted already, only the head of a chunk batch
+            // is encrypted again on the authenticated-only data frames
+            uint32_t head_size = chunk_buf->header->size + sizeof(NetworkHead_t);
+            if (chunk_buf->header->msg_type == CLIENT_UPLOAD_CHUNK) {
+                head_size = sizeof(NetworkHead_t);
+                this->AcquireCredit(stripe_id, chunk_buf->header->size +
+                    sizeof(NetworkHead_t));
+            }
+            if (!server_channel_->SendPayload(stripe_ssl, chunk_buf->send_buf,
+                chunk_buf->header->size + sizeof(NetworkHead_t), head_size)) {
+                tool::Logging(my_name_.c_str(), "send the batch error.\n");
+                exit(EXIT_FAILURE);
+            }
+            if (chunk_buf->header->msg_type == CLIENT_UPLOAD_CHUNK) {
+                gettimeofday(&batch_etime, NULL);
+                batch_tuner_->OnBatch(server_channel_, stripe_ssl,
+                    batch_item_num, tool::GetTimeDiff(batch_stime,
+                    batch_etime));
+            }
+
+            // write the key recipe while the next batch is assembled, wait for
+            // the stripes of the previous batches
+            {
+                unique_lock<mutex> lck(key_recipe_mtx_);
+                key_recipe_cv_.wait(lck, [&] {
+                    return key_recipe_turn_ == batch_seq;
+                });
+            }
+            if (tmp_batch->key_recipe_buf.cnt != 0) {
+                key_recipe_hdl_.write((char*)tmp_batch->key_recipe_buf.buf,
+                    tmp_batch->key_recipe_buf.cnt * sizeof(KeyRecipe_t));
+                tmp_batch->key_recipe_buf.cnt = 0;
+            }
+            if (chunk_buf->header->msg_type == CLIENT_UPLOAD_RECIPE_REF) {
+                this->CopyKeyRecipe(tmp_batch);
+            }
+            if (chunk_buf->header->msg_type == CLIENT_UPLOAD_CHECKPOINT) {
+                this->WaitCheckpoint(stripe_id);
+            }
+            {
+                lock_guard<mutex> lck(key_recipe_mtx_);
+                key_recipe_turn_++;
+            }
+            key_recipe_cv_.notify_all();
+            batch_seq += stripe_num_;
+
+            // return the batch to the assembler
+            chunk_buf->header->cur_item_num = 0;
+            chunk_buf->header->size = 0;
+            free_batch_mq_[stripe_id]->Push(tmp_batch);
+            gettimeofday(&etime, NULL);
+            total_io_time += tool::GetTimeDiff(stime, etime);
+        } else if (stripe_id == 0 && evict_pending_) {
+            // the pipeline is not ready, send the eviction notice
+            evict_pending_ = cache_meta_->EvictFeatureBatch();
+        }
+    }
+
+    // take the pending grant before closing, the server answers it ahead of
+    // the close
+    if (credit_window_ != 0 && credit_req_list_[stripe_id]) {
+        this->WaitCredit(stripe_id);
+    }
+
+    // close the connection 
+    server_channel_->Finish(stripe_conn_list_[stripe_id]);
+
+    lock_guard<mutex> lck(stat_lck_);
+    _total_io_time += total_io_time;
+    io_thd_num_--;
+    if (io_thd_num_ == 0) {
+        // the last I/O thread replaces the previous key recipe
+        key_recipe_hdl_.close();
+        if (prev_key_recipe_hdl_.is_open()) {
+            prev_key_recipe_hdl_.close();
+        }
+        string tmp_key_recipe_path = key_recipe_path_ + config.GetTmpSuffix();
+        if (rename(tmp_key_recipe_path.c_str(), key_recipe_path_.c_str()) != 0) {
+            tool::Logging(my_name_.c_str(), "cannot commit key recipe file: %s\n",
+                key_recipe_path_.c_str());
+            exit(EXIT_FAILURE);
+        }
+        filesystem::remove(key_recipe_path_ + config.GetCkptSuffix());
+        if (_total_ckpt_num != 0) {
+            tool::Logging(my_name_.c_str(), "checkpoint num: %lu, last acked "
+                "chunk num: %lu\n", _total_ckpt_num, _acked_chunk_num);
+        }
+    }
+    if (io_thd_num_ == 0) {
+        batch_tuner_->PrintStat();
+    }
+    if (io_thd_num_ == 0 && fp_first_) {
+        tool::Logging(my_name_.c_str(), "skipped chunk num: %lu, skipped data "
+            "size: %lu\n", _total_skip_chunk_num, _total_skip_data_size);
+    }
+    if (io_thd_num_ == 0 && credit_window_ != 0) {
+        tool::Logging(my_name_.c_str(), "batches out of credit: %lu\n",
+            _total_credit_wait_num);
+    }
+    tool::Logging(my_name_.c_str(), "I/O thread of stripe %u exits, I/O time: "
+        "%lf\n", stripe_id, total_io_time);
+    return ;
+}
+
+/**
+ * @brief hand over the current batch to the I/O thread and get a free one
  * 
  */
 void SenderThd::SendChunks() {
-    send_chunk_buf_.header->msg_type = CLIENT_UPLOAD_CHUNK;
-    if (!server_channel_->SendData(server_ssl_,
-        send_chunk_buf_.send_buf,
-        send_chunk_buf_.header->size + sizeof(NetworkHead_t))) {
-        tool::Logging(my_name_.c_str(), "send the chunk batch error.\n");
+    cur_batch_->chunk_buf.header->msg_type = CLIENT_UPLOAD_CHUNK;
+    ckpt_pending_size_ += cur_batch_->chunk_buf.header->size;
+    this->PushBatch();
+
+    if (ckpt_size_ != 0 && ckpt_pending_size_ >= ckpt_size_) {
+        // an empty batch asks the server to persist the chunks sent so far
+        cur_batch_->chunk_buf.header->msg_type = CLIENT_UPLOAD_CHECKPOINT;
+        this->PushBatch();
+        ckpt_pending_size_ = 0;
+    }
+    return ;
+}
+
+/**
+ * @brief hand over the current batch to the I/O thread (with its message type
+ * set) and get a free one
+ * 
+ */
+void SenderThd::PushBatch() {
+    full_batch_mq_[batch_seq_ % stripe_num_]->Push(cur_batch_);
+    batch_seq_++;
+
+    while (!free_batch_mq_[batch_seq_ % stripe_num_]->Pop(cur_batch_)) {
+        ;
+    }
+
+    return ;
+}
+
+/**
+ * @brief Set the ranges of the previous recipe used by the unchanged files
+ * 
+ * @param ref_list the range list
+ */
+void SenderThd::SetRecipeRef(vector<RecipeRef_t>* ref_list) {
+    if (!ref_list->empty() && !prev_key_recipe_hdl_.is_open()) {
+        tool::Logging(my_name_.c_str(), "no previous key recipe for the "
+            "unchanged files.\n");
         exit(EXIT_FAILURE);
     }
+    ref_list_ = ref_list;
+    return ;
+}
+
+/**
+ * @brief send the ranges of the previous recipe
+ * 
+ */
+void SenderThd::SendRecipeRef() {
+    SendMsgBuffer_t* chunk_buf;
+    for (auto& it : *ref_list_) {
+        chunk_buf = &cur_batch_->chunk_buf;
+        memcpy(chunk_buf->data_buf + chunk_buf->header->size, &it,
+            sizeof(RecipeRef_t));
+        chunk_buf->header->size += sizeof(RecipeRef_t);
+        chunk_buf->header->cur_item_num++;
+        if (chunk_buf->header->cur_item_num % send_chunk_batch_size_ == 0) {
+            chunk_buf->header->msg_type = CLIENT_UPLOAD_RECIPE_REF;
+            this->PushBatch();
+        }
+    }
+
+    chunk_buf = &cur_batch_->chunk_buf;
+    if (chunk_buf->header->cur_item_num != 0) {
+        chunk_buf->header->msg_type = CLIENT_UPLOAD_RECIPE_REF;
+        this->PushBatch();
+    }
+    return ;
+}
+
+/**
+ * @brief copy the key recipes of the ranges in a batch
+ * 
+ * @param batch the batch
+ */
+void SenderThd::CopyKeyRecipe(SendBatch_t* batch) {
+    SendMsgBuffer_t* chunk_buf = &batch->chunk_buf;
+    RecipeRef_t* ref_list = (RecipeRef_t*)chunk_buf->data_buf;
+    uint8_t* copy_buf = batch->key_recipe_buf.buf;
+    uint64_t copy_num = 0;
+    for (uint32_t i = 0; i < chunk_buf->header->cur_item_num; i++) {
+        prev_key_recipe_hdl_.seekg(ref_list[i].offset * sizeof(KeyRecipe_t),
+            ios_base::beg);
+        for (uint64_t j = 0; j < ref_list[i].chunk_num; j += copy_num) {
+            copy_num = min(ref_list[i].chunk_num - j, send_chunk_batch_size_);
+            prev_key_recipe_hdl_.read((char*)copy_buf,
+                copy_num * sizeof(KeyRecipe_t));
+            if ((uint64_t)prev_key_recipe_hdl_.gcount() !=
+                copy_num * sizeof(KeyRecipe_t)) {
+                tool::Logging(my_name_.c_str(), "read the previous key recipe "
+                    "error.\n");
+                exit(EXIT_FAILURE);
+            }
+            key_recipe_hdl_.write((char*)copy_buf, copy_num * sizeof(KeyRecipe_t));
+        }
+    }
+    return ;
+}
 
-    // clear the current send chunk buffer
-    send_chunk_buf_.header->cur_item_num = 0;
-    send_chunk_buf_.header->size = 0;
+/**
+ * @brief copy a chunk to the current batch
+ * 
+ * @param send_chunk the chunk
+ */
+void SenderThd::AppendChunk(SendChunk_t* send_chunk) {
+    SendMsgBuffer_t* chunk_buf = &cur_batch_->chunk_buf;
+    chunk_buf->header->size += wire::EncodeChunkHeader(&send_chunk->header,
+        chunk_buf->data_buf + chunk_buf->header->size, wire_ver_);
+    memcpy(chunk_buf->data_buf + chunk_buf->header->size,
+        send_chunk->data, send_chunk->header.size);
+    chunk_buf->header->size += send_chunk->header.size;
+    if (fp_first_) {
+        this->AddFpQuery(&send_chunk->header, send_chunk->data);
+    }
 
+    // update the send size
+    _total_send_data_size += send_chunk->header.size;
     return ;
 }
 
+/**
+ * @brief add the fp query of a chunk to the current batch
+ * 
+ * @param header the chunk header
+ * @param data the chunk payload (ciphertext)
+ */
+void SenderThd::AddFpQuery(SendChunkHeader_t* header, uint8_t* data) {
+    // the compressed chunk of a cache pair is always sent with the cached one
+    if (header->type == FULL_EDR_CACHE_CHUNK) {
+        cache_pair_pending_ = true;
+        return ;
+    }
+    if (cache_pair_pending_) {
+        cache_pair_pending_ = false;
+        return ;
+    }
+    // a delta against the previous version (or the size of an all-zero
+    // chunk) is small, always send it
+    if (header->type == CLIENT_DELTA_CHUNK || header->type == ZERO_CHUNK) {
+        return ;
+    }
+
+    SendMsgBuffer_t* fp_buf = &cur_batch_->fp_buf;
+    FpQuery_t* query = (FpQuery_t*)fp_buf->data_buf +
+        fp_buf->header->cur_item_num;
+    crypto_util_->GenerateHash(md_ctx_, data, header->size, query->fp);
+    if (header->type == FULL_EDR_UNCOMPRESS_CHUNK) {
+        // the server indexes this chunk by its dual fp
+        uint8_t dual_fp_buf[CHUNK_HASH_SIZE * 2];
+        memcpy(dual_fp_buf, query->fp, CHUNK_HASH_SIZE);
+        memcpy(dual_fp_buf + CHUNK_HASH_SIZE, header->compressed_fp,
+            CHUNK_HASH_SIZE);
+        crypto_util_->GenerateHash(md_ctx_, dual_fp_buf, CHUNK_HASH_SIZE * 2,
+            query->fp);
+    }
+    query->size = header->size;
+
+    fp_buf->header->cur_item_num++;
+    fp_buf->header->size += sizeof(FpQuery_t);
+    return ;
+}
+
+/**
+ * @brief send the fp queries of a batch, and drop the payloads that the
+ * server already has
+ * 
+ * @param batch the batch
+ * @param stripe_id the stripe of the batch
+ */
+void SenderThd::QueryFp(SendBatch_t* batch, uint32_t stripe_id) {
+    Conn_t* stripe_ssl = stripe_conn_list_[stripe_id].second;
+    uint8_t* bitmap_buf = bitmap_buf_[stripe_id];
+    SendMsgBuffer_t* fp_buf = &batch->fp_buf;
+    SendMsgBuffer_t* chunk_buf = &batch->chunk_buf;
+    uint32_t query_num = fp_buf->header->cur_item_num;
+
+    if (!server_channel_->SendData(stripe_ssl, fp_buf->send_buf,
+        fp_buf->header->size + sizeof(NetworkHead_t))) {
+        tool::Logging(my_name_.c_str(), "send the fp queries error.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // wait for the bitmap of the chunks to send
+    uint32_t recv_size = 0;
+    if (!this->ReceiveReply(stripe_id, bitmap_buf, recv_size)) {
+        tool::Logging(my_name_.c_str(), "recv the fp bitmap error.\n");
+        exit(EXIT_FAILURE);
+    }
+    NetworkHead_t* bitmap_header = (NetworkHead_t*)bitmap_buf;
+    if (bitmap_header->msg_type != SERVER_FP_BITMAP ||
+        bitmap_header->cur_item_num != query_num) {
+        tool::Logging(my_name_.c_str(), "wrong fp bitmap.\n");
+        exit(EXIT_FAILURE);
+    }
+    uint8_t* bitmap = bitmap_buf + sizeof(NetworkHead_t);
+
+    // compact the batch in place: a known chunk is replaced by a reference
+    SendChunkHeader_t header;
+    SendChunkHeader_t ref_header;
+    ref_header.type = FP_REF_CHUNK;
+    ref_header.size = 0;
+    uint8_t* data_buf = chunk_buf->data_buf;
+    uint32_t read_offset = 0;
+    uint32_t write_offset = 0;
+    uint32_t query_idx = 0;
+    uint32_t chunk_len = 0;
+    uint64_t skip_chunk_num = 0;
+    uint64_t skip_data_size = 0;
+    bool is_query = false;
+    bool is_pair = false;
+    while (read_offset < chunk_buf->header->size) {
+        chunk_len = wire::DecodeChunkHeader(data_buf + read_offset, &header,
+            wire_ver_);
+        chunk_len += header.size;
+
+        // follow the same rule as AddFpQuery()
+        is_query = !is_pair && (header.type == NORMAL_CHUNK ||
+            header.type == FULL_EDR_UNCOMPRESS_CHUNK);
+        is_pair = (header.type == FULL_EDR_CACHE_CHUNK);
+        if (is_query) {
+            bool is_needed = bitmap[query_idx / 8] & (1 << (query_idx % 8));
+            query_idx++;
+            if (!is_needed) {
+                write_offset += wire::EncodeChunkHeader(&ref_header,
+                    data_buf + write_offset, wire_ver_);
+                read_offset += chunk_len;
+                skip_chunk_num++;
+                skip_data_size += header.size;
+                continue;
+            }
+        }
+
+        if (write_offset != read_offset) {
+            memmove(data_buf + write_offset, data_buf + read_offset, chunk_len);
+        }
+        write_offset += chunk_len;
+        read_offset += chunk_len;
+    }
+
+    if (query_idx != query_num) {
+        tool::Logging(my_name_.c_str(), "fp queries do not match the batch.\n");
+        exit(EXIT_FAILURE);
+    }
+    chunk_buf->header->size = write_offset;
+    {
+        lock_guard<mutex> lck(stat_lck_);
+        _total_skip_chunk_num += skip_chunk_num;
+        _total_skip_data_size += skip_data_size;
+    }
+
+    fp_buf->header->cur_item_num = 0;
+    fp_buf->header->size = 0;
+    return ;
+}
+
+/**
+ * @brief wait for the checkpoint ack, and flush the keys of the acknowledged
+ * chunks
+ * 
+ * @param stripe_id the stripe of the checkpoint
+ */
+void SenderThd::WaitCheckpoint(uint32_t stripe_id) {
+    uint8_t ack_buf[sizeof(NetworkHead_t) + sizeof(uint64_t)];
+    uint32_t recv_size = 0;
+    if (!this->ReceiveReply(stripe_id, ack_buf, recv_size)) {
+        tool::Logging(my_name_.c_str(), "recv the checkpoint ack error.\n");
+        exit(EXIT_FAILURE);
+    }
+    NetworkHead_t* ack_header = (NetworkHead_t*)ack_buf;
+    if (ack_header->msg_type != SERVER_CHECKPOINT_ACK ||
+        ack_header->size != sizeof(uint64_t)) {
+        tool::Logging(my_name_.c_str(), "wrong checkpoint ack.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(&_acked_chunk_num, ack_buf + sizeof(NetworkHead_t),
+        sizeof(uint64_t));
+
+    // the keys of the acknowledged chunks survive a client crash
+    key_recipe_hdl_.flush();
+    _total_ckpt_num++;
+    return ;
+}
+
+/**
+ * @brief take the credit of a chunk batch, wait for the server to grant more
+ * if it is not enough
+ * 
+ * @param stripe_id the stripe of the batch
+ * @param batch_size the batch size
+ */
+void SenderThd::AcquireCredit(uint32_t stripe_id, uint32_t batch_size) {
+    if (credit_window_ == 0) {
+        return ;
+    }
+    if (batch_size > credit_window_) {
+        tool::Logging(my_name_.c_str(), "the batch exceeds the credit window.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (credit_list_[stripe_id] < batch_size) {
+        {
+            lock_guard<mutex> lck(stat_lck_);
+            _total_credit_wait_num++;
+        }
+        while (credit_list_[stripe_id] < batch_size) {
+            if (!credit_req_list_[stripe_id]) {
+                this->RequestCredit(stripe_id);
+            }
+            this->WaitCredit(stripe_id);
+        }
+    }
+    credit_list_[stripe_id] -= batch_size;
+
+    // ask for more ahead of time, the grant arrives while the next batch is
+    // assembled
+    if (credit_list_[stripe_id] < credit_window_ / 2 &&
+        !credit_req_list_[stripe_id]) {
+        this->RequestCredit(stripe_id);
+    }
+    return ;
+}
+
+/**
+ * @brief ask the server to top up the credit of a stripe
+ * 
+ * @param stripe_id the stripe id
+ */
+void SenderThd::RequestCredit(uint32_t stripe_id) {
+    Conn_t* stripe_ssl = stripe_conn_list_[stripe_id].second;
+    NetworkHead_t req_header;
+    req_header.client_id = client_id_;
+    req_header.msg_type = CLIENT_CREDIT_REQUEST;
+    req_header.cur_item_num = 0;
+    req_header.size = 0;
+    if (!server_channel_->SendData(stripe_ssl, (uint8_t*)&req_header,
+        sizeof(NetworkHead_t))) {
+        tool::Logging(my_name_.c_str(), "send the credit request error.\n");
+        exit(EXIT_FAILURE);
+    }
+    credit_req_list_[stripe_id] = true;
+    return ;
+}
+
+/**
+ * @brief wait for the credit grant of a stripe
+ * 
+ * @param stripe_id the stripe id
+ */
+void SenderThd::WaitCredit(uint32_t stripe_id) {
+    Conn_t* stripe_ssl = stripe_conn_list_[stripe_id].second;
+    uint8_t grant_buf[sizeof(NetworkHead_t) + sizeof(uint64_t)];
+    uint32_t recv_size = 0;
+    if (!server_channel_->ReceiveData(stripe_ssl, grant_buf, recv_size)) {
+        tool::Logging(my_name_.c_str(), "recv the credit grant error.\n");
+        exit(EXIT_FAILURE);
+    }
+    NetworkHead_t* grant_header = (NetworkHead_t*)grant_buf;
+    if (grant_header->msg_type != SERVER_CREDIT_GRANT ||
+        grant_header->size != sizeof(uint64_t)) {
+        tool::Logging(my_name_.c_str(), "wrong credit grant.\n");
+        exit(EXIT_FAILURE);
+    }
+    uint64_t grant = 0;
+    memcpy(&grant, grant_buf + sizeof(NetworkHead_t), sizeof(uint64_t));
+    credit_list_[stripe_id] += grant;
+    credit_req_list_[stripe_id] = false;
+    return ;
+}
+
+/**
+ * @brief receive a reply of the server, the credit grant ahead of it is taken
+ * on the way
+ * 
+ * @param stripe_id the stripe id
+ * @param buf the reply buffer
+ * @param recv_size the reply size <ret>
+ * @return true success
+ * @return false fail
+ */
+bool SenderThd::ReceiveReply(uint32_t stripe_id, uint8_t* buf,
+    uint32_t& recv_size) {
+    Conn_t* stripe_ssl = stripe_conn_list_[stripe_id].second;
+    NetworkHead_t* header = (NetworkHead_t*)buf;
+    while (true) {
+        if (!server_channel_->ReceiveData(stripe_ssl, buf, recv_size)) {
+            return false;
+        }
+        if (header->msg_type != SERVER_CREDIT_GRANT) {
+            return true;
+        }
+        uint64_t grant = 0;
+        memcpy(&grant, buf + sizeof(NetworkHead_t), sizeof(uint64_t));
+        credit_list_[stripe_id] += grant;
+        credit_req_list_[stripe_id] = false;
+    }
+}
+
 /**
  * @brief store the key recipe
  * 
  * @param input_chunk the input recipe data
  */
 void SenderThd::ProcessRecipeEnd(SendChunk_t* input_chunk) {
-    send_chunk_buf_.header->msg_type = CLIENT_UPLOAD_RECIPE_END;
+    SendMsgBuffer_t* chunk_buf = &cur_batch_->chunk_buf;
+    chunk_buf->header->msg_type = CLIENT_UPLOAD_RECIPE_END;
     // copy the recipe end to the send buffer
-    memcpy(send_chunk_buf_.data_buf + send_chunk_buf_.header->size,
+    memcpy(chunk_buf->data_buf + chunk_buf->header->size,
         input_chunk->data, input_chunk->header.size);
-    send_chunk_buf_.header->size += input_chunk->header.size;
+    chunk_buf->header->size += input_chunk->header.size;
 
-    if (!server_channel_->SendData(server_ssl_,
-        send_chunk_buf_.send_buf,
-        send_chunk_buf_.header->size + sizeof(NetworkHead_t))) {
-        tool::Logging(my_name_.c_str(), "send the recipe end error.\n");
-        exit(EXIT_FAILURE);
-    }
+    full_batch_mq_[batch_seq_ % stripe_num_]->Push(cur_batch_);
+    batch_seq_++;
+    cur_batch_ = NULL;
 
     return ;
 }
@@ -284,16 +868,11 @@ void SenderThd::ProcessRecipeEnd(SendChunk_t* input_chunk) {
  * @param key_recipe the ptr to the key recipe
  */
 void SenderThd::StoreKeyRecipe(KeyRecipe_t* key_recipe) {
-    // copy the key to the buffer
-    memcpy(key_recipe_buf_.buf + key_recipe_buf_.cnt * sizeof(KeyRecipe_t),
+    // copy the key to the batch, written by the I/O thread
+    BatchBuf_t* key_recipe_buf = &cur_batch_->key_recipe_buf;
+    memcpy(key_recipe_buf->buf + key_recipe_buf->cnt * sizeof(KeyRecipe_t),
         key_recipe, sizeof(KeyRecipe_t));
-    key_recipe_buf_.cnt++;
-
-    if (key_recipe_buf_.cnt % send_recipe_batch_size_ == 0) {
-        key_recipe_hdl_.write((char*)key_recipe_buf_.buf,
-            key_recipe_buf_.cnt * sizeof(KeyRecipe_t));
-        key_recipe_buf_.cnt = 0;
-    }
+    key_recipe_buf->cnt++;
 
     return ;
 }
@@ -306,7 +885,7 @@ void SenderThd::StoreKeyRecipe(KeyRecipe_t* key_recipe) {
 void SenderThd::UploadLogin(uint8_t* file_name_hash) {
     SendMsgBuffer_t login_buf;
     login_buf.send_buf = (uint8_t*) malloc(sizeof(NetworkHead_t) +
-        CHUNK_HASH_SIZE);
+        CHUNK_HASH_SIZE + sizeof(uint32_t) * 6 + sizeof(uint64_t));
     login_buf.header = (NetworkHead_t*) login_buf.send_buf;
     login_buf.header->client_id = client_id_;
     login_buf.header->size = 0;
@@ -316,6 +895,42 @@ void SenderThd::UploadLogin(uint8_t* file_name_hash) {
     memcpy(login_buf.data_buf + login_buf.header->size, file_name_hash,
         CHUNK_HASH_SIZE);
     login_buf.header->size += CHUNK_HASH_SIZE;
+    // the server only opens the inform cache for FULL_EDR
+    memcpy(login_buf.data_buf + login_buf.header->size, &method_type_,
+        sizeof(uint32_t));
+    login_buf.header->size += sizeof(uint32_t);
+    // the newest wire format of this client
+    memcpy(login_buf.data_buf + login_buf.header->size, &WIRE_FORMAT_VERSION,
+        sizeof(uint32_t));
+    login_buf.header->size += sizeof(uint32_t);
+    // ask for the fingerprint-first upload
+    uint32_t fp_first = config.GetFpFirstUpload();
+    memcpy(login_buf.data_buf + login_buf.header->size, &fp_first,
+        sizeof(uint32_t));
+    login_buf.header->size += sizeof(uint32_t);
+    // ask for the stripe connections (FULL_EDR: the eviction notices are
+    // only ordered with the batches on a single connection)
+    uint32_t stripe_num = config.GetStripeNum();
+    if (method_type_ == FULL_EDR) {
+        stripe_num = 1;
+    }
+    memcpy(login_buf.data_buf + login_buf.header->size, &stripe_num,
+        sizeof(uint32_t));
+    login_buf.header->size += sizeof(uint32_t);
+    // ask to resume the interrupted upload
+    memcpy(login_buf.data_buf + login_buf.header->size, &resume_chunk_num_,
+        sizeof(uint64_t));
+    login_buf.header->size += sizeof(uint64_t);
+    // ask for the authenticated-only data frames
+    uint32_t auth_only = config.GetAuthOnlyData();
+    memcpy(login_buf.data_buf + login_buf.header->size, &auth_only,
+        sizeof(uint32_t));
+    login_buf.header->size += sizeof(uint32_t);
+    // ask for the credit-based flow control
+    uint32_t credit_flow = 1;
+    memcpy(login_buf.data_buf + login_buf.header->size, &credit_flow,
+        sizeof(uint32_t));
+    login_buf.header->size += sizeof(uint32_t);
 
     // send the upload login request
     if (!server_channel_->SendData(server_ssl_, login_buf.send_buf,
@@ -334,11 +949,186 @@ void SenderThd::UploadLogin(uint8_t* file_name_hash) {
 
     if (login_buf.header->msg_type == SERVER_LOGIN_RESPONSE) {
         tool::Logging(my_name_.c_str(), "server can process the request.\n");
+        // the server replies the accepted wire format
+        if (login_buf.header->size >= sizeof(uint32_t)) {
+            memcpy(&wire_ver_, login_buf.data_buf, sizeof(uint32_t));
+        }
+        // and whether it accepts the fingerprint-first upload
+        if (login_buf.header->size >= sizeof(uint32_t) * 2) {
+            memcpy(&fp_first, login_buf.data_buf + sizeof(uint32_t),
+                sizeof(uint32_t));
+            fp_first_ = (fp_first != 0) && config.GetFpFirstUpload();
+        }
+        // and whether the connections switch to the authenticated-only data
+        // frames (after the login response)
+        if (login_buf.header->size >= sizeof(uint32_t) * 4 +
+            sizeof(uint64_t) * 2) {
+            memcpy(&auth_only, login_buf.data_buf + sizeof(uint32_t) * 3 +
+                sizeof(uint64_t) * 2, sizeof(uint32_t));
+            auth_only_ = (auth_only != 0) && config.GetAuthOnlyData();
+        }
+        this->EnableAuthOnly(server_ssl_);
+        // and the granted stripe connections
+        if (login_buf.header->size >= sizeof(uint32_t) * 3 + sizeof(uint64_t)) {
+            uint64_t stripe_token;
+            memcpy(&stripe_num_, login_buf.data_buf + sizeof(uint32_t) * 2,
+                sizeof(uint32_t));
+            memcpy(&stripe_token, login_buf.data_buf + sizeof(uint32_t) * 3,
+                sizeof(uint64_t));
+            this->JoinStripes(stripe_token);
+        }
+        // and the chunks kept from the interrupted upload
+        uint64_t granted_chunk_num = 0;
+        if (login_buf.header->size >= sizeof(uint32_t) * 3 +
+            sizeof(uint64_t) * 2) {
+            memcpy(&granted_chunk_num, login_buf.data_buf +
+                sizeof(uint32_t) * 3 + sizeof(uint64_t), sizeof(uint64_t));
+        }
+        resume_chunk_num_ = granted_chunk_num;
+        // and the credit window of each stripe
+        if (login_buf.header->size >= sizeof(uint32_t) * 4 +
+            sizeof(uint64_t) * 3) {
+            memcpy(&credit_window_, login_buf.data_buf + sizeof(uint32_t) * 4 +
+                sizeof(uint64_t) * 2, sizeof(uint64_t));
+        }
+        credit_list_.assign(stripe_num_, credit_window_);
+        credit_req_list_.assign(stripe_num_, false);
+        tool::Logging(my_name_.c_str(), "wire format: %u, fp-first upload: %d, "
+            "stripe num: %u, resumed chunk num: %lu, auth-only data: %d, "
+            "credit window: %lu\n", wire_ver_, fp_first_, stripe_num_,
+            resume_chunk_num_, auth_only_, credit_window_);
     } else {
         tool::Logging(my_name_.c_str(), "server response is wrong (not ready).\n");
         exit(EXIT_FAILURE);
     }
 
     free(login_buf.send_buf);
+    this->OpenKeyRecipe();
+    this->InitBatches();
+    return ;
+}
+
+/**
+ * @brief Set the input metadata, an interrupted upload of the same input is
+ * resumed (call it before the login)
+ * 
+ * @param input_stamp the metadata of the input files (empty: never resumed)
+ */
+void SenderThd::SetInputStamp(string& input_stamp) {
+    input_stamp_.resize(CHUNK_HASH_SIZE);
+    crypto_util_->GenerateHash(md_ctx_, (uint8_t*)&input_stamp[0],
+        input_stamp.size(), (uint8_t*)&input_stamp_[0]);
+    if (ckpt_size_ == 0 || input_stamp.empty()) {
+        return ;
+    }
+
+    // an interrupted upload leaves its tmp key recipe and input stamp
+    string tmp_key_recipe_path = key_recipe_path_ + config.GetTmpSuffix();
+    ifstream stamp_hdl;
+    stamp_hdl.open(key_recipe_path_ + config.GetCkptSuffix(), ios_base::in |
+        ios_base::binary);
+    if (!tool::FileExist(tmp_key_recipe_path) || !stamp_hdl.is_open()) {
+        return ;
+    }
+    string prev_stamp(CHUNK_HASH_SIZE, 0);
+    stamp_hdl.read(&prev_stamp[0], CHUNK_HASH_SIZE);
+    stamp_hdl.close();
+    if (prev_stamp != input_stamp_) {
+        tool::Logging(my_name_.c_str(), "the input is changed since the "
+            "interrupted upload, upload it from the start.\n");
+        return ;
+    }
+    resume_chunk_num_ = filesystem::file_size(tmp_key_recipe_path) /
+        sizeof(KeyRecipe_t);
+    return ;
+}
+
+/**
+ * @brief open the tmp key recipe (keep the keys of the resumed chunks)
+ * 
+ */
+void SenderThd::OpenKeyRecipe() {
+    string tmp_key_recipe_path = key_recipe_path_ + config.GetTmpSuffix();
+    if (resume_chunk_num_ != 0) {
+        // continue after the keys of the checkpointed chunks
+        filesystem::resize_file(tmp_key_recipe_path,
+            resume_chunk_num_ * sizeof(KeyRecipe_t));
+        key_recipe_hdl_.open(tmp_key_recipe_path, ios_base::in |
+            ios_base::out | ios_base::binary);
+        key_recipe_hdl_.seekp(0, ios_base::end);
+    } else {
+        key_recipe_hdl_.open(tmp_key_recipe_path, ios_base::trunc |
+            ios_base::binary);
+        if (ckpt_size_ != 0) {
+            // a resumed upload must read the same input
+            ofstream stamp_hdl;
+            stamp_hdl.open(key_recipe_path_ + config.GetCkptSuffix(),
+                ios_base::trunc | ios_base::binary);
+            stamp_hdl.write(input_stamp_.data(), input_stamp_.size());
+            stamp_hdl.close();
+        }
+    }
+    if (!key_recipe_hdl_.is_open()) {
+        tool::Logging(my_name_.c_str(), "cannot init key recipe file: %s\n",
+            tmp_key_recipe_path.c_str());
+        exit(EXIT_FAILURE);
+    }
+    return ;
+}
+
+/**
+ * @brief open the extra stripe connections of this session
+ * 
+ * @param stripe_token the session token from the server
+ */
+void SenderThd::JoinStripes(uint64_t stripe_token) {
+    SendMsgBuffer_t login_buf;
+    login_buf.send_buf = (uint8_t*) malloc(sizeof(NetworkHead_t) +
+        sizeof(uint64_t) + sizeof(uint32_t));
+    login_buf.header = (NetworkHead_t*) login_buf.send_buf;
+    login_buf.data_buf = login_buf.send_buf + sizeof(NetworkHead_t);
+
+    uint32_t recv_size = 0;
+    for (uint32_t i = 1; i < stripe_num_; i++) {
+        pair<int, Conn_t*> conn_record = server_channel_->Connect();
+        login_buf.header->client_id = client_id_;
+        login_buf.header->msg_type = CLIENT_LOGIN_STRIPE;
+        memcpy(login_buf.data_buf, &stripe_token, sizeof(uint64_t));
+        memcpy(login_buf.data_buf + sizeof(uint64_t), &i, sizeof(uint32_t));
+        login_buf.header->size = sizeof(uint64_t) + sizeof(uint32_t);
+        if (!server_channel_->SendData(conn_record.second, login_buf.send_buf,
+            sizeof(NetworkHead_t) + login_buf.header->size)) {
+            tool::Logging(my_name_.c_str(), "send stripe login error.\n");
+            exit(EXIT_FAILURE);
+        }
+        if (!server_channel_->ReceiveData(conn_record.second,
+            login_buf.send_buf, recv_size) ||
+            login_buf.header->msg_type != SERVER_LOGIN_RESPONSE) {
+            tool::Logging(my_name_.c_str(), "stripe %u is rejected.\n", i);
+            exit(EXIT_FAILURE);
+        }
+        this->EnableAuthOnly(conn_record.second);
+        stripe_conn_list_.push_back(conn_record);
+    }
+
+    free(login_buf.send_buf);
+    return ;
+}
+
+/**
+ * @brief switch a connection to the authenticated-only data frames after its
+ * login response (if negotiated)
+ * 
+ * @param conn the connection
+ */
+void SenderThd::EnableAuthOnly(Conn_t* conn) {
+    if (!auth_only_) {
+        return ;
+    }
+    if (!server_channel_->EnableAuthOnly(conn)) {
+        tool::Logging(my_name_.c_str(), "enable the authenticated-only data "
+            "frames error.\n");
+        exit(EXIT_FAILURE);
+    }
     return ;
 }
\ No newline at end of file
@@ -0,0 +1,424 @@
+/**
+ * @file version_delta.cc
+ * @brief implement the interfaces of VersionDelta
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "../../include/client/version_delta.h"
+
+/**
+ * @brief Construct a new VersionDelta object
+ *
+ * @param file_name_hash the session name hash
+ */
+VersionDelta::VersionDelta(uint8_t* file_name_hash) {
+    char file_name_hash_buf[CHUNK_HASH_SIZE * 2 + 1];
+    for (size_t i = 0; i < CHUNK_HASH_SIZE; i++) {
+        sprintf(file_name_hash_buf + i * 2, "%02x", file_name_hash[i]);
+    }
+    string file_name_str;
+    file_name_str.assign(file_name_hash_buf, CHUNK_HASH_SIZE * 2);
+    sig_path_ = config.GetRecipeRootPath() + file_name_str +
+        config.GetVersionSigSuffix();
+
+    // index the super-features of the previous version, the signatures are
+    // read on demand
+    if (tool::FileExist(sig_path_)) {
+        prev_sig_hdl_.open(sig_path_, ios_base::in | ios_base::binary);
+        VersionSigHead_t prev_head;
+        prev_sig_hdl_.read((char*)&prev_head, sizeof(VersionSigHead_t));
+        if (prev_sig_hdl_.gcount() == sizeof(VersionSigHead_t)) {
+            VersionSig_t tmp_sig;
+            feature_idx_.reserve(prev_head.chunk_num * SUPER_FEATURE_PER_CHUNK);
+            for (uint64_t i = 0; i < prev_head.chunk_num; i++) {
+                prev_sig_hdl_.read((char*)&tmp_sig, sizeof(VersionSig_t));
+                if (prev_sig_hdl_.gcount() != sizeof(VersionSig_t)) {
+                    break;
+                }
+                prev_chunk_num_++;
+                if (tmp_sig.size < VERSION_DELTA_BLOCK_SIZE) {
+                    continue;
+                }
+                for (size_t j = 0; j < SUPER_FEATURE_PER_CHUNK; j++) {
+                    feature_idx_.push_back(make_pair(tmp_sig.features[j], i));
+                }
+            }
+            sort(feature_idx_.begin(), feature_idx_.end());
+        }
+        prev_sig_hdl_.clear();
+    }
+
+    sig_hdl_.open(sig_path_ + config.GetTmpSuffix(), ios_base::out |
+        ios_base::trunc | ios_base::binary);
+    if (!sig_hdl_.is_open()) {
+        tool::Logging(my_name_.c_str(), "cannot init the signature file: %s\n",
+            sig_path_.c_str());
+        exit(EXIT_FAILURE);
+    }
+    VersionSigHead_t head;
+    head.chunk_num = 0;
+    sig_hdl_.write((char*)&head, sizeof(VersionSigHead_t));
+
+    crypto_util_ = new CryptoUtil(CIPHER_TYPE, HASH_TYPE);
+    md_ctx_ = EVP_MD_CTX_new();
+
+    tool::Logging(my_name_.c_str(), "chunk num of the previous version: %lu\n",
+        prev_chunk_num_);
+}
+
+/**
+ * @brief Destroy the VersionDelta object
+ *
+ */
+VersionDelta::~VersionDelta() {
+    if (prev_sig_hdl_.is_open()) {
+        prev_sig_hdl_.close();
+    }
+    if (sig_hdl_.is_open()) {
+        sig_hdl_.close();
+    }
+    delete crypto_util_;
+    EVP_MD_CTX_free(md_ctx_);
+}
+
+/**
+ * @brief compute the rolling checksum of a block
+ *
+ * @param data the block
+ * @param a the sum of the bytes <ret>
+ * @param b the weighted sum of the bytes <ret>
+ */
+void VersionDelta::WeakSum(uint8_t* data, uint32_t& a, uint32_t& b) {
+    a = 0;
+    b = 0;
+    for (uint32_t i = 0; i < VERSION_DELTA_BLOCK_SIZE; i++) {
+        a += data[i];
+        b += (VERSION_DELTA_BLOCK_SIZE - i) * data[i];
+    }
+    return ;
+}
+
+/**
+ * @brief read a signature of the previous version
+ *
+ * @param idx the chunk index in the previous version
+ * @param sig the signature <ret>
+ * @return true success
+ */
+bool VersionDelta::ReadSig(uint64_t idx, VersionSig_t* sig) {
+    if (idx >= prev_chunk_num_) {
+        return false;
+    }
+    prev_sig_hdl_.seekg(sizeof(VersionSigHead_t) + idx * sizeof(VersionSig_t),
+        ios_base::beg);
+    prev_sig_hdl_.read((char*)sig, sizeof(VersionSig_t));
+    if (prev_sig_hdl_.gcount() != sizeof(VersionSig_t)) {
+        prev_sig_hdl_.clear();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief find a chunk of the previous version sharing a super-feature
+ *
+ * @param features the plaintext super-features
+ * @param base_sig the signature of the base chunk <ret>
+ * @return true found
+ */
+bool VersionDelta::FindBase(uint64_t* features, VersionSig_t* base_sig) {
+    for (size_t i = 0; i < SUPER_FEATURE_PER_CHUNK; i++) {
+        auto find_res = lower_bound(feature_idx_.begin(), feature_idx_.end(),
+            make_pair(features[i], (uint64_t)0));
+        if (find_res == feature_idx_.end() || find_res->first != features[i]) {
+            continue;
+        }
+        if (this->ReadSig(find_res->second, base_sig) &&
+            base_sig->size >= VERSION_DELTA_BLOCK_SIZE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief delta-encode a chunk against the previous version
+ *
+ * @param input_chunk the chunk
+ * @param delta the delta (plaintext) <ret>
+ * @param delta_size the delta size <ret>
+ * @param base_sig the signature of the base chunk <ret>
+ * @return true the delta is small enough to send
+ */
+bool VersionDelta::EncodeChunk(EncFeatureChunk_t* input_chunk, uint8_t* delta,
+    uint32_t& delta_size, VersionSig_t* base_sig) {
+    uint8_t* data = input_chunk->feature_chunk.chunk.raw_chunk.data;
+    uint32_t size = input_chunk->feature_chunk.chunk.raw_chunk.size;
+    if (size < 2 * VERSION_DELTA_BLOCK_SIZE ||
+        !this->FindBase(input_chunk->plain_features, base_sig)) {
+        return false;
+    }
+    uint32_t base_block_num = base_sig->size / VERSION_DELTA_BLOCK_SIZE;
+    // otherwise, sending the chunk in full is cheaper to restore
+    uint32_t max_delta_size = size / 2;
+
+    // [base key][plaintext fp] + [ops]
+    memcpy(delta, base_sig->key, CHUNK_HASH_SIZE);
+    memcpy(delta + CHUNK_HASH_SIZE,
+        input_chunk->feature_chunk.chunk.raw_chunk.fp, CHUNK_HASH_SIZE);
+    uint32_t offset = VERSION_DELTA_HEAD_SIZE;
+
+    // literal op: [op][len (uint16_t)][bytes]
+    auto append_literal = [&](uint32_t start, uint32_t end) -> bool {
+        while (start < end) {
+            uint16_t len = min(end - start, (uint32_t)UINT16_MAX);
+            if (offset + 1 + sizeof(uint16_t) + len > max_delta_size) {
+                return false;
+            }
+            delta[offset++] = VERSION_DELTA_LITERAL;
+            memcpy(delta + offset, &len, sizeof(uint16_t));
+            offset += sizeof(uint16_t);
+            memcpy(delta + offset, data + start, len);
+            offset += len;
+            start += len;
+        }
+        return true;
+    };
+
+    // slide a block-size window over the chunk (rsync-style), a weak match
+    // is confirmed by the strong checksum
+    uint32_t pos = 0;
+    uint32_t literal_start = 0;
+    uint32_t last_copy = UINT32_MAX; // the offset of the last copy op
+    uint32_t a = 0;
+    uint32_t b = 0;
+    bool is_rolled = false;
+    while (pos + VERSION_DELTA_BLOCK_SIZE <= size) {
+        if (!is_rolled) {
+            this->WeakSum(data + pos, a, b);
+            is_rolled = true;
+        }
+        uint32_t weak = (a & 0xffff) | (b << 16);
+        int32_t match_block = -1;
+        bool has_strong = false;
+        uint64_t strong = 0;
+        for (uint32_t i = 0; i < base_block_num; i++) {
+            if (base_sig->weak[i] != weak) {
+                continue;
+            }
+            if (!has_strong) {
+                strong = XXHash64::hash(data + pos, VERSION_DELTA_BLOCK_SIZE, 0);
+                has_strong = true;
+            }
+            if (base_sig->strong[i] == strong) {
+                match_block = i;
+                break;
+            }
+        }
+
+        if (match_block >= 0) {
+            if (!append_literal(literal_start, pos)) {
+                return false;
+            }
+            // copy op: [op][first block][block num], merge the next block
+            if (last_copy + 3 == offset && delta[last_copy + 1] +
+                delta[last_copy + 2] == match_block) {
+                delta[last_copy + 2]++;
+            } else {
+                if (offset + 3 > max_delta_size) {
+                    return false;
+                }
+                last_copy = offset;
+                delta[offset++] = VERSION_DELTA_COPY;
+                delta[offset++] = match_block;
+                delta[offset++] = 1;
+            }
+            pos += VERSION_DELTA_BLOCK_SIZE;
+            literal_start = pos;
+            is_rolled = false;
+            continue;
+        }
+
+        if (pos + VERSION_DELTA_BLOCK_SIZE == size) {
+            break;
+        }
+        // roll the window by one byte
+        a = a - data[pos] + data[pos + VERSION_DELTA_BLOCK_SIZE];
+        b = b - VERSION_DELTA_BLOCK_SIZE * data[pos] + a;
+        pos++;
+    }
+    if (!append_literal(literal_start, size)) {
+        return false;
+    }
+
+    delta_size = offset;
+    _total_delta_chunk_num++;
+    _total_delta_src_size += size;
+    _total_delta_size += delta_size;
+    return true;
+}
+
+/**
+ * @brief add the signature of a chunk of this version (in the recipe order)
+ *
+ * @param input_chunk the chunk
+ * @param base_sig the signature of its base if it is sent as a delta (NULL:
+ * sent in full)
+ */
+void VersionDelta::AddChunk(EncFeatureChunk_t* input_chunk,
+    VersionSig_t* base_sig) {
+    if (base_sig != NULL) {
+        // keep its base, so that the base of the next version is always a
+        // chunk stored in full
+        sig_hdl_.write((char*)base_sig, sizeof(VersionSig_t));
+        chunk_num_++;
+        return ;
+    }
+
+    VersionSig_t sig;
+    uint8_t* data = input_chunk->feature_chunk.chunk.raw_chunk.data;
+    sig.size = input_chunk->feature_chunk.chunk.raw_chunk.size;
+    // the server indexes the chunk by the hash of its ciphertext
+    crypto_util_->GenerateHash(md_ctx_, input_chunk->enc_data,
+        input_chunk->enc_size, sig.fp);
+    memcpy(sig.key, input_chunk->key, CHUNK_HASH_SIZE);
+    memcpy(sig.features, input_chunk->plain_features,
+        sizeof(uint64_t) * SUPER_FEATURE_PER_CHUNK);
+    memset(sig.weak, 0, sizeof(sig.weak));
+    memset(sig.strong, 0, sizeof(sig.strong));
+    uint32_t a = 0;
+    uint32_t b = 0;
+    for (uint32_t i = 0; i < sig.size / VERSION_DELTA_BLOCK_SIZE; i++) {
+        this->WeakSum(data + i * VERSION_DELTA_BLOCK_SIZE, a, b);
+        sig.weak[i] = (a & 0xffff) | (b << 16);
+        sig.strong[i] = XXHash64::hash(data + i * VERSION_DELTA_BLOCK_SIZE,
+            VERSION_DELTA_BLOCK_SIZE, 0);
+    }
+    sig_hdl_.write((char*)&sig, sizeof(VersionSig_t));
+    chunk_num_++;
+    return ;
+}
+
+/**
+ * @brief add the signature of an all-zero chunk of this version (never a base)
+ *
+ */
+void VersionDelta::AddZeroChunk() {
+    VersionSig_t sig;
+    memset(&sig, 0, sizeof(VersionSig_t));
+    sig_hdl_.write((char*)&sig, sizeof(VersionSig_t));
+    chunk_num_++;
+    return ;
+}
+
+/**
+ * @brief copy the signatures of the unchanged files, and replace the previous
+ * signature
+ *
+ * @param ref_list the ranges of the previous recipe
+ */
+void VersionDelta::Commit(vector<RecipeRef_t>* ref_list) {
+    VersionSig_t sig;
+    for (auto& it : *ref_list) {
+        for (uint64_t i = 0; i < it.chunk_num; i++) {
+            if (!this->ReadSig(it.offset + i, &sig)) {
+                // never a base
+                memset(&sig, 0, sizeof(VersionSig_t));
+            }
+            sig_hdl_.write((char*)&sig, sizeof(VersionSig_t));
+            chunk_num_++;
+        }
+    }
+
+    VersionSigHead_t head;
+    head.chunk_num = chunk_num_;
+    sig_hdl_.seekp(0, ios_base::beg);
+    sig_hdl_.write((char*)&head, sizeof(VersionSigHead_t));
+    sig_hdl_.close();
+    if (prev_sig_hdl_.is_open()) {
+        prev_sig_hdl_.close();
+    }
+
+    string tmp_sig_path = sig_path_ + config.GetTmpSuffix();
+    if (rename(tmp_sig_path.c_str(), sig_path_.c_str()) != 0) {
+        tool::Logging(my_name_.c_str(), "cannot commit the signature file: %s\n",
+            sig_path_.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    tool::Logging(my_name_.c_str(), "delta chunk num: %lu, chunk size before "
+        "delta: %lu, delta size: %lu\n", _total_delta_chunk_num,
+        _total_delta_src_size, _total_delta_size);
+    return ;
+}
+
+/**
+ * @brief drop the signature of this version (it misses the chunks before the
+ * resumed point), keep the previous one
+ *
+ */
+void VersionDelta::Discard() {
+    sig_hdl_.close();
+    filesystem::remove(sig_path_ + config.GetTmpSuffix());
+    tool::Logging(my_name_.c_str(), "the upload is resumed, keep the previous "
+        "signature.\n");
+    return ;
+}
+
+/**
+ * @brief decode a delta with its base chunk
+ *
+ * @param base the base chunk (plaintext)
+ * @param base_size the base chunk size
+ * @param delta the delta ops (after the delta head)
+ * @param delta_size the size of the delta ops
+ * @param output the restored chunk <ret>
+ * @return uint32_t the restored chunk size (0: malformed delta)
+ */
+uint32_t VersionDelta::DecodeDelta(uint8_t* base, uint32_t base_size,
+    uint8_t* delta, uint32_t delta_size, uint8_t* output) {
+    uint32_t offset = 0;
+    uint32_t output_size = 0;
+    while (offset < delta_size) {
+        if (offset + 3 > delta_size) {
+            return 0;
+        }
+        switch (delta[offset]) {
+            case VERSION_DELTA_COPY: {
+                uint32_t copy_start = delta[offset + 1] *
+                    VERSION_DELTA_BLOCK_SIZE;
+                uint32_t copy_len = delta[offset + 2] *
+                    VERSION_DELTA_BLOCK_SIZE;
+                if (copy_start + copy_len > base_size ||
+                    output_size + copy_len > MAX_CHUNK_SIZE) {
+                    return 0;
+                }
+                memcpy(output + output_size, base + copy_start, copy_len);
+                output_size += copy_len;
+                offset += 3;
+                break;
+            }
+            case VERSION_DELTA_LITERAL: {
+                uint16_t len = 0;
+                memcpy(&len, delta + offset + 1, sizeof(uint16_t));
+                offset += 1 + sizeof(uint16_t);
+                if (offset + len > delta_size ||
+                    output_size + len > MAX_CHUNK_SIZE) {
+                    return 0;
+                }
+                memcpy(output + output_size, delta + offset, len);
+                output_size += len;
+                offset += len;
+                break;
+            }
+            default: {
+                return 0;
+            }
+        }
+    }
+    return output_size;
+}
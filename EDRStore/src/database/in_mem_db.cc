@@ -27,21 +27,11 @@ InMemoryDatabase::InMemoryDatabase(string db_name) {
  */
 InMemoryDatabase::~InMemoryDatabase() {
     // persistent the indexFile to the disk
-    ofstream db_file;
-    db_file.open(db_name_, ios_base::trunc | ios_base::binary);
-    uint32_t item_size = 0;
-    for (auto it = index_obj_.begin(); it != index_obj_.end(); it++) {
-        // write the key
-        item_size = it->first.size();
-        db_file.write((char*)&item_size, sizeof(uint32_t));
-        db_file.write(it->first.c_str(), item_size);
-
-        // write the value
-        item_size = it->second.size();
-        db_file.write((char*)&item_size, sizeof(uint32_t));
-        db_file.write(it->second.c_str(), item_size);
-    }
-    db_file.close();
+    pthread_rwlock_wrlock(&rwlock_);
+    this->WriteLog();
+    this->Compact();
+    pthread_rwlock_unlock(&rwlock_);
+    log_hdl_.close();
     pthread_rwlock_destroy(&rwlock_);
 }
 
@@ -54,56 +44,73 @@ InMemoryDatabase::~InMemoryDatabase() {
  */
 bool InMemoryDatabase::OpenDB(string db_name) {
     db_name_ = db_name;
+    log_name_ = db_name_ + ".log";
     // check whether there exists the index
+    file_size_ = this->LoadFile(db_name_);
+    if (file_size_ == 0) {
+        // db file not exist
+        tool::Logging(my_name_.c_str(), "db file file not exist, create a new one.\n");
+    }
+
+    // replay the updates after the last file rewrite
+    log_size_ = this->LoadFile(log_name_);
+    log_hdl_.open(log_name_, ios_base::app | ios_base::binary);
+    if (!log_hdl_.is_open()) {
+        tool::Logging(my_name_.c_str(), "cannot open the db log.\n");
+        exit(EXIT_FAILURE);
+    }
+    tool::Logging(my_name_.c_str(), "loaded index size: %lu\n",
+        index_obj_.size());
+    return true;
+}
+
+/**
+ * @brief load the (key, value) pairs of a file, an item with the max value
+ * size deletes the key
+ * 
+ * @param file_name the file name
+ * @return uint64_t the file size
+ */
+uint64_t InMemoryDatabase::LoadFile(string file_name) {
     ifstream db_file;
-    db_file.open(db_name_, ios_base::in | ios_base::binary);
+    db_file.open(file_name, ios_base::in | ios_base::binary);
     if (!db_file.is_open()) {
-        tool::Logging(my_name_.c_str(), "cannot open the db file.\n");
+        return 0;
     }
-
-    size_t start_size = db_file.tellg();
     db_file.seekg(0, ios_base::end);
-    size_t fileSize = db_file.tellg();
-    fileSize = fileSize - start_size;
+    uint64_t file_size = db_file.tellg();
+    db_file.seekg(0, ios_base::beg);
 
-    if (fileSize == 0) {
-        // db file not exist
-        tool::Logging(my_name_.c_str(), "db file file not exist, create a new one.\n");
-    } else {
-        // db file exist, load
-        db_file.seekg(0, ios_base::beg);
-        bool is_end = false;
-        uint32_t item_size = 0;
-        string key;
-        string value;
-        while (!is_end) {
-            // read key
-            db_file.read((char*)&item_size, sizeof(uint32_t));
-            if (item_size == 0) {
-                break;
-            }
-            key.resize(item_size, 0); 
-            db_file.read((char*)&key[0], item_size);
-
-            // read value
-            db_file.read((char*)&item_size, sizeof(uint32_t));
-            value.resize(item_size, 0);
-            db_file.read((char*)&value[0], item_size);
-            is_end = db_file.eof();
-            
-            // update the index
-            index_obj_[key] = value;
-            item_size = 0;
-
-            if (is_end) {
-                break;
-            }
+    // a torn item at the end of the log is dropped
+    uint32_t item_size = 0;
+    string key;
+    string value;
+    while (db_file.read((char*)&item_size, sizeof(uint32_t)) &&
+        item_size != 0) {
+        // read key
+        key.resize(item_size, 0);
+        if (!db_file.read((char*)&key[0], item_size)) {
+            break;
+        }
+
+        // read value
+        if (!db_file.read((char*)&item_size, sizeof(uint32_t))) {
+            break;
         }
+        if (item_size == UINT32_MAX) {
+            index_obj_.erase(key);
+            continue;
+        }
+        value.resize(item_size, 0);
+        if (!db_file.read((char*)&value[0], item_size)) {
+            break;
+        }
+
+        // update the index
+        index_obj_[key] = value;
     }
     db_file.close();
-    tool::Logging(my_name_.c_str(), "loaded index size: %lu\n",
-        index_obj_.size());
-    return true;
+    return file_size;
 }
 
 /**
@@ -141,6 +148,7 @@ bool InMemoryDatabase::Query(const string& key, string& value) {
 bool InMemoryDatabase::Insert(const string& key, const string& value) {
     pthread_rwlock_wrlock(&rwlock_);
     index_obj_[key] = value;
+    dirty_key_set_.insert(key);
     pthread_rwlock_unlock(&rwlock_);
     return true;
 }
@@ -159,6 +167,7 @@ bool InMemoryDatabase::InsertBuffer(const string& key, const char* buf, size_t b
     string value_str;
     value_str.assign(buf, buf_size);
     index_obj_[key] = value_str;
+    dirty_key_set_.insert(key);
     pthread_rwlock_unlock(&rwlock_);
     return true;
 }
@@ -181,6 +190,7 @@ bool InMemoryDatabase::InsertBothBuffer(const char* key, size_t key_size, const
     key_str.assign(key, key_size);
     value_str.assign(buf, buf_size);
     index_obj_[key_str] = value_str;
+    dirty_key_set_.insert(key_str);
     pthread_rwlock_unlock(&rwlock_);
     return true;
 }
@@ -221,7 +231,10 @@ bool InMemoryDatabase::QueryBuffer(const char* key, size_t key_size, string& val
 void InMemoryDatabase::DeleteBuffer(const char* key, size_t key_size) {
     string key_str;
     key_str.assign(key, key_size);
+    pthread_rwlock_wrlock(&rwlock_);
     index_obj_.erase(key_str);
+    dirty_key_set_.insert(key_str);
+    pthread_rwlock_unlock(&rwlock_);
     return ;
 }
 
@@ -231,6 +244,89 @@ void InMemoryDatabase::DeleteBuffer(const char* key, size_t key_size) {
  * @param key key str
  */
 void InMemoryDatabase::Delete(const string& key) {
+    pthread_rwlock_wrlock(&rwlock_);
     index_obj_.erase(key);
+    dirty_key_set_.insert(key);
+    pthread_rwlock_unlock(&rwlock_);
+    return ;
+}
+
+/**
+ * @brief make the previous updates durable (append them to the log)
+ * 
+ */
+void InMemoryDatabase::Sync() {
+    pthread_rwlock_wrlock(&rwlock_);
+    this->WriteLog();
+    if (log_size_ > max(file_size_, min_compact_size_)) {
+        this->Compact();
+    }
+    pthread_rwlock_unlock(&rwlock_);
+    return ;
+}
+
+/**
+ * @brief append the updated (key, value) pairs to the log (hold the write
+ * lock)
+ * 
+ */
+void InMemoryDatabase::WriteLog() {
+    uint32_t item_size = 0;
+    for (auto& key : dirty_key_set_) {
+        // write the key
+        item_size = key.size();
+        log_hdl_.write((char*)&item_size, sizeof(uint32_t));
+        log_hdl_.write(key.c_str(), item_size);
+        log_size_ += sizeof(uint32_t) + item_size;
+
+        // write the value (the max size: deleted)
+        auto find_ret = index_obj_.find(key);
+        if (find_ret == index_obj_.end()) {
+            item_size = UINT32_MAX;
+            log_hdl_.write((char*)&item_size, sizeof(uint32_t));
+            log_size_ += sizeof(uint32_t);
+            continue;
+        }
+        item_size = find_ret->second.size();
+        log_hdl_.write((char*)&item_size, sizeof(uint32_t));
+        log_hdl_.write(find_ret->second.c_str(), item_size);
+        log_size_ += sizeof(uint32_t) + item_size;
+    }
+    log_hdl_.flush();
+    dirty_key_set_.clear();
+    return ;
+}
+
+/**
+ * @brief rewrite the whole db file and clear the log (hold the write lock)
+ * 
+ */
+void InMemoryDatabase::Compact() {
+    // write a tmp file first, a crash keeps the previous index file (the
+    // log ends with the same values, replaying it is harmless)
+    string tmp_db_name = db_name_ + ".tmp";
+    ofstream db_file;
+    db_file.open(tmp_db_name, ios_base::trunc | ios_base::binary);
+    uint32_t item_size = 0;
+    file_size_ = 0;
+    for (auto it = index_obj_.begin(); it != index_obj_.end(); it++) {
+        // write the key
+        item_size = it->first.size();
+        db_file.write((char*)&item_size, sizeof(uint32_t));
+        db_file.write(it->first.c_str(), item_size);
+
+        // write the value
+        item_size = it->second.size();
+        db_file.write((char*)&item_size, sizeof(uint32_t));
+        db_file.write(it->second.c_str(), item_size);
+        file_size_ += sizeof(uint32_t) * 2 + it->first.size() +
+            it->second.size();
+    }
+    db_file.close();
+    rename(tmp_db_name.c_str(), db_name_.c_str());
+
+    log_hdl_.close();
+    log_hdl_.open(log_name_, ios_base::trunc | ios_base::binary);
+    log_size_ = 0;
     return ;
 }
\ No newline at end of file
@@ -154,4 +154,17 @@ void LeveldbDatabase::DeleteBuffer(const char* key, size_t key_size) {
 void LeveldbDatabase::Delete(const string& key) {
     level_db_obj_->Delete(leveldb::WriteOptions(), key);
     return ;
+}
+
+/**
+ * @brief make the previous updates durable
+ * 
+ */
+void LeveldbDatabase::Sync() {
+    // a synced empty write flushes the log of the previous writes
+    leveldb::WriteOptions sync_options;
+    sync_options.sync = true;
+    leveldb::WriteBatch empty_batch;
+    level_db_obj_->Write(sync_options, &empty_batch);
+    return ;
 }
\ No newline at end of file
@@ -0,0 +1,167 @@
+/**
+ * @file rocksdb_cf_db.cc
+ * @brief implement the interfaces of RocksdbCFDatabase
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#include "../../include/database/rocksdb_cf_db.h"
+
+/**
+ * @brief Construct a new RocksdbCFDatabase object
+ * 
+ * @param rocks_db_obj the shared db (owned by the RocksdbCFStore)
+ * @param cf_handle the column family handle
+ */
+RocksdbCFDatabase::RocksdbCFDatabase(rocksdb::DB* rocks_db_obj,
+    rocksdb::ColumnFamilyHandle* cf_handle) {
+    rocks_db_obj_ = rocks_db_obj;
+    cf_handle_ = cf_handle;
+    db_name_ = cf_handle_->GetName();
+
+    // write option
+    write_options_ = rocksdb::WriteOptions();
+    write_options_.disableWAL = true;
+
+    // read option
+    read_options_ = rocksdb::ReadOptions();
+}
+
+/**
+ * @brief Destroy the RocksdbCFDatabase object
+ * 
+ */
+RocksdbCFDatabase::~RocksdbCFDatabase() {
+    // the db and the column family handle are released by the store
+}
+
+/**
+ * @brief open a database (the shared db is opened by the store)
+ * 
+ * @param db_name the db path
+ * @return true success
+ * @return false fail
+ */
+bool RocksdbCFDatabase::OpenDB(string db_name) {
+    return rocks_db_obj_ != NULL;
+}
+
+/**
+ * @brief execute query over database
+ * 
+ * @param key key
+ * @param value value
+ * @return true exist
+ * @return false not exist
+ */
+bool RocksdbCFDatabase::Query(const string& key, string& value) {
+    rocksdb::Status query_stat = rocks_db_obj_->Get(read_options_, cf_handle_,
+        key, &value);
+    return query_stat.ok();
+}
+
+/**
+ * @brief insert the (key, value) pair
+ * 
+ * @param key key
+ * @param value value
+ * @return true success
+ * @return false fail
+ */
+bool RocksdbCFDatabase::Insert(const string& key, const string& value) {
+    rocksdb::Status insert_stat = rocks_db_obj_->Put(write_options_, cf_handle_,
+        key, value);
+    return insert_stat.ok();
+}
+
+/**
+ * @brief insert the (key, value) pair
+ * 
+ * @param key the key 
+ * @param buf the value buffer
+ * @param buf_size the buffer size
+ * @return true success
+ * @return false fail
+ */
+bool RocksdbCFDatabase::InsertBuffer(const string& key, const char* buf,
+    size_t buf_size) {
+    rocksdb::Status insert_stat = rocks_db_obj_->Put(write_options_, cf_handle_,
+        key, rocksdb::Slice(buf, buf_size));
+    return insert_stat.ok();
+}
+
+/**
+ * @brief insert the (key, value) pair
+ * 
+ * @param key the key
+ * @param key_size the key size
+ * @param buf the value buffer
+ * @param buf_size the buffer size
+ * @return true success
+ * @return false fail
+ */
+bool RocksdbCFDatabase::InsertBothBuffer(const char* key, size_t key_size,
+    const char* buf, size_t buf_size) {
+    rocksdb::Status insert_stat = rocks_db_obj_->Put(write_options_, cf_handle_,
+        rocksdb::Slice(key, key_size), rocksdb::Slice(buf, buf_size));
+    return insert_stat.ok();
+}
+
+/**
+ * @brief query the (key, value) pair
+ * 
+ * @param key the key
+ * @param key_size the key size
+ * @param value the value
+ * @return true exist
+ * @return false not exist
+ */
+bool RocksdbCFDatabase::QueryBuffer(const char* key, size_t key_size,
+    string& value) {
+    rocksdb::Status query_stat = rocks_db_obj_->Get(read_options_, cf_handle_,
+        rocksdb::Slice(key, key_size), &value);
+    return query_stat.ok();
+}
+
+/**
+ * @brief delete a given key
+ * 
+ * @param key key ptr
+ * @param key_size key size
+ */
+void RocksdbCFDatabase::DeleteBuffer(const char* key, size_t key_size) {
+    rocks_db_obj_->Delete(write_options_, cf_handle_,
+        rocksdb::Slice(key, key_size));
+    return ;
+}
+
+/**
+ * @brief delete a given key
+ * 
+ * @param key key str
+ */
+void RocksdbCFDatabase::Delete(const string& key) {
+    rocks_db_obj_->Delete(write_options_, cf_handle_, key);
+    return ;
+}
+
+/**
+ * @brief make the previous updates durable (the WAL is disabled, flush the
+ * memtable of this column family to the sst files)
+ * 
+ */
+void RocksdbCFDatabase::Sync() {
+    rocksdb::FlushOptions flush_options;
+    flush_options.wait = true;
+    rocksdb::Status flush_stat = rocks_db_obj_->Flush(flush_options,
+        cf_handle_);
+    if (!flush_stat.ok()) {
+        tool::Logging(my_name_.c_str(), "flush the column family error: %s\n",
+            flush_stat.ToString().c_str());
+        exit(EXIT_FAILURE);
+    }
+    return ;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file rocksdb_cf_store.cc
+ * @brief implement the interfaces of RocksdbCFStore
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#include "../../include/database/rocksdb_cf_store.h"
+
+/**
+ * @brief Construct a new RocksdbCFStore object
+ * 
+ * @param db_name the path of the db file
+ */
+RocksdbCFStore::RocksdbCFStore(string db_name) {
+    db_name_ = db_name;
+
+    // global option
+    options_.create_if_missing = true;
+    options_.create_missing_column_families = true;
+    options_.IncreaseParallelism(16);
+    options_.OptimizeForPointLookup(4096);
+    options_.info_log_level = static_cast<rocksdb::InfoLogLevel>(4); // FATAL_LEVEL
+    options_.compression = rocksdb::CompressionType::kNoCompression;
+
+    // re-open all existing column families (at least the default one)
+    vector<string> cf_name_list;
+    rocksdb::DB::ListColumnFamilies(options_, db_name_, &cf_name_list);
+    if (cf_name_list.empty()) {
+        cf_name_list.push_back(rocksdb::kDefaultColumnFamilyName);
+    }
+
+    vector<rocksdb::ColumnFamilyDescriptor> cf_desc_list;
+    for (auto& cf_name : cf_name_list) {
+        cf_desc_list.push_back(rocksdb::ColumnFamilyDescriptor(cf_name,
+            rocksdb::ColumnFamilyOptions(options_)));
+    }
+
+    vector<rocksdb::ColumnFamilyHandle*> cf_handle_list;
+    rocksdb::Status status = rocksdb::DB::Open(rocksdb::DBOptions(options_),
+        db_name_, cf_desc_list, &cf_handle_list, &rocks_db_obj_);
+    if (!status.ok()) {
+        tool::Logging(my_name_.c_str(), "cannot open the db: %s\n",
+            status.ToString().c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < cf_handle_list.size(); i++) {
+        cf_handle_idx_[cf_name_list[i]] = cf_handle_list[i];
+    }
+}
+
+/**
+ * @brief Destroy the RocksdbCFStore object
+ * 
+ */
+RocksdbCFStore::~RocksdbCFStore() {
+    for (auto it : cf_handle_idx_) {
+        rocks_db_obj_->DestroyColumnFamilyHandle(it.second);
+    }
+    delete rocks_db_obj_;
+}
+
+/**
+ * @brief get a view of a column family (create it if not exist)
+ * 
+ * @param cf_name the column family name
+ * @return AbsDatabase* the column family view (owned by the caller)
+ */
+AbsDatabase* RocksdbCFStore::GetColumnFamily(string cf_name) {
+    lock_guard<mutex> lck(cf_handle_lck_);
+    auto find_ret = cf_handle_idx_.find(cf_name);
+    if (find_ret == cf_handle_idx_.end()) {
+        rocksdb::ColumnFamilyHandle* cf_handle = NULL;
+        rocksdb::Status status = rocks_db_obj_->CreateColumnFamily(
+            rocksdb::ColumnFamilyOptions(options_), cf_name, &cf_handle);
+        if (!status.ok()) {
+            tool::Logging(my_name_.c_str(), "cannot create column family %s: %s\n",
+                cf_name.c_str(), status.ToString().c_str());
+            exit(EXIT_FAILURE);
+        }
+        find_ret = cf_handle_idx_.insert({cf_name, cf_handle}).first;
+    }
+
+    return new RocksdbCFDatabase(rocks_db_obj_, find_ret->second);
+}
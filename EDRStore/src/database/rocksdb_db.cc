@@ -153,4 +153,21 @@ void RocksdbDatabase::DeleteBuffer(const char* key, size_t key_size) {
 void RocksdbDatabase::Delete(const string& key) {
     rocks_db_obj_->Delete(write_options_, key);
     return ;
+}
+
+/**
+ * @brief make the previous updates durable (the WAL is disabled, flush the
+ * memtable to the sst files)
+ * 
+ */
+void RocksdbDatabase::Sync() {
+    rocksdb::FlushOptions flush_options;
+    flush_options.wait = true;
+    rocksdb::Status flush_stat = rocks_db_obj_->Flush(flush_options);
+    if (!flush_stat.ok()) {
+        tool::Logging(my_name_.c_str(), "flush the db error: %s\n",
+            flush_stat.ToString().c_str());
+        exit(EXIT_FAILURE);
+    }
+    return ;
 }
\ No newline at end of file
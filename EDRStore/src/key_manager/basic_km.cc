@@ -17,12 +17,12 @@
  * @param km_channel the key generation channel
  * @param feature_2_key_index the feature index
  */
-BasicKM::BasicKM(SSLConnection* km_channel, 
+BasicKM::BasicKM(AbsTransport* km_channel, 
     AbsDatabase* feature_2_key_index) {
     km_channel_ = km_channel;
     feature_2_key_index_ = feature_2_key_index;
 
-    send_chunk_batch_size_ = config.GetSendChunkBatchSize();
+    max_batch_size_ = config.GetMaxBatchSize();
     memset(global_secret_, 1, CHUNK_HASH_SIZE);
     crypto_util_ = new CryptoUtil(CIPHER_TYPE, HASH_TYPE);
 
@@ -52,7 +52,7 @@ BasicKM::~BasicKM() {
  * 
  * @param key_client_ssl the client ssl
  */
-void BasicKM::Run(SSL* key_client_ssl) {
+void BasicKM::Run(Conn_t* key_client_ssl) {
     tool::Logging(my_name_.c_str(), "the main thread is running.\n");
     uint32_t recv_size = 0;
     string client_ip;
@@ -61,7 +61,7 @@ void BasicKM::Run(SSL* key_client_ssl) {
     // the recv buffer
     SendMsgBuffer_t recv_req_buf;
     recv_req_buf.send_buf = (uint8_t*) malloc(sizeof(NetworkHead_t) + 
-        send_chunk_batch_size_ * sizeof(KeyGenReq_t));
+        max_batch_size_ * sizeof(KeyGenReq_t));
     recv_req_buf.header = (NetworkHead_t*) recv_req_buf.send_buf;  
     recv_req_buf.data_buf = recv_req_buf.send_buf + sizeof(NetworkHead_t);
     uint32_t client_id = 0;
@@ -69,7 +69,7 @@ void BasicKM::Run(SSL* key_client_ssl) {
     // the send buffer
     SendMsgBuffer_t send_key_buf;
     send_key_buf.send_buf = (uint8_t*) malloc(sizeof(NetworkHead_t) +
-        send_chunk_batch_size_ * sizeof(KeyGenRet_t));
+        max_batch_size_ * sizeof(KeyGenRet_t));
     send_key_buf.header = (NetworkHead_t*) send_key_buf.send_buf;
     send_key_buf.data_buf = send_key_buf.send_buf + sizeof(NetworkHead_t);
 
@@ -0,0 +1,93 @@
+/**
+ * @file abs_transport.cc
+ * @brief implement the common interfaces of a transport
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "../../include/network/abs_transport.h"
+
+/**
+ * @brief write the length and the data to a socket in one writev
+ *
+ * @param fd the socket fd
+ * @param data the pointer to the data buffer
+ * @param size the size of the input data
+ * @return true success
+ * @return false fail (errno is set)
+ */
+bool AbsTransport::WriteMsg(int fd, uint8_t* data, uint32_t size) {
+    struct iovec iov[2];
+    iov[0].iov_base = &size;
+    iov[0].iov_len = sizeof(uint32_t);
+    iov[1].iov_base = data;
+    iov[1].iov_len = size;
+    return this->WriteVec(fd, iov, 2);
+}
+
+/**
+ * @brief write all the buffers to a socket
+ *
+ * @param fd the socket fd
+ * @param iov the buffers (modified)
+ * @param iov_num the buffer num
+ * @return true success
+ * @return false fail (errno is set)
+ */
+bool AbsTransport::WriteVec(int fd, struct iovec* iov, int iov_num) {
+    struct iovec* cur_iov = iov;
+    ssize_t write_stat;
+    while (iov_num > 0) {
+        write_stat = writev(fd, cur_iov, iov_num);
+        if (write_stat < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        // skip the sent part
+        while (iov_num > 0 && (size_t)write_stat >= cur_iov->iov_len) {
+            write_stat -= cur_iov->iov_len;
+            cur_iov++;
+            iov_num--;
+        }
+        if (iov_num > 0) {
+            cur_iov->iov_base = (uint8_t*)cur_iov->iov_base + write_stat;
+            cur_iov->iov_len -= write_stat;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief read the given size from a socket
+ *
+ * @param fd the socket fd
+ * @param buf the buffer
+ * @param size the size to read
+ * @return true success
+ * @return false fail (errno is set, 0: the peer closed the connection)
+ */
+bool AbsTransport::ReadFull(int fd, uint8_t* buf, uint32_t size) {
+    uint32_t cur_size = 0;
+    ssize_t read_stat;
+    while (cur_size < size) {
+        read_stat = read(fd, buf + cur_size, size - cur_size);
+        if (read_stat < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (read_stat == 0) {
+            errno = 0;
+            return false;
+        }
+        cur_size += read_stat;
+    }
+    return true;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file batch_tuner.cc
+ * @brief implement the interfaces of BatchTuner
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "../../include/network/batch_tuner.h"
+
+/**
+ * @brief Construct a new BatchTuner object
+ *
+ * @param traffic_name the traffic of this tuner
+ * @param is_round_trip whether the batch waits for the response
+ */
+BatchTuner::BatchTuner(string traffic_name, bool is_round_trip) {
+    traffic_name_ = traffic_name;
+    is_round_trip_ = is_round_trip;
+    adaptive_ = config.GetAdaptiveBatch();
+    min_size_ = config.GetMinBatchSize();
+    // the peer buffers are sized by the max batch size
+    max_size_ = config.GetMaxBatchSize();
+
+    // start from the configured size until the link is measured
+    uint64_t init_size = config.GetSendChunkBatchSize();
+    cur_size_.store(init_size);
+    logged_size_ = init_size;
+    _min_used_size = init_size;
+    _max_used_size = init_size;
+}
+
+/**
+ * @brief Destroy the BatchTuner object
+ *
+ */
+BatchTuner::~BatchTuner() {
+    ;
+}
+
+/**
+ * @brief add the sample of a sent batch, and adjust the batch size
+ *
+ * @param channel the connection channel
+ * @param conn the connection of the batch
+ * @param item_num the item num of the batch
+ * @param elapsed the time to send (and get the response of) the batch
+ */
+void BatchTuner::OnBatch(AbsTransport* channel, Conn_t* conn,
+    uint64_t item_num, double elapsed) {
+    if (!adaptive_ || item_num == 0) {
+        return ;
+    }
+
+    double rtt = 0;
+    if (!channel->GetRTT(conn, rtt) || rtt <= 0) {
+        return ;
+    }
+
+    // the round trip is paid once per batch, the rest grows with the items
+    double item_time = elapsed;
+    if (is_round_trip_) {
+        item_time -= rtt;
+    }
+    item_time = max(item_time, elapsed * BATCH_TUNE_RTT_RATIO) / item_num;
+    if (item_time <= 0) {
+        return ;
+    }
+
+    lock_guard<mutex> lck(tune_lck_);
+    if (rtt_ == 0) {
+        rtt_ = rtt;
+        item_time_ = item_time;
+    } else {
+        rtt_ += BATCH_TUNE_ALPHA * (rtt - rtt_);
+        item_time_ += BATCH_TUNE_ALPHA * (item_time - item_time_);
+    }
+    sample_num_++;
+    if (sample_num_ < BATCH_TUNE_INTERVAL) {
+        return ;
+    }
+    sample_num_ = 0;
+
+    // request-response: the round trip is at most BATCH_TUNE_RTT_RATIO of a
+    // batch; stream: a batch covers the data in flight of a round trip
+    double target = rtt_ / item_time_;
+    if (is_round_trip_) {
+        target *= (1 - BATCH_TUNE_RTT_RATIO) / BATCH_TUNE_RTT_RATIO;
+    }
+    uint64_t new_size = max_size_;
+    if (target < max_size_) {
+        new_size = max(min_size_, (uint64_t)target + 1);
+    }
+    cur_size_.store(new_size, std::memory_order_relaxed);
+    _tuned_batch_num++;
+    _min_used_size = min(_min_used_size, new_size);
+    _max_used_size = max(_max_used_size, new_size);
+
+    // only log the large changes
+    uint64_t diff = (new_size > logged_size_) ? (new_size - logged_size_) :
+        (logged_size_ - new_size);
+    if (diff * 2 >= logged_size_) {
+        tool::Logging(my_name_.c_str(), "%s batch size: %lu -> %lu (rtt: %lf "
+            "ms, time per item: %lf us)\n", traffic_name_.c_str(),
+            logged_size_, new_size, rtt_ * 1000, item_time_ * 1000000);
+        logged_size_ = new_size;
+    }
+    return ;
+}
+
+/**
+ * @brief print the used batch sizes
+ *
+ */
+void BatchTuner::PrintStat() {
+    if (!adaptive_) {
+        return ;
+    }
+    lock_guard<mutex> lck(tune_lck_);
+    tool::Logging(my_name_.c_str(), "%s batch size: %lu, used range: [%lu, "
+        "%lu], adjustments: %lu, rtt: %lf ms\n", traffic_name_.c_str(),
+        cur_size_.load(), _min_used_size, _max_used_size, _tuned_batch_num,
+        rtt_ * 1000);
+    return ;
+}
@@ -0,0 +1,265 @@
+/**
+ * @file conn_reactor.cc
+ * @brief implement the interfaces of ConnReactor
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "../../include/network/conn_reactor.h"
+
+/**
+ * @brief Construct a new ConnReactor object
+ * 
+ * @param server_channel the server channel
+ * @param max_login_size the max login size
+ * @param login_hdl the handler of the established connections
+ */
+ConnReactor::ConnReactor(AbsTransport* server_channel,
+    uint32_t max_login_size, LoginHandler login_hdl) {
+    server_channel_ = server_channel;
+    max_login_size_ = max_login_size;
+    login_hdl_ = login_hdl;
+
+    int listen_fd = server_channel_->GetListenFd();
+    int flags = fcntl(listen_fd, F_GETFL, 0);
+    if (fcntl(listen_fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+        tool::Logging(my_name_.c_str(), "cannot set the listen fd "
+            "non-blocking: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    epoll_fd_ = epoll_create1(0);
+    if (epoll_fd_ < 0) {
+        tool::Logging(my_name_.c_str(), "cannot create the epoll fd: %s\n",
+            strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd, &event) != 0) {
+        tool::Logging(my_name_.c_str(), "cannot add the listen fd: %s\n",
+            strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Destroy the ConnReactor object
+ * 
+ */
+ConnReactor::~ConnReactor() {
+    vector<int> fd_list;
+    for (auto& it : pending_idx_) {
+        fd_list.push_back(it.first);
+    }
+    for (auto it : fd_list) {
+        this->Remove(it, true);
+    }
+    close(epoll_fd_);
+
+    fprintf(stderr, "========ConnReactor Info========\n");
+    fprintf(stderr, "total accepted connection: %lu\n", _total_accept_num);
+    fprintf(stderr, "total login: %lu\n", _total_login_num);
+    fprintf(stderr, "total failed connection: %lu\n", _total_fail_num);
+    fprintf(stderr, "================================\n");
+}
+
+/**
+ * @brief the main loop
+ * 
+ */
+void ConnReactor::Run() {
+    struct epoll_event event_list[REACTOR_EVENT_NUM];
+    int listen_fd = server_channel_->GetListenFd();
+    int event_num;
+
+    tool::Logging(my_name_.c_str(), "waiting the req from the client.\n");
+    while (true) {
+        // wake up every second to close the expired connections
+        event_num = epoll_wait(epoll_fd_, event_list, REACTOR_EVENT_NUM, 1000);
+        if (event_num < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            tool::Logging(my_name_.c_str(), "epoll wait fails: %s\n",
+                strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+
+        for (int i = 0; i < event_num; i++) {
+            if (event_list[i].data.fd == listen_fd) {
+                this->AcceptAll();
+            } else {
+                this->Progress(event_list[i].data.fd);
+            }
+        }
+        this->CloseExpired();
+    }
+    return ;
+}
+
+/**
+ * @brief accept all pending connections
+ * 
+ */
+void ConnReactor::AcceptAll() {
+    pair<int, Conn_t*> new_conn;
+    while (true) {
+        new_conn = server_channel_->AcceptNonBlock();
+        if (new_conn.first < 0) {
+            break;
+        }
+
+        PendingConn_t* pending_conn = new PendingConn_t;
+        pending_conn->conn = new_conn.second;
+        pending_conn->is_handshake_done = false;
+        pending_conn->login_buf = (uint8_t*) malloc(sizeof(uint32_t) +
+            max_login_size_);
+        pending_conn->recv_size = 0;
+        pending_conn->events = EPOLLIN;
+        gettimeofday(&pending_conn->accept_time, NULL);
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = new_conn.first;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, new_conn.first, &event) != 0) {
+            tool::Logging(my_name_.c_str(), "cannot add the connection: %s\n",
+                strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        pending_idx_[new_conn.first] = pending_conn;
+        _total_accept_num++;
+
+        // the client hello may have arrived
+        this->Progress(new_conn.first);
+    }
+    return ;
+}
+
+/**
+ * @brief continue the handshake and the login of a connection
+ * 
+ * @param fd the socket fd
+ */
+void ConnReactor::Progress(int fd) {
+    auto find_res = pending_idx_.find(fd);
+    if (find_res == pending_idx_.end()) {
+        return ;
+    }
+    PendingConn_t* pending_conn = find_res->second;
+
+    int ret = CONN_FAIL;
+    if (!pending_conn->is_handshake_done) {
+        ret = server_channel_->HandshakeNonBlock(pending_conn->conn);
+        if (ret == CONN_DONE) {
+            pending_conn->is_handshake_done = true;
+        }
+    }
+    if (pending_conn->is_handshake_done) {
+        ret = server_channel_->ReceiveDataNonBlock(pending_conn->conn,
+            pending_conn->login_buf, sizeof(uint32_t) + max_login_size_,
+            pending_conn->recv_size);
+    }
+
+    switch (ret) {
+        case CONN_DONE: {
+            // hand over the established connection
+            Conn_t* conn = pending_conn->conn;
+            uint8_t* login_buf = pending_conn->login_buf;
+            uint32_t login_size = 0;
+            memcpy(&login_size, login_buf, sizeof(uint32_t));
+            pending_conn->login_buf = NULL;
+            this->Remove(fd, false);
+            server_channel_->SetBlocking(conn);
+            _total_login_num++;
+            login_hdl_(conn, login_buf + sizeof(uint32_t), login_size);
+            free(login_buf);
+            break;
+        }
+        case CONN_WANT_READ: {
+            this->WaitFor(fd, EPOLLIN);
+            break;
+        }
+        case CONN_WANT_WRITE: {
+            this->WaitFor(fd, EPOLLOUT);
+            break;
+        }
+        default: {
+            _total_fail_num++;
+            this->Remove(fd, true);
+            break;
+        }
+    }
+    return ;
+}
+
+/**
+ * @brief set the events to wait for of a pending connection
+ * 
+ * @param fd the socket fd
+ * @param events the epoll events
+ */
+void ConnReactor::WaitFor(int fd, uint32_t events) {
+    PendingConn_t* pending_conn = pending_idx_[fd];
+    if (pending_conn->events == events) {
+        return ;
+    }
+    struct epoll_event event;
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) != 0) {
+        tool::Logging(my_name_.c_str(), "cannot modify the connection: %s\n",
+            strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    pending_conn->events = events;
+    return ;
+}
+
+/**
+ * @brief remove a pending connection from the reactor
+ * 
+ * @param fd the socket fd
+ * @param is_close whether to close the connection
+ */
+void ConnReactor::Remove(int fd, bool is_close) {
+    auto find_res = pending_idx_.find(fd);
+    PendingConn_t* pending_conn = find_res->second;
+    pending_idx_.erase(find_res);
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, NULL);
+    if (is_close) {
+        server_channel_->ClearAcceptedClientSd(pending_conn->conn);
+    }
+    if (pending_conn->login_buf != NULL) {
+        free(pending_conn->login_buf);
+    }
+    delete pending_conn;
+    return ;
+}
+
+/**
+ * @brief close the connections that do not login in time
+ * 
+ */
+void ConnReactor::CloseExpired() {
+    struct timeval cur_time;
+    gettimeofday(&cur_time, NULL);
+    vector<int> expired_list;
+    for (auto& it : pending_idx_) {
+        if (tool::GetTimeDiff(it.second->accept_time, cur_time) >
+            CONN_LOGIN_TIMEOUT) {
+            expired_list.push_back(it.first);
+        }
+    }
+    for (auto it : expired_list) {
+        tool::Logging(my_name_.c_str(), "close a connection that does not "
+            "login in %u sec.\n", CONN_LOGIN_TIMEOUT);
+        _total_fail_num++;
+        this->Remove(it, true);
+    }
+    return ;
+}
@@ -36,6 +36,10 @@ SSLConnection::SSLConnection(string ip, int port, int type) {
     string ca_file_str;
 
     ca_file_str.assign(CA_CERT);
+    is_ktls_logged_ = false;
+    type_ = type;
+    _total_conn_num = 0;
+    _total_resumed_num = 0;
     int enable = 1;
     switch (type) {
         case IN_SERVER_SIDE:
@@ -56,7 +60,7 @@ SSLConnection::SSLConnection(string ip, int port, int type) {
                 tool::Logging(my_name_.c_str(), "%s\n", strerror(errno));
                 exit(EXIT_FAILURE);
             }
-            if (listen(listen_fd_, 10) == -1) {
+            if (listen(listen_fd_, SOMAXCONN) == -1) {
                 tool::Logging(my_name_.c_str(), "cannot listen this socket.\n");
                 tool::Logging(my_name_.c_str(), "%s\n", strerror(errno));
                 exit(EXIT_FAILURE);
@@ -73,6 +77,58 @@ SSLConnection::SSLConnection(string ip, int port, int type) {
             exit(EXIT_FAILURE);
     }
 
+    if (config.GetEnableKTLS()) {
+#ifdef SSL_OP_ENABLE_KTLS
+        // the kernel takes over the record layer after the handshake
+        SSL_CTX_set_options(ssl_ctx_, SSL_OP_ENABLE_KTLS);
+#else
+        tool::Logging(my_name_.c_str(), "kTLS is not supported by this "
+            "OpenSSL.\n");
+#endif
+    } else if (!config.GetAuthOnlyData()) {
+        // read the length and the payload of a record in one read (it
+        // disables kTLS receive, and the authenticated-only data frames that
+        // follow the last record)
+        SSL_CTX_set_read_ahead(ssl_ctx_, 1);
+    }
+
+    if (config.GetSessionResumption()) {
+        switch (type) {
+            case IN_SERVER_SIDE: {
+                // stateless tickets, no server-side session cache
+                SSL_CTX_set_session_cache_mode(ssl_ctx_, SSL_SESS_CACHE_SERVER |
+                    SSL_SESS_CACHE_NO_INTERNAL_STORE);
+                SSL_CTX_set_session_id_context(ssl_ctx_,
+                    (const uint8_t*)SSL_SESSION_ID_CTX,
+                    strlen(SSL_SESSION_ID_CTX));
+                SSL_CTX_set_timeout(ssl_ctx_, config.GetSessionLifetime());
+                SSL_CTX_set_num_tickets(ssl_ctx_, 1);
+#ifdef SSL_OP_PREFER_NO_DHE_KEX
+                // resume without the (EC)DHE exchange
+                SSL_CTX_set_options(ssl_ctx_, SSL_OP_ALLOW_NO_DHE_KEX |
+                    SSL_OP_PREFER_NO_DHE_KEX);
+#endif
+                break;
+            }
+            case IN_CLIENT_SIDE: {
+                SSL_CTX_set_session_cache_mode(ssl_ctx_, SSL_SESS_CACHE_CLIENT |
+                    SSL_SESS_CACHE_NO_INTERNAL_STORE);
+                SSL_CTX_sess_set_new_cb(ssl_ctx_,
+                    SSLConnection::NewSessionCallback);
+                SSL_CTX_set_app_data(ssl_ctx_, this);
+                SSL_CTX_set_options(ssl_ctx_, SSL_OP_ALLOW_NO_DHE_KEX);
+                session_path_ = string(SESSION_FILE_PREFIX) + server_ip_ + "-" +
+                    to_string(port_);
+                this->LoadSession();
+                break;
+            }
+        }
+    } else {
+        SSL_CTX_set_session_cache_mode(ssl_ctx_, SSL_SESS_CACHE_OFF);
+        SSL_CTX_set_options(ssl_ctx_, SSL_OP_NO_TICKET);
+        SSL_CTX_set_num_tickets(ssl_ctx_, 0);
+    }
+
     SSL_CTX_set_verify(ssl_ctx_, SSL_VERIFY_PEER, NULL);
     if (!SSL_CTX_load_verify_locations(ssl_ctx_, ca_file_str.c_str(), NULL)) {
         tool::Logging(my_name_.c_str(), "load ca crt error\n");
@@ -117,6 +173,14 @@ SSLConnection::SSLConnection(string ip, int port, int type) {
  * 
  */
 SSLConnection::~SSLConnection() {
+    if (type_ == IN_CLIENT_SIDE && config.GetSessionResumption()) {
+        tool::Logging(my_name_.c_str(), "resumed connection num of <%s:%d>: "
+            "%lu/%lu\n", server_ip_.c_str(), port_, _total_resumed_num.load(),
+            _total_conn_num.load());
+    }
+    if (session_ != NULL) {
+        SSL_SESSION_free(session_);
+    }
     SSL_CTX_free(ssl_ctx_);
     close(listen_fd_);
 }
@@ -124,9 +188,35 @@ SSLConnection::~SSLConnection() {
 /**
  * @brief finalize the connection
  * 
- * @param ssl_pair the pair of the server socket and ssl context
+ * @param conn_pair the pair of the server socket and the connection
  */
-void SSLConnection::Finish(pair<int, SSL*> ssl_pair) {
+void SSLConnection::Finish(pair<int, Conn_t*> conn_pair) {
+    Conn_t* conn = conn_pair.second;
+    if (conn->auth_only != NULL) {
+        // the TLS records stop at the switch, close with an empty frame
+        uint32_t recv_size = 0;
+        if (!this->SendFrame(conn, NULL, 0, 0)) {
+            tool::Logging(my_name_.c_str(), "send the close frame error.\n");
+            exit(EXIT_FAILURE);
+        }
+        this->ReceiveFrame(conn, NULL, 0, recv_size);
+        if (!conn->auth_only->close_recv) {
+            tool::Logging(my_name_.c_str(), "receive the close frame error.\n");
+            exit(EXIT_FAILURE);
+        }
+        // the close is authenticated by the frames, keep the session ticket
+        SSL_set_shutdown(conn->ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        tool::Logging(my_name_.c_str(), "shutdown the SSL connection successfully.\n");
+
+        this->FreeAuthOnly(conn);
+        SSL_free(conn->ssl);
+        close(conn_pair.first);
+        delete conn;
+        return ;
+    }
+
+    pair<int, SSL*> ssl_pair = make_pair(conn_pair.first,
+        conn_pair.second->ssl);
     int ret = SSL_shutdown(ssl_pair.second);
     if (ret != 0) {
         tool::Logging(my_name_.c_str(), "first shutdown the socket in client side error, "
@@ -158,17 +248,20 @@ void SSLConnection::Finish(pair<int, SSL*> ssl_pair) {
 
     SSL_free(ssl_pair.second);
     close(ssl_pair.first);
+    delete conn_pair.second;
     return ;
 }
 
 /**
  * @brief clear the corresponding accepted client socket and context
  * 
- * @param ssl_ptr the pointer to the SSL* of accepted client
+ * @param conn the accepted client connection
  */
-void SSLConnection::ClearAcceptedClientSd(SSL* ssl_ptr) {
-    int sd = SSL_get_fd(ssl_ptr);
-    SSL_free(ssl_ptr);
+void SSLConnection::ClearAcceptedClientSd(Conn_t* conn) {
+    int sd = conn->fd;
+    this->FreeAuthOnly(conn);
+    SSL_free(conn->ssl);
+    delete conn;
     close(sd);
     return ;
 }
@@ -176,9 +269,9 @@ void SSLConnection::ClearAcceptedClientSd(SSL* ssl_ptr) {
 /**
  * @brief connect to ssl
  * 
- * @return pair<int, SSL*> 
+ * @return pair<int, Conn_t*> 
  */
-pair<int, SSL*> SSLConnection::ConnectSSL() {
+pair<int, Conn_t*> SSLConnection::Connect() {
     int socket_fd;
     SSL* ssl_ptr;
     
@@ -194,6 +287,14 @@ pair<int, SSL*> SSLConnection::ConnectSSL() {
         ERR_print_errors_fp(stderr);
         exit(EXIT_FAILURE);
     }
+
+    // offer the newest session ticket
+    {
+        lock_guard<mutex> lck(session_lck_);
+        if (session_ != NULL) {
+            SSL_set_session(ssl_ptr, session_);
+        }
+    }
     
     // start the SSL handshake 
     if (SSL_connect(ssl_ptr) != 1) {
@@ -201,16 +302,21 @@ pair<int, SSL*> SSLConnection::ConnectSSL() {
         ERR_print_errors_fp(stderr);
         exit(EXIT_FAILURE);
     } 
+    _total_conn_num++;
+    if (SSL_session_reused(ssl_ptr)) {
+        _total_resumed_num++;
+    }
+    this->LogKTLS(ssl_ptr);
 
-    return make_pair(socket_fd, ssl_ptr);
+    return make_pair(socket_fd, new Conn_t{socket_fd, ssl_ptr, NULL});
 }
 
 /**
  * @brief listen to a port 
  * 
- * @return pair<int, SSL*> 
+ * @return pair<int, Conn_t*> 
  */
-pair<int, SSL*> SSLConnection::ListenSSL() {
+pair<int, Conn_t*> SSLConnection::Listen() {
     int socket_fd;
     struct sockaddr_in client_addr;
     socklen_t client_addr_len = sizeof(client_addr);
@@ -233,22 +339,143 @@ pair<int, SSL*> SSLConnection::ListenSSL() {
         ERR_print_errors_fp(stderr);
         exit(EXIT_FAILURE);
     }
+    this->LogKTLS(ssl_ptr);
 
-    return make_pair(socket_fd, ssl_ptr);
+    return make_pair(socket_fd, new Conn_t{socket_fd, ssl_ptr, NULL});
 }
 
 /**
- * @brief send the data to the given connection
+ * @brief accept a pending connection without blocking (the handshake is
+ * driven by HandshakeNonBlock)
+ * 
+ * @return pair<int, Conn_t*> (-1, NULL) if no connection is pending
+ */
+pair<int, Conn_t*> SSLConnection::AcceptNonBlock() {
+    int socket_fd;
+    struct sockaddr_in client_addr;
+    socklen_t client_addr_len = sizeof(client_addr);
+    socket_fd = accept4(listen_fd_, (struct sockaddr*)&client_addr,
+        &client_addr_len, SOCK_NONBLOCK);
+    if (socket_fd < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR &&
+            errno != ECONNABORTED) {
+            tool::Logging(my_name_.c_str(), "socket listen fails: %s\n",
+                strerror(errno));
+        }
+        return make_pair(-1, (Conn_t*)NULL);
+    }
+
+    SSL* ssl_ptr = SSL_new(ssl_ctx_);
+    if (!SSL_set_fd(ssl_ptr, socket_fd)) {
+        tool::Logging(my_name_.c_str(), "cannot combine the fd and ssl.\n");
+        ERR_print_errors_fp(stderr);
+        exit(EXIT_FAILURE);
+    }
+    SSL_set_accept_state(ssl_ptr);
+
+    return make_pair(socket_fd, new Conn_t{socket_fd, ssl_ptr, NULL});
+}
+
+/**
+ * @brief continue the handshake of a non-blocking connection
+ * 
+ * @param conn the connection
+ * @return int the CONN_STATE_SET
+ */
+int SSLConnection::HandshakeNonBlock(Conn_t* conn) {
+    int ret = SSL_do_handshake(conn->ssl);
+    if (ret == 1) {
+        this->LogKTLS(conn->ssl);
+        return CONN_DONE;
+    }
+    return this->GetConnState(conn->ssl, ret);
+}
+
+/**
+ * @brief continue to receive a message of a non-blocking connection
+ * 
+ * @param conn the connection
+ * @param buf the buffer of [length][data]
+ * @param buf_size the buffer size
+ * @param cur_size the received size in the buffer <ret>
+ * @return int the CONN_STATE_SET
+ */
+int SSLConnection::ReceiveDataNonBlock(Conn_t* conn, uint8_t* buf,
+    uint32_t buf_size, uint32_t& cur_size) {
+    SSL* ssl_conn = conn->ssl;
+    uint32_t msg_size = 0;
+    uint32_t expect_size = sizeof(uint32_t);
+    int read_stat;
+    while (true) {
+        if (cur_size >= sizeof(uint32_t)) {
+            memcpy(&msg_size, buf, sizeof(uint32_t));
+            if (msg_size > buf_size - sizeof(uint32_t)) {
+                tool::Logging(my_name_.c_str(), "the message is too large: "
+                    "%u\n", msg_size);
+                return CONN_FAIL;
+            }
+            expect_size = sizeof(uint32_t) + msg_size;
+            if (cur_size == expect_size) {
+                return CONN_DONE;
+            }
+        }
+
+        read_stat = SSL_read(ssl_conn, buf + cur_size, expect_size - cur_size);
+        if (read_stat <= 0) {
+            return this->GetConnState(ssl_conn, read_stat);
+        }
+        cur_size += read_stat;
+    }
+}
+
+/**
+ * @brief convert the result of a non-blocking SSL call to the CONN_STATE_SET
  * 
  * @param ssl_conn the pointer to the connection
+ * @param ret the return value of the SSL call
+ * @return int the CONN_STATE_SET
+ */
+int SSLConnection::GetConnState(SSL* ssl_conn, int ret) {
+    switch (SSL_get_error(ssl_conn, ret)) {
+        case SSL_ERROR_WANT_READ:
+            return CONN_WANT_READ;
+        case SSL_ERROR_WANT_WRITE:
+            return CONN_WANT_WRITE;
+        default:
+            tool::Logging(my_name_.c_str(), "the connection fails before the "
+                "login.\n");
+            ERR_print_errors_fp(stderr);
+            return CONN_FAIL;
+    }
+}
+
+/**
+ * @brief send the data to the given connection
+ * 
+ * @param conn the connection
  * @param data the pointer to the data buffer
  * @param size the size of the input data
  * @return true success
  * @return false fail
  */
-bool SSLConnection::SendData(SSL* ssl_conn, uint8_t* data, uint32_t size) {
+bool SSLConnection::SendData(Conn_t* conn, uint8_t* data, uint32_t size) {
+    if (conn->auth_only != NULL) {
+        return this->SendFrame(conn, data, size, size);
+    }
+    SSL* ssl_conn = conn->ssl;
+    if (BIO_get_ktls_send(SSL_get_wbio(ssl_conn))) {
+        return this->SendDataKTLS(ssl_conn, data, size);
+    }
+
+    // the first record carries the length and the head of the data
+    uint8_t first_record[SSL3_RT_MAX_PLAIN_LENGTH];
+    uint32_t head_size = min(size, (uint32_t)(SSL3_RT_MAX_PLAIN_LENGTH -
+        sizeof(uint32_t)));
+    memcpy(first_record, &size, sizeof(uint32_t));
+    memcpy(first_record + sizeof(uint32_t), data, head_size);
     int write_stat;
-    write_stat = SSL_write(ssl_conn, (char*)&size, sizeof(uint32_t));
+    write_stat = SSL_write(ssl_conn, first_record, sizeof(uint32_t) +
+        head_size);
     if (write_stat <= 0) {
         tool::Logging(my_name_.c_str(), "write the data fails. ret: %d\n",
             SSL_get_error(ssl_conn, write_stat));
@@ -256,7 +483,7 @@ bool SSLConnection::SendData(SSL* ssl_conn, uint8_t* data, uint32_t size) {
         return false;
     }
 
-    uint32_t current_send_size = 0;
+    uint32_t current_send_size = head_size;
     while (current_send_size < size) {
         write_stat = SSL_write(ssl_conn, data + current_send_size,
             size - current_send_size);
@@ -272,16 +499,228 @@ bool SSLConnection::SendData(SSL* ssl_conn, uint8_t* data, uint32_t size) {
     return true;
 }
 
+/**
+ * @brief send the length and the data via the kernel (kTLS send is active) in
+ * one writev
+ * 
+ * @param ssl_conn the pointer to the connection
+ * @param data the pointer to the data buffer
+ * @param size the size of the input data
+ * @return true success
+ * @return false fail
+ */
+bool SSLConnection::SendDataKTLS(SSL* ssl_conn, uint8_t* data,
+    uint32_t size) {
+    if (!this->WriteMsg(SSL_get_fd(ssl_conn), data, size)) {
+        tool::Logging(my_name_.c_str(), "write the data fails: %s\n",
+            strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief send a message of a head and an already-encrypted payload, the
+ * payload is authenticated but not encrypted again if the connection has
+ * enabled the authenticated-only data frames
+ * 
+ * @param conn the connection
+ * @param data the pointer to the data buffer
+ * @param size the size of the input data
+ * @param head_size the size of the head (encrypted)
+ * @return true success
+ * @return false fail
+ */
+bool SSLConnection::SendPayload(Conn_t* conn, uint8_t* data, uint32_t size,
+    uint32_t head_size) {
+    if (conn->auth_only == NULL) {
+        return this->SendData(conn, data, size);
+    }
+    return this->SendFrame(conn, data, size, min(head_size, size));
+}
+
+/**
+ * @brief send an authenticated-only data frame: [size][head size][encrypted
+ * head][tag][payload], the sizes and the payload are the AAD of AES-GCM
+ * 
+ * @param conn the connection
+ * @param data the pointer to the data buffer
+ * @param size the size of the input data (0: close the connection)
+ * @param head_size the size of the head (encrypted)
+ * @return true success
+ * @return false fail
+ */
+bool SSLConnection::SendFrame(Conn_t* conn, uint8_t* data, uint32_t size,
+    uint32_t head_size) {
+    AuthOnly_t* auth_only = conn->auth_only;
+    if (auth_only->enc_buf_size < head_size) {
+        free(auth_only->enc_buf);
+        auth_only->enc_buf = (uint8_t*) malloc(head_size);
+        auth_only->enc_buf_size = head_size;
+    }
+    uint32_t frame_head[2] = {size, head_size};
+    uint32_t payload_size = size - head_size;
+    uint8_t nonce[AUTH_ONLY_IV_SIZE];
+    uint8_t tag[AUTH_ONLY_TAG_SIZE];
+    GetNonce(auth_only->send_iv, auth_only->send_seq, nonce);
+    auth_only->send_seq++;
+
+    // the AAD goes before the encrypted head
+    EVP_CIPHER_CTX* ctx = auth_only->send_ctx;
+    int out_len = 0;
+    int final_len = 0;
+    if (!EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, nonce) ||
+        !EVP_EncryptUpdate(ctx, NULL, &out_len, (uint8_t*)frame_head,
+        sizeof(frame_head)) ||
+        (payload_size != 0 && !EVP_EncryptUpdate(ctx, NULL, &out_len,
+        data + head_size, payload_size)) ||
+        (head_size != 0 && !EVP_EncryptUpdate(ctx, auth_only->enc_buf,
+        &out_len, data, head_size)) ||
+        !EVP_EncryptFinal_ex(ctx, auth_only->enc_buf + head_size,
+        &final_len) ||
+        !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, AUTH_ONLY_TAG_SIZE,
+        tag)) {
+        tool::Logging(my_name_.c_str(), "seal the data frame fails.\n");
+        ERR_print_errors_fp(stderr);
+        return false;
+    }
+
+    struct iovec iov[4];
+    iov[0].iov_base = frame_head;
+    iov[0].iov_len = sizeof(frame_head);
+    iov[1].iov_base = auth_only->enc_buf;
+    iov[1].iov_len = head_size;
+    iov[2].iov_base = tag;
+    iov[2].iov_len = AUTH_ONLY_TAG_SIZE;
+    iov[3].iov_base = data + head_size;
+    iov[3].iov_len = payload_size;
+    if (!this->WriteVec(conn->fd, iov, 4)) {
+        tool::Logging(my_name_.c_str(), "write the data fails: %s\n",
+            strerror(errno));
+        return false;
+    }
+    if (size == 0) {
+        auth_only->close_sent = true;
+    }
+    return true;
+}
+
+/**
+ * @brief load the saved session ticket of this server
+ * 
+ */
+void SSLConnection::LoadSession() {
+    ifstream session_hdl;
+    session_hdl.open(session_path_, ios_base::in | ios_base::binary);
+    if (!session_hdl.is_open()) {
+        return ;
+    }
+    string session_str((istreambuf_iterator<char>(session_hdl)),
+        istreambuf_iterator<char>());
+    session_hdl.close();
+
+    const uint8_t* session_ptr = (const uint8_t*)session_str.data();
+    SSL_SESSION* session = d2i_SSL_SESSION(NULL, &session_ptr,
+        session_str.size());
+    if (session == NULL) {
+        tool::Logging(my_name_.c_str(), "the session file is broken: %s\n",
+            session_path_.c_str());
+        return ;
+    }
+    if (!SSL_SESSION_is_resumable(session) ||
+        SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) <=
+        time(NULL)) {
+        // expired, a full handshake gets a new one
+        SSL_SESSION_free(session);
+        return ;
+    }
+    session_ = session;
+    return ;
+}
+
+/**
+ * @brief keep a new session ticket, and save it to the session file
+ * 
+ * @param session the session ticket
+ */
+void SSLConnection::SaveSession(SSL_SESSION* session) {
+    lock_guard<mutex> lck(session_lck_);
+    if (session_ != NULL) {
+        SSL_SESSION_free(session_);
+    }
+    session_ = session;
+
+    int session_size = i2d_SSL_SESSION(session, NULL);
+    if (session_size <= 0) {
+        return ;
+    }
+    string session_str(session_size, '\0');
+    uint8_t* session_ptr = (uint8_t*)&session_str[0];
+    i2d_SSL_SESSION(session, &session_ptr);
+
+    // the ticket holds the resumption secret
+    string tmp_path = session_path_ + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        tool::Logging(my_name_.c_str(), "cannot save the session file: %s\n",
+            strerror(errno));
+        return ;
+    }
+    bool is_saved = write(fd, session_str.data(), session_size) ==
+        session_size;
+    close(fd);
+    if (!is_saved || rename(tmp_path.c_str(), session_path_.c_str()) != 0) {
+        tool::Logging(my_name_.c_str(), "cannot save the session file: %s\n",
+            session_path_.c_str());
+        remove(tmp_path.c_str());
+    }
+    return ;
+}
+
+/**
+ * @brief the callback of a new session ticket (client side)
+ * 
+ * @param ssl_conn the pointer to the connection
+ * @param session the session ticket
+ * @return int 1: the session is kept
+ */
+int SSLConnection::NewSessionCallback(SSL* ssl_conn, SSL_SESSION* session) {
+    SSLConnection* conn = (SSLConnection*)SSL_CTX_get_app_data(
+        SSL_get_SSL_CTX(ssl_conn));
+    conn->SaveSession(session);
+    return 1;
+}
+
+/**
+ * @brief log whether kTLS is active on a connection after the handshake
+ * 
+ * @param ssl_conn the pointer to the connection
+ */
+void SSLConnection::LogKTLS(SSL* ssl_conn) {
+    if (!config.GetEnableKTLS() || is_ktls_logged_.exchange(true)) {
+        return ;
+    }
+    tool::Logging(my_name_.c_str(), "kTLS send: %s, receive: %s (%s)\n",
+        BIO_get_ktls_send(SSL_get_wbio(ssl_conn)) ? "on" : "off",
+        BIO_get_ktls_recv(SSL_get_rbio(ssl_conn)) ? "on" : "off",
+        SSL_get_cipher_name(ssl_conn));
+    return ;
+}
+
 /**
  * @brief receive the data from the given connection
  * 
- * @param connection the pointer to the connection
+ * @param conn the connection
  * @param data the pointer to the data buffer
- * @param receiveDataSize the size of received data 
+ * @param recv_size the size of received data <ret>
  * @return true success
  * @return false fail
  */
-bool SSLConnection::ReceiveData(SSL* ssl_conn, uint8_t* data, uint32_t& recv_size) {
+bool SSLConnection::ReceiveData(Conn_t* conn, uint8_t* data, uint32_t& recv_size) {
+    if (conn->auth_only != NULL) {
+        return this->ReceiveFrame(conn, data, UINT32_MAX, recv_size);
+    }
+    SSL* ssl_conn = conn->ssl;
     uint32_t msg_size = 0;
     int read_stat;
     read_stat = SSL_read(ssl_conn, (char*)&msg_size, sizeof(uint32_t));
@@ -309,5 +748,188 @@ bool SSLConnection::ReceiveData(SSL* ssl_conn, uint8_t* data, uint32_t& recv_siz
     }
     recv_size = msg_size;
 
+    return true;
+}
+
+/**
+ * @brief receive and verify an authenticated-only data frame
+ * 
+ * @param conn the connection
+ * @param data the pointer to the data buffer
+ * @param max_size the max size of the data
+ * @param recv_size the size of received data <ret>
+ * @return true success
+ * @return false fail (or the peer closed the connection)
+ */
+bool SSLConnection::ReceiveFrame(Conn_t* conn, uint8_t* data,
+    uint32_t max_size, uint32_t& recv_size) {
+    AuthOnly_t* auth_only = conn->auth_only;
+    uint32_t frame_head[2];
+    uint8_t tag[AUTH_ONLY_TAG_SIZE];
+    if (!this->ReadFull(conn->fd, (uint8_t*)frame_head, sizeof(frame_head))) {
+        tool::Logging(my_name_.c_str(), "read the frame head fails: %s\n",
+            errno == 0 ? "peer has closed the connection" : strerror(errno));
+        return false;
+    }
+    uint32_t size = frame_head[0];
+    uint32_t head_size = frame_head[1];
+    if (head_size > size || size > max_size) {
+        tool::Logging(my_name_.c_str(), "wrong data frame size: %u\n", size);
+        return false;
+    }
+    uint32_t payload_size = size - head_size;
+    if (!this->ReadFull(conn->fd, data, head_size) ||
+        !this->ReadFull(conn->fd, tag, AUTH_ONLY_TAG_SIZE) ||
+        !this->ReadFull(conn->fd, data + head_size, payload_size)) {
+        tool::Logging(my_name_.c_str(), "read the data fails.\n");
+        return false;
+    }
+
+    // decrypt the head in place, then check the tag of the whole frame
+    uint8_t nonce[AUTH_ONLY_IV_SIZE];
+    GetNonce(auth_only->recv_iv, auth_only->recv_seq, nonce);
+    auth_only->recv_seq++;
+    EVP_CIPHER_CTX* ctx = auth_only->recv_ctx;
+    int out_len = 0;
+    if (!EVP_DecryptInit_ex(ctx, NULL, NULL, NULL, nonce) ||
+        !EVP_DecryptUpdate(ctx, NULL, &out_len, (uint8_t*)frame_head,
+        sizeof(frame_head)) ||
+        (payload_size != 0 && !EVP_DecryptUpdate(ctx, NULL, &out_len,
+        data + head_size, payload_size)) ||
+        (head_size != 0 && !EVP_DecryptUpdate(ctx, data, &out_len, data,
+        head_size)) ||
+        !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, AUTH_ONLY_TAG_SIZE,
+        tag) ||
+        EVP_DecryptFinal_ex(ctx, data + head_size, &out_len) <= 0) {
+        tool::Logging(my_name_.c_str(), "the data frame fails the "
+            "authentication.\n");
+        return false;
+    }
+
+    if (size == 0) {
+        tool::Logging(my_name_.c_str(), "TLS/SSL peer has closed the connection.\n");
+        auth_only->close_recv = true;
+        // also close this connection
+        if (!auth_only->close_sent) {
+            this->SendFrame(conn, NULL, 0, 0);
+        }
+        return false;
+    }
+    recv_size = size;
+    return true;
+}
+
+/**
+ * @brief switch a connection to the authenticated-only data frames (both
+ * peers switch after the same message), the frames bypass the TLS records
+ * with the keys exported from the TLS session
+ * 
+ * @param conn the connection
+ * @return true success
+ * @return false fail
+ */
+bool SSLConnection::EnableAuthOnly(Conn_t* conn) {
+    SSL* ssl_conn = conn->ssl;
+    // the next frame must be the next bytes of the socket
+    if (SSL_has_pending(ssl_conn) ||
+        BIO_get_ktls_send(SSL_get_wbio(ssl_conn)) ||
+        BIO_get_ktls_recv(SSL_get_rbio(ssl_conn))) {
+        tool::Logging(my_name_.c_str(), "cannot bypass the TLS records of "
+            "this connection.\n");
+        return false;
+    }
+
+    // [client key][server key][client iv][server iv]
+    uint8_t key_buf[(AUTH_ONLY_KEY_SIZE + AUTH_ONLY_IV_SIZE) * 2];
+    if (!SSL_export_keying_material(ssl_conn, key_buf, sizeof(key_buf),
+        AUTH_ONLY_LABEL, strlen(AUTH_ONLY_LABEL), NULL, 0, 0)) {
+        tool::Logging(my_name_.c_str(), "export the frame keys fails.\n");
+        ERR_print_errors_fp(stderr);
+        return false;
+    }
+    uint8_t* client_key = key_buf;
+    uint8_t* server_key = key_buf + AUTH_ONLY_KEY_SIZE;
+    uint8_t* client_iv = key_buf + AUTH_ONLY_KEY_SIZE * 2;
+    uint8_t* server_iv = client_iv + AUTH_ONLY_IV_SIZE;
+    bool is_client = (type_ == IN_CLIENT_SIDE);
+
+    AuthOnly_t* auth_only = new AuthOnly_t;
+    auth_only->send_ctx = EVP_CIPHER_CTX_new();
+    auth_only->recv_ctx = EVP_CIPHER_CTX_new();
+    bool init_stat = EVP_EncryptInit_ex(auth_only->send_ctx,
+        EVP_aes_256_gcm(), NULL, is_client ? client_key : server_key, NULL) &&
+        EVP_DecryptInit_ex(auth_only->recv_ctx, EVP_aes_256_gcm(), NULL,
+        is_client ? server_key : client_key, NULL);
+    memcpy(auth_only->send_iv, is_client ? client_iv : server_iv,
+        AUTH_ONLY_IV_SIZE);
+    memcpy(auth_only->recv_iv, is_client ? server_iv : client_iv,
+        AUTH_ONLY_IV_SIZE);
+    OPENSSL_cleanse(key_buf, sizeof(key_buf));
+    auth_only->send_seq = 0;
+    auth_only->recv_seq = 0;
+    auth_only->enc_buf = NULL;
+    auth_only->enc_buf_size = 0;
+    auth_only->close_sent = false;
+    auth_only->close_recv = false;
+    conn->auth_only = auth_only;
+    if (!init_stat) {
+        tool::Logging(my_name_.c_str(), "init the frame cipher fails.\n");
+        ERR_print_errors_fp(stderr);
+        this->FreeAuthOnly(conn);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief the nonce of a frame: the iv XOR the frame sequence number
+ * 
+ * @param iv the iv of the direction
+ * @param seq the frame sequence number
+ * @param nonce the nonce <ret>
+ */
+void SSLConnection::GetNonce(uint8_t* iv, uint64_t seq, uint8_t* nonce) {
+    memcpy(nonce, iv, AUTH_ONLY_IV_SIZE);
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        nonce[AUTH_ONLY_IV_SIZE - 1 - i] ^= (uint8_t)(seq >> (8 * i));
+    }
+    return ;
+}
+
+/**
+ * @brief free the state of the authenticated-only data frames
+ * 
+ * @param conn the connection
+ */
+void SSLConnection::FreeAuthOnly(Conn_t* conn) {
+    if (conn->auth_only == NULL) {
+        return ;
+    }
+    EVP_CIPHER_CTX_free(conn->auth_only->send_ctx);
+    EVP_CIPHER_CTX_free(conn->auth_only->recv_ctx);
+    free(conn->auth_only->enc_buf);
+    delete conn->auth_only;
+    conn->auth_only = NULL;
+    return ;
+}
+
+/**
+ * @brief Get the smoothed round-trip time of the given connection
+ * (measured by the TCP stack)
+ * 
+ * @param conn the connection
+ * @param rtt the round-trip time (second) <ret>
+ * @return true success
+ * @return false fail
+ */
+bool SSLConnection::GetRTT(Conn_t* conn, double& rtt) {
+    struct tcp_info info;
+    socklen_t info_len = sizeof(info);
+    if (getsockopt(conn->fd, IPPROTO_TCP, TCP_INFO, &info,
+        &info_len) != 0) {
+        return false;
+    }
+    // in microsecond
+    rtt = info.tcpi_rtt / 1000000.0;
     return true;
 }
\ No newline at end of file
@@ -0,0 +1,30 @@
+/**
+ * @file transport_factory.cc
+ * @brief implement the interface defined in transport factory
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "../../include/network/transport_factory.h"
+
+AbsTransport* TransportFactory::CreateTransport(int transport_type, string ip,
+    int port, string unix_path, int type) {
+    switch (transport_type) {
+        case TLS_TRANSPORT: {
+            tool::Logging(my_name_.c_str(), "using TLS over TCP.\n");
+            return new SSLConnection(ip, port, type);
+        }
+        case UNIX_TRANSPORT: {
+            tool::Logging(my_name_.c_str(), "using plain unix-domain socket.\n");
+            return new UnixConnection(unix_path, type);
+        }
+        default: {
+            tool::Logging(my_name_.c_str(), "wrong transport type.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,255 @@
+/**
+ * @file unix_conn.cc
+ * @brief implement the interface of UnixConnection
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "../../include/network/unix_conn.h"
+
+/**
+ * @brief Construct a new UnixConnection object
+ *
+ * @param path the socket path
+ * @param type the type (client/server)
+ */
+UnixConnection::UnixConnection(string path, int type) {
+    socket_path_ = path;
+    type_ = type;
+    if (socket_path_.size() >= sizeof(socket_addr_.sun_path)) {
+        tool::Logging(my_name_.c_str(), "the socket path is too long: %s\n",
+            socket_path_.c_str());
+        exit(EXIT_FAILURE);
+    }
+    memset(&socket_addr_, 0, sizeof(socket_addr_));
+    socket_addr_.sun_family = AF_UNIX;
+    memcpy(socket_addr_.sun_path, socket_path_.c_str(), socket_path_.size());
+
+    switch (type) {
+        case IN_SERVER_SIDE: {
+            listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+            // the socket file of a previous run
+            unlink(socket_path_.c_str());
+            if (bind(listen_fd_, (struct sockaddr*)&socket_addr_,
+                sizeof(socket_addr_)) == -1) {
+                tool::Logging(my_name_.c_str(), "cannot bind to %s: %s\n",
+                    socket_path_.c_str(), strerror(errno));
+                exit(EXIT_FAILURE);
+            }
+            // no TLS, only the owner can connect
+            chmod(socket_path_.c_str(), S_IRUSR | S_IWUSR);
+            if (listen(listen_fd_, SOMAXCONN) == -1) {
+                tool::Logging(my_name_.c_str(), "cannot listen this socket.\n");
+                tool::Logging(my_name_.c_str(), "%s\n", strerror(errno));
+                exit(EXIT_FAILURE);
+            }
+            tool::Logging(my_name_.c_str(), "init the connection to %s\n",
+                socket_path_.c_str());
+            break;
+        }
+        case IN_CLIENT_SIDE: {
+            tool::Logging(my_name_.c_str(), "init the connection to <%s>\n",
+                socket_path_.c_str());
+            break;
+        }
+        default: {
+            tool::Logging(my_name_.c_str(), "error connection type.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/**
+ * @brief Destroy the UnixConnection object
+ *
+ */
+UnixConnection::~UnixConnection() {
+    if (type_ == IN_SERVER_SIDE) {
+        close(listen_fd_);
+        unlink(socket_path_.c_str());
+    }
+}
+
+/**
+ * @brief finalize the connection
+ *
+ * @param conn_pair the pair of the server socket and the connection
+ */
+void UnixConnection::Finish(pair<int, Conn_t*> conn_pair) {
+    if (shutdown(conn_pair.first, SHUT_WR) != 0) {
+        tool::Logging(my_name_.c_str(), "shutdown the socket error: %s\n",
+            strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    // wait the peer to close
+    uint8_t tmp;
+    ssize_t ret;
+    do {
+        ret = read(conn_pair.first, &tmp, sizeof(tmp));
+    } while (ret < 0 && errno == EINTR);
+    if (ret != 0) {
+        tool::Logging(my_name_.c_str(), "receive shutdown flag error.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    tool::Logging(my_name_.c_str(), "shutdown the connection successfully.\n");
+
+    close(conn_pair.first);
+    delete conn_pair.second;
+    return ;
+}
+
+/**
+ * @brief clear the corresponding accepted client socket
+ *
+ * @param conn the accepted client connection
+ */
+void UnixConnection::ClearAcceptedClientSd(Conn_t* conn) {
+    close(conn->fd);
+    delete conn;
+    return ;
+}
+
+/**
+ * @brief connect to the socket path
+ *
+ * @return pair<int, Conn_t*>
+ */
+pair<int, Conn_t*> UnixConnection::Connect() {
+    int socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connect(socket_fd, (struct sockaddr*)&socket_addr_,
+        sizeof(socket_addr_)) < 0) {
+        tool::Logging(my_name_.c_str(), "cannot connect on the socket: %s.\n",
+            strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    return make_pair(socket_fd, new Conn_t{socket_fd, NULL, NULL});
+}
+
+/**
+ * @brief listen to the socket path
+ *
+ * @return pair<int, Conn_t*>
+ */
+pair<int, Conn_t*> UnixConnection::Listen() {
+    int socket_fd = accept(listen_fd_, NULL, NULL);
+    if (socket_fd < 0) {
+        tool::Logging(my_name_.c_str(), "socket listen fails: %s\n",
+            strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    return make_pair(socket_fd, new Conn_t{socket_fd, NULL, NULL});
+}
+
+/**
+ * @brief accept a pending connection without blocking
+ *
+ * @return pair<int, Conn_t*> (-1, NULL) if no connection is pending
+ */
+pair<int, Conn_t*> UnixConnection::AcceptNonBlock() {
+    int socket_fd = accept4(listen_fd_, NULL, NULL, SOCK_NONBLOCK);
+    if (socket_fd < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR &&
+            errno != ECONNABORTED) {
+            tool::Logging(my_name_.c_str(), "socket listen fails: %s\n",
+                strerror(errno));
+        }
+        return make_pair(-1, (Conn_t*)NULL);
+    }
+    return make_pair(socket_fd, new Conn_t{socket_fd, NULL, NULL});
+}
+
+/**
+ * @brief continue to receive a message of a non-blocking connection
+ *
+ * @param conn the connection
+ * @param buf the buffer of [length][data]
+ * @param buf_size the buffer size
+ * @param cur_size the received size in the buffer <ret>
+ * @return int the CONN_STATE_SET
+ */
+int UnixConnection::ReceiveDataNonBlock(Conn_t* conn, uint8_t* buf,
+    uint32_t buf_size, uint32_t& cur_size) {
+    uint32_t msg_size = 0;
+    uint32_t expect_size = sizeof(uint32_t);
+    ssize_t read_stat;
+    while (true) {
+        if (cur_size >= sizeof(uint32_t)) {
+            memcpy(&msg_size, buf, sizeof(uint32_t));
+            if (msg_size > buf_size - sizeof(uint32_t)) {
+                tool::Logging(my_name_.c_str(), "the message is too large: "
+                    "%u\n", msg_size);
+                return CONN_FAIL;
+            }
+            expect_size = sizeof(uint32_t) + msg_size;
+            if (cur_size == expect_size) {
+                return CONN_DONE;
+            }
+        }
+
+        read_stat = read(conn->fd, buf + cur_size, expect_size - cur_size);
+        if (read_stat < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return CONN_WANT_READ;
+            }
+            return CONN_FAIL;
+        }
+        if (read_stat == 0) {
+            // closed before the login
+            return CONN_FAIL;
+        }
+        cur_size += read_stat;
+    }
+}
+
+/**
+ * @brief send the data to the given connection
+ *
+ * @param conn the connection
+ * @param data the pointer to the data buffer
+ * @param size the size of the input data
+ * @return true success
+ * @return false fail
+ */
+bool UnixConnection::SendData(Conn_t* conn, uint8_t* data, uint32_t size) {
+    if (!this->WriteMsg(conn->fd, data, size)) {
+        tool::Logging(my_name_.c_str(), "write the data fails: %s\n",
+            strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief receive the data from the given connection
+ *
+ * @param conn the connection
+ * @param data the pointer to the data buffer
+ * @param recv_size the size of received data <ret>
+ * @return true success
+ * @return false fail
+ */
+bool UnixConnection::ReceiveData(Conn_t* conn, uint8_t* data,
+    uint32_t& recv_size) {
+    uint32_t msg_size = 0;
+    if (!this->ReadFull(conn->fd, (uint8_t*)&msg_size, sizeof(uint32_t)) ||
+        !this->ReadFull(conn->fd, data, msg_size)) {
+        if (errno == 0) {
+            tool::Logging(my_name_.c_str(), "peer has closed the "
+                "connection.\n");
+        } else {
+            tool::Logging(my_name_.c_str(), "read the socket fails: %s\n",
+                strerror(errno));
+        }
+        return false;
+    }
+    recv_size = msg_size;
+    return true;
+}
@@ -30,9 +30,11 @@ DedupDetect::~DedupDetect() {
 /**
  * @brief detect deduplicate chunks
  * 
- * @param info the stat
+ * @param info the stat (the stored address of a duplicate chunk)
+ * @param journal_hdl record the new fp before updating the index (NULL: no
+ * journal)
  */
-void DedupDetect::DetectDuplicate(ChunkInfo_t* info) {
+void DedupDetect::DetectDuplicate(ChunkInfo_t* info, ofstream* journal_hdl) {
     // check the index
     string ret_val;
     if (!fp_2_addr_db_->QueryBuffer((char*)info->fp, CHUNK_HASH_SIZE,
@@ -41,11 +43,19 @@ void DedupDetect::DetectDuplicate(ChunkInfo_t* info) {
         // unique chunk
         info->stat = UNIQUE_CHUNK;
 
+        // the entry is not valid until its container is saved, journal it
+        // so that it can be rolled back after a crash
+        if (journal_hdl != NULL) {
+            journal_hdl->write((char*)info->fp, CHUNK_HASH_SIZE);
+            journal_hdl->flush();
+        }
+
         // update the index with "virtual"
         fp_2_addr_db_->InsertBothBuffer((char*)info->fp, CHUNK_HASH_SIZE,
             (char*)&info->addr, sizeof(KeyForChunkHashDB_t));
     } else {
         info->stat = DUPLICATE_CHUNK;
+        memcpy(&info->addr, &ret_val[0], sizeof(KeyForChunkHashDB_t));
         // // check the corresponding compressed_fp
         // KeyForChunkHashDB_t* addr = (KeyForChunkHashDB_t*)& ret_val[0];
         // if(strcmp((const char*)addr->compressed_fp, (const char*)info->addr.compressed_fp) != 0) {
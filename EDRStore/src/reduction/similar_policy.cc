@@ -21,7 +21,9 @@ bool CmpPair(pair<string, uint32_t>& a,
  * 
  */
 SimilarPolicy::SimilarPolicy() {
-
+    max_delta_depth_ = config.GetMaxDeltaDepth();
+    prefer_local_base_ = config.GetPreferLocalBase();
+    candidate_num_ = config.GetCandidateNum();
 }
 
 /**
@@ -142,6 +144,152 @@ void SimilarPolicy::FindBaseChunk(
     return ;
 }
 
+/**
+ * @brief find the base chunk with the restore cost (bound the delta
+ * chain depth and prefer the co-located base chunk)
+ * 
+ * @param feature_2_fp_db feature to base fp candidates index
+ * @param fp_2_addr_db fp to chunk addr index
+ * @param pending_feature_idx feature to base fp candidates of the session
+ * (not appended yet)
+ * @param pending_addr_idx fp to chunk addr of the session (not appended yet)
+ * @param info chunk info
+ * @param cur_container_id current container id
+ * @param container_cache container cache
+ * @param candidates the ranked base candidates <ret>
+ */
+void SimilarPolicy::FindBaseChunk(AbsDatabase* feature_2_fp_db,
+    AbsDatabase* fp_2_addr_db,
+    unordered_map<uint64_t, string>& pending_feature_idx,
+    unordered_map<string, KeyForChunkHashDB_t>& pending_addr_idx,
+    ChunkInfo_t* info, char* cur_container_id,
+    ReadCache* container_cache, vector<BaseCandidate_t>& candidates) {
+    // query the feature index to get the candidate base chunks
+    // <base fp, index in candidates>
+    unordered_map<string, size_t> candidate_idx;
+    string tmp_base_fps;
+    string tmp_shared_fps;
+    string tmp_base_fp;
+    candidates.clear();
+    for (size_t i = 0; i < SUPER_FEATURE_PER_CHUNK; i++) {
+        // the pending base chunks of the session are the latest ones
+        tmp_base_fps.clear();
+        auto find_pending_ret = pending_feature_idx.find(info->features[i]);
+        if (find_pending_ret != pending_feature_idx.end()) {
+            tmp_base_fps = find_pending_ret->second;
+        }
+        if (feature_2_fp_db->QueryBuffer((char*)&info->features[i],
+            sizeof(uint64_t), tmp_shared_fps)) {
+            tmp_base_fps.append(tmp_shared_fps);
+        }
+
+        size_t fp_num = tmp_base_fps.size() / CHUNK_HASH_SIZE;
+        for (size_t j = 0; j < fp_num; j++) {
+            tmp_base_fp.assign(&tmp_base_fps[j * CHUNK_HASH_SIZE],
+                CHUNK_HASH_SIZE);
+            auto find_idx_ret = candidate_idx.find(tmp_base_fp);
+            if (find_idx_ret != candidate_idx.end()) {
+                candidates[find_idx_ret->second].freq++;
+            } else {
+                candidate_idx[tmp_base_fp] = candidates.size();
+                candidates.push_back({tmp_base_fp, 1,
+                    (uint32_t)(i * 2 * candidate_num_ + j), false, 0});
+            }
+        }
+    }
+
+    // filter out the base chunks with a long delta chain
+    string base_addr_str;
+    KeyForChunkHashDB_t* base_addr;
+    auto it = candidates.begin();
+    while (it != candidates.end()) {
+        auto find_addr_ret = pending_addr_idx.find(it->base_fp);
+        if (find_addr_ret != pending_addr_idx.end()) {
+            base_addr = &find_addr_ret->second;
+        } else if (fp_2_addr_db->QueryBuffer(&it->base_fp[0],
+            CHUNK_HASH_SIZE, base_addr_str)) {
+            base_addr = (KeyForChunkHashDB_t*)&base_addr_str[0];
+        } else {
+            it = candidates.erase(it);
+            continue;
+        }
+        if (!this->IsValidBaseDepth(base_addr)) {
+            it = candidates.erase(it);
+            continue;
+        }
+        it->depth = base_addr->depth;
+        it->is_local = prefer_local_base_ &&
+            this->IsLocalBase(base_addr, cur_container_id, container_cache);
+        it++;
+    }
+
+    if (candidates.empty()) {
+        info->stat = NON_SIMILAR_CHUNK;
+        return ;
+    }
+
+    // rank the candidates: more matched super-features first, then the
+    // co-located one, then the first matched one
+    sort(candidates.begin(), candidates.end(),
+        [](const BaseCandidate_t& a, const BaseCandidate_t& b) {
+            if (a.freq != b.freq) {
+                return a.freq > b.freq;
+            }
+            if (a.is_local != b.is_local) {
+                return a.is_local;
+            }
+            return a.order < b.order;
+        });
+    if (candidates.size() > candidate_num_) {
+        candidates.resize(candidate_num_);
+    }
+
+    memcpy(info->addr.base_fp, candidates[0].base_fp.c_str(), CHUNK_HASH_SIZE);
+    info->addr.depth = candidates[0].depth + 1;
+    info->stat = SIMILAR_CHUNK;
+
+    return ;
+}
+
+/**
+ * @brief check whether the delta chain depth of a base chunk allows
+ * one more level of delta
+ * 
+ * @param base_addr base chunk address
+ * @return true can be used as the base
+ * @return false exceeds the max delta depth
+ */
+bool SimilarPolicy::IsValidBaseDepth(KeyForChunkHashDB_t* base_addr) {
+    if (base_addr->stat == CACHE_DELTA_CHUNK) {
+        // its base chunk may only exist in the inform cache
+        return false;
+    }
+    return ((uint32_t)base_addr->depth + 1) <= max_delta_depth_;
+}
+
+/**
+ * @brief check whether the base chunk is co-located with the input
+ * chunk (i.e., in the current container or the container cache)
+ * 
+ * @param base_addr base chunk address
+ * @param cur_container_id current container id
+ * @param container_cache container cache
+ * @return true co-located
+ * @return false not co-located
+ */
+bool SimilarPolicy::IsLocalBase(KeyForChunkHashDB_t* base_addr,
+    char* cur_container_id, ReadCache* container_cache) {
+    if (memcmp(base_addr->container_id, cur_container_id,
+        CONTAINER_ID_LENGTH) == 0) {
+        return true;
+    }
+
+    string container_name;
+    container_name.assign((char*)base_addr->container_id,
+        CONTAINER_ID_LENGTH);
+    return container_cache->Exist(container_name);
+}
+
 /**
  * @brief update the feature index 
  * 
@@ -174,4 +322,153 @@ void SimilarPolicy::UpdateFeatureIndex(
         feature_2_fp_db[features[i]] = base_fp;
     }
     return ;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief update the feature index with multiple candidates per
+ * super-feature (the latest base chunk first)
+ * 
+ * @param feature_2_fp_db feature to base fp candidates index
+ * @param features chunk feature
+ * @param base_fp base chunk fp
+ */
+void SimilarPolicy::UpdateFeatureCandidates(AbsDatabase* feature_2_fp_db,
+    uint64_t* features, uint8_t* base_fp) {
+    string old_base_fps;
+    string new_base_fps;
+    for (size_t i = 0; i < SUPER_FEATURE_PER_CHUNK; i++) {
+        new_base_fps.assign((char*)base_fp, CHUNK_HASH_SIZE);
+        if (feature_2_fp_db->QueryBuffer((char*)&features[i],
+            sizeof(uint64_t), old_base_fps)) {
+            // keep the latest (candidate_num - 1) old candidates
+            size_t keep_size = min(old_base_fps.size(),
+                (size_t)(candidate_num_ - 1) * CHUNK_HASH_SIZE);
+            new_base_fps.append(old_base_fps, 0, keep_size);
+        }
+        feature_2_fp_db->InsertBothBuffer((char*)&features[i],
+            sizeof(uint64_t), &new_base_fps[0], new_base_fps.size());
+    }
+    return ;
+}
+
+/**
+ * @brief update the feature index with multiple candidates per
+ * super-feature (the latest base chunk first)
+ * 
+ * @param feature_2_fp_db feature to base fp candidates index
+ * @param features chunk feature
+ * @param base_fp base chunk fp
+ */
+void SimilarPolicy::UpdateFeatureCandidates(
+    unordered_map<uint64_t, string>& feature_2_fp_db,
+    uint64_t* features, uint8_t* base_fp) {
+    string new_base_fps;
+    for (size_t i = 0; i < SUPER_FEATURE_PER_CHUNK; i++) {
+        new_base_fps.assign((char*)base_fp, CHUNK_HASH_SIZE);
+        auto find_ret = feature_2_fp_db.find(features[i]);
+        if (find_ret != feature_2_fp_db.end()) {
+            // keep the latest (candidate_num - 1) old candidates
+            size_t keep_size = min(find_ret->second.size(),
+                (size_t)(candidate_num_ - 1) * CHUNK_HASH_SIZE);
+            new_base_fps.append(find_ret->second, 0, keep_size);
+        }
+        feature_2_fp_db[features[i]] = new_base_fps;
+    }
+    return ;
+}
+
+/**
+ * @brief remove a base chunk from the candidates of its features
+ * 
+ * @param feature_2_fp_db feature to base fp candidates index
+ * @param features chunk feature
+ * @param base_fp base chunk fp
+ */
+void SimilarPolicy::RemoveFeatureCandidate(
+    unordered_map<uint64_t, string>& feature_2_fp_db,
+    uint64_t* features, uint8_t* base_fp) {
+    for (size_t i = 0; i < SUPER_FEATURE_PER_CHUNK; i++) {
+        auto find_ret = feature_2_fp_db.find(features[i]);
+        if (find_ret == feature_2_fp_db.end()) {
+            continue;
+        }
+        string& base_fps = find_ret->second;
+        for (size_t off = 0; off < base_fps.size(); off += CHUNK_HASH_SIZE) {
+            if (memcmp(&base_fps[off], base_fp, CHUNK_HASH_SIZE) == 0) {
+                base_fps.erase(off, CHUNK_HASH_SIZE);
+                break;
+            }
+        }
+        if (base_fps.empty()) {
+            feature_2_fp_db.erase(find_ret);
+        }
+    }
+    return ;
+}
+
+/**
+ * @brief compute the sampled fingerprint sketch of a chunk
+ * 
+ * @param data chunk data
+ * @param size chunk size
+ * @param sketch the sorted sampled fingerprints <ret>
+ */
+void SimilarPolicy::ComputeSketch(uint8_t* data, uint32_t size,
+    uint32_t* sketch) {
+    // content-defined sampling over the 8-byte shingles, and keep the
+    // smallest SKETCH_SAMPLE_NUM sampled fingerprints (bottom-k)
+    vector<uint32_t> sample_vec;
+    uint64_t shingle;
+    for (size_t i = 0; i + sizeof(uint64_t) <= size; i++) {
+        memcpy(&shingle, data + i, sizeof(uint64_t));
+        uint32_t sample_fp = (uint32_t)((shingle * FINGERPRINT_PT) >> 32);
+        if ((sample_fp & SKETCH_SAMPLE_MASK) == 0) {
+            sample_vec.push_back(sample_fp);
+        }
+    }
+
+    sort(sample_vec.begin(), sample_vec.end());
+    sample_vec.erase(unique(sample_vec.begin(), sample_vec.end()),
+        sample_vec.end());
+    for (size_t i = 0; i < SKETCH_SAMPLE_NUM; i++) {
+        sketch[i] = (i < sample_vec.size()) ? sample_vec[i] : UINT32_MAX;
+    }
+
+    return ;
+}
+
+/**
+ * @brief estimate the content overlap of two chunks from their sketches
+ * 
+ * @param sketch_a the sketch of chunk a
+ * @param sketch_b the sketch of chunk b
+ * @return double the estimated resemblance in [0, 1]
+ */
+double SimilarPolicy::EstimateOverlap(uint32_t* sketch_a, uint32_t* sketch_b) {
+    // walk the smallest fingerprints of the union, count the shared ones
+    size_t a_idx = 0;
+    size_t b_idx = 0;
+    uint32_t union_num = 0;
+    uint32_t shared_num = 0;
+    while (union_num < SKETCH_SAMPLE_NUM && a_idx < SKETCH_SAMPLE_NUM &&
+        b_idx < SKETCH_SAMPLE_NUM) {
+        if (sketch_a[a_idx] == UINT32_MAX && sketch_b[b_idx] == UINT32_MAX) {
+            break;
+        }
+        if (sketch_a[a_idx] == sketch_b[b_idx]) {
+            shared_num++;
+            a_idx++;
+            b_idx++;
+        } else if (sketch_a[a_idx] < sketch_b[b_idx]) {
+            a_idx++;
+        } else {
+            b_idx++;
+        }
+        union_num++;
+    }
+
+    if (union_num == 0) {
+        return 0;
+    }
+    return (double)shared_num / union_num;
+}
@@ -67,6 +67,12 @@ void CacheCompThd::Run(ClientVar* cur_client) {
                     break;
                 }
                 case UNIQUE_CHUNK: {
+                    if (inform_cache == NULL) {
+                        // non-EDR upload, no inform cache
+                        output_MQ->Push(input_data);
+                        break;
+                    }
+
                     // previous cache is not a insert cache chunk, check cache
 #ifdef EDR_BREAKDOWN
                     gettimeofday(&_cache_delta_stime, NULL);
@@ -135,6 +141,12 @@ void CacheCompThd::Run(ClientVar* cur_client) {
 
                     break;
                 }
+                case VERSION_DELTA_CHUNK:
+                case CHECKPOINT_MARK: {
+                    // directly pass to the writer
+                    output_MQ->Push(input_data);
+                    break;
+                }
                 default: {
                     tool::Logging(my_name_.c_str(), "wrong chunk input type.\n");
                     exit(EXIT_FAILURE);
@@ -10,6 +10,7 @@
  */
 
 #include "../../include/server/client_var.h"
+#include "../../include/server/storage_core.h"
 
 /**
  * @brief Construct a new Client Var object
@@ -18,24 +19,43 @@
  * @param client_ssl the client SSL
  * @param opt_type the operation type (upload / download)
  * @param recipe_path the file recipe path
+ * @param resume_chunk_num the checkpointed chunks to keep in the partial recipe
+ * (upload only, 0: a new upload)
  */
-ClientVar::ClientVar(uint32_t client_id, SSL* client_ssl,
-    int opt_type, string& recipe_path) {
+ClientVar::ClientVar(uint32_t client_id, Conn_t* client_ssl,
+    int opt_type, string& recipe_path, uint64_t resume_chunk_num) {
     // basic info
     _client_id = client_id;
     _client_ssl = client_ssl;
+    _wire_ver = WIRE_FORMAT_FIXED;
+    _auth_only = false;
+    _credit_window = 0;
+    _stripe_ssl.push_back(client_ssl);
+    _stripe_joined = 1;
+    _stripe_seq = 0;
+    _bounded_chunk_num = 0;
+    _switched_base_num = 0;
     opt_type_ = opt_type;
     recipe_path_ = recipe_path;
+    ckpt_path_ = recipe_path_ + config.GetCkptSuffix();
+    journal_path_ = recipe_path_ + config.GetJournalSuffix();
+    resume_chunk_num_ = resume_chunk_num;
+    ckpt_sealed_ = false;
     my_name_ = my_name_ + "-" + to_string(client_id);
 
     // config
     send_chunk_batch_size_ = config.GetSendChunkBatchSize();
+    max_batch_size_ = config.GetMaxBatchSize();
     send_recipe_batch_size_ = config.GetSendRecipeBatchSize();
 
     // init the container cache
     _container_cache = new ReadCache(config.GetContainerCacheSize(),
         MAX_CONTAINER_SIZE);
-    _inform_cache = new InformCache(_client_id);
+    // opened by the ServerOptThd only for the FULL_EDR upload
+    _inform_cache = NULL;
+    // opened by the ServerOptThd only for the fingerprint-first upload
+    _owner_db = NULL;
+    _known_fp_idx = 0;
 
     switch (opt_type_) {
         case UPLOAD_OPT: {
@@ -59,8 +79,13 @@ ClientVar::ClientVar(uint32_t client_id, SSL* client_ssl,
  */
 ClientVar::~ClientVar() {
     delete _container_cache;
-    *_total_cache_size = _inform_cache->DeleteEvictChunk();
-    delete _inform_cache;
+    if (_inform_cache != NULL) {
+        *_total_cache_size = _inform_cache->DeleteEvictChunk();
+        delete _inform_cache;
+    }
+    if (_owner_db != NULL) {
+        delete _owner_db;
+    }
     switch (opt_type_) {
         case UPLOAD_OPT: {
             this->DestroyUploadBuffer();
@@ -82,9 +107,10 @@ void ClientVar::InitUploadBuffer() {
     tool::CreateUUID(_cur_container.id, CONTAINER_ID_LENGTH);
     _cur_container.cur_size = 0;
 
-    // init the recv buffer
-    _recv_chunk_buf.send_buf = (uint8_t*) malloc(2 * send_chunk_batch_size_ * 
-        sizeof(SendChunk_t) + sizeof(NetworkHead_t));
+    // init the recv buffer, a stripe never has more credit than its size
+    _credit_window = 2 * max_batch_size_ * sizeof(SendChunk_t) +
+        sizeof(NetworkHead_t);
+    _recv_chunk_buf.send_buf = (uint8_t*) malloc(_credit_window);
     _recv_chunk_buf.header = (NetworkHead_t*) _recv_chunk_buf.send_buf;
     _recv_chunk_buf.header->client_id = _client_id;
     _recv_chunk_buf.header->size = 0;
@@ -99,15 +125,43 @@ void ClientVar::InitUploadBuffer() {
     _md_ctx = EVP_MD_CTX_new();
     _cipher_ctx = EVP_CIPHER_CTX_new();
 
-    // init the file recipe handler
-    _recipe_write_hdl.open(recipe_path_, ios_base::trunc | ios_base::binary);
+    // init the file recipe handler, keep the previous version readable (the
+    // unchanged files refer to it) until the upload ends
+    string tmp_recipe_path = recipe_path_ + config.GetTmpSuffix();
+    if (resume_chunk_num_ != 0) {
+        // continue the partial recipe after the checkpointed fps
+        filesystem::resize_file(tmp_recipe_path, sizeof(FileRecipeHead_t) +
+            resume_chunk_num_ * CHUNK_HASH_SIZE);
+        _recipe_write_hdl.open(tmp_recipe_path, ios_base::in | ios_base::out |
+            ios_base::binary);
+        _recipe_write_hdl.seekp(0, ios_base::end);
+    } else {
+        filesystem::remove(ckpt_path_);
+        _recipe_write_hdl.open(tmp_recipe_path, ios_base::trunc |
+            ios_base::binary);
+        FileRecipeHead_t v_recipe_end;
+        _recipe_write_hdl.write((char*)&v_recipe_end, sizeof(FileRecipeHead_t));
+    }
     if (!_recipe_write_hdl.is_open()) {
         tool::Logging(my_name_.c_str(), "cannot init recipe file: %s\n",
-            recipe_path_.c_str());
+            tmp_recipe_path.c_str());
+        exit(EXIT_FAILURE);
+    }
+    if (tool::FileExist(recipe_path_)) {
+        _prev_recipe_hdl.open(recipe_path_, ios_base::in | ios_base::binary);
+    }
+    _recipe_chunk_num = resume_chunk_num_;
+    _ckpt_chunk_num = resume_chunk_num_;
+    _recipe_done = false;
+    _resumable = true;
+
+    // the journal of a crashed session is rolled back when the server starts
+    _journal_hdl.open(journal_path_, ios_base::trunc | ios_base::binary);
+    if (!_journal_hdl.is_open()) {
+        tool::Logging(my_name_.c_str(), "cannot init the journal: %s\n",
+            journal_path_.c_str());
         exit(EXIT_FAILURE);
     }
-    FileRecipeHead_t v_recipe_end;
-    _recipe_write_hdl.write((char*)&v_recipe_end, sizeof(FileRecipeHead_t));
 
     // init the recipe buf
     _recipe_batch.buf = (uint8_t*) malloc(send_recipe_batch_size_ * CHUNK_HASH_SIZE);
@@ -118,12 +172,26 @@ void ClientVar::InitUploadBuffer() {
     //     CHUNK_QUEUE_SIZE);
     // _comp_2_writer_mq = wrapped_chunk_mq_factory_.CreateMQ(MQ_TYPE_,
     //     CHUNK_QUEUE_SIZE);
+    // the MQs share the session memory budget
+    uint64_t worker_num = config.GetDeltaWorkerNum();
+    uint64_t queue_size = config.GetSessionMemBudget() * 1024 * 1024 /
+        (UPLOAD_MQ_NUM * sizeof(WrappedChunk_t));
+    queue_size = min(max(queue_size, worker_num), (uint64_t)CHUNK_QUEUE_SIZE);
     _recv_2_dual_mq = wrapped_chunk_mq_factory_.CreateMQ(MQ_TYPE_,
-        CHUNK_QUEUE_SIZE);
+        queue_size);
     _dual_2_comp_mq = wrapped_chunk_mq_factory_.CreateMQ(MQ_TYPE_,
-        CHUNK_QUEUE_SIZE);
+        queue_size);
     _comp_2_writer_mq = wrapped_chunk_mq_factory_.CreateMQ(MQ_TYPE_,
-        CHUNK_QUEUE_SIZE);
+        queue_size);
+
+    // one pair of MQs per delta worker, share the queue size among workers
+    for (size_t i = 0; i < worker_num; i++) {
+        _writer_2_delta_mq.push_back(wrapped_chunk_mq_factory_.CreateMQ(
+            MQ_TYPE_, queue_size / worker_num));
+        _delta_2_append_mq.push_back(wrapped_chunk_mq_factory_.CreateMQ(
+            MQ_TYPE_, queue_size / worker_num));
+    }
+    upload_mq_cap_ = queue_size * 3 + queue_size / worker_num * worker_num * 2;
 
     return ;
 }
@@ -136,6 +204,12 @@ void ClientVar::DestroyUploadBuffer() {
     if (_recipe_write_hdl.is_open()) {
         _recipe_write_hdl.close();
     }
+    if (_prev_recipe_hdl.is_open()) {
+        _prev_recipe_hdl.close();
+    }
+    if (_journal_hdl.is_open()) {
+        _journal_hdl.close();
+    }
     free(_recipe_batch.buf);
     rabin_util_->FreeCtx(_rabin_ctx);
     free(_recv_chunk_buf.send_buf);
@@ -146,6 +220,12 @@ void ClientVar::DestroyUploadBuffer() {
     delete _recv_2_dual_mq;
     delete _dual_2_comp_mq;
     delete _comp_2_writer_mq;
+    for (auto it : _writer_2_delta_mq) {
+        delete it;
+    }
+    for (auto it : _delta_2_append_mq) {
+        delete it;
+    }
     delete rabin_util_;
     return ;
 }
@@ -195,4 +275,177 @@ void ClientVar::DestroyDownloadBuffer() {
     free(_read_recipe_buf);
     delete _reader_2_decoder_mq;
     return ;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief replace the previous recipe with the uploaded one
+ * 
+ */
+void ClientVar::CommitRecipe() {
+    _recipe_write_hdl.close();
+    if (_prev_recipe_hdl.is_open()) {
+        _prev_recipe_hdl.close();
+    }
+    string tmp_recipe_path = recipe_path_ + config.GetTmpSuffix();
+    if (rename(tmp_recipe_path.c_str(), recipe_path_.c_str()) != 0) {
+        tool::Logging(my_name_.c_str(), "cannot commit recipe file: %s\n",
+            recipe_path_.c_str());
+        exit(EXIT_FAILURE);
+    }
+    _recipe_done = true;
+    return ;
+}
+
+/**
+ * @brief wait for the appender to seal the container at the checkpoint
+ * 
+ */
+void ClientVar::WaitSealed() {
+    unique_lock<mutex> lck(ckpt_mtx_);
+    ckpt_cv_.wait(lck, [this] { return ckpt_sealed_; });
+    ckpt_sealed_ = false;
+    return ;
+}
+
+/**
+ * @brief get the occupancy of the upload MQs
+ * 
+ * @return double the ratio of the queued items to the capacity
+ */
+double ClientVar::GetUploadMQOccupancy() {
+    uint64_t item_num = _recv_2_dual_mq->GetSize() +
+        _dual_2_comp_mq->GetSize() + _comp_2_writer_mq->GetSize();
+    for (size_t i = 0; i < _writer_2_delta_mq.size(); i++) {
+        item_num += _writer_2_delta_mq[i]->GetSize() +
+            _delta_2_append_mq[i]->GetSize();
+    }
+    return (double)item_num / upload_mq_cap_;
+}
+
+/**
+ * @brief wait until the upload MQs are at most the occupancy
+ * 
+ * @param occupancy the ratio of the queued items to the capacity
+ */
+void ClientVar::WaitUploadMQ(double occupancy) {
+    unique_lock<mutex> lck(mq_pop_mtx_);
+    while (this->GetUploadMQOccupancy() > occupancy) {
+        // the pops notify without the lock, a missed one is seen at the
+        // timeout
+        mq_pop_cv_.wait_for(lck, chrono::milliseconds(CREDIT_WAIT_INTERVAL));
+    }
+    return ;
+}
+
+/**
+ * @brief notify that a writer stage has popped from the upload MQs
+ * 
+ */
+void ClientVar::NotifyUploadMQPop() {
+    mq_pop_cv_.notify_one();
+    return ;
+}
+
+/**
+ * @brief notify that the container is sealed at the checkpoint
+ * 
+ */
+void ClientVar::NotifySealed() {
+    {
+        lock_guard<mutex> lck(ckpt_mtx_);
+        ckpt_sealed_ = true;
+    }
+    ckpt_cv_.notify_one();
+    return ;
+}
+
+/**
+ * @brief check whether a container is saved
+ * 
+ * @param container_id the container id
+ * @param storage_core the storage core
+ * @return true the container is saved
+ */
+bool ClientVar::IsContainerSaved(const uint8_t* container_id,
+    StorageCore* storage_core) {
+    string container_id_str((char*)container_id, CONTAINER_ID_LENGTH);
+    if (_saved_container_set.find(container_id_str) !=
+        _saved_container_set.end()) {
+        return true;
+    }
+    if (!storage_core->ContainerExist(container_id)) {
+        return false;
+    }
+    _saved_container_set.insert(container_id_str);
+    return true;
+}
+
+/**
+ * @brief persist the partial recipe, the checkpoint stops before the first
+ * chunk whose container is not saved
+ * 
+ * @param fp_2_addr_db the fp to address index
+ * @param storage_core the storage core
+ */
+void ClientVar::SaveCheckpoint(AbsDatabase* fp_2_addr_db,
+    StorageCore* storage_core) {
+    // flush the pending fps of the recipe
+    if (_recipe_batch.cnt != 0) {
+        _recipe_write_hdl.write((char*)_recipe_batch.buf,
+            _recipe_batch.cnt * CHUNK_HASH_SIZE);
+        _recipe_batch.cnt = 0;
+    }
+    _recipe_write_hdl.flush();
+
+    // the chunks of this session are sealed, a duplicate may still be in
+    // the open container of another session and lost in a crash, keep it
+    // for the next checkpoint
+    uint64_t ckpt_chunk_num = _recipe_chunk_num;
+    string addr_str;
+    size_t unsaved_num = 0;
+    for (auto& ref : _unsaved_ref_list) {
+        if (fp_2_addr_db->Query(ref.second, addr_str) &&
+            this->IsContainerSaved(((KeyForChunkHashDB_t*)
+            &addr_str[0])->container_id, storage_core)) {
+            continue;
+        }
+        ckpt_chunk_num = min(ckpt_chunk_num, ref.first);
+        _unsaved_ref_list[unsaved_num] = ref;
+        unsaved_num++;
+    }
+    _unsaved_ref_list.resize(unsaved_num);
+    _ckpt_chunk_num = ckpt_chunk_num;
+
+    // replace the checkpoint file in one step
+    string tmp_ckpt_path = ckpt_path_ + config.GetTmpSuffix();
+    ofstream ckpt_hdl;
+    ckpt_hdl.open(tmp_ckpt_path, ios_base::trunc | ios_base::binary);
+    if (!ckpt_hdl.is_open()) {
+        tool::Logging(my_name_.c_str(), "cannot init the checkpoint: %s\n",
+            tmp_ckpt_path.c_str());
+        exit(EXIT_FAILURE);
+    }
+    ckpt_hdl.write((char*)&_ckpt_chunk_num, sizeof(uint64_t));
+    ckpt_hdl.close();
+    if (rename(tmp_ckpt_path.c_str(), ckpt_path_.c_str()) != 0) {
+        tool::Logging(my_name_.c_str(), "cannot commit the checkpoint: %s\n",
+            ckpt_path_.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    // the journaled fps are in the saved containers now
+    _journal_hdl.close();
+    _journal_hdl.open(journal_path_, ios_base::trunc | ios_base::binary);
+    return ;
+}
+
+/**
+ * @brief remove the checkpoint after the upload ends
+ * 
+ */
+void ClientVar::ClearCheckpoint() {
+    _journal_hdl.close();
+    filesystem::remove(journal_path_);
+    filesystem::remove(ckpt_path_);
+    return ;
+}
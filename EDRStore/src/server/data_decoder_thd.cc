@@ -16,7 +16,7 @@
  * 
  * @param server_channel server channel
  */
-DataDecoderThd::DataDecoderThd(SSLConnection* server_channel) {
+DataDecoderThd::DataDecoderThd(AbsTransport* server_channel) {
     // for config
     send_chunk_batch_size_ = config.GetSendChunkBatchSize();
     send_recipe_batch_size_ = config.GetSendRecipeBatchSize();
@@ -68,11 +68,13 @@ void DataDecoderThd::Run(ClientVar* cur_client) {
 
         if (input_MQ->Pop(tmp_raw_chunk)) {
             gettimeofday(&proc_stime, NULL);
-            this->DecodeChunk(&tmp_raw_chunk, cur_client);
+            bool is_complete = this->DecodeChunk(&tmp_raw_chunk, cur_client);
             gettimeofday(&proc_etime, NULL);
             total_proc_time += tool::GetTimeDiff(proc_stime, proc_etime);
 
-            if (send_chunk_buf->header->cur_item_num % send_chunk_batch_size_ == 0) {
+            // keep a client delta and its base in the same batch
+            if (is_complete && send_chunk_buf->header->cur_item_num %
+                send_chunk_batch_size_ == 0) {
                 this->SendChunks(cur_client);
             }
         }
@@ -98,8 +100,10 @@ void DataDecoderThd::Run(ClientVar* cur_client) {
  * 
  * @param raw_chunk raw chunk
  * @param cur_client current client
+ * @return true a chunk of the recipe is complete
+ * @return false its base follows (a client delta)
  */
-void DataDecoderThd::DecodeChunk(Reader2Decoder_t* raw_chunk,
+bool DataDecoderThd::DecodeChunk(Reader2Decoder_t* raw_chunk,
     ClientVar* cur_client) {
     SendMsgBuffer_t* send_chunk_buf = &cur_client->_send_chunk_buf;
 
@@ -119,12 +123,8 @@ void DataDecoderThd::DecodeChunk(Reader2Decoder_t* raw_chunk,
             
             // write data to the send buf (need perform decompression)
             output_chunk.header.type = COMP_NORMAL_CHUNK;
-            memcpy(send_chunk_buf ->data_buf + send_chunk_buf->header->size,
-                &output_chunk.header, sizeof(SendChunkHeader_t));
-            send_chunk_buf->header->size += sizeof(SendChunkHeader_t);
-            memcpy(send_chunk_buf->data_buf + send_chunk_buf->header->size,
-                output_chunk.data, output_chunk.header.size);
-            send_chunk_buf->header->size += output_chunk.header.size;
+            this->AppendChunk(&output_chunk.header, output_chunk.data,
+                cur_client);
             send_chunk_buf->header->cur_item_num++;
             break;
         }
@@ -134,21 +134,13 @@ void DataDecoderThd::DecodeChunk(Reader2Decoder_t* raw_chunk,
                     // write cache restore delta (do not need to perform decompression)
                     // let the client perform decompression
                     raw_chunk->input_chunk.header.type = CACHE_RESTORE_DELTA;
-                    memcpy(send_chunk_buf->data_buf + send_chunk_buf->header->size,
-                        &raw_chunk->input_chunk.header, sizeof(SendChunkHeader_t));
-                    send_chunk_buf->header->size += sizeof(SendChunkHeader_t);
-                    memcpy(send_chunk_buf->data_buf + send_chunk_buf->header->size,
-                        raw_chunk->input_chunk.data, raw_chunk->input_chunk.header.size);
-                    send_chunk_buf->header->size += raw_chunk->input_chunk.header.size;
+                    this->AppendChunk(&raw_chunk->input_chunk.header,
+                        raw_chunk->input_chunk.data, cur_client);
 
                     // write cache restore base to the send buf
                     raw_chunk->base_chunk.header.type = CACHE_RESTORE_BASE;
-                    memcpy(send_chunk_buf->data_buf + send_chunk_buf->header->size,
-                        &raw_chunk->base_chunk.header, sizeof(SendChunkHeader_t));
-                    send_chunk_buf->header->size += sizeof(SendChunkHeader_t);
-                    memcpy(send_chunk_buf->data_buf + send_chunk_buf->header->size,
-                        raw_chunk->base_chunk.data, raw_chunk->base_chunk.header.size);
-                    send_chunk_buf->header->size += raw_chunk->base_chunk.header.size;
+                    this->AppendChunk(&raw_chunk->base_chunk.header,
+                        raw_chunk->base_chunk.data, cur_client);
                     send_chunk_buf->header->cur_item_num++;
                     break;
                 }
@@ -162,23 +154,15 @@ void DataDecoderThd::DecodeChunk(Reader2Decoder_t* raw_chunk,
             
                     // write data to the send buf
                     output_chunk.header.type = UNCOMP_NORMAL_CHUNK;
-                    memcpy(send_chunk_buf ->data_buf + send_chunk_buf->header->size,
-                        &output_chunk.header, sizeof(SendChunkHeader_t));
-                    send_chunk_buf->header->size += sizeof(SendChunkHeader_t);
-                    memcpy(send_chunk_buf->data_buf + send_chunk_buf->header->size,
-                        output_chunk.data, output_chunk.header.size);
-                    send_chunk_buf->header->size += output_chunk.header.size;
+                    this->AppendChunk(&output_chunk.header, output_chunk.data,
+                        cur_client);
                     send_chunk_buf->header->cur_item_num++;
                     break;
                 }
                 case MULTI_LEVEL_DELTA_CHUNK: {
                     raw_chunk->input_chunk.header.type = MULTI_LEVEL_DELTA_CHUNK;
-                    memcpy(send_chunk_buf->data_buf + send_chunk_buf->header->size,
-                        &raw_chunk->input_chunk.header, sizeof(SendChunkHeader_t));
-                    send_chunk_buf->header->size += sizeof(SendChunkHeader_t);
-                    memcpy(send_chunk_buf->data_buf + send_chunk_buf->header->size,
-                        raw_chunk->input_chunk.data, raw_chunk->input_chunk.header.size);
-                    send_chunk_buf->header->size += raw_chunk->input_chunk.header.size;
+                    this->AppendChunk(&raw_chunk->input_chunk.header,
+                        raw_chunk->input_chunk.data, cur_client);
                     send_chunk_buf->header->cur_item_num++;
                     break;
                 }
@@ -193,21 +177,60 @@ void DataDecoderThd::DecodeChunk(Reader2Decoder_t* raw_chunk,
         case COMP_BASE_CHUNK: {
             // write data to the send buf (need to perform decompression)
             raw_chunk->input_chunk.header.type = COMP_NORMAL_CHUNK;
-            memcpy(send_chunk_buf->data_buf + send_chunk_buf->header->size,
-                &raw_chunk->input_chunk.header, sizeof(SendChunkHeader_t));
-            send_chunk_buf->header->size += sizeof(SendChunkHeader_t);
-            memcpy(send_chunk_buf->data_buf + send_chunk_buf->header->size,
-                raw_chunk->input_chunk.data, raw_chunk->input_chunk.header.size);
-            send_chunk_buf->header->size += raw_chunk->input_chunk.header.size;
+            this->AppendChunk(&raw_chunk->input_chunk.header,
+                raw_chunk->input_chunk.data, cur_client);
             send_chunk_buf->header->cur_item_num++;
             break;
         }
+        case UNCOMP_BASE_CHUNK: {
+            // write data to the send buf (do not need to perform decompression)
+            raw_chunk->input_chunk.header.type = UNCOMP_NORMAL_CHUNK;
+            this->AppendChunk(&raw_chunk->input_chunk.header,
+                raw_chunk->input_chunk.data, cur_client);
+            send_chunk_buf->header->cur_item_num++;
+            break;
+        }
+        case ZERO_RECIPE_CHUNK: {
+            // the client writes a hole (MULTI_LEVEL_DELTA_CHUNK takes the
+            // value of ZERO_CHUNK in the restore batches)
+            this->AppendChunk(&raw_chunk->input_chunk.header,
+                raw_chunk->input_chunk.data, cur_client);
+            send_chunk_buf->header->cur_item_num++;
+            break;
+        }
+        case VERSION_DELTA_CHUNK: {
+            // write the client delta, the client decodes it with the next
+            // chunk (its base)
+            raw_chunk->input_chunk.header.type = CLIENT_RESTORE_DELTA;
+            this->AppendChunk(&raw_chunk->input_chunk.header,
+                raw_chunk->input_chunk.data, cur_client);
+            return false;
+        }
         default: {
             tool::Logging(my_name_.c_str(), "wrong chunk type when sending.\n");
             exit(EXIT_FAILURE);
         }
     }
 
+    return true;
+}
+
+/**
+ * @brief append a chunk to the send buffer in the client wire format
+ * 
+ * @param header the chunk header
+ * @param data the chunk data
+ * @param cur_client current client
+ */
+void DataDecoderThd::AppendChunk(SendChunkHeader_t* header, uint8_t* data,
+    ClientVar* cur_client) {
+    SendMsgBuffer_t* send_chunk_buf = &cur_client->_send_chunk_buf;
+    send_chunk_buf->header->size += wire::EncodeChunkHeader(header,
+        send_chunk_buf->data_buf + send_chunk_buf->header->size,
+        cur_client->_wire_ver);
+    memcpy(send_chunk_buf->data_buf + send_chunk_buf->header->size,
+        data, header->size);
+    send_chunk_buf->header->size += header->size;
     return ;
 }
 
@@ -219,9 +242,16 @@ void DataDecoderThd::DecodeChunk(Reader2Decoder_t* raw_chunk,
 void DataDecoderThd::SendChunks(ClientVar* cur_client) {
     SendMsgBuffer_t* send_chunk_buf = &cur_client->_send_chunk_buf;
     send_chunk_buf->header->msg_type = SERVER_RESTORE_CHUNK;
-    if (!server_channel_->SendData(cur_client->_client_ssl,
+    // the batches go through the stripe connections in round-robin order
+    Conn_t* client_ssl = cur_client->_stripe_ssl[cur_client->_stripe_seq %
+        cur_client->_stripe_ssl.size()];
+    cur_client->_stripe_seq++;
+    // the chunks are encrypted already, only the head of the batch is
+    // encrypted again on the authenticated-only data frames
+    if (!server_channel_->SendPayload(client_ssl,
         send_chunk_buf->send_buf,
-        send_chunk_buf->header->size + sizeof(NetworkHead_t))) {
+        send_chunk_buf->header->size + sizeof(NetworkHead_t),
+        sizeof(NetworkHead_t))) {
         tool::Logging(my_name_.c_str(), "send the restore chunk batch error.\n");
         exit(EXIT_FAILURE);
     }
@@ -242,7 +272,9 @@ void DataDecoderThd::SendChunks(ClientVar* cur_client) {
 void DataDecoderThd::SendEnd(ClientVar* cur_client, string& client_ip) {
     SendMsgBuffer_t* send_chunk_buf = &cur_client->_send_chunk_buf;
     send_chunk_buf->header->msg_type = SERVER_RESTORE_FINAL; 
-    SSL* client_ssl = cur_client->_client_ssl;
+    uint32_t stripe_num = cur_client->_stripe_ssl.size();
+    Conn_t* client_ssl = cur_client->_stripe_ssl[cur_client->_stripe_seq %
+        stripe_num];
 
     if (!server_channel_->SendData(client_ssl, send_chunk_buf->send_buf,
         sizeof(NetworkHead_t))) {
@@ -250,16 +282,22 @@ void DataDecoderThd::SendEnd(ClientVar* cur_client, string& client_ip) {
         exit(EXIT_FAILURE);
     }
 
+    // the client closes the stripes in order, starting from the one of the
+    // end flag
     uint32_t recv_size = 0;
-    if (!server_channel_->ReceiveData(client_ssl, send_chunk_buf->send_buf,
-        recv_size)) {
-        tool::Logging(my_name_.c_str(), "client closed socket connection, thread exits.\n");
-        server_channel_->GetClientIp(client_ip, client_ssl);
-        server_channel_->ClearAcceptedClientSd(client_ssl);
-    } else {
-        tool::Logging(my_name_.c_str(), "client closed the connection error.\n");
-        exit(EXIT_FAILURE);
+    for (uint32_t i = 0; i < stripe_num; i++) {
+        client_ssl = cur_client->_stripe_ssl[(cur_client->_stripe_seq + i) %
+            stripe_num];
+        if (!server_channel_->ReceiveData(client_ssl, send_chunk_buf->send_buf,
+            recv_size)) {
+            server_channel_->GetClientIp(client_ip, client_ssl);
+            server_channel_->ClearAcceptedClientSd(client_ssl);
+        } else {
+            tool::Logging(my_name_.c_str(), "client closed the connection error.\n");
+            exit(EXIT_FAILURE);
+        }
     }
+    tool::Logging(my_name_.c_str(), "client closed socket connection, thread exits.\n");
 
     return ;
 }
\ No newline at end of file
@@ -66,8 +66,15 @@ void DataReaderThd::Run(ClientVar* cur_client) {
         is_end = read_recipe_hdl->eof();
 
         uint8_t* tmp_fp;
+        uint32_t zero_size = 0;
         for (size_t i = 0; i < read_item_num; i++) {
             tmp_fp = read_recipe_buf + CHUNK_HASH_SIZE * i;
+
+            if (wire::IsZeroFp(tmp_fp, zero_size)) {
+                // an all-zero chunk is not stored, send its size
+                this->PushZeroChunk(zero_size, cur_client);
+                continue;
+            }
             
             // cout<<"read file recipe fp: "<<endl;
             // tool::PrintBinaryArray(tmp_fp, CHUNK_HASH_SIZE);
@@ -116,7 +123,8 @@ void DataReaderThd::FetchChunk(uint8_t* fp, ClientVar* cur_client) {
             this->ProcNormalDeltaChunk(addr, &raw_chunk, cur_client);
             break;
         }
-        case COMP_BASE_CHUNK: {
+        case COMP_BASE_CHUNK:
+        case UNCOMP_BASE_CHUNK: {
             // it is a normal base chunk, directly pass
             break;
         }
@@ -125,6 +133,12 @@ void DataReaderThd::FetchChunk(uint8_t* fp, ClientVar* cur_client) {
             this->ProcCacheDeltaChunk(addr, &raw_chunk, cur_client);
             break;
         }
+        case VERSION_DELTA_CHUNK: {
+            // the client decodes it with its base, which follows it
+            cur_client->_reader_2_decoder_mq->Push(raw_chunk);
+            this->FetchChunk(addr->base_fp, cur_client);
+            return ;
+        }
         default: {
             tool::Logging(my_name_.c_str(), "");
             exit(EXIT_FAILURE);
@@ -137,6 +151,21 @@ void DataReaderThd::FetchChunk(uint8_t* fp, ClientVar* cur_client) {
     return ;
 }
 
+/**
+ * @brief push an all-zero chunk (only its size)
+ * 
+ * @param size chunk size
+ * @param cur_client current client
+ */
+void DataReaderThd::PushZeroChunk(uint32_t size, ClientVar* cur_client) {
+    Reader2Decoder_t raw_chunk;
+    raw_chunk.input_chunk.header.type = ZERO_RECIPE_CHUNK;
+    raw_chunk.input_chunk.header.size = sizeof(uint32_t);
+    memcpy(raw_chunk.input_chunk.data, &size, sizeof(uint32_t));
+    cur_client->_reader_2_decoder_mq->Push(raw_chunk);
+    return ;
+}
+
 /**
  * @brief process normal delta chunk
  * 
@@ -173,8 +202,9 @@ void DataReaderThd::ProcCacheDeltaChunk(KeyForChunkHashDB_t* input_addr,
     Reader2Decoder_t* raw_chunk, ClientVar* cur_client) {
     InformCache* inform_cache = cur_client->_inform_cache;
     
-    // first check the cache
-    if (inform_cache->IsBaseChunkExist(input_addr->base_fp)) {
+    // first check the cache (not opened for download sessions)
+    if (inform_cache != NULL &&
+        inform_cache->IsBaseChunkExist(input_addr->base_fp)) {
         // it exists, directly read from cache
         raw_chunk->base_chunk.header.size =
             inform_cache->FetchBaseChunk(input_addr->base_fp,
@@ -233,6 +263,13 @@ void DataReaderThd::ProcCacheDeltaChunk(KeyForChunkHashDB_t* input_addr,
                 raw_chunk->base_chunk.header.type = COMP_BASE_CHUNK;
                 break;
             }
+            case UNCOMP_BASE_CHUNK: {
+                // directly read the uncompressed base chunk
+                storage_core_->ReadChunk(base_addr, raw_chunk->base_chunk.data, cur_client);
+                raw_chunk->base_chunk.header.size = base_addr->len;
+                raw_chunk->base_chunk.header.type = UNCOMP_BASE_CHUNK;
+                break;
+            }
             case CACHE_DELTA_CHUNK: {
                 // TODO: this means multi-level delta should avoid
                 raw_chunk->base_chunk.header.type = MULTI_LEVEL_DELTA_CHUNK;
@@ -16,11 +16,13 @@
  * 
  * @param server_channel the storage server channel
  * @param fp_2_addr_db fp to chunk addr index
+ * @param storage_core the storage core
  */
-DataRecvThd::DataRecvThd(SSLConnection* server_channel,
-    AbsDatabase* fp_2_addr_db) {
+DataRecvThd::DataRecvThd(AbsTransport* server_channel,
+    AbsDatabase* fp_2_addr_db, StorageCore* storage_core) {
     server_channel_ = server_channel;
     fp_2_addr_db_ = fp_2_addr_db;
+    storage_core_ = storage_core;
     dedup_util_ = new DedupDetect(fp_2_addr_db_);
     send_chunk_batch_size_ = config.GetSendChunkBatchSize();
     send_recipe_batch_size_ = config.GetSendRecipeBatchSize();
@@ -50,7 +52,10 @@ void DataRecvThd::Run(ClientVar* cur_client) {
     uint32_t recv_size = 0;
     string client_ip;
     SendMsgBuffer_t* recv_chunk_buf = &cur_client->_recv_chunk_buf;
-    SSL* client_ssl = cur_client->_client_ssl;
+    Conn_t* client_ssl = cur_client->_client_ssl;
+    // the batches arrive on the stripe connections in round-robin order
+    vector<Conn_t*>& stripe_ssl = cur_client->_stripe_ssl;
+    uint32_t stripe_num = stripe_ssl.size();
 
     struct timeval stime;
     struct timeval etime;
@@ -63,8 +68,11 @@ void DataRecvThd::Run(ClientVar* cur_client) {
     gettimeofday(&stime, NULL);
     // -------- main process --------
 
+    uint32_t stripe_id = 0;
     while (true) {
         // receive data
+        stripe_id = cur_client->_stripe_seq % stripe_num;
+        client_ssl = stripe_ssl[stripe_id];
         if (!server_channel_->ReceiveData(client_ssl, recv_chunk_buf->send_buf, 
             recv_size)) {
             tool::Logging(my_name_.c_str(), "client closed socket connection, thread exits.\n");
@@ -75,8 +83,10 @@ void DataRecvThd::Run(ClientVar* cur_client) {
             gettimeofday(&proc_stime, NULL);
             switch (recv_chunk_buf->header->msg_type) {
                 case CLIENT_UPLOAD_CHUNK: {
+                    this->TakeCredit(cur_client, stripe_id, recv_size);
                     _chunk_batch_num++;
                     this->ProcessChunks(cur_client);
+                    cur_client->_stripe_seq++;
                     break;
                 }
                 case CLIENT_UPLOAD_RECIPE: {
@@ -85,12 +95,31 @@ void DataRecvThd::Run(ClientVar* cur_client) {
                 }
                 case CLIENT_UPLOAD_RECIPE_END: {
                     this->ProcessRecipeEnd(cur_client);
+                    cur_client->_stripe_seq++;
+                    break;
+                }
+                case CLIENT_UPLOAD_RECIPE_REF: {
+                    this->ProcessRecipeRef(cur_client);
+                    cur_client->_stripe_seq++;
                     break;
                 }
                 case CLIENT_UPLOAD_FEATURE: {
                     this->ProcessEvictFeature(cur_client);
                     break;
                 }
+                case CLIENT_UPLOAD_FP: {
+                    this->ProcessFpQuery(cur_client, client_ssl);
+                    break;
+                }
+                case CLIENT_UPLOAD_CHECKPOINT: {
+                    this->ProcessCheckpoint(cur_client, client_ssl);
+                    cur_client->_stripe_seq++;
+                    break;
+                }
+                case CLIENT_CREDIT_REQUEST: {
+                    this->ProcessCreditRequest(cur_client, stripe_id);
+                    break;
+                }
                 default: {
                     tool::Logging(my_name_.c_str(), "wrong recv data type.\n");
                     exit(EXIT_FAILURE);
@@ -101,10 +130,52 @@ void DataRecvThd::Run(ClientVar* cur_client) {
         }
     }
 
+    // the other stripes are closed after the client finishes (a stripe may
+    // still ask for credit before it closes)
+    for (uint32_t i = 1; i < stripe_num; i++) {
+        stripe_id = (cur_client->_stripe_seq + i) % stripe_num;
+        client_ssl = stripe_ssl[stripe_id];
+        while (server_channel_->ReceiveData(client_ssl,
+            recv_chunk_buf->send_buf, recv_size)) {
+            if (recv_chunk_buf->header->msg_type != CLIENT_CREDIT_REQUEST) {
+                tool::Logging(my_name_.c_str(), "recv data after the recipe "
+                    "end.\n");
+                exit(EXIT_FAILURE);
+            }
+            this->ProcessCreditRequest(cur_client, stripe_id);
+        }
+        server_channel_->ClearAcceptedClientSd(client_ssl);
+    }
+
     cur_client->_recv_2_dual_mq->_done = true;
     gettimeofday(&etime, NULL);
     total_running_time += tool::GetTimeDiff(stime, etime);
 
+    if (cur_client->_owner_db != NULL) {
+        tool::Logging(my_name_.c_str(), "skipped chunk num: %lu, skipped data "
+            "size: %lu\n", _total_skip_chunk_num, _total_skip_data_size);
+    }
+    if (_total_ref_chunk_num != 0) {
+        tool::Logging(my_name_.c_str(), "chunk num copied from the previous "
+            "recipes: %lu\n", _total_ref_chunk_num);
+    }
+    if (_total_ckpt_num != 0) {
+        tool::Logging(my_name_.c_str(), "checkpoint num: %lu\n",
+            _total_ckpt_num);
+    }
+    if (_total_credit_grant_num != 0) {
+        tool::Logging(my_name_.c_str(), "credit grant num: %lu, held by the "
+            "full MQs: %lu\n", _total_credit_grant_num,
+            _total_credit_stall_num);
+    }
+    if (_total_zero_chunk_num != 0) {
+        tool::Logging(my_name_.c_str(), "zero chunk num: %lu, zero data size: "
+            "%lu\n", _total_zero_chunk_num, _total_zero_data_size);
+    }
+    if (_total_version_delta_num != 0) {
+        tool::Logging(my_name_.c_str(), "unique delta num against the "
+            "previous version: %lu\n", _total_version_delta_num);
+    }
     tool::Logging(my_name_.c_str(), "thread (%s) exits, total proc time: %lf, "
         "total running time: %lf\n", client_ip.c_str(), total_proc_time,
         total_running_time);
@@ -122,7 +193,8 @@ void DataRecvThd::ProcessChunks(ClientVar* cur_client) {
     AbsMQ<WrappedChunk_t>* output_MQ = cur_client->_recv_2_dual_mq;
     uint32_t recv_chunk_num = recv_chunk_buf->header->cur_item_num;
     uint32_t offset = 0;
-    SendChunkHeader_t* chunk_header_ptr;
+    SendChunkHeader_t chunk_header;
+    uint32_t wire_ver = cur_client->_wire_ver;
     uint8_t* data_buf = recv_chunk_buf->data_buf;
     EVP_MD_CTX* md_ctx = cur_client->_md_ctx;
     uint8_t* chunk_data;
@@ -132,13 +204,13 @@ void DataRecvThd::ProcessChunks(ClientVar* cur_client) {
     uint8_t dual_fp_buf[CHUNK_HASH_SIZE * 2];
 
     while (cur_chunk_num != recv_chunk_num) {
-        chunk_header_ptr = (SendChunkHeader_t*)(data_buf + offset);
-        offset += sizeof(SendChunkHeader_t);
+        offset += wire::DecodeChunkHeader(data_buf + offset, &chunk_header,
+            wire_ver);
         chunk_data = data_buf + offset;
 
-        switch (chunk_header_ptr->type) {
+        switch (chunk_header.type) {
             case FULL_EDR_CACHE_CHUNK: {
-                tmp_chunk.info.size = chunk_header_ptr->size;
+                tmp_chunk.info.size = chunk_header.size;
 
 #ifdef EDR_BREAKDOWN
                 gettimeofday(&_cipher_fp_stime, NULL);
@@ -159,20 +231,20 @@ void DataRecvThd::ProcessChunks(ClientVar* cur_client) {
                 memcpy(tmp_chunk.data, chunk_data, tmp_chunk.info.size);
 
                 // copy the cipher feature from the client
-                memcpy(tmp_chunk.info.features, chunk_header_ptr->cipher_features,
+                memcpy(tmp_chunk.info.features, chunk_header.cipher_features,
                     sizeof(uint64_t) * SUPER_FEATURE_PER_CHUNK);
 
                 // mark this chunk is for cache insertion
                 tmp_chunk.info.stat = CACHE_INSERT_CHUNK;
 
-                offset += chunk_header_ptr->size;
+                offset += chunk_header.size;
 
                 // -------- read the later compressed normal chunk --------
-                chunk_header_ptr = (SendChunkHeader_t*)(data_buf + offset);
-                offset += sizeof(SendChunkHeader_t);
+                offset += wire::DecodeChunkHeader(data_buf + offset,
+                    &chunk_header, wire_ver);
                 chunk_data = data_buf + offset;
 
-                uint32_t comp_size = chunk_header_ptr->size;
+                uint32_t comp_size = chunk_header.size;
 
 #ifdef EDR_BREAKDOWN
                 gettimeofday(&_cipher_fp_stime, NULL);
@@ -202,11 +274,13 @@ void DataRecvThd::ProcessChunks(ClientVar* cur_client) {
                 _total_dual_fp_data_size += CHUNK_HASH_SIZE * 2;
 #endif
 
+                this->RecordOwner(cur_client, tmp_chunk.info.fp);
+
                 // insert the chunk for cache
                 output_MQ->Push(tmp_chunk);
 
                 // prepare for the compressed chunk
-                tmp_chunk.info.size = chunk_header_ptr->size;
+                tmp_chunk.info.size = chunk_header.size;
 
                 // insert chunk to the next thd for dedup
                 // copy the data to the tmp chunk
@@ -216,7 +290,7 @@ void DataRecvThd::ProcessChunks(ClientVar* cur_client) {
 
                 this->ProcessRecipe(cur_client, tmp_chunk.info.fp);
 
-                offset += chunk_header_ptr->size;
+                offset += chunk_header.size;
 
                 // update stat
                 _total_logical_chunk_num++;
@@ -226,8 +300,8 @@ void DataRecvThd::ProcessChunks(ClientVar* cur_client) {
             }
             case FULL_EDR_UNCOMPRESS_CHUNK: {
                 // it is a normal chunk
-                tmp_chunk.info.size = chunk_header_ptr->size;
-                memcpy(dual_fp_buf + CHUNK_HASH_SIZE, chunk_header_ptr->compressed_fp,
+                tmp_chunk.info.size = chunk_header.size;
+                memcpy(dual_fp_buf + CHUNK_HASH_SIZE, chunk_header.compressed_fp,
                     CHUNK_HASH_SIZE);
 
 #ifdef EDR_BREAKDOWN
@@ -256,17 +330,19 @@ void DataRecvThd::ProcessChunks(ClientVar* cur_client) {
 #endif
 
 
+                this->RecordOwner(cur_client, tmp_chunk.info.fp);
+
                 // insert into the next thd for dedup
                 tmp_chunk.info.stat = SINGLE_CHUNK;
                 memcpy(tmp_chunk.data, chunk_data, tmp_chunk.info.size);
                 // copy the cipher feature from the client
-                memcpy(tmp_chunk.info.features, chunk_header_ptr->cipher_features,
+                memcpy(tmp_chunk.info.features, chunk_header.cipher_features,
                     sizeof(uint64_t) * SUPER_FEATURE_PER_CHUNK);
                 output_MQ->Push(tmp_chunk);
 
                 this->ProcessRecipe(cur_client, tmp_chunk.info.fp);
 
-                offset += chunk_header_ptr->size;
+                offset += chunk_header.size;
 
                 // update stat
                 _total_logical_chunk_num++;
@@ -276,7 +352,7 @@ void DataRecvThd::ProcessChunks(ClientVar* cur_client) {
             }
             case NORMAL_CHUNK: {
                 // it is a normal chunk
-                tmp_chunk.info.size = chunk_header_ptr->size;
+                tmp_chunk.info.size = chunk_header.size;
 
 #ifdef EDR_BREAKDOWN
                 gettimeofday(&_cipher_fp_stime, NULL);
@@ -286,6 +362,7 @@ void DataRecvThd::ProcessChunks(ClientVar* cur_client) {
                     tmp_chunk.info.size, tmp_chunk.info.fp);
 
                 memset(tmp_chunk.info.addr.compressed_fp, 0, CHUNK_HASH_SIZE);
+                this->RecordOwner(cur_client, tmp_chunk.info.fp);
 
 #ifdef EDR_BREAKDOWN
                 gettimeofday(&_cipher_fp_etime, NULL);
@@ -299,12 +376,16 @@ void DataRecvThd::ProcessChunks(ClientVar* cur_client) {
 #endif
 
                 // perform deduplication
-                dedup_util_->DetectDuplicate(&tmp_chunk.info);
+                dedup_util_->DetectDuplicate(&tmp_chunk.info,
+                    &cur_client->_journal_hdl);
 
 #ifdef EDR_BREAKDOWN
                 gettimeofday(&_dedup_etime, NULL);
                 _total_dedup_time += tool::GetTimeDiff(_dedup_stime, _dedup_etime);
 #endif
+                if (tmp_chunk.info.stat == DUPLICATE_CHUNK) {
+                    this->RecordRef(cur_client, &tmp_chunk.info);
+                }
 
                 this->ProcessRecipe(cur_client, tmp_chunk.info.fp);
 
@@ -334,7 +415,7 @@ void DataRecvThd::ProcessChunks(ClientVar* cur_client) {
                     _total_unique_chunk_num++;
                     _total_unique_data_size += tmp_chunk.info.size;
                 }
-                offset += chunk_header_ptr->size;
+                offset += chunk_header.size;
 
                 // update stat
                 _total_logical_chunk_num++;
@@ -342,6 +423,97 @@ void DataRecvThd::ProcessChunks(ClientVar* cur_client) {
 
                 break;
             }
+            case CLIENT_DELTA_CHUNK: {
+                // a delta against a chunk of the previous version, encrypted
+                // by the client
+                tmp_chunk.info.size = chunk_header.size;
+                crypto_util_->GenerateHash(md_ctx, chunk_data,
+                    tmp_chunk.info.size, tmp_chunk.info.fp);
+
+                // the base is restored with the delta, it must be stored
+                string base_addr_str;
+                if (!fp_2_addr_db_->QueryBuffer((char*)chunk_header.base_fp,
+                    CHUNK_HASH_SIZE, base_addr_str)) {
+                    tool::Logging(my_name_.c_str(), "the base chunk of the "
+                        "client delta not exists.\n");
+                    exit(EXIT_FAILURE);
+                }
+
+                memset(tmp_chunk.info.addr.compressed_fp, 0, CHUNK_HASH_SIZE);
+                this->RecordOwner(cur_client, tmp_chunk.info.fp);
+
+                // perform deduplication
+                dedup_util_->DetectDuplicate(&tmp_chunk.info,
+                    &cur_client->_journal_hdl);
+                if (tmp_chunk.info.stat == DUPLICATE_CHUNK) {
+                    this->RecordRef(cur_client, &tmp_chunk.info);
+                }
+
+                this->ProcessRecipe(cur_client, tmp_chunk.info.fp);
+
+                if (tmp_chunk.info.stat == UNIQUE_CHUNK) {
+                    // no similarity detection on the server
+                    tmp_chunk.info.stat = VERSION_DELTA_CHUNK;
+                    memcpy(tmp_chunk.info.addr.base_fp, chunk_header.base_fp,
+                        CHUNK_HASH_SIZE);
+                    memcpy(tmp_chunk.data, chunk_data, tmp_chunk.info.size);
+                    output_MQ->Push(tmp_chunk);
+
+                    // update stat
+                    _total_unique_chunk_num++;
+                    _total_unique_data_size += tmp_chunk.info.size;
+                    _total_version_delta_num++;
+                }
+                offset += chunk_header.size;
+
+                // update stat
+                _total_logical_chunk_num++;
+                _total_logical_data_size += tmp_chunk.info.size;
+
+                break;
+            }
+            case ZERO_CHUNK: {
+                // an all-zero chunk, only recorded in the recipe
+                uint32_t zero_size = 0;
+                memcpy(&zero_size, chunk_data, sizeof(uint32_t));
+                uint8_t zero_fp[CHUNK_HASH_SIZE];
+                wire::MakeZeroFp(zero_size, zero_fp);
+                this->ProcessRecipe(cur_client, zero_fp);
+
+                offset += chunk_header.size;
+
+                // update stat
+                _total_logical_chunk_num++;
+                _total_logical_data_size += zero_size;
+                _total_zero_chunk_num++;
+                _total_zero_data_size += zero_size;
+
+                break;
+            }
+            case FP_REF_CHUNK: {
+                // a known chunk of this client, the payload is skipped
+                if (cur_client->_known_fp_idx ==
+                    cur_client->_known_fp_list.size()) {
+                    tool::Logging(my_name_.c_str(), "no known chunk for the "
+                        "reference.\n");
+                    exit(EXIT_FAILURE);
+                }
+                FpQuery_t* known_fp = &cur_client->_known_fp_list[
+                    cur_client->_known_fp_idx];
+                cur_client->_known_fp_idx++;
+
+                this->ProcessRecipe(cur_client, known_fp->fp);
+
+                offset += chunk_header.size;
+
+                // update stat
+                _total_logical_chunk_num++;
+                _total_logical_data_size += known_fp->size;
+                _total_skip_chunk_num++;
+                _total_skip_data_size += known_fp->size;
+
+                break;
+            }
             default: {
                 tool::Logging(my_name_.c_str(), "recv chunk type error.\n");
                 exit(EXIT_FAILURE);
@@ -372,6 +544,67 @@ void DataRecvThd::ProcessRecipeEnd(ClientVar* cur_client) {
     recipe_write_hdl->seekp(0, ios_base::beg);
     recipe_write_hdl->write((char*)recv_chunk_buf->data_buf,
         recv_chunk_buf->header->size);
+    cur_client->CommitRecipe();
+    return ;
+}
+
+/**
+ * @brief copy the ranges of the previous recipe (unchanged files)
+ * 
+ * @param cur_client current client
+ */
+void DataRecvThd::ProcessRecipeRef(ClientVar* cur_client) {
+    SendMsgBuffer_t* recv_chunk_buf = &cur_client->_recv_chunk_buf;
+    ifstream* prev_recipe_hdl = &cur_client->_prev_recipe_hdl;
+    ofstream* recipe_write_hdl = &cur_client->_recipe_write_hdl;
+    uint32_t ref_num = recv_chunk_buf->header->cur_item_num;
+    RecipeRef_t* ref_list = (RecipeRef_t*)recv_chunk_buf->data_buf;
+
+    if (!prev_recipe_hdl->is_open()) {
+        tool::Logging(my_name_.c_str(), "recv recipe ranges without the "
+            "previous recipe.\n");
+        exit(EXIT_FAILURE);
+    }
+    FileRecipeHead_t prev_head;
+    prev_recipe_hdl->seekg(0, ios_base::beg);
+    prev_recipe_hdl->read((char*)&prev_head, sizeof(FileRecipeHead_t));
+
+    // flush the pending fps, then reuse the recipe buf to copy
+    uint8_t* recipe_buf_base = cur_client->_recipe_batch.buf;
+    if (cur_client->_recipe_batch.cnt != 0) {
+        recipe_write_hdl->write((char*)recipe_buf_base,
+            cur_client->_recipe_batch.cnt * CHUNK_HASH_SIZE);
+        cur_client->_recipe_batch.cnt = 0;
+    }
+
+    uint64_t copy_num = 0;
+    for (uint32_t i = 0; i < ref_num; i++) {
+        if (ref_list[i].offset + ref_list[i].chunk_num > prev_head.chunk_num) {
+            tool::Logging(my_name_.c_str(), "recipe range out of the previous "
+                "recipe.\n");
+            exit(EXIT_FAILURE);
+        }
+        prev_recipe_hdl->seekg(sizeof(FileRecipeHead_t) + ref_list[i].offset *
+            CHUNK_HASH_SIZE, ios_base::beg);
+        for (uint64_t j = 0; j < ref_list[i].chunk_num; j += copy_num) {
+            copy_num = min(ref_list[i].chunk_num - j, send_recipe_batch_size_);
+            prev_recipe_hdl->read((char*)recipe_buf_base,
+                copy_num * CHUNK_HASH_SIZE);
+            if ((uint64_t)prev_recipe_hdl->gcount() != copy_num * CHUNK_HASH_SIZE) {
+                tool::Logging(my_name_.c_str(), "read the previous recipe "
+                    "error.\n");
+                exit(EXIT_FAILURE);
+            }
+            recipe_write_hdl->write((char*)recipe_buf_base,
+                copy_num * CHUNK_HASH_SIZE);
+        }
+        _total_ref_chunk_num += ref_list[i].chunk_num;
+        cur_client->_recipe_chunk_num += ref_list[i].chunk_num;
+    }
+
+    // the copied ranges are not in the chunk stream of the client, keep the
+    // last checkpoint if the upload is interrupted now
+    cur_client->_resumable = false;
     return ;
 }
 
@@ -390,6 +623,7 @@ void DataRecvThd::ProcessRecipe(ClientVar* cur_client, uint8_t* fp) {
         fp, CHUNK_HASH_SIZE);
     
     cur_client->_recipe_batch.cnt++;
+    cur_client->_recipe_chunk_num++;
 
     if (cur_client->_recipe_batch.cnt % send_recipe_batch_size_ == 0) {
         recipe_write_hdl->write((char*)recipe_buf_base, 
@@ -433,4 +667,186 @@ void DataRecvThd::ProcessEvictFeature(ClientVar* cur_client) {
     }
 
     return ;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief answer the fp queries with a bitmap of the chunks to send
+ * 
+ * @param cur_client current client
+ * @param client_ssl the connection of the query
+ */
+void DataRecvThd::ProcessFpQuery(ClientVar* cur_client, Conn_t* client_ssl) {
+    SendMsgBuffer_t* recv_chunk_buf = &cur_client->_recv_chunk_buf;
+    uint32_t query_num = recv_chunk_buf->header->cur_item_num;
+    FpQuery_t* query = (FpQuery_t*)recv_chunk_buf->data_buf;
+    AbsDatabase* owner_db = cur_client->_owner_db;
+
+    if (owner_db == NULL) {
+        tool::Logging(my_name_.c_str(), "recv fp queries without the "
+            "fingerprint-first upload.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (cur_client->_known_fp_idx != cur_client->_known_fp_list.size()) {
+        tool::Logging(my_name_.c_str(), "known chunks of the last query are "
+            "not referenced.\n");
+        exit(EXIT_FAILURE);
+    }
+    cur_client->_known_fp_list.clear();
+    cur_client->_known_fp_idx = 0;
+
+    // bit = 1: the server needs the payload. A chunk is known only if this
+    // client uploaded it before (other clients' chunks are never revealed) and
+    // it is still in the index
+    vector<uint8_t> bitmap(tool::DivCeil(query_num, 8), 0);
+    string tmp_value;
+    for (uint32_t i = 0; i < query_num; i++) {
+        if (owner_db->QueryBuffer((char*)query[i].fp, CHUNK_HASH_SIZE,
+            tmp_value) && fp_2_addr_db_->QueryBuffer((char*)query[i].fp,
+            CHUNK_HASH_SIZE, tmp_value)) {
+            cur_client->_known_fp_list.push_back(query[i]);
+        } else {
+            bitmap[i / 8] |= (1 << (i % 8));
+        }
+    }
+
+    recv_chunk_buf->header->msg_type = SERVER_FP_BITMAP;
+    recv_chunk_buf->header->size = bitmap.size();
+    memcpy(recv_chunk_buf->data_buf, bitmap.data(), bitmap.size());
+    if (!server_channel_->SendData(client_ssl,
+        recv_chunk_buf->send_buf, sizeof(NetworkHead_t) +
+        recv_chunk_buf->header->size)) {
+        tool::Logging(my_name_.c_str(), "send the fp bitmap error.\n");
+        exit(EXIT_FAILURE);
+    }
+    return ;
+}
+
+/**
+ * @brief seal the stored chunks, persist the partial recipe and acknowledge
+ * the checkpointed chunk num
+ * 
+ * @param cur_client current client
+ * @param client_ssl the connection of the checkpoint
+ */
+void DataRecvThd::ProcessCheckpoint(ClientVar* cur_client, Conn_t* client_ssl) {
+    SendMsgBuffer_t* recv_chunk_buf = &cur_client->_recv_chunk_buf;
+
+    // the marker follows the received chunks through all stages, the
+    // appender seals the current container when it arrives
+    WrappedChunk_t mark_chunk;
+    mark_chunk.info.stat = CHECKPOINT_MARK;
+    mark_chunk.info.addr.stat = CHECKPOINT_MARK;
+    mark_chunk.info.size = 0;
+    cur_client->_recv_2_dual_mq->Push(mark_chunk);
+    cur_client->WaitSealed();
+
+    cur_client->SaveCheckpoint(fp_2_addr_db_, storage_core_);
+    _total_ckpt_num++;
+
+    recv_chunk_buf->header->msg_type = SERVER_CHECKPOINT_ACK;
+    recv_chunk_buf->header->cur_item_num = 0;
+    recv_chunk_buf->header->size = sizeof(uint64_t);
+    memcpy(recv_chunk_buf->data_buf, &cur_client->_ckpt_chunk_num,
+        sizeof(uint64_t));
+    if (!server_channel_->SendData(client_ssl, recv_chunk_buf->send_buf,
+        sizeof(NetworkHead_t) + recv_chunk_buf->header->size)) {
+        tool::Logging(my_name_.c_str(), "send the checkpoint ack error.\n");
+        exit(EXIT_FAILURE);
+    }
+    return ;
+}
+
+/**
+ * @brief take the credit of a chunk batch
+ * 
+ * @param cur_client current client
+ * @param stripe_id the stripe of the batch
+ * @param batch_size the batch size
+ */
+void DataRecvThd::TakeCredit(ClientVar* cur_client, uint32_t stripe_id,
+    uint32_t batch_size) {
+    if (cur_client->_credit_window == 0) {
+        return ;
+    }
+    uint64_t& credit = cur_client->_stripe_credit[stripe_id];
+    if (batch_size > credit) {
+        tool::Logging(my_name_.c_str(), "the batch exceeds the credit of "
+            "stripe %u.\n", stripe_id);
+        exit(EXIT_FAILURE);
+    }
+    credit -= batch_size;
+    return ;
+}
+
+/**
+ * @brief top up the credit of a stripe to the window once the upload MQs
+ * have room
+ * 
+ * @param cur_client current client
+ * @param stripe_id the stripe of the request
+ */
+void DataRecvThd::ProcessCreditRequest(ClientVar* cur_client,
+    uint32_t stripe_id) {
+    if (cur_client->_credit_window == 0) {
+        tool::Logging(my_name_.c_str(), "credit request without the flow "
+            "control.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // hold the grant while the MQs are more than half full, the client stops
+    // at the end of its credit instead of filling the socket buffers
+    if (cur_client->GetUploadMQOccupancy() > CREDIT_GRANT_OCCUPANCY) {
+        _total_credit_stall_num++;
+        cur_client->WaitUploadMQ(CREDIT_GRANT_OCCUPANCY);
+    }
+
+    SendMsgBuffer_t* recv_chunk_buf = &cur_client->_recv_chunk_buf;
+    uint64_t grant = cur_client->_credit_window -
+        cur_client->_stripe_credit[stripe_id];
+    cur_client->_stripe_credit[stripe_id] = cur_client->_credit_window;
+    _total_credit_grant_num++;
+
+    recv_chunk_buf->header->msg_type = SERVER_CREDIT_GRANT;
+    recv_chunk_buf->header->cur_item_num = 0;
+    recv_chunk_buf->header->size = sizeof(uint64_t);
+    memcpy(recv_chunk_buf->data_buf, &grant, sizeof(uint64_t));
+    if (!server_channel_->SendData(cur_client->_stripe_ssl[stripe_id],
+        recv_chunk_buf->send_buf, sizeof(NetworkHead_t) +
+        recv_chunk_buf->header->size)) {
+        tool::Logging(my_name_.c_str(), "send the credit grant error.\n");
+        exit(EXIT_FAILURE);
+    }
+    return ;
+}
+
+/**
+ * @brief record that the client has uploaded a chunk
+ * 
+ * @param cur_client current client
+ * @param fp chunk fp
+ */
+void DataRecvThd::RecordOwner(ClientVar* cur_client, uint8_t* fp) {
+    if (cur_client->_owner_db != NULL) {
+        uint8_t owned = 1;
+        cur_client->_owner_db->InsertBothBuffer((char*)fp, CHUNK_HASH_SIZE,
+            (char*)&owned, sizeof(uint8_t));
+    }
+    return ;
+}
+
+/**
+ * @brief record a duplicate chunk whose container may not be saved, it is
+ * checked again at the checkpoint
+ * 
+ * @param cur_client current client
+ * @param info the duplicate chunk
+ */
+void DataRecvThd::RecordRef(ClientVar* cur_client, ChunkInfo_t* info) {
+    if (cur_client->IsContainerSaved(info->addr.container_id, storage_core_)) {
+        return ;
+    }
+    cur_client->_unsaved_ref_list.push_back(make_pair(
+        cur_client->_recipe_chunk_num, string((char*)info->fp,
+        CHUNK_HASH_SIZE)));
+    return ;
+}
@@ -25,6 +25,12 @@ DataWriterThd::DataWriterThd(AbsDatabase* fp_2_addr_db,
     storage_core_ = storage_core;
     delta_comp_ = new DeltaComp();
     similar_policy_ = new SimilarPolicy();
+    min_predicted_gain_ = config.GetMinPredictedGain();
+    if (similar_policy_->GetCandidateNum() > 1) {
+        DatabaseFactory db_factory;
+        fp_2_sketch_db_ = db_factory.CreateDatabase(IN_MEMORY_DB,
+            config.GetFeature2FpDBName() + config.GetSketchSuffix());
+    }
 }
 
 /**
@@ -34,16 +40,20 @@ DataWriterThd::DataWriterThd(AbsDatabase* fp_2_addr_db,
 DataWriterThd::~DataWriterThd() {
     delete delta_comp_;
     delete similar_policy_;
+    delete fp_2_sketch_db_;
 }
 
 /**
- * @brief the main process
+ * @brief the main process (dispatch the chunks to the delta workers in order)
  * 
  * @param cur_client current client var
  */
 void DataWriterThd::Run(ClientVar* cur_client) {
     tool::Logging(my_name_.c_str(), "the main thread is running.\n");
     AbsMQ<WrappedChunk_t>* input_MQ = cur_client->_comp_2_writer_mq;
+    vector<AbsMQ<WrappedChunk_t>*>& output_MQ = cur_client->_writer_2_delta_mq;
+    size_t worker_num = output_MQ.size();
+    uint64_t dispatch_cnt = 0;
 
     struct timeval stime;
     struct timeval etime;
@@ -53,6 +63,11 @@ void DataWriterThd::Run(ClientVar* cur_client) {
     struct timeval proc_etime;
     double total_proc_time = 0;
 
+    // for top-k base candidates
+    vector<BaseCandidate_t> candidates;
+    uint32_t input_sketch[SKETCH_SAMPLE_NUM];
+    bool use_sketch = (fp_2_sketch_db_ != NULL);
+
     gettimeofday(&stime, NULL);
     // -------- main process --------
     WrappedChunk_t tmp_data;
@@ -64,6 +79,7 @@ void DataWriterThd::Run(ClientVar* cur_client) {
         }
 
         if (input_MQ->Pop(tmp_data)) {
+            cur_client->NotifyUploadMQPop();
             // check the base chunk
             gettimeofday(&proc_stime, NULL);
             switch (tmp_data.info.stat) {
@@ -71,23 +87,74 @@ void DataWriterThd::Run(ClientVar* cur_client) {
                     this->ProcCacheDeltaChunk(&tmp_data, cur_client);
                     break;
                 }
+                case CHECKPOINT_MARK: {
+                    // no index update, keep its order to the appender
+                    output_MQ[dispatch_cnt % worker_num]->Push(tmp_data);
+                    dispatch_cnt++;
+                    continue;
+                }
+                case VERSION_DELTA_CHUNK: {
+                    // encoded by the client against its base, never a base
+                    // of the other chunks
+                    tmp_data.info.addr.stat = VERSION_DELTA_CHUNK;
+                    tmp_data.info.addr.depth = 1;
+                    break;
+                }
                 case UNIQUE_CHUNK: {
-                    similar_policy_->FindBaseChunk(feature_2_fp_db_,
-                        &tmp_data.info);
+                    {
+                        // the locality check reads the container cache
+                        lock_guard<mutex> lck(cur_client->_storage_mtx);
+                        lock_guard<mutex> pending_lck(
+                            cur_client->_pending_base_mtx);
+                        similar_policy_->FindBaseChunk(feature_2_fp_db_,
+                            fp_2_addr_db_, cur_client->_pending_feature_idx,
+                            cur_client->_pending_addr_idx, &tmp_data.info,
+                            cur_client->_cur_container.id,
+                            cur_client->_container_cache, candidates);
+                    }
                     switch (tmp_data.info.stat) {
                         case SIMILAR_CHUNK: {
+                            if (use_sketch && candidates.size() > 1) {
+                                similar_policy_->ComputeSketch(tmp_data.data,
+                                    tmp_data.info.size, input_sketch);
+                                this->SelectBaseCandidate(&tmp_data,
+                                    candidates, input_sketch, cur_client);
+                            }
                             _total_similar_chunk_num++;
                             _total_similar_data_size += tmp_data.info.size;
-                            this->ProcSimilarChunk(&tmp_data, cur_client);
+                            tmp_data.info.addr.stat = COMP_DELTA_CHUNK;
                             break;
                         }
                         case NON_SIMILAR_CHUNK: {
-                            this->ProcNonSimilarChunk(&tmp_data, cur_client);
-                            similar_policy_->UpdateFeatureIndex(
-                                feature_2_fp_db_,
-                                tmp_data.info.features,
-                                tmp_data.info.fp
-                            );
+                            tmp_data.info.addr.stat = COMP_BASE_CHUNK;
+                            tmp_data.info.addr.depth = 0;
+
+                            // it can be the base of the following chunks of
+                            // this session before it is appended to the
+                            // container (the other sessions see it after)
+                            if (use_sketch) {
+                                similar_policy_->ComputeSketch(tmp_data.data,
+                                    tmp_data.info.size, input_sketch);
+                            }
+                            {
+                                lock_guard<mutex> lck(
+                                    cur_client->_pending_base_mtx);
+                                cur_client->_pending_base_idx[string(
+                                    (char*)tmp_data.info.fp, CHUNK_HASH_SIZE)]
+                                    .assign((char*)tmp_data.data,
+                                    tmp_data.info.size);
+                                similar_policy_->UpdateFeatureCandidates(
+                                    cur_client->_pending_feature_idx,
+                                    tmp_data.info.features,
+                                    tmp_data.info.fp);
+                                if (use_sketch) {
+                                    cur_client->_pending_sketch_idx[string(
+                                        (char*)tmp_data.info.fp,
+                                        CHUNK_HASH_SIZE)].assign(
+                                        (char*)input_sketch,
+                                        sizeof(uint32_t) * SKETCH_SAMPLE_NUM);
+                                }
+                            }
                             break;
                         }
                         default: {
@@ -105,15 +172,177 @@ void DataWriterThd::Run(ClientVar* cur_client) {
                 }
             }
 
-            // update the fp index
-            fp_2_addr_db_->InsertBothBuffer((char*)tmp_data.info.fp, CHUNK_HASH_SIZE,
-                (char*)&tmp_data.info.addr, sizeof(KeyForChunkHashDB_t));
-            
+            // record the chunk type and depth for this session, the
+            // appender publishes the chunk with its container address
+            {
+                lock_guard<mutex> lck(cur_client->_pending_base_mtx);
+                cur_client->_pending_addr_idx[string((char*)tmp_data.info.fp,
+                    CHUNK_HASH_SIZE)] = tmp_data.info.addr;
+            }
+
+            // round-robin, the appender collects the chunks in the same order
+            output_MQ[dispatch_cnt % worker_num]->Push(tmp_data);
+            dispatch_cnt++;
+
             gettimeofday(&proc_etime, NULL);
             total_proc_time += tool::GetTimeDiff(proc_stime, proc_etime);
         }
     }
 
+    for (auto it : output_MQ) {
+        it->_done = true;
+    }
+
+    gettimeofday(&etime, NULL);
+    total_running_time += tool::GetTimeDiff(stime, etime);
+
+    tool::Logging(my_name_.c_str(), "cache delta chunks stored as base "
+        "to bound the delta chain: %lu\n", cur_client->_bounded_chunk_num);
+    tool::Logging(my_name_.c_str(), "similar chunks switched to a better "
+        "base candidate: %lu\n", cur_client->_switched_base_num);
+    tool::Logging(my_name_.c_str(), "thread exits, total proc time: %lf, "
+        "total running time: %lf\n", total_proc_time, total_running_time);
+
+    return ;
+}
+
+/**
+ * @brief the delta worker (fetch the base chunk and perform delta encoding)
+ * 
+ * @param cur_client current client var
+ * @param worker_id the worker id
+ */
+void DataWriterThd::RunDeltaWorker(ClientVar* cur_client, uint32_t worker_id) {
+    tool::Logging(my_name_.c_str(), "delta worker %u is running.\n", worker_id);
+    AbsMQ<WrappedChunk_t>* input_MQ = cur_client->_writer_2_delta_mq[worker_id];
+    AbsMQ<WrappedChunk_t>* output_MQ = cur_client->_delta_2_append_mq[worker_id];
+
+    struct timeval stime;
+    struct timeval etime;
+    double total_running_time = 0;
+
+    gettimeofday(&stime, NULL);
+    // -------- main process --------
+    WrappedChunk_t tmp_data;
+    while (true) {
+        // extract a chunk from the MQ
+        if (input_MQ->_done && input_MQ->IsEmpty()) {
+            break;
+        }
+
+        if (input_MQ->Pop(tmp_data)) {
+            switch (tmp_data.info.addr.stat) {
+                case COMP_DELTA_CHUNK: {
+                    this->ProcSimilarChunk(&tmp_data, cur_client);
+                    break;
+                }
+                case UNCOMP_BASE_CHUNK: {
+                    this->RestoreCacheDeltaChunk(&tmp_data, cur_client);
+                    break;
+                }
+                case COMP_BASE_CHUNK:
+                case CACHE_DELTA_CHUNK:
+                case VERSION_DELTA_CHUNK:
+                case CHECKPOINT_MARK: {
+                    // directly pass to the appender
+                    break;
+                }
+                default: {
+                    tool::Logging(my_name_.c_str(),
+                        "wrong chunk type in delta worker.\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            output_MQ->Push(tmp_data);
+        }
+    }
+
+    output_MQ->_done = true;
+    gettimeofday(&etime, NULL);
+    total_running_time += tool::GetTimeDiff(stime, etime);
+
+    tool::Logging(my_name_.c_str(), "delta worker %u exits, total running "
+        "time: %lf\n", worker_id, total_running_time);
+
+    return ;
+}
+
+/**
+ * @brief the container appender (write the chunks to containers in order)
+ * 
+ * @param cur_client current client var
+ */
+void DataWriterThd::RunAppender(ClientVar* cur_client) {
+    tool::Logging(my_name_.c_str(), "the appender is running.\n");
+    vector<AbsMQ<WrappedChunk_t>*>& input_MQ = cur_client->_delta_2_append_mq;
+    size_t worker_num = input_MQ.size();
+    uint64_t append_cnt = 0;
+
+    struct timeval stime;
+    struct timeval etime;
+    double total_running_time = 0;
+
+    gettimeofday(&stime, NULL);
+    // -------- main process --------
+    WrappedChunk_t tmp_data;
+    string fp_str;
+    while (true) {
+        // follow the dispatch order
+        AbsMQ<WrappedChunk_t>* cur_MQ = input_MQ[append_cnt % worker_num];
+        if (cur_MQ->_done && cur_MQ->IsEmpty()) {
+            tool::Logging(my_name_.c_str(), "no chunk in the MQ, all jobs are done.\n");
+            break;
+        }
+
+        if (cur_MQ->Pop(tmp_data)) {
+            cur_client->NotifyUploadMQPop();
+            if (tmp_data.info.addr.stat == CHECKPOINT_MARK) {
+                // all chunks before the checkpoint are appended
+                this->SealContainer(cur_client);
+                append_cnt++;
+                continue;
+            }
+
+            {
+                lock_guard<mutex> lck(cur_client->_storage_mtx);
+                storage_core_->WriteChunk(&tmp_data.info.addr, tmp_data.data,
+                    tmp_data.info.size, cur_client);
+            }
+
+            // update the fp index, the address is valid now
+            fp_2_addr_db_->InsertBothBuffer((char*)tmp_data.info.fp, CHUNK_HASH_SIZE,
+                (char*)&tmp_data.info.addr, sizeof(KeyForChunkHashDB_t));
+            if (tmp_data.info.addr.stat == COMP_DELTA_CHUNK) {
+                _total_delta_size += tmp_data.info.size;
+            }
+            bool is_base = (tmp_data.info.addr.stat == COMP_BASE_CHUNK);
+
+            fp_str.assign((char*)tmp_data.info.fp, CHUNK_HASH_SIZE);
+            {
+                lock_guard<mutex> lck(cur_client->_pending_base_mtx);
+                cur_client->_pending_addr_idx.erase(fp_str);
+                if (is_base && cur_client->_pending_base_idx.erase(fp_str)) {
+                    // the base chunk can be read from the container now,
+                    // the other sessions may pick it up
+                    auto find_sketch_ret =
+                        cur_client->_pending_sketch_idx.find(fp_str);
+                    if (find_sketch_ret !=
+                        cur_client->_pending_sketch_idx.end()) {
+                        fp_2_sketch_db_->Insert(fp_str,
+                            find_sketch_ret->second);
+                        cur_client->_pending_sketch_idx.erase(find_sketch_ret);
+                    }
+                    similar_policy_->UpdateFeatureCandidates(feature_2_fp_db_,
+                        tmp_data.info.features, tmp_data.info.fp);
+                    similar_policy_->RemoveFeatureCandidate(
+                        cur_client->_pending_feature_idx,
+                        tmp_data.info.features, tmp_data.info.fp);
+                }
+            }
+            append_cnt++;
+        }
+    }
+
     // check the tail container
     if (cur_client->_cur_container.cur_size != 0) {
         storage_core_->SaveContainer(&cur_client->_cur_container);
@@ -122,8 +351,8 @@ void DataWriterThd::Run(ClientVar* cur_client) {
     gettimeofday(&etime, NULL);
     total_running_time += tool::GetTimeDiff(stime, etime);
 
-    tool::Logging(my_name_.c_str(), "thread exits, total proc time: %lf, "
-        "total running time: %lf\n", total_proc_time, total_running_time);
+    tool::Logging(my_name_.c_str(), "the appender exits, total running "
+        "time: %lf\n", total_running_time);
 
     return ;
 }
@@ -138,67 +367,125 @@ void DataWriterThd::ProcSimilarChunk(WrappedChunk_t* input_chunk,
     ClientVar* cur_client) {
     uint8_t base_chunk[ENC_MAX_CHUNK_SIZE];
     uint32_t base_chunk_size = 0;
-    uint8_t delta_chunk[ENC_MAX_CHUNK_SIZE];
     uint32_t delta_chunk_size = 0;
+#ifdef EDR_BREAKDOWN
+    struct timeval comp_delta_stime;
+    struct timeval comp_delta_etime;
+#endif
 
     base_chunk_size = this->FetchBaseChunk(input_chunk->info.addr.base_fp,
         base_chunk, cur_client);
 
     if(base_chunk_size == 0){
         // avoid delta, directly write
-        storage_core_->WriteChunk(&input_chunk->info.addr, input_chunk->data,
-        input_chunk->info.size, cur_client);
+        input_chunk->info.addr.stat = COMP_BASE_CHUNK;
+        input_chunk->info.addr.depth = 0;
+        return ;
     }
 
 #ifdef EDR_BREAKDOWN
-    gettimeofday(&_comp_delta_stime, NULL);
+    gettimeofday(&comp_delta_stime, NULL);
 #endif
 
+    uint8_t delta_chunk[ENC_MAX_CHUNK_SIZE];
     delta_chunk_size = delta_comp_->DeltaEncode(base_chunk, base_chunk_size,
         input_chunk->data, input_chunk->info.size, delta_chunk);
 
-    storage_core_->WriteChunk(&input_chunk->info.addr, delta_chunk,
-        delta_chunk_size, cur_client);
-    input_chunk->info.addr.stat = COMP_DELTA_CHUNK;
-
-    // update stat
-    _total_delta_size += delta_chunk_size;
-
 #ifdef EDR_BREAKDOWN
-    gettimeofday(&_comp_delta_etime, NULL);
-    _total_comp_delta_time += tool::GetTimeDiff(_comp_delta_stime,
-        _comp_delta_etime);
-    _total_comp_delta_data_size += input_chunk->info.size;
+    gettimeofday(&comp_delta_etime, NULL);
+    {
+        lock_guard<mutex> lck(stat_mtx_);
+        _total_comp_delta_time += tool::GetTimeDiff(comp_delta_stime,
+            comp_delta_etime);
+        _total_comp_delta_data_size += input_chunk->info.size;
+    }
 #endif
 
+    // replace the chunk data with the delta chunk
+    memcpy(input_chunk->data, delta_chunk, delta_chunk_size);
+    input_chunk->info.size = delta_chunk_size;
+
     return ;
 }
 
 /**
- * @brief process a non-similar chunk 
+ * @brief process a cache delta chunk (decide how to store it)
  * 
  * @param input_chunk input chunk
  * @param cur_client current client
  */
-void DataWriterThd::ProcNonSimilarChunk(WrappedChunk_t* input_chunk,
+void DataWriterThd::ProcCacheDeltaChunk(WrappedChunk_t* input_chunk,
     ClientVar* cur_client) {
-    storage_core_->WriteChunk(&input_chunk->info.addr, input_chunk->data,
-        input_chunk->info.size, cur_client);
-    input_chunk->info.addr.stat = COMP_BASE_CHUNK;
+    // check the delta chain depth of its base chunk in the store, the
+    // base chunk may be evicted from the inform cache before restore
+    KeyForChunkHashDB_t base_addr_buf;
+    KeyForChunkHashDB_t* base_addr = &base_addr_buf;
+    input_chunk->info.addr.stat = CACHE_DELTA_CHUNK;
+    input_chunk->info.addr.depth = 1;
+    if (this->QueryChunkAddr(input_chunk->info.addr.base_fp, base_addr,
+        cur_client)) {
+        if (!similar_policy_->IsValidBaseDepth(base_addr)) {
+            // avoid the multi-level delta chunk, store the uncompressed
+            // chunk as a base chunk instead
+            input_chunk->info.addr.stat = UNCOMP_BASE_CHUNK;
+            input_chunk->info.addr.depth = 0;
+            cur_client->_bounded_chunk_num++;
+            return ;
+        }
+        input_chunk->info.addr.depth = base_addr->depth + 1;
+    }
+
     return ;
 }
 
 /**
- * @brief process a cache delta chunk
+ * @brief query the address of a chunk (the chunks not appended yet are only
+ * known to this session)
+ * 
+ * @param fp the chunk fp
+ * @param addr the chunk address <ret>
+ * @param cur_client current client
+ * @return true found
+ * @return false not found
+ */
+bool DataWriterThd::QueryChunkAddr(uint8_t* fp, KeyForChunkHashDB_t* addr,
+    ClientVar* cur_client) {
+    string fp_str((char*)fp, CHUNK_HASH_SIZE);
+    {
+        lock_guard<mutex> lck(cur_client->_pending_base_mtx);
+        auto find_ret = cur_client->_pending_addr_idx.find(fp_str);
+        if (find_ret != cur_client->_pending_addr_idx.end()) {
+            *addr = find_ret->second;
+            return true;
+        }
+    }
+
+    string addr_str;
+    if (!fp_2_addr_db_->QueryBuffer((char*)fp, CHUNK_HASH_SIZE, addr_str)) {
+        return false;
+    }
+    memcpy(addr, &addr_str[0], sizeof(KeyForChunkHashDB_t));
+    return true;
+}
+
+/**
+ * @brief restore the uncompressed chunk from a cache delta chunk
  * 
  * @param input_chunk input chunk
  * @param cur_client current client
  */
-void DataWriterThd::ProcCacheDeltaChunk(WrappedChunk_t* input_chunk,
+void DataWriterThd::RestoreCacheDeltaChunk(WrappedChunk_t* input_chunk,
     ClientVar* cur_client) {
-    storage_core_->WriteChunk(&input_chunk->info.addr, input_chunk->data,
-        input_chunk->info.size, cur_client);
-    input_chunk->info.addr.stat = CACHE_DELTA_CHUNK;
+    uint8_t base_chunk[ENC_MAX_CHUNK_SIZE];
+    uint8_t restore_chunk[ENC_MAX_CHUNK_SIZE];
+    uint32_t base_chunk_size = cur_client->_inform_cache->FetchBaseChunk(
+        input_chunk->info.addr.base_fp, base_chunk);
+    uint32_t restore_chunk_size = delta_comp_->DeltaDecode(
+        base_chunk, base_chunk_size, input_chunk->data,
+        input_chunk->info.size, restore_chunk);
+
+    memcpy(input_chunk->data, restore_chunk, restore_chunk_size);
+    input_chunk->info.size = restore_chunk_size;
     return ;
 }
 
@@ -212,21 +499,126 @@ void DataWriterThd::ProcCacheDeltaChunk(WrappedChunk_t* input_chunk,
  */
 uint32_t DataWriterThd::FetchBaseChunk(uint8_t* base_fp, uint8_t* base_data,
     ClientVar* cur_client) {
+    string base_fp_str((char*)base_fp, CHUNK_HASH_SIZE);
     string base_addr_str;
 
-    // step-1: query the fp index to get the base chunk address
+    // step-1: check the base chunks not appended yet
+    {
+        lock_guard<mutex> lck(cur_client->_pending_base_mtx);
+        auto find_ret = cur_client->_pending_base_idx.find(base_fp_str);
+        if (find_ret != cur_client->_pending_base_idx.end()) {
+            memcpy(base_data, find_ret->second.c_str(),
+                find_ret->second.size());
+            return find_ret->second.size();
+        }
+    }
+
+    // step-2: query the fp index to get the base chunk address
     if (!fp_2_addr_db_->QueryBuffer((char*)base_fp, CHUNK_HASH_SIZE, base_addr_str)) {
         tool::Logging(my_name_.c_str(), "req base chunk not exits.\n");
         exit(EXIT_FAILURE);
     }
 
-    // step-2: read base chunk from the disk
+    // step-3: read base chunk from the disk
     KeyForChunkHashDB_t* base_addr = (KeyForChunkHashDB_t*)&base_addr_str[0];
-    bool read = storage_core_->ReadChunk(base_addr, base_data, cur_client);
+    bool read = false;
+    {
+        lock_guard<mutex> lck(cur_client->_storage_mtx);
+        read = storage_core_->ReadChunk(base_addr, base_data, cur_client);
+    }
     
     if(read == false){
         return 0;
     }
 
     return base_addr->len;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief save the current container and make the index updates durable (at a
+ * checkpoint)
+ * 
+ * @param cur_client current client
+ */
+void DataWriterThd::SealContainer(ClientVar* cur_client) {
+    {
+        lock_guard<mutex> lck(cur_client->_storage_mtx);
+        Container_t* cur_container = &cur_client->_cur_container;
+        if (cur_container->cur_size != 0) {
+            storage_core_->SaveContainer(cur_container);
+            cur_container->cur_size = 0;
+            tool::CreateUUID(cur_container->id, CONTAINER_ID_LENGTH);
+        }
+    }
+
+    fp_2_addr_db_->Sync();
+    feature_2_fp_db_->Sync();
+    if (cur_client->_owner_db != NULL) {
+        cur_client->_owner_db->Sync();
+    }
+    cur_client->NotifySealed();
+    return ;
+}
+
+/**
+ * @brief select the base candidate with the smallest predicted delta size
+ * 
+ * @param input_chunk input chunk
+ * @param candidates the ranked base candidates
+ * @param input_sketch the sketch of the input chunk
+ * @param cur_client current client
+ */
+void DataWriterThd::SelectBaseCandidate(WrappedChunk_t* input_chunk,
+    vector<BaseCandidate_t>& candidates, uint32_t* input_sketch,
+    ClientVar* cur_client) {
+    string base_sketch_str;
+    uint32_t chunk_size = input_chunk->info.size;
+    uint64_t default_delta_size = 0;
+    uint64_t best_delta_size = UINT64_MAX;
+    size_t best_idx = 0;
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+        // the sketch of a base chunk not appended yet is in the session
+        bool is_pending = false;
+        {
+            lock_guard<mutex> lck(cur_client->_pending_base_mtx);
+            auto find_ret = cur_client->_pending_sketch_idx.find(
+                candidates[i].base_fp);
+            if (find_ret != cur_client->_pending_sketch_idx.end()) {
+                base_sketch_str = find_ret->second;
+                is_pending = true;
+            }
+        }
+        if ((!is_pending && !fp_2_sketch_db_->QueryBuffer(
+            &candidates[i].base_fp[0], CHUNK_HASH_SIZE, base_sketch_str)) ||
+            base_sketch_str.size() != sizeof(uint32_t) * SKETCH_SAMPLE_NUM) {
+            if (i == 0) {
+                // cannot compare with the majority-vote base
+                return ;
+            }
+            continue;
+        }
+
+        // predicted delta size: the non-overlapped part of the input chunk
+        double overlap = similar_policy_->EstimateOverlap(input_sketch,
+            (uint32_t*)&base_sketch_str[0]);
+        uint64_t predicted_delta_size = chunk_size * (1 - overlap);
+        if (i == 0) {
+            default_delta_size = predicted_delta_size;
+        }
+        if (predicted_delta_size < best_delta_size) {
+            best_delta_size = predicted_delta_size;
+            best_idx = i;
+        }
+    }
+
+    if (best_idx != 0 &&
+        (default_delta_size - best_delta_size) >= min_predicted_gain_) {
+        memcpy(input_chunk->info.addr.base_fp,
+            candidates[best_idx].base_fp.c_str(), CHUNK_HASH_SIZE);
+        input_chunk->info.addr.depth = candidates[best_idx].depth + 1;
+        cur_client->_switched_base_num++;
+    }
+
+    return ;
+}
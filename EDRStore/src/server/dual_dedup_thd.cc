@@ -60,7 +60,8 @@ void DualDedupThd::Run(ClientVar* cur_client) {
 #ifdef EDR_BREAKDOWN
                 gettimeofday(&_dedup_stime, NULL);
 #endif
-                    dedup_util_->DetectDuplicate(&input_data.info);
+                    dedup_util_->DetectDuplicate(&input_data.info,
+                        &cur_client->_journal_hdl);
 #ifdef EDR_BREAKDOWN
                 gettimeofday(&_dedup_etime, NULL);
                 _total_dedup_time += tool::GetTimeDiff(_dedup_stime, _dedup_etime);
@@ -95,7 +96,8 @@ void DualDedupThd::Run(ClientVar* cur_client) {
 #ifdef EDR_BREAKDOWN
                 gettimeofday(&_dedup_stime, NULL);
 #endif
-                    dedup_util_->DetectDuplicate(&input_data.info);
+                    dedup_util_->DetectDuplicate(&input_data.info,
+                        &cur_client->_journal_hdl);
 #ifdef EDR_BREAKDOWN
                 gettimeofday(&_dedup_etime, NULL);
                 _total_dedup_time += tool::GetTimeDiff(_dedup_stime, _dedup_etime);
@@ -120,6 +122,14 @@ void DualDedupThd::Run(ClientVar* cur_client) {
                     output_MQ->Push(input_data);
                     break;
                 }
+                case UNIQUE_CHUNK:
+                case VERSION_DELTA_CHUNK:
+                case CHECKPOINT_MARK: {
+                    // deduplicated by the receiver, directly pass to the
+                    // next thd
+                    output_MQ->Push(input_data);
+                    break;
+                }
                 default: {
                     tool::Logging(my_name_.c_str(), "wrong chunk input type.\n");
                     exit(EXIT_FAILURE);
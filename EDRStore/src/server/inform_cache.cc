@@ -10,21 +10,37 @@
  */
 
 #include "../../include/server/inform_cache.h"
+#include "../../include/server/storage_core.h"
 
 /**
  * @brief Construct a new InformCache object
  * 
  * @param client_id client id
+ * @param cache_store the shared cache store
+ * @param storage_core the storage core
+ * @param cur_client the current client
  */
-InformCache::InformCache(uint32_t client_id) {
+InformCache::InformCache(uint32_t client_id, RocksdbCFStore* cache_store,
+    StorageCore* storage_core, ClientVar* cur_client) {
     client_id_ = client_id;
     cache_root_path_ = config.GetCacheRootPath();
-    this->LoadCntIdx();
-
-    DatabaseFactory db_factory;
-    string db_path = cache_root_path_ + to_string(client_id_) + "_db";
-    base_2_data_db_ = db_factory.CreateDatabase(ROCKSDB_DB,
-        db_path);
+    storage_core_ = storage_core;
+    cur_client_ = cur_client;
+    cache_container_ = new Container_t;
+    cache_container_->cur_size = 0;
+    tool::CreateUUID(cache_container_->id, CONTAINER_ID_LENGTH);
+
+    // open the column families of this client
+    string cf_prefix = "client_" + to_string(client_id_);
+    base_2_entry_db_ = cache_store->GetColumnFamily(cf_prefix + "_ref");
+    feature_2_fp_db_ = cache_store->GetColumnFamily(cf_prefix + "_idx");
+
+    string cache_stat_str;
+    if (base_2_entry_db_->Query(cache_stat_key_, cache_stat_str)) {
+        memcpy(&feature_num_, &cache_stat_str[0], sizeof(uint64_t));
+        memcpy(&cache_data_size_, &cache_stat_str[sizeof(uint64_t)],
+            sizeof(uint64_t));
+    }
     
     finesse_util_ = new FinesseUtil(SUPER_FEATURE_PER_CHUNK,
         FEATURE_PER_CHUNK, FEATURE_PER_SUPER_FEATURE);
@@ -34,7 +50,6 @@ InformCache::InformCache(uint32_t client_id) {
     similar_policy_ = new SimilarPolicy();
 
     delta_comp_ = new DeltaComp(); 
-    cache_base_chunk_str_.reserve(ENC_MAX_CHUNK_SIZE);
 }
 
 /**
@@ -42,8 +57,19 @@ InformCache::InformCache(uint32_t client_id) {
  * 
  */
 InformCache::~InformCache() {
-    this->StoreCntIdx();
-    delete base_2_data_db_;
+    if (cache_container_->cur_size != 0) {
+        storage_core_->SaveContainer(cache_container_);
+    }
+    this->FlushLiveNum();
+    delete cache_container_;
+
+    string cache_stat_str;
+    cache_stat_str.append((char*)&feature_num_, sizeof(uint64_t));
+    cache_stat_str.append((char*)&cache_data_size_, sizeof(uint64_t));
+    base_2_entry_db_->Insert(cache_stat_key_, cache_stat_str);
+
+    delete base_2_entry_db_;
+    delete feature_2_fp_db_;
     delete finesse_util_;
     rabin_util_->FreeCtx(rabin_ctx_);
     delete similar_policy_;
@@ -58,22 +84,39 @@ InformCache::~InformCache() {
  */
 void InformCache::InsertCachedChunk(WrappedChunk_t* cache_chunk) {
     // update the local feature index
-    string base_fp_str;
-    base_fp_str.assign((char*)cache_chunk->info.fp, CHUNK_HASH_SIZE);    
-
-    similar_policy_->UpdateFeatureIndex(local_feature_2_fp_db_,
-        cache_chunk->info.features, base_fp_str);
-    
-    if (base_2_cnt_idx_.find(base_fp_str) != base_2_cnt_idx_.end()) {
-        base_2_cnt_idx_[base_fp_str].first += SUPER_FEATURE_PER_CHUNK;
+    string tmp_fp_str;
+    for (size_t i = 0; i < SUPER_FEATURE_PER_CHUNK; i++) {
+        if (!feature_2_fp_db_->QueryBuffer((char*)&cache_chunk->info.features[i],
+            sizeof(uint64_t), tmp_fp_str)) {
+            feature_num_++;
+        }
+    }
+    similar_policy_->UpdateFeatureIndex(feature_2_fp_db_,
+        cache_chunk->info.features, cache_chunk->info.fp);
+
+    CacheEntry_t base_entry;
+    string entry_str;
+    if (base_2_entry_db_->QueryBuffer((char*)cache_chunk->info.fp,
+        CHUNK_HASH_SIZE, entry_str)) {
+        memcpy(&base_entry, &entry_str[0], sizeof(CacheEntry_t));
+        if (base_entry.cnt == 0) {
+            zero_cnt_base_set_.erase(string((char*)cache_chunk->info.fp,
+                CHUNK_HASH_SIZE));
+        }
+        base_entry.cnt += SUPER_FEATURE_PER_CHUNK;
     } else {
-        // insert to the kv-store
-        base_2_cnt_idx_[base_fp_str] = 
-            {SUPER_FEATURE_PER_CHUNK, cache_chunk->info.size};
-        cache_base_chunk_str_.assign((char*)cache_chunk->data,
-            cache_chunk->info.size);
-        base_2_data_db_->Insert(base_fp_str, cache_base_chunk_str_);
+        // append the uncompressed base chunk to the cache container, only
+        // keep its address in the kv-store
+        base_entry.cnt = SUPER_FEATURE_PER_CHUNK;
+        base_entry.size = cache_chunk->info.size;
+        base_entry.addr.stat = CACHE_INSERT_CHUNK;
+        base_entry.addr.depth = 0;
+        this->AppendBaseChunk(cache_chunk->data, cache_chunk->info.size,
+            &base_entry.addr);
+        cache_data_size_ += cache_chunk->info.size;
     }
+    base_2_entry_db_->InsertBothBuffer((char*)cache_chunk->info.fp,
+        CHUNK_HASH_SIZE, (char*)&base_entry, sizeof(CacheEntry_t));
 
     return ;
 }
@@ -88,19 +131,21 @@ void InformCache::InsertCachedChunk(WrappedChunk_t* cache_chunk) {
  */
 bool InformCache::ProcessNormalChunk(WrappedChunk_t* input_chunk,
     WrappedChunk_t* output_chunk) {
-    similar_policy_->FindBaseChunk(local_feature_2_fp_db_,
-        &input_chunk->info);
+    similar_policy_->FindBaseChunk(feature_2_fp_db_, &input_chunk->info);
     bool ret = false;
 
     switch (input_chunk->info.stat) {
         case SIMILAR_CHUNK: {
             // fetch the base chunk
-            if (base_2_data_db_->QueryBuffer(
+            string entry_str;
+            if (base_2_entry_db_->QueryBuffer(
                 (char*)input_chunk->info.addr.base_fp,
-                CHUNK_HASH_SIZE, cache_base_chunk_str_)) {
+                CHUNK_HASH_SIZE, entry_str)) {
+                CacheEntry_t* base_entry = (CacheEntry_t*)&entry_str[0];
+                this->ReadBaseChunk(base_entry, input_chunk->info.addr.base_fp,
+                    cache_base_chunk_);
                 output_chunk->info.size = delta_comp_->DeltaEncode(
-                    (uint8_t*)&cache_base_chunk_str_[0],
-                    cache_base_chunk_str_.size(), input_chunk->data, 
+                    cache_base_chunk_, base_entry->size, input_chunk->data, 
                     input_chunk->info.size, output_chunk->data);
 
                 // copy the metadata to the input chunk 
@@ -130,143 +175,6 @@ bool InformCache::ProcessNormalChunk(WrappedChunk_t* input_chunk,
     return ret;
 }
 
-/**
- * @brief load cnt index
- * 
- */
-void InformCache::LoadCntIdx() {
-    string cnt_idx_path = cache_root_path_ + to_string(client_id_) + "_cnt";
-    // check cache meta data exist
-    ifstream cache_cnt_hdl;
-    if (tool::FileExist(cnt_idx_path)) {
-        // check the file size
-        cache_cnt_hdl.open(cnt_idx_path, ios_base::in | ios_base::binary);
-        if (!cache_cnt_hdl.is_open()) {
-            tool::Logging(my_name_.c_str(), "cannot open the cache cnt.\n");
-            exit(EXIT_FAILURE);
-        }
-
-        size_t start_size = cache_cnt_hdl.tellg();
-        cache_cnt_hdl.seekg(0, ios_base::end);
-        size_t file_size = cache_cnt_hdl.tellg();
-        file_size = file_size - start_size;
-
-        if (file_size == 0) {
-            return ;
-        }
-        cache_cnt_hdl.seekg(0, ios_base::beg);
-
-        // it exists in the client, read it
-        size_t idx_item_num = 0;
-        cache_cnt_hdl.read((char*)&idx_item_num, sizeof(size_t));
-        if (idx_item_num == 0) {
-            return ;
-        }
-
-        string base_fp_str;
-        base_fp_str.resize(CHUNK_HASH_SIZE, 0);
-        uint32_t cnt;
-        uint32_t chunk_size;
-        for (size_t i = 0; i < idx_item_num; i++) {
-            cache_cnt_hdl.read((char*)&base_fp_str[0], CHUNK_HASH_SIZE);
-            cache_cnt_hdl.read((char*)&cnt, sizeof(uint32_t));
-            cache_cnt_hdl.read((char*)&chunk_size, sizeof(uint32_t));
-            base_2_cnt_idx_[base_fp_str] = {cnt, chunk_size};
-        }
-
-        cache_cnt_hdl.close();
-    }
-
-    // -------- load local feature index --------
-    // check local feature index exits
-    ifstream feature_idx_hdl;
-    string feature_idx_path = cache_root_path_ + to_string(client_id_) +
-        "_idx";
-    if (tool::FileExist(feature_idx_path)) {
-        feature_idx_hdl.open(feature_idx_path, ios_base::in | ios_base::binary);
-        if (!feature_idx_hdl.is_open()) {
-            tool::Logging(my_name_.c_str(),
-                "cannot open the cache feature index.\n");
-            exit(EXIT_FAILURE);
-        }
-
-        size_t start_size = feature_idx_hdl.tellg();
-        feature_idx_hdl.seekg(0, ios_base::end);
-        size_t file_size = feature_idx_hdl.tellg();
-        file_size = file_size - start_size;
-
-        if (file_size == 0) {
-            return ;
-        }
-        feature_idx_hdl.seekg(0, ios_base::beg);
-
-        size_t feature_item_num = 0;
-        feature_idx_hdl.read((char*)&feature_item_num, sizeof(size_t));
-        if (feature_item_num == 0) {
-            return ;
-        }
-
-        string tmp_base_fp;
-        tmp_base_fp.resize(CHUNK_HASH_SIZE, 0);
-        uint64_t feature;
-        for (size_t i = 0; i < feature_item_num; i++) {
-            feature_idx_hdl.read((char*)&feature, sizeof(uint64_t));
-            feature_idx_hdl.read(&tmp_base_fp[0], CHUNK_HASH_SIZE);
-            local_feature_2_fp_db_[feature] = tmp_base_fp;
-        }
-
-        feature_idx_hdl.close();
-    }
-
-    return ;
-}
-
-/**
- * @brief store cnt index
- * 
- */
-void InformCache::StoreCntIdx() {
-    string cnt_idx_path = cache_root_path_ + to_string(client_id_) + "_cnt";
-    ofstream cache_cnt_hdl;
-    cache_cnt_hdl.open(cnt_idx_path, ios_base::trunc | ios_base::binary);
-    if (!cache_cnt_hdl.is_open()) {
-        tool::Logging(my_name_.c_str(), "cannot init the cache cnt idx.\n");
-        exit(EXIT_FAILURE);
-    }
-
-    size_t idx_item_num = base_2_cnt_idx_.size();
-    cache_cnt_hdl.write((char*)&idx_item_num, sizeof(size_t));
-
-    for (auto it : base_2_cnt_idx_) {
-        cache_cnt_hdl.write(it.first.c_str(), CHUNK_HASH_SIZE);
-        cache_cnt_hdl.write((char*)&it.second.first, sizeof(uint32_t));
-        cache_cnt_hdl.write((char*)&it.second.second, sizeof(uint32_t));
-    }
-    cache_cnt_hdl.close();
-
-    // -------- store local feature index --------
-    string feature_idx_path = cache_root_path_ + to_string(client_id_) +
-        "_idx";
-    ofstream feature_idx_hdl;
-    feature_idx_hdl.open(feature_idx_path, ios_base::trunc | ios_base::binary);
-    if (!feature_idx_hdl.is_open()) {
-        tool::Logging(my_name_.c_str(),
-            "cannot init the cache feature index.\n");
-        exit(EXIT_FAILURE);
-    }
-
-    size_t feature_item_num = local_feature_2_fp_db_.size();
-    feature_idx_hdl.write((char*)&feature_item_num, sizeof(size_t));
-
-    for (auto it : local_feature_2_fp_db_) {
-        feature_idx_hdl.write((char*)&it.first, sizeof(uint64_t));
-        feature_idx_hdl.write(it.second.c_str(),CHUNK_HASH_SIZE);
-    }
-    feature_idx_hdl.close();
-
-    return ;
-}
-
 /**
  * @brief process evict chunk
  * 
@@ -276,26 +184,32 @@ void InformCache::EvictCacheChunk(WrappedChunk_t* evict_chunk) {
     uint32_t feature_num = evict_chunk->info.size;
     uint64_t* feature_ptr;
     string base_fp_str;
+    string entry_str;
+    CacheEntry_t base_entry;
 
     for (size_t i = 0; i < feature_num; i++) {
         feature_ptr = (uint64_t*)(evict_chunk->data + i * sizeof(uint64_t));
         // check base chunk hash
-        auto find_base_ret = local_feature_2_fp_db_.find(*feature_ptr);
-        if (find_base_ret != local_feature_2_fp_db_.end()) {
-            auto find_cnt_ret = base_2_cnt_idx_.find(find_base_ret->second);
-            if (find_cnt_ret != base_2_cnt_idx_.end()) {
-                if (find_cnt_ret->second.first > 0) {
-                    find_cnt_ret->second.first--;
-                } else {
-                    find_cnt_ret->second.first = 0;
+        if (feature_2_fp_db_->QueryBuffer((char*)feature_ptr, sizeof(uint64_t),
+            base_fp_str)) {
+            if (base_2_entry_db_->Query(base_fp_str, entry_str)) {
+                memcpy(&base_entry, &entry_str[0], sizeof(CacheEntry_t));
+                if (base_entry.cnt > 0) {
+                    base_entry.cnt--;
                 }
+                if (base_entry.cnt == 0) {
+                    zero_cnt_base_set_.insert(base_fp_str);
+                }
+                base_2_entry_db_->InsertBuffer(base_fp_str, (char*)&base_entry,
+                    sizeof(CacheEntry_t));
             } else {
                 tool::Logging(my_name_.c_str(),
                     "cannot find the evict chunk in count index.\n");
                 exit(EXIT_FAILURE);
             }
 
-            local_feature_2_fp_db_.erase(*feature_ptr);
+            feature_2_fp_db_->DeleteBuffer((char*)feature_ptr, sizeof(uint64_t));
+            feature_num_--;
         } else {
             tool::Logging(my_name_.c_str(), "cannot find the evict feature"
                 "in local feature index.\n");
@@ -312,19 +226,33 @@ void InformCache::EvictCacheChunk(WrappedChunk_t* evict_chunk) {
  * @return total cache size
  */
 uint64_t InformCache::DeleteEvictChunk() {
-    uint64_t total_cache_size = 0;
-    auto it = base_2_cnt_idx_.begin();
-    while (it != base_2_cnt_idx_.end()) {
-        if (it->second.first == 0) {
-            base_2_data_db_->Delete(it->first);
-            it = base_2_cnt_idx_.erase(it);
-        } else {
-            total_cache_size += it->second.second;
-            it++;
+    // only the base chunks whose count drops to zero in this session, their
+    // cache containers are deleted once empty
+    string entry_str;
+    CacheEntry_t base_entry;
+    {
+        lock_guard<mutex> lck(cache_container_mtx_);
+        for (auto& base_fp_str : zero_cnt_base_set_) {
+            if (base_2_entry_db_->Query(base_fp_str, entry_str)) {
+                memcpy(&base_entry, &entry_str[0], sizeof(CacheEntry_t));
+                if (base_entry.cnt == 0) {
+                    base_2_entry_db_->Delete(base_fp_str);
+                    cache_data_size_ -= base_entry.size;
+                    // the base chunks cached before the cache containers
+                    // are in the chunk containers, keep them
+                    uint64_t* live_num = this->GetLiveNum(string(
+                        (char*)base_entry.addr.container_id,
+                        CONTAINER_ID_LENGTH));
+                    if (live_num != NULL && *live_num > 0) {
+                        (*live_num)--;
+                    }
+                }
+            }
         }
     }
+    zero_cnt_base_set_.clear();
 
-    return total_cache_size;
+    return cache_data_size_;
 }
 
 
@@ -336,13 +264,9 @@ uint64_t InformCache::DeleteEvictChunk() {
  * @return false not exist
  */
 bool InformCache::IsBaseChunkExist(uint8_t* base_fp) {
-    string base_fp_str;
-    base_fp_str.assign((char*)base_fp, CHUNK_HASH_SIZE);
-    if (base_2_cnt_idx_.find(base_fp_str) != base_2_cnt_idx_.end()) {
-        return true;
-    } else {
-        return false;
-    }
+    string entry_str;
+    return base_2_entry_db_->QueryBuffer((char*)base_fp, CHUNK_HASH_SIZE,
+        entry_str);
 }
 
 /**
@@ -353,15 +277,128 @@ bool InformCache::IsBaseChunkExist(uint8_t* base_fp) {
  * @return uint32_t output base chunk size
  */
 uint32_t InformCache::FetchBaseChunk(uint8_t* base_fp, uint8_t* output_base) {
-    string base_fp_str;
-    base_fp_str.assign((char*)base_fp, CHUNK_HASH_SIZE);
-    if (!base_2_data_db_->Query(base_fp_str, cache_base_chunk_str_)) {
+    // use a local buffer, it is also called by the delta workers
+    string entry_str;
+    if (!base_2_entry_db_->QueryBuffer((char*)base_fp, CHUNK_HASH_SIZE,
+        entry_str)) {
         tool::Logging(my_name_.c_str(), "cannot find the base chunk in the cache.\n");
         exit(EXIT_FAILURE);
     }
-    uint32_t base_chunk_size = cache_base_chunk_str_.size();
-    memcpy(output_base, cache_base_chunk_str_.c_str(), base_chunk_size);
-    return base_chunk_size;
+    CacheEntry_t* base_entry = (CacheEntry_t*)&entry_str[0];
+    this->ReadBaseChunk(base_entry, base_fp, output_base);
+    return base_entry->size;
+}
+
+/**
+ * @brief read a cached base chunk (unsealed cache container first, then the
+ * saved one)
+ * 
+ * @param base_entry the cache entry of the base chunk
+ * @param base_fp base chunk fp
+ * @param output_base output base chunk <ret>
+ */
+void InformCache::ReadBaseChunk(CacheEntry_t* base_entry, uint8_t* base_fp,
+    uint8_t* output_base) {
+    {
+        lock_guard<mutex> lck(cache_container_mtx_);
+        if (memcmp(cache_container_->id, base_entry->addr.container_id,
+            CONTAINER_ID_LENGTH) == 0) {
+            memcpy(output_base, cache_container_->body +
+                base_entry->addr.offset, base_entry->addr.len);
+            return ;
+        }
+    }
+
+    lock_guard<mutex> lck(cur_client_->_storage_mtx);
+    if (!storage_core_->ReadChunk(&base_entry->addr, output_base,
+        cur_client_)) {
+        tool::Logging(my_name_.c_str(), "cannot read the base chunk "
+            "from the container.\n");
+        exit(EXIT_FAILURE);
+    }
+    return ;
+}
+
+/**
+ * @brief append a base chunk to the cache container
+ * 
+ * @param data the base chunk
+ * @param size the base chunk size
+ * @param addr the base chunk address <ret>
+ */
+void InformCache::AppendBaseChunk(uint8_t* data, uint32_t size,
+    KeyForChunkHashDB_t* addr) {
+    lock_guard<mutex> lck(cache_container_mtx_);
+    if ((cache_container_->cur_size + size) > MAX_CONTAINER_SIZE) {
+        storage_core_->SaveContainer(cache_container_);
+        cache_container_->cur_size = 0;
+        tool::CreateUUID(cache_container_->id, CONTAINER_ID_LENGTH);
+    }
+    memcpy(cache_container_->body + cache_container_->cur_size, data, size);
+
+    memcpy(addr->container_id, cache_container_->id, CONTAINER_ID_LENGTH);
+    addr->offset = cache_container_->cur_size;
+    addr->len = size;
+    cache_container_->cur_size += size;
+
+    string container_id(cache_container_->id, CONTAINER_ID_LENGTH);
+    uint64_t* live_num = this->GetLiveNum(container_id);
+    if (live_num == NULL) {
+        live_num = &container_live_map_[container_id];
+        *live_num = 0;
+    }
+    (*live_num)++;
+    return ;
+}
+
+/**
+ * @brief get the num of the cached base chunks in a cache container
+ * 
+ * @param container_id the container id
+ * @return uint64_t* the num (NULL: not a cache container)
+ */
+uint64_t* InformCache::GetLiveNum(const string& container_id) {
+    auto find_ret = container_live_map_.find(container_id);
+    if (find_ret != container_live_map_.end()) {
+        return &find_ret->second;
+    }
+
+    string live_num_str;
+    if (!base_2_entry_db_->Query(container_key_prefix_ + container_id,
+        live_num_str)) {
+        return NULL;
+    }
+    uint64_t* live_num = &container_live_map_[container_id];
+    memcpy(live_num, &live_num_str[0], sizeof(uint64_t));
+    return live_num;
+}
+
+/**
+ * @brief store the nums of the cached base chunks, and delete the cache
+ * containers without any cached base chunk
+ * 
+ */
+void InformCache::FlushLiveNum() {
+    lock_guard<mutex> lck(cache_container_mtx_);
+    for (auto& it : container_live_map_) {
+        string live_key = container_key_prefix_ + it.first;
+        if (it.second != 0) {
+            base_2_entry_db_->InsertBuffer(live_key, (char*)&it.second,
+                sizeof(uint64_t));
+            continue;
+        }
+
+        // no base chunk refers to it (the entries are deleted before)
+        base_2_entry_db_->Delete(live_key);
+        storage_core_->DeleteContainer((uint8_t*)it.first.c_str());
+        if (memcmp(cache_container_->id, it.first.c_str(),
+            CONTAINER_ID_LENGTH) == 0) {
+            cache_container_->cur_size = 0;
+            tool::CreateUUID(cache_container_->id, CONTAINER_ID_LENGTH);
+        }
+    }
+    container_live_map_.clear();
+    return ;
 }
 
 /**
@@ -370,5 +407,5 @@ uint32_t InformCache::FetchBaseChunk(uint8_t* base_fp, uint8_t* output_base) {
  * @return uint64_t the cache size
  */
 uint64_t InformCache::GetCacheSize() {
-    return local_feature_2_fp_db_.size();
+    return feature_num_;
 }
\ No newline at end of file
@@ -18,7 +18,7 @@
  * @param fp_2_addr_db the fp to address index
  * @param feature_2_fp_db the feature to base hash index
  */
-ServerOptThd::ServerOptThd(SSLConnection* server_channel, 
+ServerOptThd::ServerOptThd(AbsTransport* server_channel, 
     AbsDatabase* fp_2_addr_db, AbsDatabase* feature_2_fp_db) {
     server_channel_ = server_channel;
     fp_2_addr_db_ = fp_2_addr_db;
@@ -27,7 +27,8 @@ ServerOptThd::ServerOptThd(SSLConnection* server_channel,
     // init the upload
     storage_core_ = new StorageCore();
     
-    data_recv_thd_ = new DataRecvThd(server_channel_, fp_2_addr_db_);
+    data_recv_thd_ = new DataRecvThd(server_channel_, fp_2_addr_db_,
+        storage_core_);
     cache_comp_thd_ = new CacheCompThd();
     data_writer_thd_ = new DataWriterThd(fp_2_addr_db_,
         feature_2_fp_db_, storage_core_);
@@ -37,6 +38,14 @@ ServerOptThd::ServerOptThd(SSLConnection* server_channel,
     data_decode_thd_ = new DataDecoderThd(server_channel_);
     
     this->LoadStat();
+
+    // start the session workers
+    boost::thread_attributes attrs;
+    attrs.set_stack_size(THREAD_STACK_SIZE);
+    for (size_t i = 0; i < config.GetSessionWorkerNum(); i++) {
+        worker_list_.push_back(new boost::thread(attrs,
+            boost::bind(&ServerOptThd::RunWorker, this)));
+    }
 }
 
 /**
@@ -44,6 +53,21 @@ ServerOptThd::ServerOptThd(SSLConnection* server_channel,
  * 
  */
 ServerOptThd::~ServerOptThd() {
+    // wait for the running sessions, drop the queued ones
+    {
+        lock_guard<mutex> lck(session_queue_lck_);
+        is_stop_ = true;
+    }
+    session_queue_cv_.notify_all();
+    for (auto it : worker_list_) {
+        it->join();
+        delete it;
+    }
+    for (auto& it : session_queue_) {
+        server_channel_->ClearAcceptedClientSd(it.first);
+        free(it.second);
+    }
+
     this->StoreStat();
     delete storage_core_;
 
@@ -55,6 +79,13 @@ ServerOptThd::~ServerOptThd() {
     delete data_reader_thd_;
     delete data_decode_thd_;
 
+    if (inform_cache_store_ != NULL) {
+        delete inform_cache_store_;
+    }
+    if (owner_store_ != NULL) {
+        delete owner_store_;
+    }
+
     for (auto it : client_lck_idx_) {
         delete it.second;
     }
@@ -67,41 +98,97 @@ ServerOptThd::~ServerOptThd() {
 }
 
 /**
- * @brief the main thread
+ * @brief dispatch an established connection (called by the reactor)
+ * 
+ * @param client_ssl the connection
+ * @param login the login message
+ * @param login_size the login size
+ */
+void ServerOptThd::Dispatch(Conn_t* client_ssl, uint8_t* login,
+    uint32_t login_size) {
+    uint8_t* login_buf = (uint8_t*) malloc(LOGIN_SIZE);
+    memset(login_buf, 0, sizeof(NetworkHead_t));
+    memcpy(login_buf, login, login_size);
+
+    // a stripe connection joins the session opened by another connection,
+    // here rather than in a worker, since its session holds a worker until
+    // all stripes join
+    if (((NetworkHead_t*)login_buf)->msg_type == CLIENT_LOGIN_STRIPE) {
+        SendMsgBuffer_t recv_buf;
+        recv_buf.send_buf = login_buf;
+        recv_buf.header = (NetworkHead_t*) recv_buf.send_buf;
+        recv_buf.data_buf = recv_buf.send_buf + sizeof(NetworkHead_t);
+        this->JoinStripe(client_ssl, &recv_buf);
+        free(login_buf);
+        return ;
+    }
+
+    {
+        lock_guard<mutex> lck(session_queue_lck_);
+        session_queue_.push_back(make_pair(client_ssl, login_buf));
+    }
+    session_queue_cv_.notify_one();
+    return ;
+}
+
+/**
+ * @brief the session worker (run the queued sessions one by one)
+ * 
+ */
+void ServerOptThd::RunWorker() {
+    pair<Conn_t*, uint8_t*> session;
+    while (true) {
+        {
+            unique_lock<mutex> lck(session_queue_lck_);
+            session_queue_cv_.wait(lck, [this]() {
+                return is_stop_ || !session_queue_.empty();
+            });
+            if (is_stop_) {
+                break;
+            }
+            session = session_queue_.front();
+            session_queue_.pop_front();
+        }
+        this->Run(session.first, session.second);
+    }
+    return ;
+}
+
+/**
+ * @brief the main thread of a session
  * 
- * @param client_ssl 
+ * @param client_ssl the connection
+ * @param login_buf the login message (freed by the session)
  */
-void ServerOptThd::Run(SSL* client_ssl) {
+void ServerOptThd::Run(Conn_t* client_ssl, uint8_t* login_buf) {
     boost::thread* tmp_thd;
     boost::thread_attributes attrs;
     attrs.set_stack_size(THREAD_STACK_SIZE);
     vector<boost::thread*> thd_list;
 
     SendMsgBuffer_t recv_buf;
-    recv_buf.send_buf = (uint8_t*) malloc(sizeof(NetworkHead_t) + CHUNK_HASH_SIZE);
+    recv_buf.send_buf = login_buf;
     recv_buf.header = (NetworkHead_t*) recv_buf.send_buf;
-    recv_buf.header->size = 0;
     recv_buf.data_buf = recv_buf.send_buf + sizeof(NetworkHead_t);
     uint32_t recv_size = 0;
 
     tool::Logging(my_name_.c_str(), "the main thread is running.\n");
 
-    // start to receive the login data type
-    if (!server_channel_->ReceiveData(client_ssl, recv_buf.send_buf,
-        recv_size)) {
-        tool::Logging(my_name_.c_str(), "recv the login message error.\n");
-        exit(EXIT_FAILURE);
-    }
-
     // add a client lck here (ensure only one client with the same id)
     uint32_t client_id = recv_buf.header->client_id;
     this->LockClientID(client_id);
     
     // -------- main process --------
     int opt_type = 0;
+    uint32_t method_type = 0;
+    uint32_t wire_ver_offset = CHUNK_HASH_SIZE;
     switch (recv_buf.header->msg_type) {
         case CLIENT_LOGIN_UPLOAD: {
             opt_type = UPLOAD_OPT;
+            // the upload login carries the EDR method after the file name hash
+            memcpy(&method_type, recv_buf.data_buf + CHUNK_HASH_SIZE,
+                sizeof(uint32_t));
+            wire_ver_offset += sizeof(uint32_t);
             break;
         }
         case CLIENT_LOGIN_DOWNLOAD: {
@@ -114,6 +201,68 @@ void ServerOptThd::Run(SSL* client_ssl) {
         }
     }
 
+    // negotiate the wire format (a client without it uses the fixed one)
+    uint32_t wire_ver = WIRE_FORMAT_FIXED;
+    if (recv_buf.header->size >= wire_ver_offset + sizeof(uint32_t)) {
+        memcpy(&wire_ver, recv_buf.data_buf + wire_ver_offset,
+            sizeof(uint32_t));
+        wire_ver = min(wire_ver, WIRE_FORMAT_VERSION);
+    }
+    // the upload login may ask for the fingerprint-first upload
+    uint32_t fp_first = 0;
+    uint32_t stripe_offset = wire_ver_offset + sizeof(uint32_t);
+    if (opt_type == UPLOAD_OPT) {
+        if (recv_buf.header->size >= stripe_offset + sizeof(uint32_t)) {
+            memcpy(&fp_first, recv_buf.data_buf + stripe_offset,
+                sizeof(uint32_t));
+        }
+        stripe_offset += sizeof(uint32_t);
+    }
+    // and the number of connections of this session
+    uint32_t stripe_num = 1;
+    if (recv_buf.header->size >= stripe_offset + sizeof(uint32_t)) {
+        memcpy(&stripe_num, recv_buf.data_buf + stripe_offset,
+            sizeof(uint32_t));
+        stripe_num = tool::CompareLimit(stripe_num, 1, MAX_STRIPE_NUM);
+    }
+    // the eviction notices of a FULL_EDR upload are not in the batch order,
+    // they must share the connection with the chunk batches
+    if (opt_type == UPLOAD_OPT && method_type == FULL_EDR) {
+        stripe_num = 1;
+    }
+    uint64_t stripe_token = 0;
+    if (stripe_num > 1) {
+        RAND_bytes((uint8_t*)&stripe_token, sizeof(uint64_t));
+    }
+    // the upload login may ask to resume an interrupted upload (the chunks
+    // that the client has kept)
+    uint64_t resume_chunk_num = 0;
+    uint32_t resume_offset = stripe_offset + sizeof(uint32_t);
+    if (opt_type == UPLOAD_OPT && recv_buf.header->size >= resume_offset +
+        sizeof(uint64_t)) {
+        memcpy(&resume_chunk_num, recv_buf.data_buf + resume_offset,
+            sizeof(uint64_t));
+    }
+    // and the authenticated-only data frames (both sides enable them)
+    uint32_t auth_only = 0;
+    uint32_t auth_only_offset = resume_offset;
+    if (opt_type == UPLOAD_OPT) {
+        auth_only_offset += sizeof(uint64_t);
+    }
+    if (recv_buf.header->size >= auth_only_offset + sizeof(uint32_t)) {
+        memcpy(&auth_only, recv_buf.data_buf + auth_only_offset,
+            sizeof(uint32_t));
+    }
+    auth_only = (auth_only != 0) && config.GetAuthOnlyData();
+    // and the upload login may ask for the credit-based flow control
+    uint32_t credit_flow = 0;
+    uint32_t credit_offset = auth_only_offset + sizeof(uint32_t);
+    if (opt_type == UPLOAD_OPT && recv_buf.header->size >= credit_offset +
+        sizeof(uint32_t)) {
+        memcpy(&credit_flow, recv_buf.data_buf + credit_offset,
+            sizeof(uint32_t));
+    }
+
     // check the file status
     // convert the file name hash to the file path
     char file_hash_buf[CHUNK_HASH_SIZE * 2 + 1];
@@ -159,8 +308,72 @@ void ServerOptThd::Run(SSL* client_ssl) {
             _total_upload_opt_num++;
             tool::Logging(my_name_.c_str(), "recv the upload req from client: %u\n",
                 client_id);
+            if (method_type == FULL_EDR) {
+                // the inform cache state is not checkpointed
+                resume_chunk_num = 0;
+            }
+            resume_chunk_num = min(resume_chunk_num,
+                this->LoadCheckpoint(recipe_path));
+            if (resume_chunk_num != 0) {
+                tool::Logging(my_name_.c_str(), "resume the upload of client "
+                    "%u after chunk %lu\n", client_id, resume_chunk_num);
+            }
             cur_client = new ClientVar(client_id, client_ssl, UPLOAD_OPT,
-                recipe_path);
+                recipe_path, resume_chunk_num);
+            cur_client->_wire_ver = wire_ver;
+            cur_client->_auth_only = (auth_only != 0);
+            if (fp_first != 0) {
+                // only answer the fp queries with the chunks of this client
+                cur_client->_owner_db = this->GetOwnerStore()->GetColumnFamily(
+                    "client_" + to_string(client_id) + "_own");
+            }
+            if (method_type == FULL_EDR) {
+                cur_client->_inform_cache = new InformCache(client_id,
+                    this->GetInformCacheStore(), storage_core_, cur_client);
+            }
+            this->OpenStripes(cur_client, stripe_num, stripe_token);
+            // each stripe starts with a full credit window
+            if (credit_flow == 0) {
+                cur_client->_credit_window = 0;
+            }
+            cur_client->_stripe_credit.assign(stripe_num,
+                cur_client->_credit_window);
+
+            // send the upload-response to the client (include the wire format,
+            // the fingerprint-first upload, the stripe setting, the resumed
+            // chunk num, the authenticated-only data frames and the credit
+            // window)
+            recv_buf.header->msg_type = SERVER_LOGIN_RESPONSE;
+            recv_buf.header->size = sizeof(uint32_t) * 4 + sizeof(uint64_t) * 3;
+            memcpy(recv_buf.data_buf, &wire_ver, sizeof(uint32_t));
+            memcpy(recv_buf.data_buf + sizeof(uint32_t), &fp_first,
+                sizeof(uint32_t));
+            memcpy(recv_buf.data_buf + sizeof(uint32_t) * 2, &stripe_num,
+                sizeof(uint32_t));
+            memcpy(recv_buf.data_buf + sizeof(uint32_t) * 3, &stripe_token,
+                sizeof(uint64_t));
+            memcpy(recv_buf.data_buf + sizeof(uint32_t) * 3 + sizeof(uint64_t),
+                &resume_chunk_num, sizeof(uint64_t));
+            memcpy(recv_buf.data_buf + sizeof(uint32_t) * 3 +
+                sizeof(uint64_t) * 2, &auth_only, sizeof(uint32_t));
+            memcpy(recv_buf.data_buf + sizeof(uint32_t) * 4 +
+                sizeof(uint64_t) * 2, &cur_client->_credit_window,
+                sizeof(uint64_t));
+            if (!server_channel_->SendData(client_ssl, recv_buf.send_buf,
+                sizeof(NetworkHead_t) + recv_buf.header->size)) {
+                tool::Logging(my_name_.c_str(), "send the upload-login response error.\n");
+                this->AbandonSession(cur_client, stripe_token);
+                free(recv_buf.send_buf);
+                this->UnlockClientID(client_id);
+                return ;
+            }
+            this->EnableAuthOnly(cur_client, client_ssl);
+            if (!this->WaitStripes(cur_client, stripe_token)) {
+                this->AbandonSession(cur_client, stripe_token);
+                free(recv_buf.send_buf);
+                this->UnlockClientID(client_id);
+                return ;
+            }
             
             // receive data & data fp generation
             tmp_thd = new boost::thread(attrs, boost::bind(&DataRecvThd::Run,
@@ -176,14 +389,15 @@ void ServerOptThd::Run(SSL* client_ssl) {
             tmp_thd = new boost::thread(attrs, boost::bind(&DataWriterThd::Run,
                 data_writer_thd_, cur_client));
             thd_list.push_back(tmp_thd);
-
-            // send the upload-response to the client
-            recv_buf.header->msg_type = SERVER_LOGIN_RESPONSE;
-            if (!server_channel_->SendData(client_ssl, recv_buf.send_buf,
-                sizeof(NetworkHead_t))) {
-                tool::Logging(my_name_.c_str(), "send the upload-login response error.\n");
-                exit(EXIT_FAILURE);
+            for (uint32_t i = 0; i < cur_client->_writer_2_delta_mq.size(); i++) {
+                tmp_thd = new boost::thread(attrs, boost::bind(
+                    &DataWriterThd::RunDeltaWorker, data_writer_thd_,
+                    cur_client, i));
+                thd_list.push_back(tmp_thd);
             }
+            tmp_thd = new boost::thread(attrs, boost::bind(
+                &DataWriterThd::RunAppender, data_writer_thd_, cur_client));
+            thd_list.push_back(tmp_thd);
             break;
         }
         case DOWNLOAD_OPT: {
@@ -192,15 +406,43 @@ void ServerOptThd::Run(SSL* client_ssl) {
                 client_id);
             cur_client = new ClientVar(client_id, client_ssl, DOWNLOAD_OPT,
                 recipe_path);
+            cur_client->_wire_ver = wire_ver;
+            cur_client->_auth_only = (auth_only != 0);
+            this->OpenStripes(cur_client, stripe_num, stripe_token);
             
-            // send the download-response to the client (include the file recipe header)
+            // send the download-response to the client (include the file
+            // recipe header, the wire format, the stripe setting and the
+            // authenticated-only data frames)
             recv_buf.header->msg_type = SERVER_LOGIN_RESPONSE;
             cur_client->_recipe_read_hdl.read((char*)recv_buf.data_buf,
                 sizeof(FileRecipeHead_t));
+            recv_buf.header->size = sizeof(FileRecipeHead_t);
+            memcpy(recv_buf.data_buf + recv_buf.header->size, &wire_ver,
+                sizeof(uint32_t));
+            recv_buf.header->size += sizeof(uint32_t);
+            memcpy(recv_buf.data_buf + recv_buf.header->size, &stripe_num,
+                sizeof(uint32_t));
+            recv_buf.header->size += sizeof(uint32_t);
+            memcpy(recv_buf.data_buf + recv_buf.header->size, &stripe_token,
+                sizeof(uint64_t));
+            recv_buf.header->size += sizeof(uint64_t);
+            memcpy(recv_buf.data_buf + recv_buf.header->size, &auth_only,
+                sizeof(uint32_t));
+            recv_buf.header->size += sizeof(uint32_t);
             if (!server_channel_->SendData(client_ssl, recv_buf.send_buf,
-                sizeof(NetworkHead_t) + sizeof(FileRecipeHead_t))) {
+                sizeof(NetworkHead_t) + recv_buf.header->size)) {
                 tool::Logging(my_name_.c_str(), "send the download-login response error.\n");
-                exit(EXIT_FAILURE);
+                this->AbandonSession(cur_client, stripe_token);
+                free(recv_buf.send_buf);
+                this->UnlockClientID(client_id);
+                return ;
+            }
+            this->EnableAuthOnly(cur_client, client_ssl);
+            if (!this->WaitStripes(cur_client, stripe_token)) {
+                this->AbandonSession(cur_client, stripe_token);
+                free(recv_buf.send_buf);
+                this->UnlockClientID(client_id);
+                return ;
             }
 
             tmp_thd = new boost::thread(attrs, boost::bind(&DataReaderThd::Run,
@@ -229,6 +471,9 @@ void ServerOptThd::Run(SSL* client_ssl) {
         delete it;
     }
     thd_list.clear();
+    if (opt_type == UPLOAD_OPT) {
+        this->CloseCheckpoint(cur_client);
+    }
 
     // clean up client variables
     uint64_t total_cache_size = 0;
@@ -324,6 +569,297 @@ bool ServerOptThd::CheckFileStat(string& recipe_path, int opt_type) {
     return true;
 }
 
+/**
+ * @brief get the shared inform cache store (open it lazily)
+ * 
+ * @return RocksdbCFStore* the inform cache store
+ */
+RocksdbCFStore* ServerOptThd::GetInformCacheStore() {
+    lock_guard<mutex> lck(inform_cache_store_lck_);
+    if (inform_cache_store_ == NULL) {
+        inform_cache_store_ = new RocksdbCFStore(config.GetCacheRootPath() +
+            "inform_cache_db");
+    }
+    return inform_cache_store_;
+}
+
+/**
+ * @brief register a session that waits for its stripe connections
+ * 
+ * @param cur_client the current client
+ * @param stripe_num the number of connections
+ * @param stripe_token the session token
+ */
+void ServerOptThd::OpenStripes(ClientVar* cur_client, uint32_t stripe_num,
+    uint64_t stripe_token) {
+    if (stripe_num == 1) {
+        return ;
+    }
+    lock_guard<mutex> lck(stripe_session_lck_);
+    cur_client->_stripe_ssl.resize(stripe_num, NULL);
+    stripe_session_idx_[stripe_token] = cur_client;
+    return ;
+}
+
+/**
+ * @brief wait until all stripe connections of a session join
+ * 
+ * @param cur_client the current client
+ * @param stripe_token the session token
+ * @return true all stripes join in time
+ */
+bool ServerOptThd::WaitStripes(ClientVar* cur_client, uint64_t stripe_token) {
+    if (cur_client->_stripe_ssl.size() == 1) {
+        return true;
+    }
+    unique_lock<mutex> lck(stripe_session_lck_);
+    bool is_joined = stripe_session_cv_.wait_for(lck,
+        chrono::seconds(STRIPE_JOIN_TIMEOUT), [cur_client]() {
+            return cur_client->_stripe_joined == cur_client->_stripe_ssl.size();
+        });
+    stripe_session_idx_.erase(stripe_token);
+    if (!is_joined) {
+        tool::Logging(my_name_.c_str(), "stripe connections of client %u do "
+            "not join in time.\n", cur_client->_client_id);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief close the connections of a session that fails before its threads
+ * start, the other sessions keep running
+ * 
+ * @param cur_client the current client (deleted)
+ * @param stripe_token the session token
+ */
+void ServerOptThd::AbandonSession(ClientVar* cur_client,
+    uint64_t stripe_token) {
+    {
+        // no stripe joins after this
+        lock_guard<mutex> lck(stripe_session_lck_);
+        stripe_session_idx_.erase(stripe_token);
+        for (auto conn : cur_client->_stripe_ssl) {
+            if (conn != NULL) {
+                server_channel_->ClearAcceptedClientSd(conn);
+            }
+        }
+    }
+    tool::Logging(my_name_.c_str(), "abandon the session of client %u.\n",
+        cur_client->_client_id);
+
+    // nothing is stored, keep the last checkpoint
+    uint64_t total_cache_size = 0;
+    cur_client->_total_cache_size = &total_cache_size;
+    delete cur_client;
+    return ;
+}
+
+/**
+ * @brief attach a stripe connection to its session
+ * 
+ * @param client_ssl the stripe connection
+ * @param recv_buf the stripe login
+ */
+void ServerOptThd::JoinStripe(Conn_t* client_ssl, SendMsgBuffer_t* recv_buf) {
+    uint64_t stripe_token;
+    uint32_t stripe_id;
+    memcpy(&stripe_token, recv_buf->data_buf, sizeof(uint64_t));
+    memcpy(&stripe_id, recv_buf->data_buf + sizeof(uint64_t), sizeof(uint32_t));
+
+    {
+        lock_guard<mutex> lck(stripe_session_lck_);
+        auto find_res = stripe_session_idx_.find(stripe_token);
+        if (find_res == stripe_session_idx_.end() ||
+            find_res->second->_client_id != recv_buf->header->client_id ||
+            stripe_id == 0 || stripe_id >= find_res->second->_stripe_ssl.size() ||
+            find_res->second->_stripe_ssl[stripe_id] != NULL) {
+            tool::Logging(my_name_.c_str(), "wrong stripe login from client "
+                "%u.\n", recv_buf->header->client_id);
+            server_channel_->ClearAcceptedClientSd(client_ssl);
+            return ;
+        }
+
+        // reply before the session can use this connection
+        recv_buf->header->msg_type = SERVER_LOGIN_RESPONSE;
+        recv_buf->header->size = 0;
+        if (!server_channel_->SendData(client_ssl, recv_buf->send_buf,
+            sizeof(NetworkHead_t))) {
+            tool::Logging(my_name_.c_str(), "send the stripe-login response "
+                "error.\n");
+            // the session is abandoned when its stripes do not join in time
+            server_channel_->ClearAcceptedClientSd(client_ssl);
+            return ;
+        }
+        this->EnableAuthOnly(find_res->second, client_ssl);
+        find_res->second->_stripe_ssl[stripe_id] = client_ssl;
+        find_res->second->_stripe_joined++;
+    }
+    stripe_session_cv_.notify_all();
+    return ;
+}
+
+/**
+ * @brief switch a connection of the session to the authenticated-only data
+ * frames after its login response (if negotiated)
+ * 
+ * @param cur_client the current client
+ * @param client_ssl the connection
+ */
+void ServerOptThd::EnableAuthOnly(ClientVar* cur_client, Conn_t* client_ssl) {
+    if (!cur_client->_auth_only) {
+        return ;
+    }
+    if (!server_channel_->EnableAuthOnly(client_ssl)) {
+        tool::Logging(my_name_.c_str(), "enable the authenticated-only data "
+            "frames error.\n");
+        exit(EXIT_FAILURE);
+    }
+    return ;
+}
+
+/**
+ * @brief roll back the journals of the uploads interrupted by a crash, before
+ * any connection is accepted
+ * 
+ */
+void ServerOptThd::RollbackJournals() {
+    string journal_suffix = config.GetJournalSuffix();
+    vector<string> recipe_path_list;
+    if (!filesystem::is_directory(config.GetRecipeRootPath())) {
+        return ;
+    }
+    for (auto& entry : filesystem::directory_iterator(
+        config.GetRecipeRootPath())) {
+        string file_path = entry.path().string();
+        if (file_path.size() > journal_suffix.size() &&
+            file_path.compare(file_path.size() - journal_suffix.size(),
+            journal_suffix.size(), journal_suffix) == 0) {
+            recipe_path_list.push_back(file_path.substr(0,
+                file_path.size() - journal_suffix.size()));
+        }
+    }
+
+    for (auto& recipe_path : recipe_path_list) {
+        this->RollbackIndex(recipe_path);
+    }
+    return ;
+}
+
+/**
+ * @brief remove the index entries of an interrupted upload whose containers
+ * were never saved, and remove its journal
+ * 
+ * @param recipe_path the full recipe path
+ */
+void ServerOptThd::RollbackIndex(string& recipe_path) {
+    string journal_path = recipe_path + config.GetJournalSuffix();
+    ifstream journal_hdl;
+    journal_hdl.open(journal_path, ios_base::in | ios_base::binary);
+    if (!journal_hdl.is_open()) {
+        return ;
+    }
+
+    // keep the entries in the saved containers, other uploads may refer to them
+    uint8_t fp[CHUNK_HASH_SIZE];
+    string addr_str;
+    uint64_t rollback_num = 0;
+    while (journal_hdl.read((char*)fp, CHUNK_HASH_SIZE)) {
+        if (!fp_2_addr_db_->QueryBuffer((char*)fp, CHUNK_HASH_SIZE, addr_str)) {
+            continue;
+        }
+        KeyForChunkHashDB_t* addr = (KeyForChunkHashDB_t*)&addr_str[0];
+        if (storage_core_->ContainerExist(addr->container_id)) {
+            continue;
+        }
+        fp_2_addr_db_->DeleteBuffer((char*)fp, CHUNK_HASH_SIZE);
+        rollback_num++;
+    }
+    journal_hdl.close();
+
+    if (rollback_num != 0) {
+        fp_2_addr_db_->Sync();
+        tool::Logging(my_name_.c_str(), "roll back the index entries of the "
+            "interrupted upload: %lu\n", rollback_num);
+    }
+    // a later upload may store the same chunks in new containers
+    filesystem::remove(journal_path);
+    return ;
+}
+
+/**
+ * @brief load the checkpointed chunk num of an interrupted upload
+ * 
+ * @param recipe_path the full recipe path
+ * @return uint64_t the checkpointed chunk num (0: no checkpoint)
+ */
+uint64_t ServerOptThd::LoadCheckpoint(string& recipe_path) {
+    ifstream ckpt_hdl;
+    ckpt_hdl.open(recipe_path + config.GetCkptSuffix(), ios_base::in |
+        ios_base::binary);
+    if (!ckpt_hdl.is_open()) {
+        return 0;
+    }
+    uint64_t ckpt_chunk_num = 0;
+    ckpt_hdl.read((char*)&ckpt_chunk_num, sizeof(uint64_t));
+    if (!ckpt_hdl) {
+        ckpt_chunk_num = 0;
+    }
+    ckpt_hdl.close();
+
+    // the partial recipe must hold all checkpointed fps
+    string tmp_recipe_path = recipe_path + config.GetTmpSuffix();
+    if (!tool::FileExist(tmp_recipe_path) ||
+        filesystem::file_size(tmp_recipe_path) < sizeof(FileRecipeHead_t) +
+        ckpt_chunk_num * CHUNK_HASH_SIZE) {
+        return 0;
+    }
+    return ckpt_chunk_num;
+}
+
+/**
+ * @brief make the index updates durable after the upload, and keep a
+ * checkpoint if it is interrupted
+ * 
+ * @param cur_client the current client
+ */
+void ServerOptThd::CloseCheckpoint(ClientVar* cur_client) {
+    fp_2_addr_db_->Sync();
+    feature_2_fp_db_->Sync();
+    if (cur_client->_owner_db != NULL) {
+        cur_client->_owner_db->Sync();
+    }
+
+    if (cur_client->_recipe_done) {
+        cur_client->ClearCheckpoint();
+        return ;
+    }
+
+    // the connection is closed before the recipe end, all received chunks
+    // are stored now
+    if (cur_client->_resumable) {
+        cur_client->SaveCheckpoint(fp_2_addr_db_, storage_core_);
+        tool::Logging(my_name_.c_str(), "upload of client %u is interrupted, "
+            "checkpoint at chunk %lu\n", cur_client->_client_id,
+            cur_client->_ckpt_chunk_num);
+    }
+    return ;
+}
+
+/**
+ * @brief get the shared chunk owner store (open it lazily)
+ * 
+ * @return RocksdbCFStore* the chunk owner store
+ */
+RocksdbCFStore* ServerOptThd::GetOwnerStore() {
+    lock_guard<mutex> lck(owner_store_lck_);
+    if (owner_store_ == NULL) {
+        owner_store_ = new RocksdbCFStore(config.GetFp2ChunkDBName() +
+            "_owner");
+    }
+    return owner_store_;
+}
+
 /**
  * @brief load previous stat 
  * 
@@ -164,4 +164,28 @@ void StorageCore::SaveContainer(Container_t* new_container) {
 
     _write_container_num++;
     return ;
+}
+
+/**
+ * @brief check whether a container is saved
+ * 
+ * @param container_id the container id
+ * @return true the container file exists
+ */
+bool StorageCore::ContainerExist(const uint8_t* container_id) {
+    string req_name((char*)container_id, CONTAINER_ID_LENGTH);
+    return tool::FileExist(container_name_prefix_ + req_name +
+        container_name_suffix_);
+}
+
+/**
+ * @brief delete a saved container (no chunk refers to it)
+ * 
+ * @param container_id the container id
+ */
+void StorageCore::DeleteContainer(const uint8_t* container_id) {
+    string req_name((char*)container_id, CONTAINER_ID_LENGTH);
+    filesystem::remove(container_name_prefix_ + req_name +
+        container_name_suffix_);
+    return ;
 }
\ No newline at end of file
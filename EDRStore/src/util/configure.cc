@@ -51,20 +51,31 @@ void Configure::ReadConfig(string path) {
 
     // Similar detection setting
     similar_sliding_win_size_ = root.get<uint64_t>("Similar.sliding_win_size");
+    max_delta_depth_ = root.get<uint64_t>("Similar.max_delta_depth");
+    prefer_local_base_ = root.get<bool>("Similar.prefer_local_base");
+    candidate_num_ = root.get<uint64_t>("Similar.candidate_num");
+    min_predicted_gain_ = root.get<uint64_t>("Similar.min_predicted_gain");
 
     // Storage Server settings
     storage_server_ip_ = root.get<string>("StorageServer.ip");
     storage_server_port_ = root.get<int>("StorageServer.port");
+    storage_server_transport_ = root.get<int>("StorageServer.transport");
+    storage_server_unix_path_ = root.get<string>("StorageServer.unix_path");
     recipe_root_path_ = root.get<string>("StorageServer.recipe_root_path");
     container_root_path_ = root.get<string>("StorageServer.container_root_path");
     cache_root_path_ = root.get<string>("StorageServer.cache_root_path");
     fp_2_chunk_db_ = root.get<string>("StorageServer.fp_2_chunk_db");
     feature_2_fp_db_ = root.get<string>("StorageServer.feature_2_fp_db");
     container_cache_size_ = root.get<uint64_t>("StorageServer.container_cache_size");
+    delta_worker_num_ = root.get<uint64_t>("StorageServer.delta_worker_num");
+    session_worker_num_ = root.get<uint64_t>("StorageServer.session_worker_num");
+    session_mem_budget_ = root.get<uint64_t>("StorageServer.session_mem_budget");
 
     // key manager settings
     km_ip_ = root.get<string>("KeyServer.ip");
     km_port_ = root.get<int>("KeyServer.port");
+    km_transport_ = root.get<int>("KeyServer.transport");
+    km_unix_path_ = root.get<string>("KeyServer.unix_path");
     feature_2_key_db_ = root.get<string>("KeyServer.feature_2_key_db");
 
     // client settings
@@ -72,6 +83,93 @@ void Configure::ReadConfig(string path) {
     send_chunk_batch_size_ = root.get<uint64_t>("Client.send_chunk_batch_size");
     send_recipe_batch_size_ = root.get<uint64_t>("Client.send_recipe_batch_size");
     user_key_ = root.get<string>("Client.user_key");
+    cache_meta_budget_ = root.get<uint64_t>("Client.cache_meta_budget");
+    fp_first_upload_ = root.get<bool>("Client.fp_first_upload");
+    stripe_num_ = root.get<uint32_t>("Client.stripe_num");
+    skip_unchanged_file_ = root.get<bool>("Client.skip_unchanged_file");
+    checkpoint_size_ = root.get<uint64_t>("Client.checkpoint_size");
+    restore_window_ = root.get<uint64_t>("Client.restore_window");
+    version_delta_ = root.get<bool>("Client.version_delta");
+    adaptive_batch_ = root.get<bool>("Client.adaptive_batch");
+    min_batch_size_ = root.get<uint64_t>("Client.min_batch_size");
+    max_batch_size_ = root.get<uint64_t>("Client.max_batch_size");
+
+    // network settings
+    enable_ktls_ = root.get<bool>("Network.enable_ktls");
+    session_resumption_ = root.get<bool>("Network.session_resumption");
+    session_lifetime_ = root.get<uint64_t>("Network.session_lifetime");
+    auth_only_data_ = root.get<bool>("Network.auth_only_data");
+
+    if (max_delta_depth_ > MAX_DELTA_DEPTH) {
+        tool::Logging(my_name_.c_str(), "max delta depth should not be larger "
+            "than %u.\n", MAX_DELTA_DEPTH);
+        exit(EXIT_FAILURE);
+    }
+
+    if (delta_worker_num_ == 0 || delta_worker_num_ > CHUNK_QUEUE_SIZE) {
+        tool::Logging(my_name_.c_str(), "delta worker num should be in "
+            "[1, %u].\n", CHUNK_QUEUE_SIZE);
+        exit(EXIT_FAILURE);
+    }
+
+    if (session_lifetime_ == 0) {
+        tool::Logging(my_name_.c_str(), "session lifetime should be at least "
+            "1 sec.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (auth_only_data_ && enable_ktls_) {
+        tool::Logging(my_name_.c_str(), "auth only data cannot be used with "
+            "kTLS.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (session_mem_budget_ == 0) {
+        tool::Logging(my_name_.c_str(), "session memory budget should be at "
+            "least 1 MiB.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (session_worker_num_ == 0) {
+        tool::Logging(my_name_.c_str(), "session worker num should be at "
+            "least 1.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (candidate_num_ == 0) {
+        tool::Logging(my_name_.c_str(), "candidate num should be at least 1.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (cache_meta_budget_ == 0) {
+        tool::Logging(my_name_.c_str(), "cache meta budget should be at least "
+            "1 MiB.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (restore_window_ == 0) {
+        tool::Logging(my_name_.c_str(), "restore window should be at least "
+            "1 MiB.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (stripe_num_ == 0 || stripe_num_ > MAX_STRIPE_NUM) {
+        tool::Logging(my_name_.c_str(), "stripe num should be in [1, %u].\n",
+            MAX_STRIPE_NUM);
+        exit(EXIT_FAILURE);
+    }
+
+    if (min_batch_size_ == 0 || min_batch_size_ > send_chunk_batch_size_) {
+        tool::Logging(my_name_.c_str(), "min batch size should be in [1, "
+            "chunk batch size].\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (max_batch_size_ < send_chunk_batch_size_) {
+        tool::Logging(my_name_.c_str(), "max batch size should be at least "
+            "the chunk batch size.\n");
+        exit(EXIT_FAILURE);
+    }
 
     if (send_recipe_batch_size_ % send_chunk_batch_size_ != 0) {
         tool::Logging(my_name_.c_str(), "recipe batch size should be a multiple "